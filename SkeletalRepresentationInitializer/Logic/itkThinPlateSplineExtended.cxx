@@ -3,3 +3,368 @@
 //
 
 #include "itkThinPlateSplineExtended.h"
+
+// VTK includes
+#include <vtkSMPTools.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// landmarks per block of the local level of the preconditioner
+const size_t BLOCK_SIZE = 128;
+// landmarks of every block that also belong to the coarse level
+const size_t COARSE_POINTS_PER_BLOCK = 16;
+const size_t MAX_COARSE_POINTS = 4000;
+
+// TPS system [K + stiffness I, P; P^T, 0] of a subset of the landmarks
+// K(a, b) = |x_a - x_b| is the 3D TPS kernel, P(a, :) = [x_a, 1]
+Eigen::MatrixXd LocalSystem(const Eigen::MatrixXd& landmarks, const vtkIdType* ids, size_t m, double stiffness)
+{
+	Eigen::MatrixXd L = Eigen::MatrixXd::Zero(m + 4, m + 4);
+	for(size_t a = 0; a < m; ++a) {
+		for(size_t b = 0; b < m; ++b) {
+			L(a, b) = (landmarks.row(ids[a]) - landmarks.row(ids[b])).norm();
+		}
+		L(a, a) += stiffness;
+		L.block(a, m, 1, 3) = landmarks.row(ids[a]);
+		L(a, m + 3) = 1;
+	}
+	L.block(m, 0, 4, m) = L.block(0, m, m, 4).transpose();
+	return L;
+}
+
+// out = (K + stiffness I) c, the kernel is evaluated on the fly: no n x n matrix is stored
+class KernelProductFunctor
+{
+public:
+	KernelProductFunctor(const Eigen::MatrixXd& landmarks, const Eigen::MatrixXd& c, double stiffness, Eigen::MatrixXd& out)
+		: X(landmarks), C(c), Stiffness(stiffness), Out(out) {}
+
+	void operator()(vtkIdType begin, vtkIdType end)
+	{
+		const vtkIdType n = X.rows();
+		const double* x = X.col(0).data();
+		const double* y = X.col(1).data();
+		const double* z = X.col(2).data();
+		const double* c0 = C.col(0).data();
+		const double* c1 = C.col(1).data();
+		const double* c2 = C.col(2).data();
+		for(vtkIdType i = begin; i < end; ++i) {
+			const double xi = x[i], yi = y[i], zi = z[i];
+			double s0 = 0, s1 = 0, s2 = 0;
+			for(vtkIdType j = 0; j < n; ++j) {
+				const double dx = x[j] - xi, dy = y[j] - yi, dz = z[j] - zi;
+				const double r = std::sqrt(dx * dx + dy * dy + dz * dz);
+				s0 += r * c0[j];
+				s1 += r * c1[j];
+				s2 += r * c2[j];
+			}
+			Out(i, 0) = s0 + Stiffness * c0[i];
+			Out(i, 1) = s1 + Stiffness * c1[i];
+			Out(i, 2) = s2 + Stiffness * c2[i];
+		}
+	}
+
+private:
+	const Eigen::MatrixXd& X;
+	const Eigen::MatrixXd& C;
+	double Stiffness;
+	Eigen::MatrixXd& Out;
+};
+
+void KernelProduct(const Eigen::MatrixXd& landmarks, const Eigen::MatrixXd& c, double stiffness, Eigen::MatrixXd& out)
+{
+	out.resize(c.rows(), 3);
+	KernelProductFunctor functor(landmarks, c, stiffness, out);
+	vtkSMPTools::For(0, c.rows(), functor);
+}
+
+// remove the component of v in the span of P (Q1 is an orthonormal basis of it)
+void Project(const Eigen::MatrixXd& Q1, Eigen::MatrixXd& v)
+{
+	v -= Q1 * (Q1.transpose() * v);
+}
+
+// Two level additive Schwarz preconditioner of -(K + stiffness I) on the space P^T c = 0.
+// Local level: TPS of blocks of nearby landmarks (recursive bisection of the landmarks).
+// Coarse level: TPS of a few landmarks of every block, it carries the smooth part of the
+// solution that the blocks cannot see.
+class TwoLevelPreconditioner
+{
+public:
+	void Build(const Eigen::MatrixXd& landmarks, double stiffness)
+	{
+		const vtkIdType n = landmarks.rows();
+		Ids.resize(n);
+		for(vtkIdType i = 0; i < n; ++i) {
+			Ids[i] = i;
+		}
+		Blocks.clear();
+		Split(landmarks, 0, Ids.size());
+
+		// local level: symmetric pseudo inverse, so that blocks of coplanar landmarks stay harmless
+		// only the kernel part is kept since the right hand sides have no affine part
+		LocalInverses.resize(Blocks.size());
+		LocalInverseFunctor functor(*this, landmarks, stiffness);
+		vtkSMPTools::For(0, static_cast<vtkIdType>(Blocks.size()), 1, functor);
+
+		// coarse level: landmarks evenly picked in every block
+		size_t perBlock = std::max<size_t>(1, std::min(COARSE_POINTS_PER_BLOCK, MAX_COARSE_POINTS / Blocks.size()));
+		CoarseIds.clear();
+		for(size_t b = 0; b < Blocks.size(); ++b) {
+			size_t size = Blocks[b].second - Blocks[b].first;
+			for(size_t a = 0; a < std::min(perBlock, size); ++a) {
+				CoarseIds.push_back(Ids[Blocks[b].first + a * size / perBlock]);
+			}
+		}
+		CoarseSolver.compute(LocalSystem(landmarks, &CoarseIds[0], CoarseIds.size(), stiffness));
+		// a degenerate coarse level (e.g. flat object) is dropped
+		HasCoarseLevel = CoarseIds.size() > 4 && CoarseSolver.rcond() > 1e-14;
+	}
+
+	// z = M r
+	void Apply(const Eigen::MatrixXd& r, Eigen::MatrixXd& z) const
+	{
+		z.setZero(r.rows(), 3);
+		ApplyFunctor functor(*this, r, z);
+		vtkSMPTools::For(0, static_cast<vtkIdType>(Blocks.size()), 1, functor);
+		if(HasCoarseLevel) {
+			const size_t m = CoarseIds.size();
+			Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(m + 4, 3);
+			for(size_t a = 0; a < m; ++a) {
+				rhs.row(a) = r.row(CoarseIds[a]);
+			}
+			Eigen::MatrixXd s = CoarseSolver.solve(rhs);
+			for(size_t a = 0; a < m; ++a) {
+				z.row(CoarseIds[a]) -= s.row(a);
+			}
+		}
+	}
+
+private:
+	void Split(const Eigen::MatrixXd& landmarks, size_t begin, size_t end)
+	{
+		if(end - begin <= BLOCK_SIZE) {
+			Blocks.push_back(std::make_pair(begin, end));
+			return;
+		}
+		// split at the median of the longest side of the bounding box
+		Eigen::RowVector3d lo = landmarks.row(Ids[begin]), hi = lo;
+		for(size_t k = begin; k < end; ++k) {
+			lo = lo.cwiseMin(landmarks.row(Ids[k]));
+			hi = hi.cwiseMax(landmarks.row(Ids[k]));
+		}
+		int axis = 0;
+		(hi - lo).maxCoeff(&axis);
+		size_t middle = (begin + end) / 2;
+		std::nth_element(Ids.begin() + begin, Ids.begin() + middle, Ids.begin() + end,
+		                 [&landmarks, axis](vtkIdType a, vtkIdType b) {return landmarks(a, axis) < landmarks(b, axis);});
+		Split(landmarks, begin, middle);
+		Split(landmarks, middle, end);
+	}
+
+	class LocalInverseFunctor
+	{
+	public:
+		LocalInverseFunctor(TwoLevelPreconditioner& p, const Eigen::MatrixXd& landmarks, double stiffness)
+			: Self(p), X(landmarks), Stiffness(stiffness) {}
+		void operator()(vtkIdType begin, vtkIdType end)
+		{
+			for(vtkIdType b = begin; b < end; ++b) {
+				size_t first = Self.Blocks[b].first;
+				size_t m = Self.Blocks[b].second - first;
+				Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(LocalSystem(X, &Self.Ids[first], m, Stiffness));
+				Eigen::VectorXd lambda = eigen.eigenvalues();
+				double threshold = 1e-12 * lambda.cwiseAbs().maxCoeff();
+				for(vtkIdType k = 0; k < lambda.size(); ++k) {
+					lambda(k) = std::fabs(lambda(k)) > threshold ? 1.0 / lambda(k) : 0.0;
+				}
+				Eigen::MatrixXd V = eigen.eigenvectors().topRows(m);
+				Self.LocalInverses[b] = V * lambda.asDiagonal() * V.transpose();
+			}
+		}
+	private:
+		TwoLevelPreconditioner& Self;
+		const Eigen::MatrixXd& X;
+		double Stiffness;
+	};
+
+	class ApplyFunctor
+	{
+	public:
+		ApplyFunctor(const TwoLevelPreconditioner& p, const Eigen::MatrixXd& r, Eigen::MatrixXd& z)
+			: Self(p), R(r), Z(z) {}
+		void operator()(vtkIdType begin, vtkIdType end)
+		{
+			for(vtkIdType b = begin; b < end; ++b) {
+				size_t first = Self.Blocks[b].first;
+				size_t m = Self.Blocks[b].second - first;
+				Eigen::MatrixXd rb(m, 3);
+				for(size_t a = 0; a < m; ++a) {
+					rb.row(a) = R.row(Self.Ids[first + a]);
+				}
+				Eigen::MatrixXd zb = Self.LocalInverses[b] * rb;
+				// blocks do not overlap: every task writes its own rows
+				for(size_t a = 0; a < m; ++a) {
+					Z.row(Self.Ids[first + a]) = -zb.row(a);
+				}
+			}
+		}
+	private:
+		const TwoLevelPreconditioner& Self;
+		const Eigen::MatrixXd& R;
+		Eigen::MatrixXd& Z;
+	};
+
+	std::vector<vtkIdType> Ids;
+	std::vector<std::pair<size_t, size_t> > Blocks;
+	std::vector<Eigen::MatrixXd> LocalInverses;
+	std::vector<vtkIdType> CoarseIds;
+	Eigen::PartialPivLU<Eigen::MatrixXd> CoarseSolver;
+	bool HasCoarseLevel;
+};
+
+bool Converged(const Eigen::MatrixXd& r, const Eigen::RowVector3d& bNorm, double tolerance)
+{
+	for(int k = 0; k < 3; ++k) {
+		if(r.col(k).norm() > tolerance * bNorm(k)) {
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+itkThinPlateSplineExtended::itkThinPlateSplineExtended()
+	: m_Solver(AutomaticSolver), m_Tolerance(1e-6), m_MaximumNumberOfIterations(1000), m_NumberOfIterations(0)
+{
+}
+
+void itkThinPlateSplineExtended::ComputeWMatrix()
+{
+	m_NumberOfIterations = 0;
+	bool iterative = m_Solver == IterativeSolver
+		|| (m_Solver == AutomaticSolver && this->m_SourceLandmarks->GetNumberOfPoints() > getDenseSolverMaximumLandmarks());
+	if(iterative && this->ComputeWMatrixIterative()) {
+		return;
+	}
+	// the iterations of a failed iterative solve do not count
+	m_NumberOfIterations = 0;
+	Superclass::ComputeWMatrix();
+}
+
+bool itkThinPlateSplineExtended::ComputeWMatrixIterative()
+{
+	// The kernel of the 3D TPS is |r| I, so the (3n+12) system splits into three (n+4) systems
+	// sharing the matrix L = [K, P; P^T, 0]: for coordinate i, K c_i + P d_i = y_i and P^T c_i = 0,
+	// with D(i, :) = c_i^T, [A(i, :), B(i)] = d_i^T and y_i the displacements of the landmarks.
+	// With P = Q1 R, c solves -Pi K Pi c = -Pi y (Pi = I - Q1 Q1^T), which is symmetric positive
+	// definite on the space P^T c = 0; then R d = Q1^T (y - K c).
+	const vtkIdType n = this->m_SourceLandmarks->GetNumberOfPoints();
+	if(n < 5 || n != static_cast<vtkIdType>(this->m_TargetLandmarks->GetNumberOfPoints())) {
+		return false;
+	}
+	Eigen::MatrixXd X(n, 3), Y(n, 3);
+	for(vtkIdType i = 0; i < n; ++i) {
+		InputPointType source = this->m_SourceLandmarks->GetPoints()->GetElement(i);
+		InputPointType target = this->m_TargetLandmarks->GetPoints()->GetElement(i);
+		for(int k = 0; k < 3; ++k) {
+			X(i, k) = source[k];
+			Y(i, k) = target[k] - source[k];
+		}
+	}
+	const double stiffness = this->m_Stiffness;
+
+	Eigen::MatrixXd P(n, 4);
+	P << X, Eigen::VectorXd::Ones(n);
+	Eigen::HouseholderQR<Eigen::MatrixXd> qr(P);
+	Eigen::MatrixXd Q1 = qr.householderQ() * Eigen::MatrixXd::Identity(n, 4);
+	Eigen::Matrix4d R = qr.matrixQR().topLeftCorner(4, 4).triangularView<Eigen::Upper>();
+	if(R.diagonal().cwiseAbs().minCoeff() <= 1e-10 * R.diagonal().cwiseAbs().maxCoeff()) {
+		// coplanar landmarks: let the SVD of the dense solver deal with them
+		return false;
+	}
+
+	TwoLevelPreconditioner preconditioner;
+	preconditioner.Build(X, stiffness);
+
+	// conjugate gradients on the three coordinates in lockstep, they share every kernel product
+	Eigen::MatrixXd c = Eigen::MatrixXd::Zero(n, 3);
+	Eigen::MatrixXd r = -Y;
+	Project(Q1, r);
+	const Eigen::RowVector3d bNorm = r.colwise().norm();
+	Eigen::MatrixXd z, Ap;
+	if(this->m_InitialDMatrix.rows() == 3 && static_cast<vtkIdType>(this->m_InitialDMatrix.cols()) == n) {
+		// warm start: r = b - A c = Pi (K c - y) for c in the space P^T c = 0
+		for(vtkIdType l = 0; l < n; ++l) {
+			for(int i = 0; i < 3; ++i) {
+				c(l, i) = this->m_InitialDMatrix(i, l);
+			}
+		}
+		Project(Q1, c);
+		KernelProduct(X, c, stiffness, r);
+		r -= Y;
+		Project(Q1, r);
+	}
+	preconditioner.Apply(r, z);
+	Project(Q1, z);
+	Eigen::MatrixXd p = z;
+	Eigen::RowVector3d rz = r.cwiseProduct(z).colwise().sum();
+	while(m_NumberOfIterations < m_MaximumNumberOfIterations && !Converged(r, bNorm, m_Tolerance)) {
+		KernelProduct(X, p, stiffness, Ap);
+		Ap = -Ap;
+		Project(Q1, Ap);
+		Eigen::RowVector3d pAp = p.cwiseProduct(Ap).colwise().sum();
+		for(int k = 0; k < 3; ++k) {
+			if(rz(k) == 0) {
+				continue;
+			}
+			if(pAp(k) <= 0) {
+				// a large stiffness makes the system indefinite: leave it to the dense solver
+				return false;
+			}
+			double alpha = rz(k) / pAp(k);
+			c.col(k) += alpha * p.col(k);
+			r.col(k) -= alpha * Ap.col(k);
+		}
+		preconditioner.Apply(r, z);
+		Project(Q1, z);
+		Eigen::RowVector3d rzNext = r.cwiseProduct(z).colwise().sum();
+		for(int k = 0; k < 3; ++k) {
+			double beta = rz(k) != 0 ? rzNext(k) / rz(k) : 0.0;
+			p.col(k) = z.col(k) + beta * p.col(k);
+		}
+		rz = rzNext;
+		++m_NumberOfIterations;
+	}
+	if(!Converged(r, bNorm, m_Tolerance)) {
+		itkWarningMacro(<< "TPS solve stopped after " << m_NumberOfIterations << " iterations before reaching the tolerance");
+	}
+
+	// affine part from the interpolation conditions
+	Eigen::MatrixXd Kc;
+	KernelProduct(X, c, stiffness, Kc);
+	Eigen::Matrix<double, 4, 3> d = R.triangularView<Eigen::Upper>().solve(Q1.transpose() * (Y - Kc));
+
+	this->m_DMatrix.set_size(3, n);
+	for(vtkIdType l = 0; l < n; ++l) {
+		for(int i = 0; i < 3; ++i) {
+			this->m_DMatrix(i, l) = c(l, i);
+		}
+	}
+	for(int i = 0; i < 3; ++i) {
+		for(int j = 0; j < 3; ++j) {
+			this->m_AMatrix(i, j) = d(j, i);
+		}
+		this->m_BVector(i) = d(3, i);
+	}
+	return true;
+}
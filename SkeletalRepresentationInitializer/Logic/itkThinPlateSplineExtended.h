@@ -42,12 +42,54 @@ public:
 //	BMatrixType m_BVector;
 	BMatrixType getBVector() {return m_BVector;};
 	void setBVector(BMatrixType B) {m_BVector = B;};
+
+	/** Solver of the W matrix.
+		DenseSolver: SVD of the whole (3n+12) x (3n+12) system by the superclass,
+		O(n^3) time and O(n^2) memory.
+		IterativeSolver: preconditioned conjugate gradients on the (n+4) x (n+4)
+		system shared by the three coordinates. Kernel products are evaluated on
+		the fly in parallel, so memory stays O(n).
+		AutomaticSolver: dense up to getDenseSolverMaximumLandmarks() landmarks,
+		iterative above.
+		The iterative solver falls back to the dense one for coplanar landmarks or
+		a stiffness large enough to make the system indefinite. */
+	enum SolverType {AutomaticSolver, DenseSolver, IterativeSolver};
+	void setSolver(SolverType solver) {m_Solver = solver;};
+	SolverType getSolver() const {return m_Solver;};
+	static unsigned long getDenseSolverMaximumLandmarks() {return 500;};
+
+	/** Relative residual at which the iterative solver stops */
+	void setTolerance(double tolerance) {m_Tolerance = tolerance;};
+	double getTolerance() const {return m_Tolerance;};
+	void setMaximumNumberOfIterations(unsigned int n) {m_MaximumNumberOfIterations = n;};
+	unsigned int getMaximumNumberOfIterations() const {return m_MaximumNumberOfIterations;};
+	/** Number of iterations of the last iterative solve (0 after a dense solve) */
+	unsigned int getNumberOfIterations() const {return m_NumberOfIterations;};
+
+	/** Start the iterative solver from the D matrix of a nearby TPS with the same
+		number of landmarks, e.g. the TPS of the previous pair of snapshots of a flow.
+		An empty matrix (the default) starts from zero. */
+	void setInitialDMatrix(const DMatrixType& D) {m_InitialDMatrix = D;};
+
+	/** Compute D, A and B with the selected solver */
+	virtual void ComputeWMatrix();
+
 protected:
-	itkThinPlateSplineExtended() {};
+	itkThinPlateSplineExtended();
 	virtual ~itkThinPlateSplineExtended() {}
+
+	/** Solve with the iterative solver, return false if it cannot be used */
+	bool ComputeWMatrixIterative();
+
 private:
 	itkThinPlateSplineExtended(const Self&); //purposely not implemented
 	void operator=(const Self&); //purposely not implemented
+
+	SolverType m_Solver;
+	double m_Tolerance;
+	unsigned int m_MaximumNumberOfIterations;
+	unsigned int m_NumberOfIterations;
+	DMatrixType m_InitialDMatrix;
 };
 
 
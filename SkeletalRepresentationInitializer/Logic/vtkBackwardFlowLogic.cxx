@@ -2,29 +2,40 @@
 // author: Zhiyuan Liu
 // Date: Sept. 4, 2018
 #include "vtkBackwardFlowLogic.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <string>
 
 //#include "itkThinPlateSplineKernelTransform.h"
 #include "itkThinPlateSplineExtended.h"
+#include "vtkTPSChainEvaluator.h"
+#include "vtkTPSFile.h"
+#include "vtkFarthestPointSampler.h"
+#include "vtkVertexCorrespondenceMapper.h"
+#include "vtkLegacySrep.h"
+#include "vtkSrepModel.h"
+#include "vtkEigenArrayBridge.h"
 #include "itkPointSet.h"
 //#include "itkTransformFileWriter.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkPolyDataReader.h"
 #include "vtkPolyData.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkMultiBlockDataSet.h"
 #include "vtkMath.h"
+#include "vtkSMPTools.h"
 
 #define EPS			1e-9
 #define PI			3.141592653589793
 #define EQZERO(x)	(fabs(x)<EPS)
 
-void vtkBackwardFlowLogic::runApplyTPS()
-{
-    
-}
-
-void vtkBackwardFlowLogic::computePairwiseTPS(vtkPolyData* polyData_source, vtkPolyData* polyData_target, const char* outputFileName)
+// TPS from the source to the target mesh, landmarks are every landmarkStep-th vertex of both meshes
+// the W matrix is not computed yet
+static itkThinPlateSplineExtended::Pointer NewPairwiseTPS(vtkPolyData* polyData_source, vtkPolyData* polyData_target, int landmarkStep)
 {
     typedef double CoordinateRepType;
 //	typedef itk::ThinPlateSplineKernelTransform< CoordinateRepType,3> TransformType;
@@ -46,7 +57,7 @@ void vtkBackwardFlowLogic::computePairwiseTPS(vtkPolyData* polyData_source, vtkP
 	PointIdType id_s = itk::NumericTraits< PointIdType >::Zero;
 	PointIdType id_t = itk::NumericTraits< PointIdType >::Zero;
 	// Read in the source points set
-	for(unsigned int i = 0; i < polyData_source->GetNumberOfPoints(); i += 10){
+	for(unsigned int i = 0; i < polyData_source->GetNumberOfPoints(); i += landmarkStep){
 		double p[3];
 		polyData_source->GetPoint(i,p);
 		p1[0] = p[0];
@@ -57,7 +68,7 @@ void vtkBackwardFlowLogic::computePairwiseTPS(vtkPolyData* polyData_source, vtkP
 	}
 
 	// Read in the target points set
-	for(unsigned int i = 0; i < polyData_target->GetNumberOfPoints(); i += 10){
+	for(unsigned int i = 0; i < polyData_target->GetNumberOfPoints(); i += landmarkStep){
 		double p[3];
 		polyData_target->GetPoint(i,p);
 		p2[0] = p[0];
@@ -70,189 +81,619 @@ void vtkBackwardFlowLogic::computePairwiseTPS(vtkPolyData* polyData_source, vtkP
 	TransformType::Pointer tps = TransformType::New();
 	tps->SetSourceLandmarks(sourceLandMarks);
 	tps->SetTargetLandmarks(targetLandMarks);
+	return tps;
+}
+
+vtkBackwardFlowLogic::vtkBackwardFlowLogic()
+    : landmarkErrorTarget(0)
+{
+}
+
+vtkBackwardFlowLogic::~vtkBackwardFlowLogic()
+{
+}
+
+void vtkBackwardFlowLogic::computePairwiseTPS(vtkPolyData* polyData_source, vtkPolyData* polyData_target, const char* outputFileName)
+{
+	itkThinPlateSplineExtended::Pointer tps = NewPairwiseTPS(polyData_source, polyData_target, 10);
 
 	cout<<"Computing W Matrix... "<<endl;
 	tps->ComputeWMatrix();
 	cout<<"Compute W Matrix finished!"<<endl;
 
-//	PointType pos;
-//	pos[0] = 0; pos[1] = 0; pos[2] = 0;
-//	PointType new_pos = tps->TransformPoint(pos);
-
-	// 1. write D matrix
-	itkThinPlateSplineExtended::DMatrixType D = tps->getDMatrix();
-
-	// 2. write A matrix
-	itkThinPlateSplineExtended::AMatrixType A = tps->getAMatrix();
-
-	// 3. write B vector
-	itkThinPlateSplineExtended::BMatrixType B = tps->getBVector();
-
-	std::ofstream fout;
-	fout.open(outputFileName);
-
-	if (fout)  {
-//        for (int i=0;i< featurematrix.size();i++){
-//            for (int j=0;j< featurematrix[i].size();j++)
-//                fout<< featurematrix[i][j]<<" ";
-//            fout<<endl;
-//        }
-		fout << D.rows() << "x" << D.cols() << "\n";
-		for(int i = 0; i < D.rows(); i++) {
-			for(int j = 0; j < D.cols(); j++) {
-				fout << D.get(i,j)<<",";
-			}
-			fout << "\n";
-		}
-
-		fout << A.rows() << "x" << A.cols() << "\n";
-		for(int i = 0; i < A.rows(); i++) {
-			for(int j = 0; j < A.cols(); j++) {
-				fout << A.get(i,j)<<",";
-			}
-			fout << "\n";
-		}
-
-		fout << B.size() << "\n";
-		for(int i = 0; i < B.size(); i++) {
-			fout << B.get(i)<<",";
-		}
-		fout << "\n";
-		//cout<<"Successfully saved to: "<<filename<<endl;
-	}
-	else {
-		cerr<<"Write out failed, cannot open the file!"<<endl;
-		fout.flush();
-		fout.close();
-		return;
-	}
+	// landmarks, D, A and B at full precision, see vtkTPSFile for the layout
+	vtkTPSFile::Write(tps, outputFileName);
+}
+void vtkBackwardFlowLogic::generateEllipsoidSrep(int numRow, int numCol, double ra, double rb, double rc, const char* outputPath)
+{
+    // the medial sheet of the ellipsoid (ra >= rb >= rc) is the ellipse with these radii
+    double mra = (ra*ra-rc*rc)/ra;
+    double mrb = (rb*rb-rc*rc)/rb;
+    const double ELLIPSE_SCALE = 0.9;
+    int halfRows = (numRow - 1) / 2;
+
+    vtkLegacySrep srep;
+    srep.SetGridSize(numRow, numCol);
+    double* hubs = srep.GetHubs();
+    double* directions = srep.GetSpokeDirections();
+    double* radii = srep.GetSpokeRadii();
+    for (int row = 0; row < numRow; ++row) {
+        for (int col = 0; col < numCol; ++col) {
+            int atom = row * numCol + col;
+            double x = 0;
+            double y = 0;
+            if (row == halfRows) {
+                x = 2*mra*col / (numCol-1) - mra;
+            } else {
+                x = 2*mra*(col+1) / (numCol + 1) - mra;
+            }
+            double t = halfRows > 0 ? double(row - halfRows) / halfRows : 0.0;
+            y = t * mrb*sqrt(std::max(0.0, 1-x*x/(mra*mra)));
+
+            x*=ELLIPSE_SCALE;
+            y*=ELLIPSE_SCALE;
+
+            double sinB = y*mra;
+            double cosB = x*mrb;
+            double l = sqrt(sinB*sinB + cosB*cosB);
+            if (!EQZERO(l)) {
+                sinB /= l;
+                cosB /= l;
+            }
+            double cosA = l/(mra*mrb);
+            double sinA = sqrt(std::max(0.0, 1-cosA*cosA));
+
+            double s[3] = {ra * cosA * cosB - x, rb * cosA * sinB - y, rc * sinA};
+            double cr[3] = {ra * cosB - x, rb * sinB - y, 0};
+            double len1 = vtkMath::Normalize(s);
+            double len2 = sqrt(cr[0]*cr[0] + cr[1]*cr[1]);
+            if (EQZERO(len2)) {
+                cr[2] = 1;
+            } else {
+                cr[0] /= len2;
+                cr[1] /= len2;
+            }
+
+            hubs[3*atom] = x;
+            hubs[3*atom+1] = y;
+            hubs[3*atom+2] = 0;
+            // spoke 0 points to -z, spoke 1 to +z
+            double* u = directions + 9*atom;
+            u[0] = s[0]; u[1] = s[1]; u[2] = -s[2];
+            u[3] = s[0]; u[4] = s[1]; u[5] = s[2];
+            u[6] = cr[0]; u[7] = cr[1]; u[8] = cr[2];
+            radii[3*atom] = len1;
+            radii[3*atom+1] = len1;
+            radii[3*atom+2] = srep.IsCrest(atom) ? len2 : 0;
+        }
+    }
+    srep.WriteM3D(outputPath);
+}
 
-	fout.close();
+// read one flow snapshot, NULL if the file has no points
+static vtkSmartPointer<vtkPolyData> ReadSnapshot(const std::string& fileName)
+{
+    vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+    reader->SetFileName(fileName.c_str());
+    reader->Update();
+    vtkSmartPointer<vtkPolyData> mesh = reader->GetOutput();
+    if(mesh == NULL || mesh->GetNumberOfPoints() == 0)
+    {
+        return NULL;
+    }
+    return mesh;
+}
 
+// every snapshot is a keyframe
+static void SetAllKeyframes(size_t nSnapshots, std::vector<size_t>& keyframes)
+{
+    keyframes.resize(nSnapshots);
+    for(size_t i = 0; i < nSnapshots; ++i)
+    {
+        keyframes[i] = i;
+    }
 }
-void vtkBackwardFlowLogic::generateEllipsoidSrep(int numRow, int numCol, double ra, double rb, double rc, const char* outputPath)
+
+// largest distance between the TPS image of the given vertices of the source mesh and
+// the same vertices of the target mesh
+static double WarpError(itkThinPlateSplineExtended* tps, vtkPolyData* source, vtkPolyData* target,
+                        const vtkIdType* ids, vtkIdType nIds)
+{
+    if(nIds == 0)
+    {
+        return 0.0;
+    }
+    vtkEigenArrayBridge::PointMatrixType warped(nIds, 3), expected(nIds, 3);
+    for(vtkIdType i = 0; i < nIds; ++i)
+    {
+        source->GetPoint(ids[i], warped.row(i).data());
+        target->GetPoint(ids[i], expected.row(i).data());
+    }
+    vtkTPSChainEvaluator evaluator;
+    evaluator.AppendTPS(tps);
+    evaluator.TransformPoints(vtkEigenArrayBridge::PointMatrixMap(warped.data(), nIds, 3));
+    return (warped - expected).rowwise().norm().maxCoeff();
+}
+
+// warp error on the held-out vertices, halfway between two landmarks taken every landmarkStep-th vertex
+static double HeldOutWarpError(itkThinPlateSplineExtended* tps, vtkPolyData* source, vtkPolyData* target, int landmarkStep)
+{
+    std::vector<vtkIdType> ids;
+    for(vtkIdType i = landmarkStep / 2; i < source->GetNumberOfPoints(); i += landmarkStep)
+    {
+        ids.push_back(i);
+    }
+    return WarpError(tps, source, target, ids.data(), static_cast<vtkIdType>(ids.size()));
+}
+
+// TPS from the source to the target mesh on the given vertices, the W matrix is not computed yet
+static itkThinPlateSplineExtended::Pointer NewLandmarkTPS(vtkPolyData* source, vtkPolyData* target,
+                                                           const vtkIdType* ids, vtkIdType nLandmarks)
+{
+    typedef itkThinPlateSplineExtended::PointSetType PointSetType;
+    PointSetType::Pointer sourceLandmarks = PointSetType::New();
+    PointSetType::Pointer targetLandmarks = PointSetType::New();
+    for(vtkIdType l = 0; l < nLandmarks; ++l)
+    {
+        double p[3], q[3];
+        source->GetPoint(ids[l], p);
+        target->GetPoint(ids[l], q);
+        itkThinPlateSplineExtended::InputPointType s, t;
+        for(int k = 0; k < 3; ++k)
+        {
+            s[k] = p[k];
+            t[k] = q[k];
+        }
+        sourceLandmarks->GetPoints()->InsertElement(l, s);
+        targetLandmarks->GetPoints()->InsertElement(l, t);
+    }
+    itkThinPlateSplineExtended::Pointer tps = itkThinPlateSplineExtended::New();
+    tps->SetSourceLandmarks(sourceLandmarks);
+    tps->SetTargetLandmarks(targetLandmarks);
+    return tps;
+}
+
+// smallest landmark set of the adaptive landmark selection
+const vtkIdType MIN_ADAPTIVE_LANDMARKS = 64;
+
+// solved TPS from the source to the target mesh on the fewest farthest point landmarks of the source mesh
+// whose warp error stays under errorTarget; the landmark count doubles from MIN_ADAPTIVE_LANDMARKS
+// With m landmarks, the error is measured on the next m vertices of the farthest point order,
+// i.e. on the vertices worst covered by the landmarks.
+static itkThinPlateSplineExtended::Pointer NewAdaptiveTPS(vtkPolyData* source, vtkPolyData* target, double errorTarget)
+{
+    vtkIdType n = source->GetNumberOfPoints();
+    std::vector<vtkIdType> order = vtkFarthestPointSampler::Order(source->GetPoints());
+    if(static_cast<vtkIdType>(order.size()) != n)
+    {
+        // no farthest point order: fall back to every 10th vertex
+        itkThinPlateSplineExtended::Pointer tps = NewPairwiseTPS(source, target, 10);
+        tps->ComputeWMatrix();
+        return tps;
+    }
+    vtkIdType nLandmarks = std::min(MIN_ADAPTIVE_LANDMARKS, n);
+    while(true)
+    {
+        itkThinPlateSplineExtended::Pointer tps = NewLandmarkTPS(source, target, order.data(), nLandmarks);
+        tps->ComputeWMatrix();
+        vtkIdType nHeldOut = std::min(nLandmarks, n - nLandmarks);
+        if(nHeldOut == 0 || WarpError(tps, source, target, order.data() + nLandmarks, nHeldOut) <= errorTarget)
+        {
+            return tps;
+        }
+        nLandmarks = std::min(2 * nLandmarks, n);
+    }
+}
+
+// solved TPS from the source to the target mesh
+// landmarkErrorTarget > 0: adaptive farthest point landmarks, otherwise every landmarkStep-th vertex
+static itkThinPlateSplineExtended::Pointer NewSolvedTPS(vtkPolyData* source, vtkPolyData* target,
+                                                         int landmarkStep, double landmarkErrorTarget)
+{
+    if(landmarkErrorTarget > 0)
+    {
+        return NewAdaptiveTPS(source, target, landmarkErrorTarget);
+    }
+    itkThinPlateSplineExtended::Pointer tps = NewPairwiseTPS(source, target, landmarkStep);
+    tps->ComputeWMatrix();
+    return tps;
+}
+
+// solve the TPS of a range of consecutive snapshot pairs
+// every task reads its own two snapshots and only writes its own slot of the chain
+class PairwiseTPSFunctor
+{
+public:
+    PairwiseTPSFunctor(const std::vector<std::string>& fileNames, int step, double errorTarget,
+                       std::vector<itkThinPlateSplineExtended::Pointer>& chain,
+                       std::vector<unsigned int>& iterations)
+        : snapshotFileNames(fileNames), landmarkStep(step), landmarkErrorTarget(errorTarget),
+          tpsChain(chain), iterationCounts(iterations) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            vtkSmartPointer<vtkPolyData> after = ReadSnapshot(snapshotFileNames[i + 1]);
+            vtkSmartPointer<vtkPolyData> before = ReadSnapshot(snapshotFileNames[i]);
+            if(after == NULL || before == NULL || after->GetNumberOfPoints() != before->GetNumberOfPoints())
+            {
+                continue;
+            }
+            itkThinPlateSplineExtended::Pointer tps = NewSolvedTPS(after, before, landmarkStep, landmarkErrorTarget);
+            tpsChain[i] = tps;
+            iterationCounts[i] = tps->getNumberOfIterations();
+        }
+    }
+
+private:
+    const std::vector<std::string>& snapshotFileNames;
+    int landmarkStep;
+    double landmarkErrorTarget;
+    std::vector<itkThinPlateSplineExtended::Pointer>& tpsChain;
+    std::vector<unsigned int>& iterationCounts;
+};
+
+bool vtkBackwardFlowLogic::computeBackwardTPSChain(const std::vector<std::string>& snapshotFileNames, int landmarkStep)
+{
+    tpsChain.clear();
+    keyframes.clear();
+    iterationCounts.clear();
+    if(snapshotFileNames.size() < 2 || landmarkStep < 1)
+    {
+        std::cerr << "The backward flow needs at least two snapshots and a positive landmark step" << std::endl;
+        return false;
+    }
+
+    // pairs are independent: one task per pair, idle threads steal the remaining pairs
+    vtkIdType nPairs = static_cast<vtkIdType>(snapshotFileNames.size()) - 1;
+    std::vector<itkThinPlateSplineExtended::Pointer> chain(nPairs);
+    std::vector<unsigned int> iterations(nPairs, 0);
+    PairwiseTPSFunctor functor(snapshotFileNames, landmarkStep, landmarkErrorTarget, chain, iterations);
+    vtkSMPTools::For(0, nPairs, 1, functor);
+
+    for(vtkIdType i = 0; i < nPairs; ++i)
+    {
+        if(chain[i].IsNull())
+        {
+            std::cerr << "Cannot compute the TPS from " << snapshotFileNames[i + 1]
+                      << " to " << snapshotFileNames[i] << std::endl;
+            return false;
+        }
+    }
+    tpsChain.swap(chain);
+    iterationCounts.swap(iterations);
+    SetAllKeyframes(tpsChain.size() + 1, keyframes);
+    return true;
+}
+
+bool vtkBackwardFlowLogic::computeBackwardTPSChainWarmStarted(const std::vector<std::string>& snapshotFileNames, int landmarkStep)
+{
+    tpsChain.clear();
+    keyframes.clear();
+    iterationCounts.clear();
+    if(snapshotFileNames.size() < 2 || landmarkStep < 1)
+    {
+        std::cerr << "The backward flow needs at least two snapshots and a positive landmark step" << std::endl;
+        return false;
+    }
+
+    size_t nPairs = snapshotFileNames.size() - 1;
+    std::vector<itkThinPlateSplineExtended::Pointer> chain(nPairs);
+    std::vector<unsigned int> iterations(nPairs, 0);
+    // the "after" mesh of a pair is the "before" mesh of the next one, so every snapshot is read once
+    vtkSmartPointer<vtkPolyData> before = ReadSnapshot(snapshotFileNames[0]);
+    for(size_t i = 0; i < nPairs; ++i)
+    {
+        vtkSmartPointer<vtkPolyData> after = ReadSnapshot(snapshotFileNames[i + 1]);
+        if(after == NULL || before == NULL || after->GetNumberOfPoints() != before->GetNumberOfPoints())
+        {
+            std::cerr << "Cannot compute the TPS from " << snapshotFileNames[i + 1]
+                      << " to " << snapshotFileNames[i] << std::endl;
+            return false;
+        }
+        itkThinPlateSplineExtended::Pointer tps;
+        if(landmarkErrorTarget > 0)
+        {
+            // adaptive landmarks differ from pair to pair: nothing to start from
+            tps = NewAdaptiveTPS(after, before, landmarkErrorTarget);
+        }
+        else
+        {
+            tps = NewPairwiseTPS(after, before, landmarkStep);
+            tps->setSolver(itkThinPlateSplineExtended::IterativeSolver);
+            // consecutive snapshots move little, the previous coefficients are close to the solution
+            if(i > 0)
+            {
+                tps->setInitialDMatrix(chain[i - 1]->getDMatrix());
+            }
+            tps->ComputeWMatrix();
+        }
+        chain[i] = tps;
+        iterations[i] = tps->getNumberOfIterations();
+        before = after;
+    }
+
+    unsigned long totalIterations = 0;
+    for(size_t i = 0; i < nPairs; ++i)
+    {
+        totalIterations += iterations[i];
+    }
+    std::cout << "Warm-started backward flow: " << nPairs << " TPS, " << totalIterations
+              << " iterations in total, " << iterations[0] << " for the cold-started first pair" << std::endl;
+
+    tpsChain.swap(chain);
+    iterationCounts.swap(iterations);
+    SetAllKeyframes(tpsChain.size() + 1, keyframes);
+    return true;
+}
+
+bool vtkBackwardFlowLogic::computeBackwardTPSChainKeyframes(const std::vector<std::string>& snapshotFileNames,
+                                                            double tolerance, int landmarkStep)
+{
+    tpsChain.clear();
+    keyframes.clear();
+    iterationCounts.clear();
+    if(snapshotFileNames.size() < 2 || landmarkStep < 2 || tolerance < 0)
+    {
+        std::cerr << "The keyframe backward flow needs at least two snapshots, a landmark step of at least 2"
+                  << " and a non-negative tolerance" << std::endl;
+        return false;
+    }
+
+    const size_t last = snapshotFileNames.size() - 1;
+    size_t nSolves = 0;
+    size_t keyframe = 0;
+    // the flow changes slowly: the search starts at the span between the last two keyframes
+    size_t span = 1;
+    vtkSmartPointer<vtkPolyData> keyframeMesh = ReadSnapshot(snapshotFileNames[0]);
+    keyframes.push_back(0);
+    while(keyframe < last)
+    {
+        vtkSmartPointer<vtkPolyData> acceptedMesh;
+        itkThinPlateSplineExtended::Pointer acceptedTPS;
+        size_t accepted = keyframe;
+        size_t rejected = last + 1;
+        size_t stride = span;
+        // gallop: keyframe + span, + 2 span, + 4 span, ... until a snapshot is too far, then bisect
+        while(rejected - accepted > 1)
+        {
+            size_t candidate = rejected > last ? std::min(keyframe + stride, last) : accepted + (rejected - accepted) / 2;
+            vtkSmartPointer<vtkPolyData> candidateMesh = ReadSnapshot(snapshotFileNames[candidate]);
+            if(keyframeMesh == NULL || candidateMesh == NULL
+                    || candidateMesh->GetNumberOfPoints() != keyframeMesh->GetNumberOfPoints())
+            {
+                std::cerr << "Cannot compute the TPS from " << snapshotFileNames[candidate]
+                          << " to " << snapshotFileNames[keyframe] << std::endl;
+                tpsChain.clear();
+                keyframes.clear();
+                iterationCounts.clear();
+                return false;
+            }
+            itkThinPlateSplineExtended::Pointer tps = NewSolvedTPS(candidateMesh, keyframeMesh, landmarkStep, landmarkErrorTarget);
+            ++nSolves;
+            if(candidate == keyframe + 1 || HeldOutWarpError(tps, candidateMesh, keyframeMesh, landmarkStep) <= tolerance)
+            {
+                accepted = candidate;
+                acceptedMesh = candidateMesh;
+                acceptedTPS = tps;
+                if(candidate == last)
+                {
+                    break;
+                }
+                stride *= 2;
+            }
+            else
+            {
+                rejected = candidate;
+            }
+        }
+        tpsChain.push_back(acceptedTPS);
+        iterationCounts.push_back(acceptedTPS->getNumberOfIterations());
+        keyframes.push_back(accepted);
+        span = accepted - keyframe;
+        keyframe = accepted;
+        keyframeMesh = acceptedMesh;
+    }
+
+    std::cout << "Backward flow keyframes: " << keyframes.size() << " of " << snapshotFileNames.size()
+              << " snapshots, " << nSolves << " TPS solves" << std::endl;
+    return true;
+}
+
+// spoke lines of the up, down and crest spokes of an s-rep
+// points 2i and 2i+1 of the spoke lines are the hub and the tip of spoke i
+static void NewSrepSpokeLines(vtkMultiBlockDataSet* srep, vtkSmartPointer<vtkPolyData> lines[3])
+{
+    for(unsigned int b = 0; b < 3; ++b)
+    {
+        lines[b] = vtkSrepModel::NewSpokeLines(vtkPolyData::SafeDownCast(srep->GetBlock(b)));
+    }
+}
+
+// s-rep with the hubs and tips of moved spoke lines and the connectivity and grid of the original s-rep
+static vtkSmartPointer<vtkMultiBlockDataSet> NewSrepFromSpokeLines(vtkMultiBlockDataSet* srep, vtkSmartPointer<vtkPolyData> lines[3])
+{
+    vtkSmartPointer<vtkPolyData> blocks[3];
+    for(unsigned int b = 0; b < 3; ++b)
+    {
+        vtkPolyData* spokes = vtkPolyData::SafeDownCast(srep->GetBlock(b));
+        vtkEigenArrayBridge::PointMatrixType buffer;
+        vtkEigenArrayBridge::ConstPointMatrixMap pts = vtkEigenArrayBridge::ReadPoints(lines[b]->GetPoints(), buffer);
+        vtkIdType nSpokes = spokes->GetNumberOfPoints();
+        vtkSmartPointer<vtkPoints> hubs = vtkSmartPointer<vtkPoints>::New();
+        hubs->SetDataTypeToDouble();
+        hubs->SetNumberOfPoints(nSpokes);
+        vtkEigenArrayBridge::PointMatrixMap hubPts = vtkEigenArrayBridge::MapPoints(hubs);
+        hubPts = Eigen::Map<const vtkEigenArrayBridge::PointMatrixType, Eigen::Unaligned, Eigen::OuterStride<> >(
+                    pts.data(), nSpokes, 3, Eigen::OuterStride<>(6));
+
+        blocks[b] = vtkSrepModel::NewSpokes(hubs, lines[b]->GetPoints());
+        blocks[b]->SetPolys(spokes->GetPolys());
+        blocks[b]->SetLines(spokes->GetLines());
+    }
+    return vtkSrepModel::New(blocks[vtkSrepModel::UpBlock], blocks[vtkSrepModel::DownBlock], blocks[vtkSrepModel::CrestBlock],
+                             vtkSrepModel::GetNumberOfRows(srep), vtkSrepModel::GetNumberOfColumns(srep));
+}
+
+// points of several spoke line sets gathered in one matrix, so that every transform goes over all of them at once
+static vtkEigenArrayBridge::PointMatrixType GatherPoints(const vtkSmartPointer<vtkPolyData>* lines, size_t nLines)
+{
+    vtkIdType nPoints = 0;
+    for(size_t l = 0; l < nLines; ++l)
+    {
+        nPoints += lines[l]->GetNumberOfPoints();
+    }
+    vtkEigenArrayBridge::PointMatrixType pts(nPoints, 3);
+    vtkEigenArrayBridge::PointMatrixType buffer;
+    vtkIdType offset = 0;
+    for(size_t l = 0; l < nLines; ++l)
+    {
+        vtkIdType n = lines[l]->GetNumberOfPoints();
+        if(n > 0)
+        {
+            pts.middleRows(offset, n) = vtkEigenArrayBridge::ReadPoints(lines[l]->GetPoints(), buffer);
+        }
+        offset += n;
+    }
+    return pts;
+}
+
+// copy the gathered points back to their spoke lines
+static void ScatterPoints(const vtkEigenArrayBridge::PointMatrixType& pts, vtkSmartPointer<vtkPolyData>* lines, size_t nLines)
+{
+    vtkIdType offset = 0;
+    for(size_t l = 0; l < nLines; ++l)
+    {
+        vtkIdType n = lines[l]->GetNumberOfPoints();
+        if(n > 0)
+        {
+            vtkEigenArrayBridge::MapPoints(lines[l]->GetPoints()) = pts.middleRows(offset, n);
+        }
+        offset += n;
+    }
+}
+
+// carry a batch of s-reps through a TPS chain: the hubs and tips of all the s-reps are evaluated together
+static std::vector<vtkSmartPointer<vtkMultiBlockDataSet> > TransformSreps(const vtkTPSChainEvaluator& evaluator,
+                                                                          const std::vector<vtkMultiBlockDataSet*>& sreps)
+{
+    std::vector<vtkSmartPointer<vtkMultiBlockDataSet> > results;
+    for(size_t s = 0; s < sreps.size(); ++s)
+    {
+        if(!vtkSrepModel::IsValid(sreps[s]))
+        {
+            std::cerr << "S-rep " << s << " of the batch is invalid" << std::endl;
+            return results;
+        }
+    }
+    std::vector<vtkSmartPointer<vtkPolyData> > lines(3 * sreps.size());
+    for(size_t s = 0; s < sreps.size(); ++s)
+    {
+        NewSrepSpokeLines(sreps[s], &lines[3 * s]);
+    }
+    vtkEigenArrayBridge::PointMatrixType pts = GatherPoints(lines.data(), lines.size());
+    evaluator.TransformPoints(vtkEigenArrayBridge::PointMatrixMap(pts.data(), pts.rows(), 3));
+    ScatterPoints(pts, lines.data(), lines.size());
+    for(size_t s = 0; s < sreps.size(); ++s)
+    {
+        results.push_back(NewSrepFromSpokeLines(sreps[s], &lines[3 * s]));
+    }
+    return results;
+}
+
+std::vector<vtkSmartPointer<vtkMultiBlockDataSet> > vtkBackwardFlowLogic::runApplyTPS(
+        const std::vector<std::string>& tpsFileNames, const std::vector<vtkMultiBlockDataSet*>& sreps)
+{
+    std::vector<vtkSmartPointer<vtkMultiBlockDataSet> > results;
+    if(tpsFileNames.empty() || sreps.empty())
+    {
+        std::cerr << "runApplyTPS needs a TPS chain and at least one s-rep" << std::endl;
+        return results;
+    }
+
+    // every TPS file is mapped once for the whole batch and evaluated in place
+    std::vector<vtkTPSFile> files(tpsFileNames.size());
+    vtkTPSChainEvaluator evaluator;
+    for(size_t t = tpsFileNames.size(); t > 0; --t)
+    {
+        if(!files[t - 1].Open(tpsFileNames[t - 1]))
+        {
+            return results;
+        }
+        evaluator.AppendTPS(files[t - 1]);
+    }
+    return TransformSreps(evaluator, sreps);
+}
+
+bool vtkBackwardFlowLogic::writeBackwardTPSChain(const std::string& directory, std::vector<std::string>& tpsFileNames) const
+{
+    tpsFileNames.clear();
+    if(tpsChain.empty())
+    {
+        std::cerr << "No TPS chain to write" << std::endl;
+        return false;
+    }
+    for(size_t t = 0; t < tpsChain.size(); ++t)
+    {
+        char fileName[32];
+        sprintf(fileName, "/backward_tps#%04d.tps", static_cast<int>(t));
+        std::string tpsFileName = directory + fileName;
+        if(!vtkTPSFile::Write(tpsChain[t], tpsFileName))
+        {
+            std::cerr << "Cannot write the TPS file " << tpsFileName << std::endl;
+            tpsFileNames.clear();
+            return false;
+        }
+        tpsFileNames.push_back(tpsFileName);
+    }
+    return true;
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkBackwardFlowLogic::applyBackwardTPSChain(vtkMultiBlockDataSet* srep)
+{
+    if(tpsChain.empty() || !vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "No TPS chain or invalid s-rep to carry back" << std::endl;
+        return NULL;
+    }
+
+    // the chain runs from the last snapshot to the first one
+    vtkTPSChainEvaluator evaluator;
+    for(size_t t = tpsChain.size(); t > 0; --t)
+    {
+        evaluator.AppendTPS(tpsChain[t - 1]);
+    }
+
+    return TransformSreps(evaluator, std::vector<vtkMultiBlockDataSet*>(1, srep))[0];
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkBackwardFlowLogic::mapBackwardByCorrespondence(
+        const std::vector<std::string>& snapshotFileNames, vtkMultiBlockDataSet* srep)
 {
-//    using namespace std;
-//    ofstream fout(outputPath);
-//    if (!fout.is_open()) {
-//            cout << "File access failure!" <<endl;
-//            return;
-//    }
-
-//    double mra = (ra*ra-rc*rc)/ra;
-//    double mrb = (rb*rb-rc*rc)/rb;
-
-//    fout << "model {" << endl
-//             << "\tfigureCount = 1;" << endl
-//             << "\tname = default;" << endl;
-//    fout << "\tfigureTrees {" << endl
-//             << "\t\tcount = 1;" << endl
-//             << "\t\ttree[0] {" << endl
-//             << "\t\t\tattachmentMode = 0;" << endl
-//             << "\t\t\tblendAmount = 0;" << endl
-//             << "\t\t\tblendExtent = 0;" << endl
-//             << "\t\t\tchildCount = 0;" << endl
-//             << "\t\t\tfigureId = 0;" << endl
-//             << "\t\t\tlinkCount = 0;" << endl
-//             << "\t\t}" << endl
-//             << "\t}" << endl;
-//    fout << "\tfigure[0] {" << endl
-//             << "\t\tnumRows = " << numRow << ";" << endl
-//             << "\t\tnumColumns = " << numCol << ";" << endl
-//             << "\t\tnumLandmarks = 0;" << endl
-//             << "\t\tpositivePolarity = 1;" << endl
-//             << "\t\tpositiveSpace = 1;" << endl
-//             << "\t\tsmoothness = 50;" << endl
-//             << "\t\ttype = QuadFigure;" << endl;
-//    fout << "\t\tcolor {" << endl
-//             << "\t\t\tblue = 0;" << endl
-//             << "\t\t\tgreen = 1;" << endl
-//             << "\t\t\tred = 0;" << endl
-//             << "\t\t}" << endl;
-
-//    double ELLIPSE_SCALE = 0.9;
-//    for (int row = 0; row < numRow; ++row) {
-//            for (int col = 0; col < numCol; ++col) {
-//                    fout << "\t\tprimitive[" << row << "][" << col << "] {" << endl;
-//                    fout << "\t\t\tselected = 1;" << endl;
-//                    if (row == 0 || row == numRow-1 || col == 0 || col == numCol-1) {
-//                            fout << "\t\t\ttype = EndPrimitive;" << endl;
-//                    } else {
-//                            fout << "\t\t\ttype = StandardPrimitive;" << endl;
-//                    }
-
-//                    double x = 0;
-//                    double y = 0;
-//                    double z = 0;
-
-//                    if (row == 1) {
-//                            x = 2*mra*col / (numCol-1) - mra;
-//                    } else {
-//                            x = 2*mra*(col+1) / (numCol + 1) - mra;
-//                    }
-//                    y = (row - 1) * mrb*sqrt(1-x*x/(mra*mra));
-
-//                    x*=ELLIPSE_SCALE;
-//                    y*=ELLIPSE_SCALE;
-
-////                    fout << "\t\t\tx = " << transform(x) << ";" << endl
-////                             << "\t\t\ty = " << transform(y) << ";" << endl
-////                             << "\t\t\tz = " << transform(z) << ";" << endl;
-
-//                    double sinB = y*mra;
-//                    double cosB = x*mrb;
-//                    double l = normalize2(sinB, cosB);
-//                    double cosA = l/(mra*mrb);
-//                    double sinA = sqrt(1-cosA*cosA+EPS);
-
-//                    double sx = ra * cosA * cosB - x;
-//                    double sy = rb * cosA * sinB - y;
-//                    double sz = rc * sinA ;
-
-//                    double cx = ra * cosB - x;
-//                    double cy = rb * sinB - y;
-//                    double cz = 0;
-
-//                    double len1 = normalize3(sx,sy,sz);
-//                    double len2 = normalize2(cx,cy);
-//                    if (EQZERO(len2)) cz = 1;
-
-//                    fout << "\t\t\tux[0] = " << sx << ";" << endl
-//                             << "\t\t\tux[1] = " << sx << ";" << endl
-//                             << "\t\t\tux[2] = " << cx << ";" << endl
-//                             << "\t\t\tuy[0] = " << sy << ";" << endl
-//                             << "\t\t\tuy[1] = " << sy << ";" << endl
-//                             << "\t\t\tuy[2] = " << cy << ";" << endl
-//                             << "\t\t\tuz[0] = " <<-sz << ";" << endl
-//                             << "\t\t\tuz[1] = " << sz << ";" << endl
-//                             << "\t\t\tuz[2] = " << cz << ";" << endl;
-
-//                    fout << "\t\t\tr[0] = " << scale(len1) << ";" << endl
-//                             << "\t\t\tr[1] = " << scale(len1) << ";" << endl;
-//                    if (row == 0 || row == numRow-1 || col == 0 || col == numCol-1) {
-//                            fout << "\t\t\tr[2] = " << scale(len2) << ";" << endl;
-//                    }
-
-//                    fout << "\t\t}" << endl;
-//            }
-//    }
-
-//    fout << "\t}" << endl;
-//    fout << "\ttransformation {" << endl
-//             << "\t\tscale = 1;" << endl
-//             << "\t\trotation {" << endl
-//             << "\t\t\tw = 1;" << endl
-//             << "\t\t\tx = 0;" << endl
-//             << "\t\t\ty = 0;" << endl
-//             << "\t\t\tz = 0;" << endl
-//             << "\t\t}" << endl
-//             << "\t\ttranslation {" << endl
-//             << "\t\t\tx = 0;" << endl
-//             << "\t\t\ty = 0;" << endl
-//             << "\t\t\tz = 0;" << endl
-//             << "\t\t}" << endl
-//             << "\t}" << endl;
-//    fout << "}" << endl;
-//    fout.flush();
-//    fout.close();
+    if(snapshotFileNames.size() < 2 || !vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "The backward mapping needs at least two snapshots and a valid s-rep" << std::endl;
+        return NULL;
+    }
+
+    // hubs and tips of the three blocks in one matrix, so that every snapshot is searched once
+    vtkSmartPointer<vtkPolyData> lines[3];
+    NewSrepSpokeLines(srep, lines);
+    vtkEigenArrayBridge::PointMatrixType pts = GatherPoints(lines, 3);
+
+    // the flow keeps the vertices: anchored once in the last snapshot, the points are rebuilt
+    // directly on the input mesh, the snapshots in between are not needed
+    vtkSmartPointer<vtkPolyData> last = ReadSnapshot(snapshotFileNames.back());
+    vtkSmartPointer<vtkPolyData> first = ReadSnapshot(snapshotFileNames.front());
+    vtkEigenArrayBridge::PointMatrixMap ptsMap(pts.data(), pts.rows(), 3);
+    vtkVertexCorrespondenceMapper mapper;
+    if(!mapper.Anchor(last, ptsMap) || !mapper.Rebuild(first, ptsMap))
+    {
+        std::cerr << "Cannot map the s-rep from " << snapshotFileNames.back() << " to " << snapshotFileNames.front() << std::endl;
+        return NULL;
+    }
+
+    ScatterPoints(pts, lines, 3);
+    return NewSrepFromSpokeLines(srep, lines);
 }
@@ -4,14 +4,101 @@
 #ifndef __vtkBackwardFlowLogic_h
 #define __vtkBackwardFlowLogic_h
 
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
 class vtkPolyData;
+class vtkMultiBlockDataSet;
+class itkThinPlateSplineExtended;
+namespace itk
+{
+template <class TObjectType> class SmartPointer;
+}
 class vtkBackwardFlowLogic {
 public:
-    vtkBackwardFlowLogic(){}
-    ~vtkBackwardFlowLogic(){}
+    vtkBackwardFlowLogic();
+    ~vtkBackwardFlowLogic();
 
-    void runApplyTPS();
+    // carry a batch of s-reps of one subject (e.g. different grids or perturbed s-reps) back through
+    // the subject's TPS chain, stored in TPS files (vtkTPSFile) where tpsFileNames[i] maps keyframe i+1
+    // to keyframe i (see writeBackwardTPSChain). The files are mapped once and the hubs and tips of all the s-reps go through
+    // every TPS together.
+    // return the carried s-reps in the order of the batch, none if a file cannot be read or an s-rep is invalid
+    std::vector<vtkSmartPointer<vtkMultiBlockDataSet> > runApplyTPS(const std::vector<std::string>& tpsFileNames,
+                                                                    const std::vector<vtkMultiBlockDataSet*>& sreps);
+    // write the TPS from afterFlow to beforeFlow in the binary TPS format of vtkTPSFile
     void computePairwiseTPS(vtkPolyData* afterFlow, vtkPolyData* beforeFlow, const char* outputFileName);
     void generateEllipsoidSrep(int numRow, int numCol, double ra, double rb, double rc, const char* outputPath);
+
+    // landmarks of the TPS between snapshots
+    // 0 (default): every landmarkStep-th vertex
+    // > 0: farthest point samples of the later snapshot, as few as meet this warp error (in mesh units)
+    void setLandmarkErrorTarget(double errorTarget) {landmarkErrorTarget = errorTarget;}
+    double getLandmarkErrorTarget() const {return landmarkErrorTarget;}
+
+    // compute the TPS of every consecutive pair of snapshots, from snapshot i+1 back to snapshot i
+    // snapshotFileNames[0] is the object before the flow, snapshotFileNames[i] the i-th forward flow output
+    // The pairs are independent and solved concurrently; each task reads its two snapshots and keeps
+    // only the TPS (landmarks and coefficients), so at most two meshes per thread are in memory.
+    // input[landmarkStep]: every landmarkStep-th vertex is a landmark
+    // return false if a snapshot cannot be read or two snapshots have different numbers of points
+    bool computeBackwardTPSChain(const std::vector<std::string>& snapshotFileNames, int landmarkStep = 10);
+
+    // same chain, but the pairs are solved one after the other with the iterative TPS solver,
+    // every solve starting from the coefficients of the previous pair instead of from zero
+    // Consecutive snapshots differ little, so the warm start saves iterations on large landmark sets.
+    // Adaptive landmarks change from pair to pair, their solves are not warm-started.
+    bool computeBackwardTPSChainWarmStarted(const std::vector<std::string>& snapshotFileNames, int landmarkStep = 10);
+
+    // chain over keyframes only: from the current keyframe, the TPS is fitted directly to the farthest
+    // later snapshot whose warp error stays under the tolerance, found by galloping from the span
+    // between the last two keyframes, then bisecting
+    // The error is the largest distance between the TPS image of a held-out vertex (halfway between
+    // two landmarks) of the later snapshot and the same vertex of the keyframe.
+    // The first and the last snapshots are always keyframes; consecutive snapshots are always accepted.
+    // input[tolerance]: largest warp error, in the units of the meshes
+    // input[landmarkStep]: every landmarkStep-th vertex is a landmark, at least 2 to leave held-out vertices
+    bool computeBackwardTPSChainKeyframes(const std::vector<std::string>& snapshotFileNames, double tolerance,
+                                          int landmarkStep = 10);
+
+    // write every TPS of the chain to directory/backward_tps#<i>.tps in the binary format of vtkTPSFile
+    // output[tpsFileNames]: the files in the order runApplyTPS reads them
+    // return false if the chain is empty or a file cannot be written
+    bool writeBackwardTPSChain(const std::string& directory, std::vector<std::string>& tpsFileNames) const;
+
+    // carry an s-rep fitted to the last snapshot back to the object before the flow
+    // through the TPS chain; hubs and spoke tips are transformed, spokes recomputed from them
+    // return NULL if the chain is empty or the s-rep invalid
+    vtkSmartPointer<vtkMultiBlockDataSet> applyBackwardTPSChain(vtkMultiBlockDataSet* srep);
+
+    // carry an s-rep fitted to the last snapshot back to the object before the flow without any TPS:
+    // the flow keeps the vertices, so hubs and spoke tips are anchored once to their closest triangle of the
+    // last snapshot and rebuilt on the same triangle of the first one (see vtkVertexCorrespondenceMapper)
+    // The cost is one triangle hierarchy over the last snapshot plus one query per point.
+    // return NULL if a snapshot cannot be read, the snapshots differ in vertices or the s-rep is invalid
+    vtkSmartPointer<vtkMultiBlockDataSet> mapBackwardByCorrespondence(const std::vector<std::string>& snapshotFileNames,
+                                                                      vtkMultiBlockDataSet* srep);
+
+    // number of TPS in the chain (number of keyframes - 1)
+    size_t getNumberOfTPS() const {return tpsChain.size();}
+
+    // indices of the snapshots the chain goes through, every snapshot unless keyframes are selected
+    const std::vector<size_t>& getKeyframes() const {return keyframes;}
+
+    // iterations of the iterative solver for every TPS of the chain (0 for dense solves)
+    const std::vector<unsigned int>& getIterationCounts() const {return iterationCounts;}
+
+private:
+    vtkBackwardFlowLogic(const vtkBackwardFlowLogic&); // Not implemented
+    void operator=(const vtkBackwardFlowLogic&); // Not implemented
+
+    // tpsChain[i] maps snapshot keyframes[i+1] to snapshot keyframes[i]
+    std::vector<itk::SmartPointer<itkThinPlateSplineExtended> > tpsChain;
+    std::vector<size_t> keyframes;
+    std::vector<unsigned int> iterationCounts;
+    double landmarkErrorTarget;
 };
 #endif
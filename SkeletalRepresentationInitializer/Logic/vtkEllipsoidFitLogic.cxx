@@ -0,0 +1,128 @@
+// This class provides the best fitting ellipsoid of a surface mesh
+#include "vtkEllipsoidFitLogic.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+
+vtkEllipsoidFitLogic::vtkEllipsoidFitLogic()
+    : center(Eigen::Vector3d::Zero()),
+      rotation(Eigen::Matrix3d::Identity()),
+      radii(Eigen::Vector3d::Zero()),
+      volume(0.0)
+{
+}
+
+bool vtkEllipsoidFitLogic::Fit(vtkPolyData* mesh)
+{
+    using namespace Eigen;
+    if(mesh == NULL || mesh->GetPolys() == NULL || mesh->GetNumberOfPoints() == 0)
+    {
+        return false;
+    }
+
+    // integrate relative to the center of bounding box to keep the sums well conditioned
+    double bounds[6];
+    mesh->GetBounds(bounds);
+    Vector3d origin((bounds[0] + bounds[1]) / 2, (bounds[2] + bounds[3]) / 2, (bounds[4] + bounds[5]) / 2);
+
+    // zero, first and second moments of the enclosed solid (signed tetrahedra against the origin)
+    double vol = 0.0;
+    Vector3d volFirst = Vector3d::Zero();
+    Matrix3d volSecond = Matrix3d::Zero();
+    // same moments of the surface itself, used if the mesh is not closed
+    double area = 0.0;
+    Vector3d areaFirst = Vector3d::Zero();
+    Matrix3d areaSecond = Matrix3d::Zero();
+
+    vtkPoints* points = mesh->GetPoints();
+    vtkCellArray* polys = mesh->GetPolys();
+    vtkSmartPointer<vtkIdList> ptIds = vtkSmartPointer<vtkIdList>::New();
+    polys->InitTraversal();
+    while(polys->GetNextCell(ptIds))
+    {
+        vtkIdType npts = ptIds->GetNumberOfIds();
+        if(npts < 3)
+        {
+            continue;
+        }
+        double p[3];
+        points->GetPoint(ptIds->GetId(0), p);
+        Vector3d a = Vector3d(p[0], p[1], p[2]) - origin;
+        // fan triangulation of the polygon
+        for(vtkIdType k = 1; k + 1 < npts; ++k)
+        {
+            points->GetPoint(ptIds->GetId(k), p);
+            Vector3d b = Vector3d(p[0], p[1], p[2]) - origin;
+            points->GetPoint(ptIds->GetId(k + 1), p);
+            Vector3d c = Vector3d(p[0], p[1], p[2]) - origin;
+
+            Vector3d s = a + b + c;
+            Matrix3d outer = a * a.transpose() + b * b.transpose() + c * c.transpose() + s * s.transpose();
+
+            // tetrahedron (origin, a, b, c)
+            double v = a.dot(b.cross(c)) / 6.0;
+            vol += v;
+            volFirst += v / 4.0 * s;
+            volSecond += v / 20.0 * outer;
+
+            // triangle (a, b, c)
+            double t = 0.5 * (b - a).cross(c - a).norm();
+            area += t;
+            areaFirst += t / 3.0 * s;
+            areaSecond += t / 12.0 * outer;
+        }
+    }
+    if(area <= 0.0)
+    {
+        return false;
+    }
+
+    // a closed surface encloses a volume comparable to area^1.5, an open one almost nothing
+    bool isClosed = std::fabs(vol) > 1e-6 * std::pow(area, 1.5);
+    Matrix3d covariance;
+    double radiusFactor;
+    if(isClosed)
+    {
+        // dividing by the signed volume also handles inward oriented triangles
+        Vector3d mean = volFirst / vol;
+        covariance = volSecond / vol - mean * mean.transpose();
+        center = mean + origin;
+        volume = std::fabs(vol);
+        // solid ellipsoid: variance along an axis is r^2 / 5
+        radiusFactor = 5.0;
+    }
+    else
+    {
+        Vector3d mean = areaFirst / area;
+        covariance = areaSecond / area - mean * mean.transpose();
+        center = mean + origin;
+        volume = 0.0;
+        // thin shell: variance along an axis is about r^2 / 3
+        radiusFactor = 3.0;
+    }
+
+    SelfAdjointEigenSolver<Matrix3d> es(covariance);
+    rotation = es.eigenvectors();
+    Vector3d eigenvalues = es.eigenvalues();
+    for(int i = 0; i < 3; ++i)
+    {
+        radii(i) = std::sqrt(std::max(radiusFactor * eigenvalues(i), 0.0));
+    }
+
+    // remove the residual scale difference between the object and the ellipsoid
+    double ellipsoid_volume = 4 / 3.0 * vtkMath::Pi() * radii(0) * radii(1) * radii(2);
+    if(isClosed && ellipsoid_volume > 0)
+    {
+        radii *= std::pow(volume / ellipsoid_volume, 1.0 / 3.0);
+    }
+    return true;
+}
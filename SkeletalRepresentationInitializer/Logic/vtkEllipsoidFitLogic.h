@@ -0,0 +1,39 @@
+// This class provides the best fitting ellipsoid of a surface mesh
+// The fit matches the second moments of the solid bounded by the mesh,
+// which are exact integrals over the triangles, hence independent of
+// how densely (or unevenly) the surface is sampled.
+#ifndef __vtkEllipsoidFitLogic_h
+#define __vtkEllipsoidFitLogic_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// Eigen includes
+#include <Eigen/Dense>
+
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkEllipsoidFitLogic {
+public:
+    vtkEllipsoidFitLogic();
+    ~vtkEllipsoidFitLogic(){}
+
+    // compute the fitting ellipsoid of the mesh
+    // closed meshes use volume moments; open meshes fall back to area-weighted surface moments
+    // return false if the mesh has no polygon with non zero area
+    bool Fit(vtkPolyData* mesh);
+
+    // center of the ellipsoid
+    const Eigen::Vector3d& GetCenter() const {return center;}
+    // 3 by 3 rotation, column i is the axis of radius i
+    const Eigen::Matrix3d& GetRotation() const {return rotation;}
+    // radii in ascending order, scaled so that the ellipsoid has the volume of the mesh
+    const Eigen::Vector3d& GetRadii() const {return radii;}
+    // volume enclosed by the mesh (0 if the mesh is open)
+    double GetVolume() const {return volume;}
+
+private:
+    Eigen::Vector3d center;
+    Eigen::Matrix3d rotation;
+    Eigen::Vector3d radii;
+    double volume;
+};
+#endif
@@ -0,0 +1,103 @@
+// This class provides farthest point sampling of mesh vertices
+#include "vtkFarthestPointSampler.h"
+#include "vtkEigenArrayBridge.h"
+
+// VTK includes
+#include <vtkPoints.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+std::vector<vtkIdType> vtkFarthestPointSampler::Order(vtkPoints* points, vtkIdType nSamples)
+{
+    std::vector<vtkIdType> order;
+    if(points == NULL || points->GetNumberOfPoints() == 0 || nSamples == 0)
+    {
+        return order;
+    }
+    vtkEigenArrayBridge::PointMatrixType buffer;
+    vtkEigenArrayBridge::ConstPointMatrixMap pts = vtkEigenArrayBridge::ReadPoints(points, buffer);
+    vtkIdType n = pts.rows();
+    if(nSamples < 0 || nSamples > n)
+    {
+        nSamples = n;
+    }
+
+    // about 8 cells per point: a surface mesh fills few of them, with a handful of points each
+    Eigen::RowVector3d lower = pts.colwise().minCoeff();
+    Eigen::RowVector3d extent = pts.colwise().maxCoeff() - lower;
+    double cellSize = std::max(extent.maxCoeff() / (2.0 * std::cbrt(static_cast<double>(n))), 1e-12);
+    Eigen::Array3i dims = ((extent.array() / cellSize).floor().cast<int>() + 1).transpose();
+    std::vector<vtkIdType> cellStart(static_cast<size_t>(dims.prod()) + 1, 0);
+    std::vector<vtkIdType> cellPoints(n);
+    std::vector<int> cellOf(n);
+    for(vtkIdType i = 0; i < n; ++i)
+    {
+        Eigen::Array3i c = ((pts.row(i) - lower).array() / cellSize).floor().cast<int>().transpose().min(dims - 1);
+        cellOf[i] = (c(2) * dims(1) + c(1)) * dims(0) + c(0);
+        ++cellStart[cellOf[i] + 1];
+    }
+    // counting sort of the points by cell
+    for(size_t c = 1; c < cellStart.size(); ++c)
+    {
+        cellStart[c] += cellStart[c - 1];
+    }
+    std::vector<vtkIdType> fill(cellStart.begin(), cellStart.end() - 1);
+    for(vtkIdType i = 0; i < n; ++i)
+    {
+        cellPoints[fill[cellOf[i]]++] = i;
+    }
+
+    // distance of every point to the chosen points; a max-heap with lazy deletion of stale entries
+    std::vector<double> distance(n, std::numeric_limits<double>::infinity());
+    std::priority_queue<std::pair<double, vtkIdType> > farthest;
+    vtkIdType sample = 0;
+    double radius = extent.norm() + cellSize;
+    order.reserve(nSamples);
+    while(true)
+    {
+        order.push_back(sample);
+        distance[sample] = 0;
+        if(static_cast<vtkIdType>(order.size()) == nSamples)
+        {
+            break;
+        }
+        // only the points closer to the new sample than the covering radius can get closer
+        Eigen::Array3d p = pts.row(sample).transpose().array();
+        Eigen::Array3i cmin = ((p - lower.transpose().array() - radius) / cellSize).floor().cast<int>().max(0);
+        Eigen::Array3i cmax = ((p - lower.transpose().array() + radius) / cellSize).floor().cast<int>().min(dims - 1);
+        for(int z = cmin(2); z <= cmax(2); ++z)
+        {
+            for(int y = cmin(1); y <= cmax(1); ++y)
+            {
+                for(int x = cmin(0); x <= cmax(0); ++x)
+                {
+                    int c = (z * dims(1) + y) * dims(0) + x;
+                    for(vtkIdType k = cellStart[c]; k < cellStart[c + 1]; ++k)
+                    {
+                        vtkIdType i = cellPoints[k];
+                        double d = (pts.row(i) - pts.row(sample)).norm();
+                        if(d < distance[i])
+                        {
+                            distance[i] = d;
+                            farthest.push(std::make_pair(d, i));
+                        }
+                    }
+                }
+            }
+        }
+        // pop the farthest point whose entry is up to date
+        while(farthest.top().first != distance[farthest.top().second])
+        {
+            farthest.pop();
+        }
+        sample = farthest.top().second;
+        radius = farthest.top().first;
+        farthest.pop();
+    }
+    return order;
+}
@@ -0,0 +1,24 @@
+// This class provides farthest point sampling of mesh vertices
+// Every prefix of the order is a well-spread sample: the next point is always the one
+// farthest from the points already chosen. Distances are only updated in the cells of a
+// uniform grid that can hold closer points, and the covering radius shrinks as points are
+// added, so ordering n points costs O(n log n) on meshes of roughly uniform density.
+#ifndef __vtkFarthestPointSampler_h
+#define __vtkFarthestPointSampler_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class vtkPoints;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkFarthestPointSampler {
+public:
+    // ids of the first nSamples points in farthest point order, starting from point 0
+    // nSamples < 0 orders all the points
+    static std::vector<vtkIdType> Order(vtkPoints* points, vtkIdType nSamples = -1);
+};
+#endif
@@ -0,0 +1,320 @@
+// This class provides the boundary implied by an s-rep as a closed quad mesh
+#include "vtkImpliedBoundary.h"
+#include "vtkSrepModel.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+// tip of the spoke blended from spoke 0 to spoke 1 at s in [0, 1]
+Eigen::RowVector3d BlendTip(const double* hubs, const double* directions, const double* lengths, double s)
+{
+    Eigen::Map<const Eigen::RowVector3d> hub0(hubs), hub1(hubs + 3);
+    Eigen::Map<const Eigen::RowVector3d> direction0(directions), direction1(directions + 3);
+    Eigen::RowVector3d direction = ((1 - s) * direction0 + s * direction1).normalized();
+    return (1 - s) * hub0 + s * hub1 + ((1 - s) * lengths[0] + s * lengths[1]) * direction;
+}
+}
+
+// compute the points of the tasks [begin, end): every patch of one side of the grid writes its own
+// rows and columns of the dense grid, every segment of the fold curve the arcs of its ring positions
+class vtkImpliedBoundary::TaskFunctor
+{
+public:
+    TaskFunctor(const vtkImpliedBoundary& self, const std::vector<vtkIdType>& tasks, vtkEigenArrayBridge::PointMatrixMap points)
+        : Self(self), Tasks(tasks), Points(points) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        const vtkSpokeInterpolator& interpolator = this->Self.Interpolator;
+        const int n = this->Self.Resolution;
+        const vtkIdType nPatchRows = interpolator.GetNumberOfRows() - 1;
+        const vtkIdType nPatchCols = interpolator.GetNumberOfColumns() - 1;
+        const vtkIdType nPatches = nPatchRows * nPatchCols;
+        const vtkIdType N = nPatchRows * n + 1;
+        const vtkIdType M = nPatchCols * n + 1;
+        // buffers of the tasks of this range, the interpolation runs serially in this thread
+        std::vector<double> positions, hubs, directions, lengths;
+        std::vector<double> ringHubs(9 * n), ringDirections(9 * n), ringLengths(3 * n), crestPositions(n);
+        for(vtkIdType t = begin; t < end; ++t)
+        {
+            vtkIdType task = this->Tasks[t];
+            if(task < 2 * nPatches)
+            {
+                int block = task < nPatches ? vtkSrepModel::UpBlock : vtkSrepModel::DownBlock;
+                vtkIdType patch = task % nPatches;
+                vtkIdType pr = patch / nPatchCols, pc = patch % nPatchCols;
+                // the last patch of a row or column also writes the last row or column of the dense grid
+                vtkIdType rowEnd = pr == nPatchRows - 1 ? N : (pr + 1) * n;
+                vtkIdType colEnd = pc == nPatchCols - 1 ? M : (pc + 1) * n;
+                positions.clear();
+                for(vtkIdType row = pr * n; row < rowEnd; ++row)
+                {
+                    for(vtkIdType col = pc * n; col < colEnd; ++col)
+                    {
+                        positions.push_back(static_cast<double>(row) / n);
+                        positions.push_back(static_cast<double>(col) / n);
+                    }
+                }
+                vtkIdType nQueries = static_cast<vtkIdType>(positions.size() / 2);
+                this->Evaluate(block, positions, nQueries, hubs, directions, lengths);
+                vtkIdType q = 0;
+                for(vtkIdType row = pr * n; row < rowEnd; ++row)
+                {
+                    for(vtkIdType col = pc * n; col < colEnd; ++col, ++q)
+                    {
+                        this->Points.row(block * N * M + row * M + col) = Eigen::Map<const Eigen::RowVector3d>(&hubs[3 * q])
+                            + lengths[q] * Eigen::Map<const Eigen::RowVector3d>(&directions[3 * q]);
+                    }
+                }
+                continue;
+            }
+            // spokes of the ring positions of the segment: up, crest and down, 3 consecutive spokes per position
+            vtkIdType segment = task - 2 * nPatches;
+            positions.clear();
+            for(int step = 0; step < n; ++step)
+            {
+                vtkIdType row = 0, col = 0;
+                this->Self.GetRingPoint(segment * n + step, row, col);
+                positions.push_back(static_cast<double>(row) / n);
+                positions.push_back(static_cast<double>(col) / n);
+                crestPositions[step] = segment + static_cast<double>(step) / n;
+            }
+            const int blocks[3] = {vtkSrepModel::UpBlock, vtkSrepModel::CrestBlock, vtkSrepModel::DownBlock};
+            for(int b = 0; b < 3; ++b)
+            {
+                this->Evaluate(blocks[b], blocks[b] == vtkSrepModel::CrestBlock ? crestPositions : positions, n,
+                               hubs, directions, lengths);
+                for(int step = 0; step < n; ++step)
+                {
+                    std::copy(&hubs[3 * step], &hubs[3 * step] + 3, &ringHubs[9 * step + 3 * b]);
+                    std::copy(&directions[3 * step], &directions[3 * step] + 3, &ringDirections[9 * step + 3 * b]);
+                    ringLengths[3 * step + b] = lengths[step];
+                }
+            }
+            for(int step = 0; step < n; ++step)
+            {
+                vtkIdType first = 2 * N * M + (segment * n + step) * (2 * n - 1);
+                for(int k = 0; k < 2 * n - 1; ++k)
+                {
+                    // up spoke to crest spoke over the first n points, crest spoke to down spoke over the others
+                    int from = k < n ? 0 : 1;
+                    double s = static_cast<double>(k < n ? k + 1 : k - n + 1) / n;
+                    this->Points.row(first + k) = BlendTip(&ringHubs[9 * step + 3 * from], &ringDirections[9 * step + 3 * from],
+                                                           &ringLengths[3 * step + from], s);
+                }
+            }
+        }
+    }
+
+private:
+    void Evaluate(int block, const std::vector<double>& positions, vtkIdType nQueries,
+                  std::vector<double>& hubs, std::vector<double>& directions, std::vector<double>& lengths) const
+    {
+        hubs.resize(3 * nQueries);
+        directions.resize(3 * nQueries);
+        lengths.resize(nQueries);
+        this->Self.Interpolator.EvaluateSerial(block, positions.data(), nQueries, hubs.data(), directions.data(), lengths.data());
+    }
+
+    const vtkImpliedBoundary& Self;
+    const std::vector<vtkIdType>& Tasks;
+    vtkEigenArrayBridge::PointMatrixMap Points;
+};
+
+vtkImpliedBoundary::vtkImpliedBoundary()
+    : Resolution(5), Flipped(false)
+{
+}
+
+bool vtkImpliedBoundary::Update(vtkMultiBlockDataSet* srep)
+{
+    if(!this->Interpolator.Update(srep))
+    {
+        std::cerr << "Failed to compute the implied boundary" << std::endl;
+        return false;
+    }
+    const int nRows = this->Interpolator.GetNumberOfRows();
+    const int nCols = this->Interpolator.GetNumberOfColumns();
+    const vtkIdType nCrest = this->Interpolator.GetNumberOfCrestSpokes();
+    const int n = this->Resolution;
+
+    // the two ends of every segment of the fold curve are corners of one patch of the grid
+    this->CrestPatches.resize(nCrest);
+    for(vtkIdType i = 0; i < nCrest; ++i)
+    {
+        vtkIdType first = vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols);
+        vtkIdType second = vtkSrepModel::GetCrestSkeletalPoint((i + 1) % nCrest, nRows, nCols);
+        vtkIdType pr = std::min<vtkIdType>(std::min(first / nCols, second / nCols), nRows - 2);
+        vtkIdType pc = std::min<vtkIdType>(std::min(first % nCols, second % nCols), nCols - 2);
+        this->CrestPatches[i] = pr * (nCols - 1) + pc;
+    }
+
+    vtkIdType N = (nRows - 1) * n + 1;
+    vtkIdType M = (nCols - 1) * n + 1;
+    this->Output = vtkSmartPointer<vtkPolyData>::New();
+    vtkEigenArrayBridge::AllocatePoints(this->Output, 2 * N * M + nCrest * n * (2 * n - 1));
+    std::vector<vtkIdType> tasks(2 * (nRows - 1) * (nCols - 1) + nCrest);
+    for(size_t t = 0; t < tasks.size(); ++t)
+    {
+        tasks[t] = static_cast<vtkIdType>(t);
+    }
+    this->ComputeTasks(tasks);
+
+    // the cells face outward when they enclose a positive volume
+    this->Flipped = false;
+    this->BuildCells();
+    vtkEigenArrayBridge::PointMatrixMap points = vtkEigenArrayBridge::MapPoints(this->Output->GetPoints());
+    vtkSmartPointer<vtkIdList> cell = vtkSmartPointer<vtkIdList>::New();
+    double volume = 0;
+    vtkCellArray* polys = this->Output->GetPolys();
+    polys->InitTraversal();
+    while(polys->GetNextCell(cell))
+    {
+        Eigen::Vector3d p0 = points.row(cell->GetId(0)).transpose();
+        for(vtkIdType j = 1; j + 1 < cell->GetNumberOfIds(); ++j)
+        {
+            Eigen::Vector3d p1 = points.row(cell->GetId(j)).transpose();
+            Eigen::Vector3d p2 = points.row(cell->GetId(j + 1)).transpose();
+            volume += p0.dot(p1.cross(p2)) / 6;
+        }
+    }
+    if(volume < 0)
+    {
+        this->Flipped = true;
+        this->BuildCells();
+    }
+    return true;
+}
+
+bool vtkImpliedBoundary::UpdateSpoke(int block, vtkIdType spokeId)
+{
+    if(this->Output == NULL || !this->Interpolator.UpdateSpoke(block, spokeId))
+    {
+        std::cerr << "Failed to update the implied boundary" << std::endl;
+        return false;
+    }
+    const int nRows = this->Interpolator.GetNumberOfRows();
+    const int nCols = this->Interpolator.GetNumberOfColumns();
+    const vtkIdType nPatches = (nRows - 1) * (nCols - 1);
+    const vtkIdType nCrest = this->Interpolator.GetNumberOfCrestSpokes();
+    std::vector<vtkIdType> tasks;
+    if(block == vtkSrepModel::CrestBlock)
+    {
+        // a segment of the fold curve depends on the crest spokes at its ends and on the next on either side
+        for(vtkIdType i = spokeId - 2; i <= spokeId + 1; ++i)
+        {
+            tasks.push_back(2 * nPatches + (i + nCrest) % nCrest);
+        }
+    }
+    else
+    {
+        // a patch depends on the 4 x 4 spokes around it
+        vtkIdType r = spokeId / nCols, c = spokeId % nCols;
+        vtkIdType firstRow = std::max<vtkIdType>(r - 2, 0), lastRow = std::min<vtkIdType>(r + 1, nRows - 2);
+        vtkIdType firstCol = std::max<vtkIdType>(c - 2, 0), lastCol = std::min<vtkIdType>(c + 1, nCols - 2);
+        for(vtkIdType pr = firstRow; pr <= lastRow; ++pr)
+        {
+            for(vtkIdType pc = firstCol; pc <= lastCol; ++pc)
+            {
+                tasks.push_back(pr * (nCols - 1) + pc);
+                tasks.push_back(nPatches + pr * (nCols - 1) + pc);
+            }
+        }
+        for(vtkIdType i = 0; i < nCrest; ++i)
+        {
+            vtkIdType pr = this->CrestPatches[i] / (nCols - 1), pc = this->CrestPatches[i] % (nCols - 1);
+            if(pr >= firstRow && pr <= lastRow && pc >= firstCol && pc <= lastCol)
+            {
+                tasks.push_back(2 * nPatches + i);
+            }
+        }
+    }
+    // a short fold curve lists the same segment more than once
+    std::sort(tasks.begin(), tasks.end());
+    tasks.erase(std::unique(tasks.begin(), tasks.end()), tasks.end());
+    this->ComputeTasks(tasks);
+    return true;
+}
+
+void vtkImpliedBoundary::GetRingPoint(vtkIdType q, vtkIdType& row, vtkIdType& col) const
+{
+    int N = (this->Interpolator.GetNumberOfRows() - 1) * this->Resolution + 1;
+    int M = (this->Interpolator.GetNumberOfColumns() - 1) * this->Resolution + 1;
+    vtkIdType id = vtkSrepModel::GetCrestSkeletalPoint(q, N, M);
+    row = id / M;
+    col = id % M;
+}
+
+void vtkImpliedBoundary::ComputeTasks(const std::vector<vtkIdType>& tasks)
+{
+    TaskFunctor functor(*this, tasks, vtkEigenArrayBridge::MapPoints(this->Output->GetPoints()));
+    vtkSMPTools::For(0, static_cast<vtkIdType>(tasks.size()), functor);
+    this->Output->GetPoints()->Modified();
+    this->Output->Modified();
+}
+
+void vtkImpliedBoundary::BuildCells()
+{
+    const int n = this->Resolution;
+    const vtkIdType N = (this->Interpolator.GetNumberOfRows() - 1) * n + 1;
+    const vtkIdType M = (this->Interpolator.GetNumberOfColumns() - 1) * n + 1;
+    const vtkIdType nRing = 2 * N + 2 * (M - 2);
+    const vtkIdType nArc = 2 * n - 1;
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    vtkIdType quad[4];
+    // up side, then down side in the opposite order
+    for(int side = 0; side < 2; ++side)
+    {
+        for(vtkIdType row = 0; row + 1 < N; ++row)
+        {
+            for(vtkIdType col = 0; col + 1 < M; ++col)
+            {
+                vtkIdType id = side * N * M + row * M + col;
+                quad[0] = id;
+                quad[1] = side == 0 ? id + M : id + 1;
+                quad[2] = id + M + 1;
+                quad[3] = side == 0 ? id + 1 : id + M;
+                if(this->Flipped)
+                {
+                    std::swap(quad[1], quad[3]);
+                }
+                polys->InsertNextCell(4, quad);
+            }
+        }
+    }
+    // strips around the fold, from the up side through the arcs to the down side
+    for(vtkIdType q = 0; q < nRing; ++q)
+    {
+        vtkIdType next = (q + 1) % nRing;
+        vtkIdType row = 0, col = 0;
+        this->GetRingPoint(q, row, col);
+        vtkIdType up = row * M + col, down = N * M + up;
+        this->GetRingPoint(next, row, col);
+        vtkIdType nextUp = row * M + col, nextDown = N * M + nextUp;
+        vtkIdType arc = 2 * N * M + q * nArc, nextArc = 2 * N * M + next * nArc;
+        for(vtkIdType k = -1; k < nArc; ++k)
+        {
+            quad[0] = k < 0 ? up : arc + k;
+            quad[1] = k < 0 ? nextUp : nextArc + k;
+            quad[2] = k + 1 < nArc ? nextArc + k + 1 : nextDown;
+            quad[3] = k + 1 < nArc ? arc + k + 1 : down;
+            if(this->Flipped)
+            {
+                std::swap(quad[1], quad[3]);
+            }
+            polys->InsertNextCell(4, quad);
+        }
+    }
+    this->Output->SetPolys(polys);
+}
@@ -0,0 +1,56 @@
+// This class provides the boundary implied by an s-rep as a closed quad mesh
+// The up and down spokes are interpolated over every cell of the skeletal grid by vtkSpokeInterpolator,
+// resolution steps per grid interval; the tips form the up and down sides. The crest spokes are
+// interpolated the same way along the fold curve, and every point of the grid boundary is joined to the
+// fold by an arc of spokes blended from the up spoke to the crest spoke to the down spoke. The mesh is computed patch by patch in parallel, and when one spoke changes
+// only the patches in its support are computed again.
+#ifndef __vtkImpliedBoundary_h
+#define __vtkImpliedBoundary_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+#include "vtkEigenArrayBridge.h"
+#include "vtkSpokeInterpolator.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class vtkMultiBlockDataSet;
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkImpliedBoundary {
+public:
+    vtkImpliedBoundary();
+
+    // interpolation steps per interval of the skeletal grid and of the fold curve, at least 1
+    void SetResolution(int resolution) {Resolution = resolution < 1 ? 1 : resolution;}
+    int GetResolution() const {return Resolution;}
+
+    // compute the whole implied boundary of the s-rep, which is kept for UpdateSpoke
+    // return false if the s-rep is not valid or its crest does not follow the boundary of its grid
+    bool Update(vtkMultiBlockDataSet* srep);
+    // compute again the part of the implied boundary that depends on spoke spokeId of a block
+    // (vtkSrepModel::UpBlock, DownBlock or CrestBlock) after it changed in the s-rep given to Update
+    bool UpdateSpoke(int block, vtkIdType spokeId);
+
+    // the implied boundary, its points are updated in place by UpdateSpoke
+    vtkPolyData* GetOutput() const {return Output;}
+
+private:
+    // position q of the boundary of the dense grid, as (row, col) of the dense grid
+    void GetRingPoint(vtkIdType q, vtkIdType& row, vtkIdType& col) const;
+    void ComputeTasks(const std::vector<vtkIdType>& tasks);
+    void BuildCells();
+
+    int Resolution;
+    vtkSpokeInterpolator Interpolator;
+    // patch of the grid under every interval of the fold curve
+    std::vector<vtkIdType> CrestPatches;
+    bool Flipped;
+    vtkSmartPointer<vtkPolyData> Output;
+
+    class TaskFunctor;
+};
+#endif
@@ -0,0 +1,321 @@
+// This class provides the signed distance to a closed triangle mesh sampled on a narrow band grid
+#include "vtkSignedDistanceField.h"
+#include "vtkTriangleBVH.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// cells per brick along each axis, a brick holds the samples of both its faces
+const int BRICK_SIZE = 8;
+const int BRICK_SAMPLES = BRICK_SIZE + 1;
+const vtkIdType SAMPLES_PER_BRICK = BRICK_SAMPLES * BRICK_SAMPLES * BRICK_SAMPLES;
+// values of a sample: distance and gradient
+const int SAMPLE_VALUES = 4;
+// brick beyond the band
+const vtkIdType BRICK_FAR = -1;
+
+// signed distance of x to the boundary and its gradient (x - c) / distance, the pseudo-normal on the boundary
+// the distance of x is at most maxDistance, e.g. the distance of a neighbour plus their separation
+double SignedDistance(const vtkTriangleBVH& boundary, const double x[3], double gradient[3],
+                      double maxDistance = std::numeric_limits<double>::max())
+{
+    double closest[3], normal[3];
+    vtkIdType cellId;
+    double distance = boundary.FindClosestPoint(x, closest, normal, cellId, maxDistance);
+    if(distance < 0)
+    {
+        // the bound was too tight for rounding
+        distance = boundary.FindClosestPoint(x, closest, normal, cellId);
+    }
+    double side = 0;
+    for(int k = 0; k < 3; ++k)
+    {
+        side += (x[k] - closest[k]) * normal[k];
+    }
+    double signedDistance = side < 0 ? -distance : distance;
+    // on the boundary x - c is rounding noise: a sample there takes the pseudo-normal
+    double scale = std::max(std::max(std::fabs(x[0]), std::fabs(x[1])), std::max(std::fabs(x[2]), 1.0));
+    bool onBoundary = distance <= 1e-9 * scale;
+    for(int k = 0; k < 3; ++k)
+    {
+        gradient[k] = onBoundary ? normal[k] : (x[k] - closest[k]) / signedDistance;
+    }
+    return signedDistance;
+}
+}
+
+// decide for every brick whether it is within the band, from the distance at its center
+class vtkSignedDistanceField::ClassifyFunctor
+{
+public:
+    ClassifyFunctor(vtkSignedDistanceField& field, const vtkTriangleBVH& boundary) : Field(field), Boundary(boundary) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        const double brickLength = BRICK_SIZE * this->Field.Spacing;
+        // a brick is within the band if its bounding sphere is
+        const double radius = 0.5 * std::sqrt(3.0) * brickLength;
+        for(vtkIdType b = begin; b < end; ++b)
+        {
+            vtkIdType i = b % this->Field.BrickDimensions[0];
+            vtkIdType j = (b / this->Field.BrickDimensions[0]) % this->Field.BrickDimensions[1];
+            vtkIdType k = b / (vtkIdType(this->Field.BrickDimensions[0]) * this->Field.BrickDimensions[1]);
+            double center[3] = {this->Field.Origin[0] + (i + 0.5) * brickLength,
+                                this->Field.Origin[1] + (j + 0.5) * brickLength,
+                                this->Field.Origin[2] + (k + 0.5) * brickLength};
+            double gradient[3];
+            double distance = SignedDistance(this->Boundary, center, gradient);
+            float* far = &this->Field.Centers[SAMPLE_VALUES * b];
+            far[0] = static_cast<float>(distance);
+            far[1] = static_cast<float>(gradient[0]);
+            far[2] = static_cast<float>(gradient[1]);
+            far[3] = static_cast<float>(gradient[2]);
+            // within the band: its samples are placed by the caller
+            this->Field.BrickTable[b] = std::fabs(distance) - radius <= this->Field.BandWidth ? 0 : BRICK_FAR;
+        }
+    }
+
+private:
+    vtkSignedDistanceField& Field;
+    const vtkTriangleBVH& Boundary;
+};
+
+// sample the bricks within the band, listed in bricks
+class vtkSignedDistanceField::SampleFunctor
+{
+public:
+    SampleFunctor(vtkSignedDistanceField& field, const vtkTriangleBVH& boundary, const std::vector<vtkIdType>& bricks)
+        : Field(field), Boundary(boundary), Bricks(bricks) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        const double spacing = this->Field.Spacing;
+        for(vtkIdType n = begin; n < end; ++n)
+        {
+            vtkIdType b = this->Bricks[n];
+            vtkIdType i0 = BRICK_SIZE * (b % this->Field.BrickDimensions[0]);
+            vtkIdType j0 = BRICK_SIZE * ((b / this->Field.BrickDimensions[0]) % this->Field.BrickDimensions[1]);
+            vtkIdType k0 = BRICK_SIZE * (b / (vtkIdType(this->Field.BrickDimensions[0]) * this->Field.BrickDimensions[1]));
+            float* sample = &this->Field.Samples[SAMPLE_VALUES * this->Field.BrickTable[b]];
+            for(int k = 0; k < BRICK_SAMPLES; ++k)
+            {
+                for(int j = 0; j < BRICK_SAMPLES; ++j)
+                {
+                    for(int i = 0; i < BRICK_SAMPLES; ++i, sample += SAMPLE_VALUES)
+                    {
+                        double x[3] = {this->Field.Origin[0] + (i0 + i) * spacing,
+                                       this->Field.Origin[1] + (j0 + j) * spacing,
+                                       this->Field.Origin[2] + (k0 + k) * spacing};
+                        // the closest point of the sample one spacing before along i, j or k, x_n - d_n g_n,
+                        // is on the boundary: its distance to x bounds the search, up to the float rounding
+                        int axis = i > 0 ? 0 : j > 0 ? 1 : k > 0 ? 2 : -1;
+                        double bound = std::numeric_limits<double>::max();
+                        if(axis >= 0)
+                        {
+                            const vtkIdType strides[3] = {1, BRICK_SAMPLES, BRICK_SAMPLES * BRICK_SAMPLES};
+                            const float* neighbour = sample - SAMPLE_VALUES * strides[axis];
+                            double squared = 0;
+                            for(int m = 0; m < 3; ++m)
+                            {
+                                double offset = (m == axis ? spacing : 0) + neighbour[0] * neighbour[1 + m];
+                                squared += offset * offset;
+                            }
+                            bound = std::sqrt(squared) + 1e-3 * spacing;
+                        }
+                        double gradient[3];
+                        sample[0] = static_cast<float>(SignedDistance(this->Boundary, x, gradient, bound));
+                        sample[1] = static_cast<float>(gradient[0]);
+                        sample[2] = static_cast<float>(gradient[1]);
+                        sample[3] = static_cast<float>(gradient[2]);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    vtkSignedDistanceField& Field;
+    const vtkTriangleBVH& Boundary;
+    const std::vector<vtkIdType>& Bricks;
+};
+
+namespace
+{
+// signed distance of every point of a mesh
+class DistanceArrayFunctor
+{
+public:
+    DistanceArrayFunctor(const vtkSignedDistanceField& field, vtkPolyData* mesh, double* distances)
+        : Field(field), Mesh(mesh), Distances(distances) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            double x[3];
+            this->Mesh->GetPoint(i, x);
+            this->Distances[i] = this->Field.Evaluate(x, NULL);
+        }
+    }
+
+private:
+    const vtkSignedDistanceField& Field;
+    vtkPolyData* Mesh;
+    double* Distances;
+};
+}
+
+vtkSignedDistanceField::vtkSignedDistanceField() : Spacing(0), BandWidth(0)
+{
+    for(int k = 0; k < 3; ++k)
+    {
+        Origin[k] = 0;
+        BrickDimensions[k] = 0;
+    }
+}
+
+bool vtkSignedDistanceField::Build(const vtkTriangleBVH& boundary, double spacing, double bandWidth)
+{
+    BrickTable.clear();
+    Centers.clear();
+    Samples.clear();
+    if(boundary.GetNumberOfTriangles() == 0 || spacing <= 0)
+    {
+        return false;
+    }
+    Spacing = spacing;
+    BandWidth = std::max(bandWidth, 0.0);
+
+    // 1. bricks covering the boundary and its band
+    double bounds[6];
+    boundary.GetBounds(bounds);
+    double margin = BandWidth + Spacing;
+    vtkIdType nBricks = 1;
+    for(int k = 0; k < 3; ++k)
+    {
+        Origin[k] = bounds[2 * k] - margin;
+        double extent = bounds[2 * k + 1] - bounds[2 * k] + 2 * margin;
+        BrickDimensions[k] = std::max(1, static_cast<int>(std::ceil(extent / (BRICK_SIZE * Spacing))));
+        nBricks *= BrickDimensions[k];
+    }
+    BrickTable.resize(nBricks);
+    Centers.resize(SAMPLE_VALUES * nBricks);
+    ClassifyFunctor classify(*this, boundary);
+    vtkSMPTools::For(0, nBricks, classify);
+
+    // 2. samples of the bricks within the band
+    std::vector<vtkIdType> bandBricks;
+    for(vtkIdType b = 0; b < nBricks; ++b)
+    {
+        if(BrickTable[b] >= 0)
+        {
+            BrickTable[b] = static_cast<vtkIdType>(bandBricks.size()) * SAMPLES_PER_BRICK;
+            bandBricks.push_back(b);
+        }
+    }
+    Samples.resize(SAMPLE_VALUES * SAMPLES_PER_BRICK * bandBricks.size());
+    SampleFunctor sample(*this, boundary, bandBricks);
+    vtkSMPTools::For(0, static_cast<vtkIdType>(bandBricks.size()), sample);
+    return true;
+}
+
+vtkIdType vtkSignedDistanceField::GetNumberOfBricks() const
+{
+    return static_cast<vtkIdType>(Samples.size() / (SAMPLE_VALUES * SAMPLES_PER_BRICK));
+}
+
+vtkIdType vtkSignedDistanceField::BrickIndex(const int brick[3]) const
+{
+    return brick[0] + BrickDimensions[0] * (brick[1] + vtkIdType(BrickDimensions[1]) * brick[2]);
+}
+
+double vtkSignedDistanceField::Evaluate(const double x[3], double gradient[3]) const
+{
+    if(gradient != NULL)
+    {
+        gradient[0] = gradient[1] = gradient[2] = 0;
+    }
+    if(BrickTable.empty())
+    {
+        return 0;
+    }
+
+    // cell of the grid holding x, its brick and its place in the brick
+    int brick[3], cell[3];
+    double weight[3];
+    bool inside = true;
+    for(int k = 0; k < 3; ++k)
+    {
+        double g = (x[k] - Origin[k]) / Spacing;
+        int nCells = BRICK_SIZE * BrickDimensions[k];
+        // NaN compares false and lands outside the grid too
+        inside = inside && g >= 0 && g <= nCells;
+        int c = g >= 0 ? static_cast<int>(std::min(g, nCells - 1.0)) : 0;
+        weight[k] = g - c;
+        brick[k] = c / BRICK_SIZE;
+        cell[k] = c % BRICK_SIZE;
+    }
+    vtkIdType index = BrickIndex(brick);
+    vtkIdType first = BrickTable[index];
+    if(!inside || first == BRICK_FAR)
+    {
+        const float* far = &Centers[SAMPLE_VALUES * index];
+        double distance = far[0];
+        for(int k = 0; k < 3; ++k)
+        {
+            double center = Origin[k] + (brick[k] + 0.5) * BRICK_SIZE * Spacing;
+            distance += far[1 + k] * (x[k] - center);
+            if(gradient != NULL)
+            {
+                gradient[k] = far[1 + k];
+            }
+        }
+        return distance;
+    }
+
+    const float* samples = &Samples[SAMPLE_VALUES * (first + cell[0] + BRICK_SAMPLES * (cell[1] + BRICK_SAMPLES * cell[2]))];
+    double values[SAMPLE_VALUES] = {0, 0, 0, 0};
+    for(int corner = 0; corner < 8; ++corner)
+    {
+        int di = corner & 1, dj = (corner >> 1) & 1, dk = (corner >> 2) & 1;
+        double w = (di ? weight[0] : 1 - weight[0]) * (dj ? weight[1] : 1 - weight[1]) * (dk ? weight[2] : 1 - weight[2]);
+        const float* sample = samples + SAMPLE_VALUES * (di + BRICK_SAMPLES * (dj + BRICK_SAMPLES * dk));
+        for(int v = 0; v < SAMPLE_VALUES; ++v)
+        {
+            values[v] += w * sample[v];
+        }
+    }
+    if(gradient != NULL)
+    {
+        gradient[0] = values[1];
+        gradient[1] = values[2];
+        gradient[2] = values[3];
+    }
+    return values[0];
+}
+
+void vtkSignedDistanceField::AddDistanceArray(vtkPolyData* mesh, const char* name) const
+{
+    if(mesh == NULL)
+    {
+        return;
+    }
+    vtkSmartPointer<vtkDoubleArray> distances = vtkSmartPointer<vtkDoubleArray>::New();
+    distances->SetName(name);
+    distances->SetNumberOfComponents(1);
+    distances->SetNumberOfTuples(mesh->GetNumberOfPoints());
+    DistanceArrayFunctor functor(*this, mesh, distances->GetPointer(0));
+    vtkSMPTools::For(0, mesh->GetNumberOfPoints(), functor);
+    mesh->GetPointData()->AddArray(distances);
+}
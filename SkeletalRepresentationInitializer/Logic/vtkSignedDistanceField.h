@@ -0,0 +1,58 @@
+// This class provides the signed distance to a closed triangle mesh sampled on a narrow band grid
+// The grid is cut in bricks of BRICK_SIZE^3 cells; only the bricks within the band of the boundary hold
+// samples, every brick keeps the distance and gradient at its center for the far field. Every sample keeps
+// the distance (negative inside) and its gradient, both computed once from the closest point of the boundary
+// and its pseudo-normal. Queries interpolate the 8 samples around the point and only read the field, so that
+// they run concurrently and cost the same anywhere: one field is shared by every fit and check of an
+// s-rep against the same mesh.
+#ifndef __vtkSignedDistanceField_h
+#define __vtkSignedDistanceField_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class vtkPolyData;
+class vtkTriangleBVH;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkSignedDistanceField {
+public:
+    vtkSignedDistanceField();
+
+    // sample the boundary on a grid of the given spacing, within bandWidth of the boundary
+    // return false if the hierarchy is empty or the spacing not positive
+    bool Build(const vtkTriangleBVH& boundary, double spacing, double bandWidth);
+    bool IsEmpty() const {return BrickTable.empty();}
+    double GetSpacing() const {return Spacing;}
+    double GetBandWidth() const {return BandWidth;}
+    // bricks holding samples
+    vtkIdType GetNumberOfBricks() const;
+
+    // trilinear signed distance at x, and its gradient if gradient is not NULL
+    // beyond the band, first order extension d(c) + g(c) . (x - c) from the center c of the closest brick
+    double Evaluate(const double x[3], double gradient[3]) const;
+
+    // add the signed distance to the boundary of every point of the mesh as a point data array
+    void AddDistanceArray(vtkPolyData* mesh, const char* name) const;
+
+private:
+    vtkIdType BrickIndex(const int brick[3]) const;
+
+    double Origin[3];
+    double Spacing;
+    double BandWidth;
+    int BrickDimensions[3];
+    // per brick, the first sample of a brick within the band, or -1
+    std::vector<vtkIdType> BrickTable;
+    // per brick, distance and gradient at its center
+    std::vector<float> Centers;
+    // (BRICK_SIZE + 1)^3 samples per brick, 4 values per sample: distance and gradient
+    std::vector<float> Samples;
+
+    class ClassifyFunctor;
+    class SampleFunctor;
+};
+#endif
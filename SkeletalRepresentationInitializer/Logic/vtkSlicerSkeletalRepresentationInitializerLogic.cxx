@@ -27,6 +27,9 @@
 #include <vtkMRMLMarkupsFiducialNode.h>
 #include <vtkMRMLMarkupsNode.h>
 #include "vtkSlicerMarkupsLogic.h"
+#include "vtkMRMLSrepNode.h"
+#include "vtkMRMLSrepDisplayNode.h"
+#include "vtkMRMLSrepStorageNode.h"
 
 // VTK includes
 #include <vtkIntArray.h>
@@ -39,25 +42,25 @@
 #include <vtkSmoothPolyDataFilter.h>
 #include <vtkParametricEllipsoid.h>
 #include <vtkParametricFunctionSource.h>
-#include <vtkImplicitPolyDataDistance.h>
 #include <vtkPolyDataNormals.h>
 
 #include <vtkPoints.h>
-#include <vtkLine.h>
-#include <vtkQuad.h>
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
 #include <vtkDataArray.h>
 #include <vtkDoubleArray.h>
+#include <vtkCellArray.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkMassProperties.h>
+#include <vtkMultiBlockDataSet.h>
 
 // Eigen includes
 #include <Eigen/Dense>
 #include <Eigen/Eigenvalues>
 
 // STD includes
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -65,6 +68,16 @@
 #include <vtksys/SystemTools.hxx>
 
 #include "vtkBackwardFlowLogic.h"
+#include "vtkImpliedBoundary.h"
+#include "vtkSignedDistanceField.h"
+#include "vtkSpokeRefiner.h"
+#include "vtkSrepOptimizer.h"
+#include "vtkTriangleBVH.h"
+#include "vtkValidityChecker.h"
+#include "vtkEllipsoidFitLogic.h"
+#include "vtkEigenArrayBridge.h"
+#include "vtkSrepModel.h"
+#include "vtkSrepIO.h"
 #include "qSlicerApplication.h"
 #include <QString>
 
@@ -74,6 +87,7 @@ vtkStandardNewMacro(vtkSlicerSkeletalRepresentationInitializerLogic);
 
 //----------------------------------------------------------------------------
 vtkSlicerSkeletalRepresentationInitializerLogic::vtkSlicerSkeletalRepresentationInitializerLogic()
+    : inputBoundary(new vtkTriangleBVH), inputDistanceField(new vtkSignedDistanceField)
 {
 }
 
@@ -102,6 +116,9 @@ void vtkSlicerSkeletalRepresentationInitializerLogic::SetMRMLSceneInternal(vtkMR
 void vtkSlicerSkeletalRepresentationInitializerLogic::RegisterNodes()
 {
   assert(this->GetMRMLScene() != 0);
+  this->GetMRMLScene()->RegisterNodeClass(vtkSmartPointer<vtkMRMLSrepNode>::New());
+  this->GetMRMLScene()->RegisterNodeClass(vtkSmartPointer<vtkMRMLSrepDisplayNode>::New());
+  this->GetMRMLScene()->RegisterNodeClass(vtkSmartPointer<vtkMRMLSrepStorageNode>::New());
 }
 
 //---------------------------------------------------------------------------
@@ -314,6 +331,8 @@ int vtkSlicerSkeletalRepresentationInitializerLogic::FlowSurfaceMesh(const std::
     double original_volume = mass_filter->GetVolume();
 //    std::cout << "Original Volume: " << original_volume << std::endl;
 
+    inputFileName = filename;
+
     // default parameters
     // double dt = 0.001;
     // double smooth_amount = 0.03;
@@ -409,6 +428,10 @@ int vtkSlicerSkeletalRepresentationInitializerLogic::FlowSurfaceMesh(const std::
 //            points->SetPoint(i, p);
         }
         points->Modified();
+        if(this->ValidityCheckInterval > 0 && (iter + 1) % this->ValidityCheckInterval == 0)
+        {
+            CheckMeshValidity(mesh, iter + 1);
+        }
         // TODO: move to the proper directory
         // save the result for the purpose of backward flow
         char fileName[MAX_FILE_NAME];
@@ -441,18 +464,18 @@ int vtkSlicerSkeletalRepresentationInitializerLogic::FlowSurfaceMesh(const std::
     ShowFittingEllipsoid(mesh, rx, ry, rz);
 
 
-    GenerateSrepForEllipsoid(mesh, 5, 5);
+    GenerateSrepForEllipsoid(mesh, NumberOfRows, NumberOfColumns);
     return 1;
 }
 
-void vtkSlicerSkeletalRepresentationInitializerLogic::AddModelNodeToScene(vtkPolyData* mesh, const char* modelName, bool isModelVisible, double r, double g, double b)
+vtkMRMLModelNode* vtkSlicerSkeletalRepresentationInitializerLogic::AddModelNodeToScene(vtkPolyData* mesh, const char* modelName, bool isModelVisible, double r, double g, double b)
 {
     std::cout << "AddModelNodeToScene: parameters:" << modelName << std::endl;
     vtkMRMLScene *scene = this->GetMRMLScene();
     if(!scene)
     {
         vtkErrorMacro(" Invalid scene");
-        return;
+        return NULL;
     }
 
     // model node
@@ -470,7 +493,7 @@ void vtkSlicerSkeletalRepresentationInitializerLogic::AddModelNodeToScene(vtkPol
     if(displayModelNode == NULL)
     {
         vtkErrorMacro("displayModelNode is NULL");
-        return;
+        return NULL;
     }
     displayModelNode->SetColor(r, g, b);
     displayModelNode->SetScene(scene);
@@ -491,41 +514,18 @@ void vtkSlicerSkeletalRepresentationInitializerLogic::AddModelNodeToScene(vtkPol
     modelNode->AddAndObserveDisplayNodeID(displayModelNode->GetID());
 
     scene->AddNode(modelNode);
-
+    return modelNode;
 }
 int vtkSlicerSkeletalRepresentationInitializerLogic::ShowFittingEllipsoid(vtkPolyData* mesh, double &rx, double &ry, double &rz)
 {
-    vtkSmartPointer<vtkPoints> points = mesh->GetPoints();
-    Eigen::MatrixXd point_matrix(points->GetNumberOfPoints(), 3);
-    for(int i = 0; i < points->GetNumberOfPoints(); ++i)
+    // compute best fitting ellipsoid from the moments of the volume enclosed by the mesh
+    vtkEllipsoidFitLogic fit;
+    if(!fit.Fit(mesh))
     {
-        double p[3];
-        points->GetPoint(i, p);
-        point_matrix.row(i) << p[0], p[1], p[2];
+        vtkErrorMacro("Cannot fit an ellipsoid to a mesh without polygons");
+        return -1;
     }
-    // compute best fitting ellipsoid
-    // For now assume that the surface is centered and rotationally aligned
-    // 1. compute the second moment after centering the data points
-    Eigen::MatrixXd center = point_matrix.colwise().mean();
-    Eigen::MatrixXd centered_point_mat = point_matrix - center.replicate(point_matrix.rows(), 1);
-    Eigen::MatrixXd point_matrix_transposed = centered_point_mat.transpose();
-    Eigen::Matrix3d second_moment = point_matrix_transposed * centered_point_mat;
-    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(second_moment);
-    Eigen::VectorXd radii = es.eigenvalues();
-    radii(0) = sqrt(radii(0));
-    radii(1) = sqrt(radii(1));
-    radii(2) = sqrt(radii(2));
-
-    double ellipsoid_volume = 4 / 3.0 * vtkMath::Pi() * radii(0) * radii(1) * radii(2);
-    vtkSmartPointer<vtkMassProperties> mass =
-        vtkSmartPointer<vtkMassProperties>::New();
-    mass->SetInputData(mesh);
-    mass->Update();
-
-    double volume_factor = pow(mass->GetVolume() / ellipsoid_volume, 1.0 / 3.0);
-    radii(0) *= volume_factor;
-    radii(1) *= volume_factor;
-    radii(2) *= volume_factor;
+    Eigen::Vector3d radii = fit.GetRadii();
     // obtain the best fitting ellipsoid from the second moment matrix
     vtkSmartPointer<vtkParametricEllipsoid> ellipsoid =
         vtkSmartPointer<vtkParametricEllipsoid>::New();
@@ -538,40 +538,17 @@ int vtkSlicerSkeletalRepresentationInitializerLogic::ShowFittingEllipsoid(vtkPol
     parametric_function->SetParametricFunction(ellipsoid);
     parametric_function->SetUResolution(30);
     parametric_function->SetVResolution(30);
+    parametric_function->SetOutputPointsPrecision(vtkAlgorithm::DOUBLE_PRECISION);
     parametric_function->Update();
-    vtkSmartPointer<vtkPolyData> ellipsoid_polydata = parametric_function->GetOutput();
-
-    using namespace Eigen;
-    // Get ellipsoid points into the matrix
-    MatrixXd ellipsoid_points_matrix(ellipsoid_polydata->GetNumberOfPoints(), 3);
-    for(int i = 0; i < ellipsoid_polydata->GetNumberOfPoints(); ++i) {
-        double p[3];
-        ellipsoid_polydata->GetPoint(i,p);
-        ellipsoid_points_matrix(i,0) = p[0];
-        ellipsoid_points_matrix(i,1) = p[1];
-        ellipsoid_points_matrix(i,2) = p[2];
-    }
-    MatrixXd rotation;
-    rotation = es.eigenvectors(); // 3 by 3 rotation matrix
-
-    // rotate the points
-    MatrixXd rotated_ellipsoid_points = rotation * (ellipsoid_points_matrix.transpose());
-    rotated_ellipsoid_points.transposeInPlace(); // n x 3
-    // translate the points
-    MatrixXd translated_points = rotated_ellipsoid_points + center.replicate(rotated_ellipsoid_points.rows(),1);
+    vtkSmartPointer<vtkPolyData> best_fitting_ellipsoid_polydata = parametric_function->GetOutput();
+    // normals of the axis aligned ellipsoid would be wrong after rotation
+    best_fitting_ellipsoid_polydata->GetPointData()->Initialize();
 
-    // convert eigen matrix to vtk polydata
-    vtkSmartPointer<vtkPolyData> best_fitting_ellipsoid_polydata =
-        vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkPoints> best_fitting_ellipsoid_points =
-        vtkSmartPointer<vtkPoints>::New();
-    for(int i = 0; i < translated_points.rows(); ++i) {
-        double p[3] = {translated_points(i,0), translated_points(i,1), translated_points(i,2)};
-        best_fitting_ellipsoid_points->InsertNextPoint(p);
-    }
-    best_fitting_ellipsoid_polydata->SetPoints(best_fitting_ellipsoid_points);
-    best_fitting_ellipsoid_polydata->SetPolys(ellipsoid_polydata->GetPolys());
-    best_fitting_ellipsoid_polydata->Modified();
+    // rotate and translate the ellipsoid points in place
+    vtkEigenArrayBridge::PointMatrixMap ellipsoid_points =
+        vtkEigenArrayBridge::MapPoints(best_fitting_ellipsoid_polydata->GetPoints());
+    vtkEigenArrayBridge::TransformInPlace(ellipsoid_points, fit.GetRotation(), fit.GetCenter());
+    best_fitting_ellipsoid_polydata->GetPoints()->Modified();
 
     AddModelNodeToScene(best_fitting_ellipsoid_polydata, "best_fitting_ellipsoid", true, 1, 1, 0);
 //    vtkSmartPointer<vtkPolyDataWriter> writer =
@@ -585,426 +562,166 @@ int vtkSlicerSkeletalRepresentationInitializerLogic::ShowFittingEllipsoid(vtkPol
 
 const double ELLIPSE_SCALE = 0.9;
 const double EPS = 0.0001;
+
 int vtkSlicerSkeletalRepresentationInitializerLogic::GenerateSrepForEllipsoid(vtkPolyData *mesh, int nRows, int nCols)
 {
     using namespace Eigen;
-    // the number of rows should be odd number
+    // the numbers of rows and columns should be odd numbers
+    if(nRows < 3 || nRows % 2 == 0 || nCols < 3 || nCols % 2 == 0)
+    {
+        vtkErrorMacro("The s-rep grid needs odd numbers of rows and columns, at least 3 each");
+        return -1;
+    }
     double shift = 0.02; // shift fold curve off the inner spokes
-    nRows = 5; nCols = 5; // TODO: accept input values from user interface
 
     // 1. derive the best fitting ellipsoid from the deformed mesh
-    vtkSmartPointer<vtkPoints> points = mesh->GetPoints();
-    MatrixXd point_matrix(points->GetNumberOfPoints(), 3);
-    for(int i = 0; i < points->GetNumberOfPoints(); ++i)
+    vtkEllipsoidFitLogic fit;
+    if(!fit.Fit(mesh))
     {
-        double p[3];
-        points->GetPoint(i, p);
-        point_matrix.row(i) << p[0], p[1], p[2];
+        vtkErrorMacro("Cannot fit an ellipsoid to a mesh without polygons");
+        return -1;
     }
-    MatrixXd center = point_matrix.colwise().mean();
-    MatrixXd centered_point_mat = point_matrix - center.replicate(point_matrix.rows(), 1);
-    MatrixXd point_matrix_transposed = centered_point_mat.transpose();
-    Matrix3d second_moment = point_matrix_transposed * centered_point_mat;
-    SelfAdjointEigenSolver<Eigen::MatrixXd> es_obj(second_moment);
-    VectorXd radii = es_obj.eigenvalues();
-
-    double rz = sqrt(radii(0));
-    double ry = sqrt(radii(1));
-    double rx = sqrt(radii(2));
-    double ellipsoid_volume = 4 / 3.0 * vtkMath::Pi() * rx * ry * rz;
-    vtkSmartPointer<vtkMassProperties> mass =
-        vtkSmartPointer<vtkMassProperties>::New();
-    mass->SetInputData(mesh);
-    mass->Update();
-
-    double volume_factor = pow(mass->GetVolume() / ellipsoid_volume, 1.0 / 3.0);
-    rz *= volume_factor;
-    ry *= volume_factor;
-    rx *= volume_factor;
+    double rz = fit.GetRadii()(0);
+    double ry = fit.GetRadii()(1);
+    double rx = fit.GetRadii()(2);
 
     double mrx_o = (rx*rx-rz*rz)/rx;
     double mry_o = (ry*ry-rz*rz)/ry;
     double mrb = mry_o * ELLIPSE_SCALE;
     double mra = mrx_o * ELLIPSE_SCALE;
 
-    // 2. compute the skeletal points
-    int nCrestPoints = nRows*2 + (nCols-2)*2;
-    double deltaTheta = 2*vtkMath::Pi()/nCrestPoints;
-    MatrixXd skeletal_points_x(nRows, nCols);
-    MatrixXd skeletal_points_y(nRows, nCols);
-    //MatrixXd skeletal_points_z(nRows, nCols);
-    int r = 0, c = 0;
-    for(int i = 0; i < nCrestPoints; ++i)
+    // s-rep frame: x along the longest axis of the ellipsoid, z along the shortest one
+    Matrix3d rotation;
+    rotation.col(0) = fit.GetRotation().col(2);
+    rotation.col(1) = fit.GetRotation().col(1);
+    rotation.col(2) = fit.GetRotation().col(0);
+    if(rotation.determinant() < 0)
     {
-        double theta = vtkMath::Pi() - deltaTheta * floor(nRows/2) - deltaTheta*i;
-        double x = mra * cos(theta);
-        double y = mrb * sin(theta);
-
-        // these crest points have no inward points (side or corner of the s-rep)
-        skeletal_points_x(r, c) = x;
-        skeletal_points_y(r, c) = y;
-        //skeletal_points_z(r, c) = z;
-        if(i < nCols - 1)
-        {
-            // top row of crest points
-            c += 1;
-        }
-        else if(i < nCols - 1 + nRows - 1)
-        {
-            // right side col of crest points ( if the top-left point is the origin)
-            r = r + 1;
-        }
-        else if(i < nCols - 1 + nRows - 1 + nCols - 1)
-        {
-            // bottom row of crest points
-            c = c - 1;
-        }
-        else
-        {
-            // left side col of crest points
-            r = r - 1;
-        }
-        if((i < nCols - 1 && i > 0) || (i > nCols + nRows - 2 && i < 2*nCols + nRows - 3))
+        // the s-rep is symmetric w.r.t. the skeletal plane
+        rotation.col(2) = -rotation.col(2);
+    }
+    Vector3d center = fit.GetCenter();
+
+    const vtkIdType nPoints = nRows * nCols;
+    const vtkIdType nCrestPoints = 2 * nRows + 2 * (nCols - 2);
+    const int halfRows = nRows / 2; // steps from the medial row to the top or bottom row
+    const double deltaTheta = 2 * vtkMath::Pi() / nCrestPoints;
+
+    // 2. allocate the output once
+    vtkSmartPointer<vtkPolyData> upSpokes_poly    = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPolyData> downSpokes_poly  = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPolyData> srep_poly        = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPolyData> crestSpokes_poly = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPolyData> foldCurve_poly   = vtkSmartPointer<vtkPolyData>::New();
+
+    // spoke polydata store (tail, head) pairs: point 2i is the hub, point 2i+1 the tip of spoke i
+    // the matrices below are views on the vtkPoints buffers
+    typedef vtkEigenArrayBridge::PointMatrixMap PointMatrixMap;
+    PointMatrixMap up_pts    = vtkEigenArrayBridge::AllocatePoints(upSpokes_poly, 2 * nPoints);
+    PointMatrixMap down_pts  = vtkEigenArrayBridge::AllocatePoints(downSpokes_poly, 2 * nPoints);
+    PointMatrixMap sheet_pts = vtkEigenArrayBridge::AllocatePoints(srep_poly, nPoints);
+    PointMatrixMap crest_pts = vtkEigenArrayBridge::AllocatePoints(crestSpokes_poly, 2 * nCrestPoints);
+    PointMatrixMap fold_pts  = vtkEigenArrayBridge::AllocatePoints(foldCurve_poly, nCrestPoints);
+
+    // 3. skeletal points and spokes in closed form
+    // Skeletal points lie on the ellipse (mra, mrb). The boundary of the grid samples it at
+    // nCrestPoints equally spaced angles, clockwise from the top-left corner; interior
+    // columns linearly interpolate between the top (bottom) crest point and the medial axis.
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
         {
-            // compute skeletal points inward
-            double mx_ = (mra * mra - mrb * mrb) * cos(theta) / mra; // this is the middle line
-            double my_ = .0;
-            double dx_ = x - mx_;
-            double dy_ = y - my_;
-            int numSteps = floor(nRows/2); // steps from crest point to the skeletal point
-            double stepSize = 1.0 / double(numSteps); // step size on the half side of srep
-            for(int j = 0; j <= numSteps; ++j)
+            double mx, my;
+            if(c == 0 || c == nCols - 1)
             {
-                double tempX_ = mx_ + stepSize * j * dx_;
-                double tempY_ = my_ + stepSize * j * dy_;
-                if(i < nCols - 1)
-                {
-                    // step from medial to top at current iteration on the top line
-                    int currR = numSteps - j;
-                    skeletal_points_x(currR, c-1) = tempX_;
-                    skeletal_points_y(currR, c-1) = tempY_;
-                }
-                else
-                {
-                    int currR = j + numSteps;
-                    skeletal_points_x(currR, c+1) = tempX_;
-                    skeletal_points_y(currR, c+1) = tempY_;
-                }
-
+                // side columns are crest points
+                double theta = (c == 0) ? vtkMath::Pi() - deltaTheta * (halfRows - r)
+                                        : vtkMath::Pi() - deltaTheta * (halfRows + nCols - 1 + r);
+                mx = mra * cos(theta);
+                my = mrb * sin(theta);
+            }
+            else
+            {
+                double theta = vtkMath::Pi() - deltaTheta * (halfRows + c);
+                double t = double(halfRows - r) / halfRows; // 1 on the top row, -1 on the bottom row
+                double medial_x = (mra * mra - mrb * mrb) * cos(theta) / mra; // this is the middle line
+                mx = medial_x + fabs(t) * (mra * cos(theta) - medial_x);
+                my = t * mrb * sin(theta);
             }
 
-        }
-    }
-
-    // 3. compute the head points of spokes
-    MatrixXd skeletal_points(nRows*nCols, 3);
-    MatrixXd bdry_points_up(nRows*nCols, 3);
-    MatrixXd bdry_points_down(nRows*nCols, 3);
-    MatrixXd bdry_points_crest(nCrestPoints, 3);
-    MatrixXd skeletal_points_crest(nCrestPoints, 3);
-    int id_pt = 0; int id_crest = 0;
-    MatrixXd shift_dir(nCrestPoints, 3); // shift direction for every crest point
-    for(int i = 0; i < nRows; ++i)
-    {
-        for(int j = 0; j < nCols; ++j)
-        {
-            double mx = skeletal_points_x(i,j);
-            double my = skeletal_points_y(i,j);
             double sB = my * mrx_o;
             double cB = mx * mry_o;
             double l = sqrt(sB*sB + cB*cB);
-            double sB_n, cB_n;
-            if(l == 0)
-            {
-                sB_n = sB;
-                cB_n = cB;
-            }
-            else
+            double sB_n = sB, cB_n = cB;
+            if(l > 0)
             {
                 sB_n = sB / l;
                 cB_n = cB / l;
             }
             double cA = l / (mrx_o * mry_o);
-            double sA = sqrt(1 - cA*cA);
-            double sx = rx * cA * cB_n - mx;
-            double sy = ry * cA * sB_n - my;
-            double sz = rz * sA;
-
-            double bx = (sx + mx);
-            double by = (sy + my);
-            double bz = (sz);
-
-            skeletal_points.row(id_pt) << mx, my, 0.0;
-            bdry_points_up.row(id_pt) << bx, by, bz;
-            bdry_points_down.row(id_pt) << bx, by, -bz;
-            id_pt++;
-            // fold curve
-            if(i == 0 || i == nRows - 1 || j == 0 || j == nCols - 1)
-            {
-                double cx = rx * cB_n - mx;
-                double cy = ry * sB_n - my;
-                double cz = 0;
-                Vector3d v, v2, v3;
-                v << cx, cy, cz;
-                v2 << sx, sy, 0.0;
-                double v_n = v.norm();
-                v2.normalize(); // v2 is the unit vector pointing out to norm dir
-                v3 = v_n * v2;
-                double bx = (v3(0) + mx);
-                double by = (v3(1) + my);
-                double bz = v3(2);
-                bdry_points_crest.row(id_crest) << bx, by, bz;
-                skeletal_points_crest.row(id_crest) << mx, my, 0.0;
-                shift_dir.row(id_crest) << v2(0), v2(1), v2(2);
-                id_crest++;
-            }
+            double sA = sqrt(std::max(1 - cA*cA, 0.0));
+            double bx = rx * cA * cB_n;
+            double by = ry * cA * sB_n;
+            double bz = rz * sA;
+
+            vtkIdType id = r * nCols + c;
+            sheet_pts.row(id) << mx, my, 0.0;
+            up_pts.row(2 * id) << mx, my, 0.0;
+            up_pts.row(2 * id + 1) << bx, by, bz;
+            down_pts.row(2 * id) << mx, my, 0.0;
+            down_pts.row(2 * id + 1) << bx, by, -bz;
         }
     }
 
-    // 4. transform the s-rep
-    MatrixXd transpose_srep = skeletal_points.transpose(); // 3xn
-    Matrix3d srep_secondMoment = transpose_srep * skeletal_points; // 3x3
-    SelfAdjointEigenSolver<Eigen::MatrixXd> es_srep(srep_secondMoment);
-
-    Matrix3d rotation;
-    rotation = es_obj.eigenvectors(); // 3 by 3 rotation relative to deformed object
-    Matrix3d rot_srep;
-    rot_srep = es_srep.eigenvectors().transpose();
-    rotation = rotation * rot_srep;
-
-    // all skeletal points
-    MatrixXd trans_srep = (rotation * transpose_srep).transpose();
-    MatrixXd transformed_skeletal_points = trans_srep+
-            center.replicate(trans_srep.rows(), 1);
-
-    // up spoke head point on the bdry
-    MatrixXd transpose_up_pdm = bdry_points_up.transpose();
-    MatrixXd trans_up_pdm = (rotation * transpose_up_pdm).transpose();
-    MatrixXd transformed_up_pdm =  trans_up_pdm +
-            center.replicate(trans_up_pdm.rows(), 1);
-
-    // down spoke head point on the bdry
-    MatrixXd transpose_down_pdm = bdry_points_down.transpose();
-    MatrixXd trans_down_pdm = (rotation * transpose_down_pdm).transpose();
-    MatrixXd transformed_down_pdm = trans_down_pdm +
-            center.replicate(trans_down_pdm.rows(), 1);
-
-    // crest head point on the bdry
-    MatrixXd transpose_crest_pdm = bdry_points_crest.transpose();
-    MatrixXd trans_crest_pdm = (rotation * transpose_crest_pdm).transpose();
-    MatrixXd transformed_crest_pdm = trans_crest_pdm + center.replicate(trans_crest_pdm.rows(), 1);
-
-    // crest base point on the skeletal sheet
-    MatrixXd transpose_crest_base = skeletal_points_crest.transpose();
-    MatrixXd trans_crest_base = (rotation * transpose_crest_base).transpose();
-    MatrixXd transformed_crest_base = trans_crest_base + center.replicate(trans_crest_base.rows(), 1);
-
-    // 5. transfer points to polydata
-    // srep_poly is supposed to form a mesh grid connecting skeletal points
-    vtkSmartPointer<vtkPolyData>  srep_poly       = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkPoints>    skeletal_sheet  = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> skeletal_mesh   = vtkSmartPointer<vtkCellArray>::New();
-
-    vtkSmartPointer<vtkPolyData>  upSpokes_poly      = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkPoints>    upSpokes_pts       = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> upSpokes_lines     = vtkSmartPointer<vtkCellArray>::New();
-
-    vtkSmartPointer<vtkPolyData>  downSpokes_poly      = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkPoints>    downSpokes_pts       = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> downSpokes_lines     = vtkSmartPointer<vtkCellArray>::New();
-
-    // TODO:crest spokes should be a little off the inner spokes
-    vtkSmartPointer<vtkPolyData>  crestSpokes_poly      = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkPoints>    crestSpokes_pts       = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> crestSpokes_lines     = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPolyData> foldCurve_poly         = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkPoints>    foldCurve_pts         = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> fold_curve            = vtkSmartPointer<vtkCellArray>::New();
-
-    skeletal_sheet->SetDataTypeToDouble();
-    upSpokes_pts->SetDataTypeToDouble();
-    downSpokes_pts->SetDataTypeToDouble();
-    crestSpokes_pts->SetDataTypeToDouble();
-
-    for(int i = 0; i < nRows * nCols; ++i)
+    // crest spokes, in the same clockwise order as the fold curve
+    for(vtkIdType i = 0; i < nCrestPoints; ++i)
     {
-        // skeletal points
-        double mx = transformed_skeletal_points(i,0);
-        double my = transformed_skeletal_points(i,1);
-        double mz = transformed_skeletal_points(i,2);
-        int id0 = upSpokes_pts->InsertNextPoint(mx,my, mz);
-
-        double bx_up = transformed_up_pdm(i, 0);
-        double by_up = transformed_up_pdm(i, 1);
-        double bz_up = transformed_up_pdm(i, 2);
-        int id1 = upSpokes_pts->InsertNextPoint(bx_up, by_up, bz_up);
-
-        // form up spokes
-        vtkSmartPointer<vtkLine> up_arrow = vtkSmartPointer<vtkLine>::New();
-        up_arrow->GetPointIds()->SetId(0, id0);
-        up_arrow->GetPointIds()->SetId(1, id1);
-        upSpokes_lines->InsertNextCell(up_arrow);
-
-        // form down spokes
-        int id2 = downSpokes_pts->InsertNextPoint(mx, my, mz);
-        double bx_down = transformed_down_pdm(i,0);
-        double by_down = transformed_down_pdm(i,1);
-        double bz_down = transformed_down_pdm(i,2);
-        int id3 = downSpokes_pts->InsertNextPoint(bx_down,by_down,bz_down);
-
-        vtkSmartPointer<vtkLine> down_arrow = vtkSmartPointer<vtkLine>::New();
-        down_arrow->GetPointIds()->SetId(0, id2);
-        down_arrow->GetPointIds()->SetId(1, id3);
-        downSpokes_lines->InsertNextCell(down_arrow);
+        vtkIdType id = vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols);
+        double mx = sheet_pts(id, 0), my = sheet_pts(id, 1);
 
-    }
-    // display up spokes
-    upSpokes_poly->SetPoints(upSpokes_pts);
-    upSpokes_poly->SetLines(upSpokes_lines);
-    AddModelNodeToScene(upSpokes_poly, "up spokes", true, 0, 1, 1);
-
-    // display down spokes
-    downSpokes_poly->SetPoints(downSpokes_pts);
-    downSpokes_poly->SetLines(downSpokes_lines);
-    AddModelNodeToScene(downSpokes_poly, "down spokes", true, 1, 0, 1);
-
-    // deal with skeletal mesh
-    for(int i = 0; i < nRows * nCols; ++i)
-    {
-        double mx = transformed_skeletal_points(i, 0);
-        double my = transformed_skeletal_points(i, 1);
-        double mz = transformed_skeletal_points(i, 2);
-        int current_id = skeletal_sheet->InsertNextPoint(mx, my, mz);
-        int current_row = floor(i / nRows);
-        int current_col = i - current_row * nRows;
-        if(current_col >= 0 && current_row >= 0
-                && current_row < nRows-1 && current_col < nCols - 1)
+        double l = sqrt(my * mrx_o * my * mrx_o + mx * mry_o * mx * mry_o);
+        double sB_n = 0, cB_n = 0;
+        if(l > 0)
         {
-            vtkSmartPointer<vtkQuad> quad = vtkSmartPointer<vtkQuad>::New();
-            quad->GetPointIds()->SetId(0, current_id);
-            quad->GetPointIds()->SetId(1, current_id + nCols);
-            quad->GetPointIds()->SetId(2, current_id + nCols + 1);
-            quad->GetPointIds()->SetId(3, current_id + 1);
-            skeletal_mesh->InsertNextCell(quad);
+            sB_n = my * mrx_o / l;
+            cB_n = mx * mry_o / l;
         }
-    }
-    srep_poly->SetPoints(skeletal_sheet);
-    srep_poly->SetPolys(skeletal_mesh);
-    AddModelNodeToScene(srep_poly, "skeletal mesh", true, 0, 0, 0);
-
-    // deal with crest spokes
-    for(int i = 0; i < nCrestPoints; ++i)
-    {
-        // tail point
-        double cx_t = transformed_crest_base(i, 0);
-        double cy_t = transformed_crest_base(i, 1);
-        double cz_t = transformed_crest_base(i, 2);
-        // head point (_b means boundary)
-        double cx_b = transformed_crest_pdm(i, 0);
-        double cy_b = transformed_crest_pdm(i, 1);
-        double cz_b = transformed_crest_pdm(i, 2);
-
-        if(shift > 0)
-        {
-            double shift_x = (cx_b - cx_t) * shift;
-            double shift_y = (cy_b - cy_t) * shift;
-            double shift_z = (cz_b - cz_t) * shift;
-
-            cx_t += shift_x;
-            cy_t += shift_y;
-            cz_t += shift_z;
-        }
-
-        int id0 = crestSpokes_pts->InsertNextPoint(cx_t, cy_t, cz_t);
-        int id1 = crestSpokes_pts->InsertNextPoint(cx_b, cy_b, cz_b);
-
-        vtkSmartPointer<vtkLine> crest_arrow = vtkSmartPointer<vtkLine>::New();
-        crest_arrow->GetPointIds()->SetId(0, id0);
-        crest_arrow->GetPointIds()->SetId(1, id1);
-        crestSpokes_lines->InsertNextCell(crest_arrow);
-
-
-    }
-    crestSpokes_poly->SetPoints(crestSpokes_pts);
-    crestSpokes_poly->SetLines(crestSpokes_lines);
-    AddModelNodeToScene(crestSpokes_poly, "crest spokes", true, 1, 0, 0);
-
-    // deal with fold curve
-    for(int i = 0; i < nCrestPoints; ++i)
-    {
-        double cx_t = transformed_crest_base(i, 0);
-        double cy_t = transformed_crest_base(i, 1);
-        double cz_t = transformed_crest_base(i, 2);
-        double cx_b = transformed_crest_pdm(i, 0);
-        double cy_b = transformed_crest_pdm(i, 1);
-        double cz_b = transformed_crest_pdm(i, 2);
-
-        if(shift > 0)
-        {
-            double shift_x = (cx_b - cx_t) * shift;
-            double shift_y = (cy_b - cy_t) * shift;
-            double shift_z = (cz_b - cz_t) * shift;
-
-            cx_t += shift_x;
-            cy_t += shift_y;
-            cz_t += shift_z;
-        }
-        int id0 = foldCurve_pts->InsertNextPoint(cx_t, cy_t, cz_t);
-
-        if(id0 > 0 && i < nCols)
-        {
-            // first row
-            vtkSmartPointer<vtkLine> fold_seg = vtkSmartPointer<vtkLine>::New();
-            fold_seg->GetPointIds()->SetId(0, id0-1);
-            fold_seg->GetPointIds()->SetId(1, id0);
-            fold_curve->InsertNextCell(fold_seg);
-        }
-
-        if(i > nCols && i < nCols + 2*(nRows-2) + 1 && (i-nCols) % 2 == 1)
+        // the crest spoke has the length of the in-plane spoke to the ellipse,
+        // but points along the projection of the up spoke onto the skeletal plane
+        Vector2d v(rx * cB_n - mx, ry * sB_n - my);
+        Vector2d v2(up_pts(2 * id + 1, 0) - mx, up_pts(2 * id + 1, 1) - my);
+        if(v2.norm() > 0)
         {
-            // right side of crest
-            vtkSmartPointer<vtkLine> fold_seg = vtkSmartPointer<vtkLine>::New();
-            fold_seg->GetPointIds()->SetId(0, id0-2);
-            fold_seg->GetPointIds()->SetId(1, id0);
-            fold_curve->InsertNextCell(fold_seg);
+            v2 = v.norm() * v2.normalized();
         }
-        if(i > nCols && i < nCols + 2*(nRows-2) + 1 && (i-nCols) % 2 == 0)
+        else
         {
-            // part of left side
-            vtkSmartPointer<vtkLine> fold_seg = vtkSmartPointer<vtkLine>::New();
-            fold_seg->GetPointIds()->SetId(0, id0-2);
-            fold_seg->GetPointIds()->SetId(1, id0);
-            fold_curve->InsertNextCell(fold_seg);
+            v2 = v;
         }
 
-        if(i == nCols)
-        {
-            // remaining part of left side
-            vtkSmartPointer<vtkLine> fold_seg = vtkSmartPointer<vtkLine>::New();
-            fold_seg->GetPointIds()->SetId(0, 0);
-            fold_seg->GetPointIds()->SetId(1, id0);
-            fold_curve->InsertNextCell(fold_seg);
-        }
-        if(i > nCols + 2*(nRows-2))
-        {
-            //bottom side
-            vtkSmartPointer<vtkLine> fold_seg = vtkSmartPointer<vtkLine>::New();
-            fold_seg->GetPointIds()->SetId(0, id0-1);
-            fold_seg->GetPointIds()->SetId(1, id0);
-            fold_curve->InsertNextCell(fold_seg);
-        }
-        if(i == nCrestPoints - 1)
-        {
-            // bottome right
-            vtkSmartPointer<vtkLine> fold_seg = vtkSmartPointer<vtkLine>::New();
-            fold_seg->GetPointIds()->SetId(0, id0-nCols);
-            fold_seg->GetPointIds()->SetId(1, id0);
-            fold_curve->InsertNextCell(fold_seg);
-        }
+        // tail shifted off the inner spokes towards the boundary
+        crest_pts.row(2 * i) << mx + shift * v2(0), my + shift * v2(1), 0.0;
+        crest_pts.row(2 * i + 1) << mx + v2(0), my + v2(1), 0.0;
+        fold_pts.row(i) = crest_pts.row(2 * i);
     }
-    foldCurve_poly->SetPoints(foldCurve_pts);
-    foldCurve_poly->SetLines(fold_curve);
-    AddModelNodeToScene(foldCurve_poly, "fold curve", true, 1, 1, 0);
+
+    // 4. transform the s-rep to the deformed object
+    vtkEigenArrayBridge::TransformInPlace(up_pts, rotation, center);
+    vtkEigenArrayBridge::TransformInPlace(down_pts, rotation, center);
+    vtkEigenArrayBridge::TransformInPlace(sheet_pts, rotation, center);
+    vtkEigenArrayBridge::TransformInPlace(crest_pts, rotation, center);
+    vtkEigenArrayBridge::TransformInPlace(fold_pts, rotation, center);
+
+    // 5. keep the s-rep in the new s-rep format: spokes hinge on the skeletal sheet and on the fold curve
+    // it is shown once GenerateSrep adds it to the scene as an s-rep node
+    vtkSmartPointer<vtkCellArray> quads = vtkSrepModel::NewQuadMesh(nRows, nCols);
+    vtkSmartPointer<vtkPolyData> up = vtkSrepModel::NewSpokes(srep_poly->GetPoints(), upSpokes_poly->GetPoints());
+    up->SetPolys(quads);
+    vtkSmartPointer<vtkPolyData> down = vtkSrepModel::NewSpokes(srep_poly->GetPoints(), downSpokes_poly->GetPoints());
+    down->SetPolys(quads);
+    vtkSmartPointer<vtkPolyData> crest = vtkSrepModel::NewSpokes(foldCurve_poly->GetPoints(), crestSpokes_poly->GetPoints());
+    crest->SetLines(vtkSrepModel::NewClosedPolyLine(nCrestPoints));
+    srepModel = vtkSrepModel::New(up, down, crest, nRows, nCols);
 
     return 0;
 }
@@ -1198,6 +915,10 @@ int vtkSlicerSkeletalRepresentationInitializerLogic::InklingFlow(const std::stri
             }
         }
         points->Modified();
+        if(this->ValidityCheckInterval > 0 && (iter + 1) % this->ValidityCheckInterval == 0)
+        {
+            CheckMeshValidity(mesh, iter + 1);
+        }
 
         double testRender[3];
         points->GetPoint(maxIndex, testRender);
@@ -1271,28 +992,338 @@ void vtkSlicerSkeletalRepresentationInitializerLogic::AddPointToScene(double x,
 
 }
 
-int vtkSlicerSkeletalRepresentationInitializerLogic::BackwardFlow()
+int vtkSlicerSkeletalRepresentationInitializerLogic::BackwardFlow(std::string& output)
 {
-    // 1. compute pairwise TPS
+    if(srepModel == NULL || forwardCount == 0 || inputFileName.empty())
+    {
+        vtkErrorMacro("Run the forward flow and generate the s-rep of the ellipsoid first.");
+        return -1;
+    }
 
-    // 2. generate s-rep for ellipsoid
+    // 1. compute pairwise TPS, the snapshots are read by the tasks that need them
+    std::vector<std::string> snapshots;
+    snapshots.push_back(inputFileName);
+    for(int i = 1; i <= forwardCount; ++i)
+    {
+        char fileName[MAX_FILE_NAME];
+        sprintf(fileName, "%s/forward/forward_output#%04d.vtk", this->GetApplicationLogic()->GetTemporaryPath(), i);
+        snapshots.push_back(fileName);
+    }
+    vtkBackwardFlowLogic backwardFlow;
+    if(this->CorrespondenceBackwardFlow)
+    {
+        // the flow keeps the vertices: the s-rep is anchored to the triangles of the last snapshot
+        // and rebuilt on the same triangles of the input mesh, no intermediate snapshot and no TPS
+        vtkSmartPointer<vtkMultiBlockDataSet> srep = backwardFlow.mapBackwardByCorrespondence(snapshots, srepModel);
+        if(srep == NULL)
+        {
+            vtkErrorMacro("Failed to carry the s-rep back to the input object.");
+            return -1;
+        }
+        if(FitSrepToInputMesh(srep) != 0)
+        {
+            return -1;
+        }
+        return AddSrepNode(srep, "srep", output);
+    }
+
+    backwardFlow.setLandmarkErrorTarget(this->LandmarkErrorTarget);
+    bool computed = false;
+    if(this->KeyframeTolerance > 0)
+    {
+        computed = backwardFlow.computeBackwardTPSChainKeyframes(snapshots, this->KeyframeTolerance);
+    }
+    else
+    {
+        computed = this->SequentialBackwardFlow ? backwardFlow.computeBackwardTPSChainWarmStarted(snapshots)
+                                                : backwardFlow.computeBackwardTPSChain(snapshots);
+    }
+    if(!computed)
+    {
+        vtkErrorMacro("Failed to compute the TPS between the forward flow snapshots.");
+        return -1;
+    }
+
+    // 2. keep the chain next to the snapshots, so that more s-reps of this object can be carried back later,
+    // and run applyTPS on the s-rep of the ellipsoid through the stored chain
+    std::string backwardFolder = std::string(this->GetApplicationLogic()->GetTemporaryPath()) + "/backward";
+    std::vector<std::string> tpsFileNames;
+    vtkSmartPointer<vtkMultiBlockDataSet> srep;
+    if(vtksys::SystemTools::MakeDirectory(backwardFolder) && backwardFlow.writeBackwardTPSChain(backwardFolder, tpsFileNames))
+    {
+        std::vector<vtkSmartPointer<vtkMultiBlockDataSet> > sreps
+                = backwardFlow.runApplyTPS(tpsFileNames, std::vector<vtkMultiBlockDataSet*>(1, srepModel.GetPointer()));
+        if(!sreps.empty())
+        {
+            srep = sreps[0];
+        }
+    }
+    else
+    {
+        vtkWarningMacro("Failed to store the TPS chain in " << backwardFolder << ", the s-rep is carried back in memory.");
+        srep = backwardFlow.applyBackwardTPSChain(srepModel);
+    }
+    if(srep == NULL)
+    {
+        vtkErrorMacro("Failed to carry the s-rep back to the input object.");
+        return -1;
+    }
+    // 3. fit the s-rep to the input boundary
+    if(FitSrepToInputMesh(srep) != 0)
+    {
+        return -1;
+    }
+    return AddSrepNode(srep, "srep", output);
+}
 
-    // 3. run applyTPS
+int vtkSlicerSkeletalRepresentationInitializerLogic::UpdateInputBoundary()
+{
+    if(boundaryFileName == inputFileName && boundaryResolution == this->DistanceFieldResolution
+            && !inputDistanceField->IsEmpty())
+    {
+        return 0;
+    }
+    boundaryFileName.clear();
+    vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+    reader->SetFileName(inputFileName.c_str());
+    reader->Update();
+    if(!inputBoundary->Build(reader->GetOutput()))
+    {
+        vtkErrorMacro("Failed to read the triangles of the input mesh " << inputFileName);
+        return -1;
+    }
+    // a band of a few cells around the boundary, the field extends to first order beyond it
+    double bounds[6];
+    inputBoundary->GetBounds(bounds);
+    double longestSide = std::max(bounds[1] - bounds[0], std::max(bounds[3] - bounds[2], bounds[5] - bounds[4]));
+    double spacing = longestSide / std::max(this->DistanceFieldResolution, 1);
+    if(!inputDistanceField->Build(*inputBoundary, spacing, 6 * spacing))
+    {
+        vtkErrorMacro("Failed to build the distance field of the input mesh " << inputFileName);
+        return -1;
+    }
+    boundaryFileName = inputFileName;
+    boundaryResolution = this->DistanceFieldResolution;
     return 0;
 }
 
-int vtkSlicerSkeletalRepresentationInitializerLogic::DummyBackwardFlow(std::string& output)
+int vtkSlicerSkeletalRepresentationInitializerLogic::FitSrepToInputMesh(vtkMultiBlockDataSet* srep)
 {
-    std::string tempDir(this->GetApplicationLogic()->GetTemporaryPath());
-    tempDir += "/srep.m3d";
-    output = tempDir;
+    if(!this->OptimizeSrep && !this->RefineSpokeLengths)
+    {
+        return 0;
+    }
+    if(UpdateInputBoundary() != 0)
+    {
+        return -1;
+    }
+
+    if(this->OptimizeSrep)
+    {
+        vtkSrepOptimizer optimizer;
+        if(!optimizer.Optimize(srep, *inputDistanceField))
+        {
+            vtkErrorMacro("Failed to optimize the s-rep.");
+            return -1;
+        }
+        vtkDebugMacro("Optimized the s-rep in " << optimizer.GetNumberOfIterations() << " iterations, cost "
+                      << optimizer.GetInitialCost() << " -> " << optimizer.GetFinalCost());
+    }
+
+    if(this->RefineSpokeLengths)
+    {
+        vtkIdType nRefined = vtkSpokeRefiner::RefineSpokeLengths(srep, *inputBoundary);
+        if(nRefined < 0)
+        {
+            vtkErrorMacro("Failed to refine the spokes of the s-rep.");
+            return -1;
+        }
+        double maxResidual = 0, meanResidual = 0;
+        vtkSpokeRefiner::GetResidualStatistics(srep, maxResidual, meanResidual);
+        vtkDebugMacro("Refined " << nRefined << " spokes against the input mesh, residual max "
+                      << maxResidual << " mean " << meanResidual);
+    }
     return 0;
 }
 
 int vtkSlicerSkeletalRepresentationInitializerLogic::GenerateSrep(std::string& output)
 {
-    std::string tempDir(this->GetApplicationLogic()->GetTemporaryPath());
-    output = tempDir +  "/ellipsoid.m3d";
+    if(srepModel == NULL)
+    {
+        vtkErrorMacro("No s-rep has been generated yet.");
+        return -1;
+    }
+    return AddSrepNode(srepModel, "ellipsoid_srep", output);
+}
+
+int vtkSlicerSkeletalRepresentationInitializerLogic::AddSrepNode(vtkMultiBlockDataSet* srep, const char* name, std::string& nodeID)
+{
+    vtkMRMLScene *scene = this->GetMRMLScene();
+    if(!scene)
+    {
+        vtkErrorMacro(" Invalid scene");
+        return -1;
+    }
+    CheckSrepValidity(srep);
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(
+                scene->AddNewNodeByClass("vtkMRMLSrepNode", scene->GenerateUniqueName(name)));
+    if(srepNode == NULL)
+    {
+        vtkErrorMacro("Cannot add an s-rep node to the scene, is vtkMRMLSrepNode registered?");
+        return -1;
+    }
+    srepNode->SetSrep(srep);
+    srepNode->CreateDefaultDisplayNodes();
+    nodeID = srepNode->GetID();
+    return 0;
+}
+
+vtkIdType vtkSlicerSkeletalRepresentationInitializerLogic::CheckMeshValidity(vtkPolyData* mesh, int iteration)
+{
+    vtkValidityChecker::PairList pairs;
+    vtkIdType nPairs = vtkValidityChecker::FindSelfIntersections(mesh, &pairs);
+    if(nPairs > 0)
+    {
+        vtkWarningMacro("The flowed mesh intersects itself at iteration " << iteration << ": " << nPairs
+                        << " pairs of cells, e.g. " << pairs[0].first << " and " << pairs[0].second);
+    }
+    return nPairs;
+}
 
+vtkIdType vtkSlicerSkeletalRepresentationInitializerLogic::CheckSrepValidity(vtkMultiBlockDataSet* srep)
+{
+    vtkValidityChecker::PairList pairs;
+    vtkIdType nPairs = vtkValidityChecker::FindSpokeCrossings(srep, this->SpokeCrossingTolerance, &pairs);
+    if(nPairs > 0)
+    {
+        vtkWarningMacro("The s-rep has " << nPairs << " pairs of crossing spokes (up, down, then crest), e.g. "
+                        << pairs[0].first << " and " << pairs[0].second);
+    }
+    return nPairs;
+}
+
+int vtkSlicerSkeletalRepresentationInitializerLogic::WriteSrep(const std::string& headerFileName)
+{
+    if(srepModel == NULL)
+    {
+        vtkErrorMacro("No s-rep has been generated yet.");
+        return -1;
+    }
+    if(!vtkSrepIO::WriteSrep(srepModel, headerFileName))
+    {
+        vtkErrorMacro("Failed to write s-rep to " << headerFileName);
+        return -1;
+    }
+    return 0;
+}
+
+vtkMRMLSrepNode* vtkSlicerSkeletalRepresentationInitializerLogic::LoadSrep(const std::string& fileName)
+{
+    vtkMRMLScene *scene = this->GetMRMLScene();
+    if(!scene)
+    {
+        vtkErrorMacro(" Invalid scene");
+        return NULL;
+    }
+    std::string name = vtksys::SystemTools::GetFilenameWithoutExtension(fileName);
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(
+                scene->AddNewNodeByClass("vtkMRMLSrepNode", scene->GenerateUniqueName(name)));
+    if(srepNode == NULL)
+    {
+        vtkErrorMacro("Cannot add an s-rep node to the scene, is vtkMRMLSrepNode registered?");
+        return NULL;
+    }
+    vtkSmartPointer<vtkMRMLStorageNode> storageNode = vtkSmartPointer<vtkMRMLStorageNode>::Take(srepNode->CreateDefaultStorageNode());
+    scene->AddNode(storageNode);
+    srepNode->SetAndObserveStorageNodeID(storageNode->GetID());
+    storageNode->SetFileName(fileName.c_str());
+    if(!storageNode->ReadData(srepNode) || !vtkSrepModel::IsValid(srepNode->GetSrep()))
+    {
+        vtkErrorMacro("Failed to read s-rep: " << fileName);
+        scene->RemoveNode(storageNode);
+        scene->RemoveNode(srepNode);
+        return NULL;
+    }
+    srepNode->CreateDefaultDisplayNodes();
+    return srepNode;
+}
+
+int vtkSlicerSkeletalRepresentationInitializerLogic::VisualizeSrep(const std::string& headerFileName)
+{
+    vtkMRMLSrepNode* srepNode = LoadSrep(headerFileName);
+    if(srepNode == NULL)
+    {
+        return -1;
+    }
+    return VisualizeSrepNode(srepNode);
+}
+
+int vtkSlicerSkeletalRepresentationInitializerLogic::VisualizeSrepNode(vtkMRMLSrepNode* srepNode)
+{
+    vtkMRMLScene *scene = this->GetMRMLScene();
+    if(!scene)
+    {
+        vtkErrorMacro(" Invalid scene");
+        return -1;
+    }
+    vtkMultiBlockDataSet* srep = srepNode != NULL ? srepNode->GetSrep() : NULL;
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        vtkErrorMacro("No s-rep to visualize in node " << (srepNode != NULL ? srepNode->GetID() : "(none)"));
+        return -1;
+    }
+    // the s-rep itself is drawn by the displayable manager through the display node of the s-rep node
+    if(srepNode->GetDisplayNode() == NULL)
+    {
+        srepNode->CreateDefaultDisplayNodes();
+    }
+
+    scene->StartState(vtkMRMLScene::BatchProcessState);
+    // implied boundary (hidden), replaced by the boundary of the current s-rep
+    vtkMRMLModelNode* boundaryNode = vtkMRMLModelNode::SafeDownCast(srepNode->GetNodeReference("impliedBoundary"));
+    vtkImpliedBoundary impliedBoundary;
+    impliedBoundary.SetResolution(this->ImpliedBoundaryResolution);
+    if(this->ImpliedBoundaryResolution > 0 && impliedBoundary.Update(srep))
+    {
+        if(boundaryNode == NULL)
+        {
+            std::string name = std::string(srepNode->GetName()) + " Implied Boundary";
+            boundaryNode = AddModelNodeToScene(impliedBoundary.GetOutput(), name.c_str(), false, 0.8, 0.8, 0.8);
+            srepNode->SetNodeReferenceID("impliedBoundary", boundaryNode != NULL ? boundaryNode->GetID() : NULL);
+        }
+        else
+        {
+            boundaryNode->SetAndObservePolyData(impliedBoundary.GetOutput());
+        }
+    }
+    else if(boundaryNode != NULL)
+    {
+        if(boundaryNode->GetDisplayNode() != NULL)
+        {
+            scene->RemoveNode(boundaryNode->GetDisplayNode());
+        }
+        scene->RemoveNode(boundaryNode);
+    }
+
+    // medial points, locked until editing them updates the connected structures
+    vtkMRMLMarkupsFiducialNode* fidNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(srepNode->GetNodeReference("medialPoints"));
+    if(fidNode == NULL)
+    {
+        vtkSmartPointer<vtkMRMLMarkupsDisplayNode> fidDisplayNode = vtkSmartPointer<vtkMRMLMarkupsDisplayNode>::New();
+        fidDisplayNode->SetGlyphScale(0.01);
+        fidDisplayNode->SetSelectedColor(1.0, 1.0, 0.0);
+        fidDisplayNode->SetTextScale(0.0);
+        scene->AddNode(fidDisplayNode);
+        vtkSmartPointer<vtkMRMLMarkupsFiducialNode> newFidNode = vtkSmartPointer<vtkMRMLMarkupsFiducialNode>::New();
+        newFidNode->SetName((std::string(srepNode->GetName()) + " Medial Points").c_str());
+        newFidNode->SetLocked(true);
+        scene->AddNode(newFidNode);
+        newFidNode->SetAndObserveDisplayNodeID(fidDisplayNode->GetID());
+        srepNode->SetNodeReferenceID("medialPoints", newFidNode->GetID());
+        fidNode = newFidNode;
+    }
+    // all the points at once: one point added event instead of one per point, extra points are removed
+    fidNode->SetControlPointPositionsWorld(vtkSrepModel::GetUpSpokes(srep)->GetPoints());
+    scene->EndState(vtkMRMLScene::BatchProcessState);
     return 0;
 }
@@ -29,13 +29,22 @@
 
 // MRML includes
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
 // STD includes
 #include <cstdlib>
+#include <memory>
 
 #include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
 
 class vtkPolyData;
 class vtkPoints;
+class vtkMultiBlockDataSet;
+class vtkMRMLModelNode;
+class vtkMRMLSrepNode;
+class vtkTriangleBVH;
+class vtkSignedDistanceField;
 
 /// \ingroup Slicer_QtModules_ExtensionTemplate
 class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkSlicerSkeletalRepresentationInitializerLogic :
@@ -71,17 +80,96 @@ public:
   int ShowFittingEllipsoid(vtkPolyData* mesh, double &rx, double &ry, double &rz);
 
   // generate srep given an ellipsoid and expected rows and columns of medial sheet.
+  // input[rows]: odd number of rows of the skeletal grid, at least 3
+  // input[cols]: odd number of columns of the skeletal grid, at least 3
   int GenerateSrepForEllipsoid(vtkPolyData* mesh, int rows, int cols);
 
-  int InklingFlow(const std::string &filename, double dt, double smooth_amount, int max_iter, int freq_output, double threshold);
+  // size of the skeletal grid of the s-rep generated at the end of the forward flow,
+  // odd numbers of rows and columns, at least 3 each
+  vtkSetMacro(NumberOfRows, int);
+  vtkGetMacro(NumberOfRows, int);
+  vtkSetMacro(NumberOfColumns, int);
+  vtkGetMacro(NumberOfColumns, int);
 
-  int BackwardFlow();
+  int InklingFlow(const std::string &filename, double dt, double smooth_amount, int max_iter, int freq_output, double threshold);
 
-  // For the sake of completion of backward flow,
-  // add this function to show what the process like.
-  // This will be replaced by BackwardFlow later.
-  int DummyBackwardFlow(std::string& output);
+  // carry the s-rep generated at the end of the forward flow back to the input object
+  // through the TPS of every consecutive pair of forward flow snapshots
+  // output: ID of the s-rep node added to the scene
+  int BackwardFlow(std::string& output);
+
+  // solve the TPS of the backward flow one pair after the other, every iterative solve
+  // warm-started from the previous pair, instead of all pairs concurrently from scratch
+  vtkSetMacro(SequentialBackwardFlow, bool);
+  vtkGetMacro(SequentialBackwardFlow, bool);
+  vtkBooleanMacro(SequentialBackwardFlow, bool);
+
+  // largest warp error allowed when the backward flow skips snapshots between keyframes,
+  // in the units of the input mesh; 0 keeps one TPS per pair of consecutive snapshots
+  vtkSetMacro(KeyframeTolerance, double);
+  vtkGetMacro(KeyframeTolerance, double);
+
+  // warp error the landmarks of every backward flow TPS must meet, in the units of the input mesh;
+  // 0 takes every 10th vertex as a landmark
+  vtkSetMacro(LandmarkErrorTarget, double);
+  vtkGetMacro(LandmarkErrorTarget, double);
+
+  // carry the s-rep back by vertex correspondence between the last snapshot and the input mesh instead of TPS
+  vtkSetMacro(CorrespondenceBackwardFlow, bool);
+  vtkGetMacro(CorrespondenceBackwardFlow, bool);
+  vtkBooleanMacro(CorrespondenceBackwardFlow, bool);
+
+  // optimize the hubs, spoke directions and spoke lengths of the backward flow s-rep against the input mesh:
+  // boundary distance of the spoke tips, alignment of the spokes with the boundary normals and regularity
+  // of the skeletal grid and fold curve, see vtkSrepOptimizer
+  vtkSetMacro(OptimizeSrep, bool);
+  vtkGetMacro(OptimizeSrep, bool);
+  vtkBooleanMacro(OptimizeSrep, bool);
+
+  // number of cells of the signed distance field of the input mesh along its longest side
+  vtkSetMacro(DistanceFieldResolution, int);
+  vtkGetMacro(DistanceFieldResolution, int);
+
+  // cast every spoke of the backward flow s-rep against the input mesh and set its length
+  // so that the tip lies on the boundary; the change of length is kept as "spokeResidual"
+  vtkSetMacro(RefineSpokeLengths, bool);
+  vtkGetMacro(RefineSpokeLengths, bool);
+  vtkBooleanMacro(RefineSpokeLengths, bool);
+
+  // number of flow iterations between two checks of the flowed mesh for self intersections; 0 checks none
+  vtkSetMacro(ValidityCheckInterval, int);
+  vtkGetMacro(ValidityCheckInterval, int);
+
+  // distance under which two spokes of a generated s-rep count as crossing, relative to the mean spoke length
+  vtkSetMacro(SpokeCrossingTolerance, double);
+  vtkGetMacro(SpokeCrossingTolerance, double);
+
+  // interpolation steps per interval of the skeletal grid of the implied boundary shown with an s-rep,
+  // see vtkImpliedBoundary; 0 shows no implied boundary
+  vtkSetMacro(ImpliedBoundaryResolution, int);
+  vtkGetMacro(ImpliedBoundaryResolution, int);
+
+  // add the s-rep generated at the end of the flow to the scene as an s-rep node
+  // output: ID of the s-rep node, the s-rep is written to disk only when the scene is saved
   int GenerateSrep(std::string& output);
+
+  // write the last generated s-rep in the new s-rep format
+  // input[headerFileName]: header.xml to write, up.vtp, down.vtp and crest.vtp go to the same folder
+  int WriteSrep(const std::string& headerFileName);
+
+  // read an s-rep file (header of the new s-rep format or legacy m3d) into a new s-rep node,
+  // through its storage node
+  // return NULL if the file cannot be read
+  vtkMRMLSrepNode* LoadSrep(const std::string& fileName);
+
+  // show the s-rep of a node: its display node draws the spokes, medial mesh and fold curve,
+  // the medial points are added as locked fiducials and the implied boundary as a hidden model.
+  // The fiducials and the implied boundary are referenced by the node and replaced when it is shown again
+  int VisualizeSrepNode(vtkMRMLSrepNode* srepNode);
+
+  // load an s-rep file into a new s-rep node and show it, see LoadSrep and VisualizeSrepNode
+  // input[headerFileName]: header.xml of the s-rep
+  int VisualizeSrep(const std::string& headerFileName);
   
 protected:
   vtkSlicerSkeletalRepresentationInitializerLogic();
@@ -95,9 +183,19 @@ protected:
   virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
 
 private:
-  void AddModelNodeToScene(vtkPolyData* mesh, const char* modelName, bool isModelVisible, double r = 0.25, double g = 0.25, double b = 0.25);
+  vtkMRMLModelNode* AddModelNodeToScene(vtkPolyData* mesh, const char* modelName, bool isModelVisible, double r = 0.25, double g = 0.25, double b = 0.25);
   void HideNodesByNameByClass(const std::string & nodeName, const std::string &className);
   void AddPointToScene(double x, double y, double z, int glyphType, double r = 1, double g = 0, double b = 0);
+  // add an s-rep node holding the s-rep (no copy) with its default display node
+  int AddSrepNode(vtkMultiBlockDataSet* srep, const char* name, std::string& nodeID);
+  // optimize the s-rep and refine its spoke lengths against the input mesh, as OptimizeSrep and RefineSpokeLengths ask
+  int FitSrepToInputMesh(vtkMultiBlockDataSet* srep);
+  // build the triangle hierarchy and the signed distance field of the input mesh, unless they are up to date
+  int UpdateInputBoundary();
+  // warn about self intersections of the mesh at a flow iteration and about crossing spokes of an s-rep,
+  // see vtkValidityChecker; return the number of intersecting pairs
+  vtkIdType CheckMeshValidity(vtkPolyData* mesh, int iteration);
+  vtkIdType CheckSrepValidity(vtkMultiBlockDataSet* srep);
 
 private:
 
@@ -106,6 +204,29 @@ private:
 
 private:
   int forwardCount = 0;
+  int NumberOfRows = 5;
+  int NumberOfColumns = 5;
+  bool SequentialBackwardFlow = false;
+  double KeyframeTolerance = 0.0;
+  double LandmarkErrorTarget = 0.0;
+  bool CorrespondenceBackwardFlow = false;
+  bool OptimizeSrep = false;
+  bool RefineSpokeLengths = false;
+  int DistanceFieldResolution = 128;
+  int ValidityCheckInterval = 10;
+  double SpokeCrossingTolerance = 1e-3;
+  int ImpliedBoundaryResolution = 5;
+  // input mesh of the last forward flow, first snapshot of the backward flow
+  std::string inputFileName;
+  // s-rep generated at the end of the forward flow, in the new s-rep format
+  vtkSmartPointer<vtkMultiBlockDataSet> srepModel;
+  // triangle hierarchy and signed distance field of the input mesh, shared by every fit and check
+  // against it; built for boundaryFileName at boundaryResolution
+  // owned here, the destructor is defined where both classes are complete
+  std::unique_ptr<vtkTriangleBVH> inputBoundary;
+  std::unique_ptr<vtkSignedDistanceField> inputDistanceField;
+  std::string boundaryFileName;
+  int boundaryResolution = 0;
 };
 
 #endif
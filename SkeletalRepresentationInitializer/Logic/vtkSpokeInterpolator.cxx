@@ -0,0 +1,301 @@
+// This class provides the spokes of an s-rep at any position of its skeletal sheet and fold curve
+#include "vtkSpokeInterpolator.h"
+#include "vtkSrepModel.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+// Catmull-Rom basis: the weights of the 4 control points at t are [1 t t^2 t^3] * BASIS
+Eigen::Matrix4d CatmullRomBasis()
+{
+    Eigen::Matrix4d basis;
+    basis <<    0,    1,    0,    0,
+             -0.5,    0,  0.5,    0,
+                1, -2.5,    2, -0.5,
+             -0.5,  1.5, -1.5,  0.5;
+    return basis;
+}
+const Eigen::Matrix4d BASIS = CatmullRomBasis();
+
+vtkIdType Clamp(vtkIdType i, vtkIdType n)
+{
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+}
+
+// interval of n - 1 intervals holding x, clamped, and the position of x in it
+vtkIdType LocateClamped(double x, vtkIdType n, double& t)
+{
+    x = std::min(std::max(x, 0.0), static_cast<double>(n - 1));
+    vtkIdType interval = std::min(static_cast<vtkIdType>(x), n - 2);
+    t = x - interval;
+    return interval;
+}
+
+// interval of a closed curve of n intervals holding x, and the position of x in it
+vtkIdType LocatePeriodic(double x, vtkIdType n, double& t)
+{
+    x -= std::floor(x / n) * n;
+    vtkIdType interval = std::min(static_cast<vtkIdType>(x), n - 1);
+    t = x - interval;
+    return interval;
+}
+}
+
+// evaluate the queries [begin, end)
+class vtkSpokeInterpolator::EvaluateFunctor
+{
+public:
+    EvaluateFunctor(const vtkSpokeInterpolator& self, int block, const double* positions,
+                    double* hubs, double* directions, double* lengths)
+        : Self(self), Block(block), Positions(positions), Hubs(hubs), Directions(directions), Lengths(lengths) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        const CoefficientMatrixType& coefficients = this->Self.Coefficients[this->Block];
+        Eigen::Matrix<double, 1, NumberOfChannels> value;
+        for(vtkIdType q = begin; q < end; ++q)
+        {
+            if(this->Block == vtkSrepModel::CrestBlock)
+            {
+                double t = 0;
+                vtkIdType interval = LocatePeriodic(this->Positions[q], coefficients.rows() / 4, t);
+                Eigen::RowVector4d powers(1, t, t * t, t * t * t);
+                value.noalias() = powers * coefficients.middleRows<4>(4 * interval);
+            }
+            else
+            {
+                double u = 0, v = 0;
+                vtkIdType pr = LocateClamped(this->Positions[2 * q], this->Self.NumberOfRows, u);
+                vtkIdType pc = LocateClamped(this->Positions[2 * q + 1], this->Self.NumberOfColumns, v);
+                Eigen::Vector4d uPowers(1, u, u * u, u * u * u);
+                Eigen::RowVector4d vPowers(1, v, v * v, v * v * v);
+                Eigen::Matrix<double, 1, 16> monomials;
+                Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor> >(monomials.data()).noalias() = uPowers * vPowers;
+                vtkIdType patch = pr * (this->Self.NumberOfColumns - 1) + pc;
+                value.noalias() = monomials * coefficients.middleRows<16>(16 * patch);
+            }
+            if(this->Hubs != NULL)
+            {
+                Eigen::Map<Eigen::RowVector3d>(this->Hubs + 3 * q) = value.segment<3>(0);
+            }
+            if(this->Directions != NULL)
+            {
+                Eigen::Map<Eigen::RowVector3d>(this->Directions + 3 * q) = value.segment<3>(3).normalized();
+            }
+            if(this->Lengths != NULL)
+            {
+                this->Lengths[q] = std::max(value(6), 0.0);
+            }
+        }
+    }
+
+private:
+    const vtkSpokeInterpolator& Self;
+    int Block;
+    const double* Positions;
+    double* Hubs;
+    double* Directions;
+    double* Lengths;
+};
+
+vtkSpokeInterpolator::vtkSpokeInterpolator()
+    : NumberOfRows(0), NumberOfColumns(0)
+{
+}
+
+bool vtkSpokeInterpolator::Update(vtkMultiBlockDataSet* srep)
+{
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "Spoke interpolation needs a valid s-rep" << std::endl;
+        return false;
+    }
+    int nRows = vtkSrepModel::GetNumberOfRows(srep);
+    int nCols = vtkSrepModel::GetNumberOfColumns(srep);
+    vtkIdType nCrest = 2 * nRows + 2 * (nCols - 2);
+    if(nRows < 2 || nCols < 2
+        || vtkSrepModel::GetUpSpokes(srep)->GetNumberOfPoints() != nRows * nCols
+        || vtkSrepModel::GetDownSpokes(srep)->GetNumberOfPoints() != nRows * nCols
+        || vtkSrepModel::GetCrestSpokes(srep)->GetNumberOfPoints() != nCrest)
+    {
+        std::cerr << "Spoke interpolation needs the crest spokes to follow the boundary of the skeletal grid" << std::endl;
+        return false;
+    }
+    this->Srep = srep;
+    this->NumberOfRows = nRows;
+    this->NumberOfColumns = nCols;
+    const vtkIdType nPatches = (nRows - 1) * (nCols - 1);
+    for(int b = 0; b < 3; ++b)
+    {
+        vtkIdType nSpokes = b == vtkSrepModel::CrestBlock ? nCrest : nRows * nCols;
+        this->Spokes[b].setZero(nSpokes, NumberOfChannels);
+        for(vtkIdType i = 0; i < nSpokes; ++i)
+        {
+            this->ReadSpoke(b, i);
+        }
+        this->Coefficients[b].resize(b == vtkSrepModel::CrestBlock ? 4 * nCrest : 16 * nPatches, NumberOfChannels);
+    }
+    for(vtkIdType patch = 0; patch < nPatches; ++patch)
+    {
+        this->UpdatePatch(vtkSrepModel::UpBlock, patch);
+        this->UpdatePatch(vtkSrepModel::DownBlock, patch);
+    }
+    for(vtkIdType i = 0; i < nCrest; ++i)
+    {
+        this->UpdateInterval(i);
+    }
+    return true;
+}
+
+bool vtkSpokeInterpolator::UpdateSpoke(int block, vtkIdType spokeId)
+{
+    if(this->Srep == NULL || block < vtkSrepModel::UpBlock || block > vtkSrepModel::CrestBlock
+        || spokeId < 0 || spokeId >= this->Spokes[block].rows())
+    {
+        std::cerr << "Spoke interpolation has no spoke " << spokeId << " in block " << block << std::endl;
+        return false;
+    }
+    if(block == vtkSrepModel::CrestBlock)
+    {
+        this->ReadSpoke(block, spokeId);
+        // an interval depends on the crest spokes at its ends and on the next on either side
+        vtkIdType nCrest = this->Spokes[block].rows();
+        for(vtkIdType i = spokeId - 2; i <= spokeId + 1; ++i)
+        {
+            this->UpdateInterval((i + 2 * nCrest) % nCrest);
+        }
+        return true;
+    }
+    // up and down spokes share their hubs, both sides are read again
+    this->ReadSpoke(vtkSrepModel::UpBlock, spokeId);
+    this->ReadSpoke(vtkSrepModel::DownBlock, spokeId);
+    // a patch depends on the 4 x 4 spokes around it
+    const int nRows = this->NumberOfRows;
+    const int nCols = this->NumberOfColumns;
+    vtkIdType r = spokeId / nCols, c = spokeId % nCols;
+    for(vtkIdType pr = std::max<vtkIdType>(r - 2, 0); pr <= std::min<vtkIdType>(r + 1, nRows - 2); ++pr)
+    {
+        for(vtkIdType pc = std::max<vtkIdType>(c - 2, 0); pc <= std::min<vtkIdType>(c + 1, nCols - 2); ++pc)
+        {
+            this->UpdatePatch(vtkSrepModel::UpBlock, pr * (nCols - 1) + pc);
+            this->UpdatePatch(vtkSrepModel::DownBlock, pr * (nCols - 1) + pc);
+        }
+    }
+    return true;
+}
+
+void vtkSpokeInterpolator::Evaluate(int block, const double* positions, vtkIdType nQueries,
+                                    double* hubs, double* directions, double* lengths) const
+{
+    if(!this->CanEvaluate(block))
+    {
+        return;
+    }
+    EvaluateFunctor functor(*this, block, positions, hubs, directions, lengths);
+    vtkSMPTools::For(0, nQueries, functor);
+}
+
+void vtkSpokeInterpolator::EvaluateSerial(int block, const double* positions, vtkIdType nQueries,
+                                          double* hubs, double* directions, double* lengths) const
+{
+    if(!this->CanEvaluate(block))
+    {
+        return;
+    }
+    EvaluateFunctor functor(*this, block, positions, hubs, directions, lengths);
+    functor(0, nQueries);
+}
+
+vtkSmartPointer<vtkPolyData> vtkSpokeInterpolator::NewSpokes(int block, const double* positions, vtkIdType nQueries) const
+{
+    vtkSmartPointer<vtkPolyData> spokes = vtkSmartPointer<vtkPolyData>::New();
+    vtkEigenArrayBridge::PointMatrixMap hubs = vtkEigenArrayBridge::AllocatePoints(spokes, nQueries);
+    vtkSmartPointer<vtkDoubleArray> directions = vtkSmartPointer<vtkDoubleArray>::New();
+    directions->SetName("spokeDirection");
+    directions->SetNumberOfComponents(3);
+    directions->SetNumberOfTuples(nQueries);
+    vtkSmartPointer<vtkDoubleArray> lengths = vtkSmartPointer<vtkDoubleArray>::New();
+    lengths->SetName("spokeLength");
+    lengths->SetNumberOfComponents(1);
+    lengths->SetNumberOfTuples(nQueries);
+    this->Evaluate(block, positions, nQueries, hubs.data(), directions->GetPointer(0), lengths->GetPointer(0));
+    spokes->GetPointData()->AddArray(directions);
+    spokes->GetPointData()->AddArray(lengths);
+    return spokes;
+}
+
+bool vtkSpokeInterpolator::CanEvaluate(int block) const
+{
+    if(this->Srep == NULL || block < vtkSrepModel::UpBlock || block > vtkSrepModel::CrestBlock)
+    {
+        std::cerr << "Spoke interpolation has no block " << block << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void vtkSpokeInterpolator::ReadSpoke(int block, vtkIdType spokeId)
+{
+    vtkPolyData* spokes = vtkPolyData::SafeDownCast(this->Srep->GetBlock(block));
+    double hub[3], direction[3];
+    spokes->GetPoint(spokeId, hub);
+    spokes->GetPointData()->GetArray("spokeDirection")->GetTuple(spokeId, direction);
+    this->Spokes[block].row(spokeId) << hub[0], hub[1], hub[2], direction[0], direction[1], direction[2],
+        spokes->GetPointData()->GetArray("spokeLength")->GetTuple1(spokeId), 0;
+}
+
+void vtkSpokeInterpolator::UpdatePatch(int block, vtkIdType patch)
+{
+    const int nRows = this->NumberOfRows;
+    const int nCols = this->NumberOfColumns;
+    vtkIdType pr = patch / (nCols - 1), pc = patch % (nCols - 1);
+    // coefficients of u^i v^j: BASIS * P * BASIS^T for the 4 x 4 control values P of every channel
+    Eigen::Matrix<double, 4, 4 * NumberOfChannels> rows;
+    for(int a = 0; a < 4; ++a)
+    {
+        Eigen::Matrix<double, 4, NumberOfChannels> controls;
+        for(int b = 0; b < 4; ++b)
+        {
+            vtkIdType id = Clamp(pr - 1 + a, nRows) * nCols + Clamp(pc - 1 + b, nCols);
+            controls.row(b) = this->Spokes[block].row(id);
+        }
+        // along the columns first: coefficients of v^j of control row a
+        Eigen::Matrix<double, 4, NumberOfChannels> alongColumns = BASIS * controls;
+        for(int j = 0; j < 4; ++j)
+        {
+            rows.block<1, NumberOfChannels>(a, j * NumberOfChannels) = alongColumns.row(j);
+        }
+    }
+    Eigen::Matrix<double, 4, 4 * NumberOfChannels> monomials = BASIS * rows;
+    for(int i = 0; i < 4; ++i)
+    {
+        for(int j = 0; j < 4; ++j)
+        {
+            this->Coefficients[block].row(16 * patch + 4 * i + j) = monomials.block<1, NumberOfChannels>(i, j * NumberOfChannels);
+        }
+    }
+}
+
+void vtkSpokeInterpolator::UpdateInterval(vtkIdType interval)
+{
+    const CoefficientMatrixType& spokes = this->Spokes[vtkSrepModel::CrestBlock];
+    vtkIdType nCrest = spokes.rows();
+    Eigen::Matrix<double, 4, NumberOfChannels> controls;
+    for(int a = 0; a < 4; ++a)
+    {
+        controls.row(a) = spokes.row((interval - 1 + a + nCrest) % nCrest);
+    }
+    this->Coefficients[vtkSrepModel::CrestBlock].middleRows<4>(4 * interval) = BASIS * controls;
+}
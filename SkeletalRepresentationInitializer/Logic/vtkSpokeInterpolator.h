@@ -0,0 +1,71 @@
+// This class provides the spokes of an s-rep at any position of its skeletal sheet and fold curve
+// Hubs, directions and lengths are interpolated with Catmull-Rom cubics, i.e. cubic Hermite splines whose
+// tangents are the central differences of the spokes: bicubic over every patch of the skeletal grid for the
+// up and down spokes, cubic over every interval of the closed fold curve for the crest spokes. The polynomial
+// coefficients of every patch and interval are computed once per s-rep, and again only around a changed spoke,
+// so that a query is one small matrix product.
+#ifndef __vtkSpokeInterpolator_h
+#define __vtkSpokeInterpolator_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+#include "vtkEigenArrayBridge.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+
+class vtkMultiBlockDataSet;
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkSpokeInterpolator {
+public:
+    vtkSpokeInterpolator();
+
+    // compute the coefficients of every patch and interval of the s-rep, which is kept for UpdateSpoke
+    // return false if the s-rep is not valid or its crest does not follow the boundary of its grid
+    bool Update(vtkMultiBlockDataSet* srep);
+    // compute again the coefficients that depend on spoke spokeId of a block
+    // (vtkSrepModel::UpBlock, DownBlock or CrestBlock) after it changed in the s-rep given to Update
+    bool UpdateSpoke(int block, vtkIdType spokeId);
+
+    int GetNumberOfRows() const {return NumberOfRows;}
+    int GetNumberOfColumns() const {return NumberOfColumns;}
+    vtkIdType GetNumberOfCrestSpokes() const {return Coefficients[2].rows() / 4;}
+
+    // spokes of a block at nQueries positions, in parallel over the queries
+    // up and down: positions u0 v0 u1 v1 ... in grid units, spoke (r, c) of the grid is at (r, c), clamped to the grid
+    // crest: positions t0 t1 ..., crest spoke i is at i, taken modulo the number of crest spokes
+    // hubs and directions are written x0 y0 z0 x1 y1 z1 ..., lengths one per query; any of them can be NULL
+    void Evaluate(int block, const double* positions, vtkIdType nQueries,
+                  double* hubs, double* directions, double* lengths) const;
+    // same in the calling thread, for callers that already run in parallel
+    void EvaluateSerial(int block, const double* positions, vtkIdType nQueries,
+                        double* hubs, double* directions, double* lengths) const;
+    // same as spoke polydata with "spokeDirection" and "spokeLength", cells are left to the caller
+    vtkSmartPointer<vtkPolyData> NewSpokes(int block, const double* positions, vtkIdType nQueries) const;
+
+private:
+    // hub, direction, length and one unused channel, so that a row of coefficients is 8 doubles
+    enum {NumberOfChannels = 8};
+    typedef Eigen::Matrix<double, Eigen::Dynamic, NumberOfChannels, Eigen::RowMajor> CoefficientMatrixType;
+
+    // return false with a message if no s-rep is interpolated or the block does not exist
+    bool CanEvaluate(int block) const;
+    void ReadSpoke(int block, vtkIdType spokeId);
+    // coefficients of monomial u^i v^j at row 16 * patch + 4 * i + j
+    void UpdatePatch(int block, vtkIdType patch);
+    // coefficients of monomial t^i at row 4 * interval + i
+    void UpdateInterval(vtkIdType interval);
+
+    vtkSmartPointer<vtkMultiBlockDataSet> Srep;
+    int NumberOfRows;
+    int NumberOfColumns;
+    // control values of the spokes of every block, one row per spoke
+    CoefficientMatrixType Spokes[3];
+    CoefficientMatrixType Coefficients[3];
+
+    class EvaluateFunctor;
+};
+#endif
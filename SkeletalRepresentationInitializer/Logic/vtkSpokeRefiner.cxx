@@ -0,0 +1,153 @@
+// This class provides refinement of the spoke lengths of an s-rep against the boundary it represents
+#include "vtkSpokeRefiner.h"
+#include "vtkTriangleBVH.h"
+#include "vtkSrepModel.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+const char* RESIDUAL_ARRAY_NAME = "spokeResidual";
+
+// cast the spokes [begin, end) of one block, the arrays are written at the index of the spoke only
+class RefineFunctor
+{
+public:
+    RefineFunctor(vtkPolyData* spokes, vtkDataArray* directions, vtkDoubleArray* lengths,
+                  vtkDoubleArray* residuals, const vtkTriangleBVH& boundary)
+        : Spokes(spokes), Directions(directions), Lengths(lengths), Residuals(residuals), Boundary(boundary) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            double hub[3], direction[3];
+            this->Spokes->GetPoint(i, hub);
+            this->Directions->GetTuple(i, direction);
+            // the ray parameter is the spoke length only along a unit direction
+            double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+            double t = 0;
+            vtkIdType cellId = -1;
+            if(norm == 0)
+            {
+                this->Residuals->SetValue(i, std::numeric_limits<double>::quiet_NaN());
+                continue;
+            }
+            for(int k = 0; k < 3; ++k)
+            {
+                direction[k] /= norm;
+            }
+            this->Directions->SetTuple(i, direction);
+            // the first crossing of a ray from a hub outside the boundary is not the tip of its spoke
+            double closest[3], normal[3];
+            if(this->Boundary.FindClosestPoint(hub, closest, normal, cellId) > 0
+                    && (hub[0] - closest[0]) * normal[0] + (hub[1] - closest[1]) * normal[1] + (hub[2] - closest[2]) * normal[2] > 0)
+            {
+                this->Residuals->SetValue(i, std::numeric_limits<double>::quiet_NaN());
+                continue;
+            }
+            if(!this->Boundary.IntersectRay(hub, direction, 0, std::numeric_limits<double>::max(), t, cellId))
+            {
+                this->Residuals->SetValue(i, std::numeric_limits<double>::quiet_NaN());
+                continue;
+            }
+            this->Residuals->SetValue(i, t - this->Lengths->GetValue(i));
+            this->Lengths->SetValue(i, t);
+        }
+    }
+
+private:
+    vtkPolyData* Spokes;
+    vtkDataArray* Directions;
+    vtkDoubleArray* Lengths;
+    vtkDoubleArray* Residuals;
+    const vtkTriangleBVH& Boundary;
+};
+}
+
+vtkIdType vtkSpokeRefiner::RefineSpokeLengths(vtkMultiBlockDataSet* srep, const vtkTriangleBVH& boundary)
+{
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "Spoke refinement needs a valid s-rep" << std::endl;
+        return -1;
+    }
+    vtkPolyData* blocks[3] = {vtkSrepModel::GetUpSpokes(srep), vtkSrepModel::GetDownSpokes(srep), vtkSrepModel::GetCrestSpokes(srep)};
+    vtkIdType nRefined = 0;
+    for(int b = 0; b < 3; ++b)
+    {
+        vtkPolyData* spokes = blocks[b];
+        vtkIdType nSpokes = spokes->GetNumberOfPoints();
+        vtkDataArray* directions = spokes->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* oldLengths = spokes->GetPointData()->GetArray("spokeLength");
+        // the functor writes the lengths through the double array directly
+        vtkDoubleArray* lengths = vtkDoubleArray::FastDownCast(oldLengths);
+        if(lengths == NULL)
+        {
+            vtkSmartPointer<vtkDoubleArray> copy = vtkSmartPointer<vtkDoubleArray>::New();
+            copy->DeepCopy(oldLengths);
+            copy->SetName("spokeLength");
+            spokes->GetPointData()->AddArray(copy);
+            lengths = copy;
+        }
+        vtkSmartPointer<vtkDoubleArray> residuals = vtkSmartPointer<vtkDoubleArray>::New();
+        residuals->SetName(RESIDUAL_ARRAY_NAME);
+        residuals->SetNumberOfComponents(1);
+        residuals->SetNumberOfTuples(nSpokes);
+        spokes->GetPointData()->AddArray(residuals);
+
+        RefineFunctor functor(spokes, directions, lengths, residuals, boundary);
+        vtkSMPTools::For(0, nSpokes, functor);
+        for(vtkIdType i = 0; i < nSpokes; ++i)
+        {
+            if(!std::isnan(residuals->GetValue(i)))
+            {
+                ++nRefined;
+            }
+        }
+        directions->Modified();
+        lengths->Modified();
+        spokes->Modified();
+    }
+    return nRefined;
+}
+
+void vtkSpokeRefiner::GetResidualStatistics(vtkMultiBlockDataSet* srep, double& maxResidual, double& meanResidual)
+{
+    maxResidual = 0;
+    meanResidual = 0;
+    vtkIdType nRefined = 0;
+    for(unsigned int b = 0; srep != NULL && b < srep->GetNumberOfBlocks(); ++b)
+    {
+        vtkPolyData* spokes = vtkPolyData::SafeDownCast(srep->GetBlock(b));
+        vtkDataArray* residuals = spokes == NULL ? NULL : spokes->GetPointData()->GetArray(RESIDUAL_ARRAY_NAME);
+        for(vtkIdType i = 0; residuals != NULL && i < residuals->GetNumberOfTuples(); ++i)
+        {
+            double residual = residuals->GetTuple1(i);
+            if(std::isnan(residual))
+            {
+                continue;
+            }
+            maxResidual = std::max(maxResidual, std::fabs(residual));
+            meanResidual += std::fabs(residual);
+            ++nRefined;
+        }
+    }
+    if(nRefined > 0)
+    {
+        meanResidual /= nRefined;
+    }
+}
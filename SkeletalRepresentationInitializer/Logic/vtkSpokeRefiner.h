@@ -0,0 +1,28 @@
+// This class provides refinement of the spoke lengths of an s-rep against the boundary it represents
+// Every spoke is cast as a ray from its hub along its direction into a bounding volume hierarchy
+// of the boundary triangles, in parallel over the spokes, and its length is set so that the tip
+// lands on the first boundary crossing. Spokes whose hub lies outside the boundary are skipped.
+// The change of length is kept per spoke as the residual.
+#ifndef __vtkSpokeRefiner_h
+#define __vtkSpokeRefiner_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// VTK includes
+#include <vtkType.h>
+
+class vtkMultiBlockDataSet;
+class vtkTriangleBVH;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkSpokeRefiner {
+public:
+    // set spokeLength of the up, down and crest spokes to the distance from the hub to the boundary
+    // along spokeDirection, which is normalized in place, and add the point data array "spokeResidual":
+    // refined minus former length, NaN for a spoke without direction, whose hub lies outside the boundary
+    // or whose ray misses the boundary, its length is then kept
+    // return the number of spokes refined, -1 if the s-rep is not valid
+    static vtkIdType RefineSpokeLengths(vtkMultiBlockDataSet* srep, const vtkTriangleBVH& boundary);
+
+    // largest and mean absolute residual over the spokes refined by the last call on the s-rep
+    static void GetResidualStatistics(vtkMultiBlockDataSet* srep, double& maxResidual, double& meanResidual);
+};
+#endif
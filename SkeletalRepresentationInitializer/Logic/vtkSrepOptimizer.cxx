@@ -0,0 +1,377 @@
+// This class provides the fit of an s-rep to the boundary it represents
+#include "vtkSrepOptimizer.h"
+#include "vtkSignedDistanceField.h"
+#include "vtkSrepModel.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+// Jacobian entries of a spoke: 6 in its distance row and in each of its 3 normal rows
+const int SPOKE_TRIPLETS = 24;
+// Jacobian entries of a second difference: one diagonal of 3 per hub
+const int DIFFERENCE_TRIPLETS = 9;
+// Jacobian entries of a fold attachment: one diagonal of 3 for the fold hub and one for its edge hub
+const int ATTACHMENT_TRIPLETS = 6;
+// attempts to lower E with a growing damping before giving up
+const int MAX_DAMPING_ATTEMPTS = 10;
+}
+
+// residual rows 4s, ..., 4s + 3 and their Jacobian entries for the spokes [begin, end)
+class vtkSrepOptimizer::SpokeFunctor
+{
+public:
+    SpokeFunctor(const vtkSrepOptimizer& optimizer, const State& state, const vtkSignedDistanceField& boundary,
+                 Eigen::VectorXd& residuals, std::vector<Eigen::Triplet<double> >& triplets, Eigen::MatrixXd& tangents)
+        : Optimizer(optimizer), Current(state), Boundary(boundary), Residuals(residuals), Triplets(triplets), Tangents(tangents) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        typedef Eigen::Triplet<double> Triplet;
+        const vtkIdType nHubs = this->Current.Hubs.rows();
+        const double normalWeight = this->Optimizer.NormalWeight * this->Optimizer.MeanLength;
+        for(vtkIdType s = begin; s < end; ++s)
+        {
+            vtkIdType hub = this->Optimizer.SpokeHubs[s];
+            Eigen::Vector3d h = this->Current.Hubs.row(hub).transpose();
+            Eigen::Vector3d u = this->Current.Directions.row(s).transpose();
+            double length = this->Current.Lengths(s);
+
+            // tangent plane of the sphere at u
+            int axis;
+            u.cwiseAbs().minCoeff(&axis);
+            Eigen::Vector3d e1 = u.cross(Eigen::Vector3d::Unit(axis)).normalized();
+            Eigen::Vector3d e2 = u.cross(e1);
+            this->Tangents.block<1, 3>(s, 0) = e1.transpose();
+            this->Tangents.block<1, 3>(s, 3) = e2.transpose();
+
+            Eigen::Vector3d tip = h + length * u;
+            Eigen::Vector3d g;
+            double distance = this->Boundary.Evaluate(tip.data(), g.data());
+            // beyond the band the spoke keeps its direction
+            double gradientNorm = g.norm();
+            Eigen::Vector3d n = gradientNorm > 0 ? Eigen::Vector3d(g / gradientNorm) : u;
+            // derivative of the normal along the tip, by central differences over one cell of the field
+            Eigen::Matrix3d dn = Eigen::Matrix3d::Zero();
+            double delta = this->Boundary.GetSpacing();
+            for(int k = 0; k < 3 && gradientNorm > 0; ++k)
+            {
+                Eigen::Vector3d forward = tip, backward = tip, gForward, gBackward;
+                forward(k) += delta;
+                backward(k) -= delta;
+                this->Boundary.Evaluate(forward.data(), gForward.data());
+                this->Boundary.Evaluate(backward.data(), gBackward.data());
+                if(gForward.norm() > 0 && gBackward.norm() > 0)
+                {
+                    dn.col(k) = (gForward.normalized() - gBackward.normalized()) / (2 * delta);
+                }
+            }
+
+            vtkIdType row = 4 * s;
+            vtkIdType hubColumn = 3 * hub;
+            vtkIdType spokeColumn = 3 * nHubs + 3 * s;
+            Triplet* t = &this->Triplets[SPOKE_TRIPLETS * s];
+            // signed distance of the tip to the boundary
+            this->Residuals(row) = distance;
+            for(int k = 0; k < 3; ++k)
+            {
+                *t++ = Triplet(row, hubColumn + k, g(k));
+            }
+            *t++ = Triplet(row, spokeColumn, length * g.dot(e1));
+            *t++ = Triplet(row, spokeColumn + 1, length * g.dot(e2));
+            *t++ = Triplet(row, spokeColumn + 2, g.dot(u));
+            // alignment of the spoke with the boundary normal at its tip
+            Eigen::Vector3d dnLength = dn * u;
+            Eigen::Vector3d de1 = e1 - length * dn * e1;
+            Eigen::Vector3d de2 = e2 - length * dn * e2;
+            for(int k = 0; k < 3; ++k)
+            {
+                this->Residuals(row + 1 + k) = normalWeight * (u(k) - n(k));
+                for(int m = 0; m < 3; ++m)
+                {
+                    *t++ = Triplet(row + 1 + k, hubColumn + m, -normalWeight * dn(k, m));
+                }
+                *t++ = Triplet(row + 1 + k, spokeColumn, normalWeight * de1(k));
+                *t++ = Triplet(row + 1 + k, spokeColumn + 1, normalWeight * de2(k));
+                *t++ = Triplet(row + 1 + k, spokeColumn + 2, -normalWeight * dnLength(k));
+            }
+        }
+    }
+
+private:
+    const vtkSrepOptimizer& Optimizer;
+    const State& Current;
+    const vtkSignedDistanceField& Boundary;
+    Eigen::VectorXd& Residuals;
+    std::vector<Eigen::Triplet<double> >& Triplets;
+    Eigen::MatrixXd& Tangents;
+};
+
+vtkSrepOptimizer::vtkSrepOptimizer()
+    : NormalWeight(0.5), RegularityWeight(0.2), FoldWeight(1.0), MaximumNumberOfIterations(50), Tolerance(1e-6),
+      InitialCost(0), FinalCost(0), NumberOfIterations(0), MeanLength(1)
+{
+}
+
+double vtkSrepOptimizer::Evaluate(const State& state, const vtkSignedDistanceField& boundary, Eigen::VectorXd& residuals,
+                                  std::vector<Eigen::Triplet<double> >& triplets, Eigen::MatrixXd& tangents) const
+{
+    vtkIdType nSpokes = state.Directions.rows();
+    vtkIdType nDifferences = static_cast<vtkIdType>(SecondDifferences.size() / 3);
+    vtkIdType nAttachments = static_cast<vtkIdType>(FoldAttachments.size() / 2);
+    residuals.resize(4 * nSpokes + 3 * nDifferences + 3 * nAttachments);
+    triplets.resize(SPOKE_TRIPLETS * nSpokes + DIFFERENCE_TRIPLETS * nDifferences + ATTACHMENT_TRIPLETS * nAttachments);
+    tangents.resize(nSpokes, 6);
+
+    SpokeFunctor functor(*this, state, boundary, residuals, triplets, tangents);
+    vtkSMPTools::For(0, nSpokes, functor);
+
+    // second differences h_i - 2 h_j + h_k, linear in the hubs
+    const double weights[3] = {RegularityWeight, -2 * RegularityWeight, RegularityWeight};
+    for(vtkIdType d = 0; d < nDifferences; ++d)
+    {
+        vtkIdType row = 4 * nSpokes + 3 * d;
+        const vtkIdType* hubs = &SecondDifferences[3 * d];
+        residuals.segment<3>(row) = (RegularityWeight * (state.Hubs.row(hubs[0]) - 2 * state.Hubs.row(hubs[1])
+                + state.Hubs.row(hubs[2]))).transpose();
+        Eigen::Triplet<double>* t = &triplets[SPOKE_TRIPLETS * nSpokes + DIFFERENCE_TRIPLETS * d];
+        for(int m = 0; m < 3; ++m)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                *t++ = Eigen::Triplet<double>(row + k, 3 * hubs[m] + k, weights[m]);
+            }
+        }
+    }
+
+    // offsets f_i - h_e(i) - o_i, linear in the hubs
+    for(vtkIdType a = 0; a < nAttachments; ++a)
+    {
+        vtkIdType row = 4 * nSpokes + 3 * nDifferences + 3 * a;
+        vtkIdType fold = FoldAttachments[2 * a];
+        vtkIdType edge = FoldAttachments[2 * a + 1];
+        residuals.segment<3>(row) = (FoldWeight * (state.Hubs.row(fold) - state.Hubs.row(edge) - FoldOffsets.row(a))).transpose();
+        Eigen::Triplet<double>* t = &triplets[SPOKE_TRIPLETS * nSpokes + DIFFERENCE_TRIPLETS * nDifferences + ATTACHMENT_TRIPLETS * a];
+        for(int k = 0; k < 3; ++k)
+        {
+            *t++ = Eigen::Triplet<double>(row + k, 3 * fold + k, FoldWeight);
+            *t++ = Eigen::Triplet<double>(row + k, 3 * edge + k, -FoldWeight);
+        }
+    }
+    return 0.5 * residuals.squaredNorm();
+}
+
+void vtkSrepOptimizer::Step(const State& state, const Eigen::MatrixXd& tangents, const Eigen::VectorXd& step, State& moved) const
+{
+    vtkIdType nHubs = state.Hubs.rows();
+    vtkIdType nSpokes = state.Directions.rows();
+    moved.Hubs = state.Hubs + Eigen::Map<const RowMatrixType>(step.data(), nHubs, 3);
+    moved.Directions.resize(nSpokes, 3);
+    moved.Lengths.resize(nSpokes);
+    for(vtkIdType s = 0; s < nSpokes; ++s)
+    {
+        const double* spokeStep = step.data() + 3 * nHubs + 3 * s;
+        Eigen::RowVector3d u = state.Directions.row(s) + spokeStep[0] * tangents.block<1, 3>(s, 0)
+                + spokeStep[1] * tangents.block<1, 3>(s, 3);
+        moved.Directions.row(s) = u.normalized();
+        // a spoke never flips through its hub
+        moved.Lengths(s) = std::max(state.Lengths(s) + spokeStep[2], 1e-3 * MeanLength);
+    }
+}
+
+bool vtkSrepOptimizer::Optimize(vtkMultiBlockDataSet* srep, const vtkSignedDistanceField& boundary)
+{
+    InitialCost = FinalCost = 0;
+    NumberOfIterations = 0;
+    if(!vtkSrepModel::IsValid(srep) || boundary.IsEmpty())
+    {
+        std::cerr << "S-rep optimization needs a valid s-rep and the distance field of its boundary" << std::endl;
+        return false;
+    }
+    vtkPolyData* blocks[3] = {vtkSrepModel::GetUpSpokes(srep), vtkSrepModel::GetDownSpokes(srep), vtkSrepModel::GetCrestSpokes(srep)};
+    vtkIdType nSheet = blocks[0]->GetNumberOfPoints();
+    vtkIdType nFold = blocks[2]->GetNumberOfPoints();
+    if(blocks[1]->GetNumberOfPoints() != nSheet)
+    {
+        std::cerr << "S-rep optimization needs up and down spokes on the same skeletal points" << std::endl;
+        return false;
+    }
+
+    // 1. gather the hubs and spokes, up and down spokes share the skeletal hubs
+    State state;
+    vtkIdType nHubs = nSheet + nFold;
+    vtkIdType nSpokes = 2 * nSheet + nFold;
+    state.Hubs.resize(nHubs, 3);
+    state.Directions.resize(nSpokes, 3);
+    state.Lengths.resize(nSpokes);
+    SpokeHubs.resize(nSpokes);
+    vtkIdType s = 0;
+    for(int b = 0; b < 3; ++b)
+    {
+        vtkPolyData* spokes = blocks[b];
+        vtkDataArray* directions = spokes->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengths = spokes->GetPointData()->GetArray("spokeLength");
+        vtkIdType hubOffset = b == 2 ? nSheet : 0;
+        for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i, ++s)
+        {
+            if(b != 1)
+            {
+                spokes->GetPoint(i, state.Hubs.row(hubOffset + i).data());
+            }
+            double u[3];
+            directions->GetTuple(i, u);
+            state.Directions.row(s) = Eigen::RowVector3d(u[0], u[1], u[2]).normalized();
+            state.Lengths(s) = lengths->GetTuple1(i);
+            SpokeHubs[s] = hubOffset + i;
+        }
+    }
+    MeanLength = nSpokes > 0 && state.Lengths.mean() > 0 ? state.Lengths.mean() : 1.0;
+
+    // 2. consecutive hubs along the rows and columns of the skeletal grid and along the closed fold curve
+    SecondDifferences.clear();
+    int nRows = vtkSrepModel::GetNumberOfRows(srep);
+    int nCols = vtkSrepModel::GetNumberOfColumns(srep);
+    if(vtkIdType(nRows) * nCols == nSheet)
+    {
+        for(int r = 0; r < nRows; ++r)
+        {
+            for(int c = 1; c + 1 < nCols; ++c)
+            {
+                vtkIdType j = vtkIdType(r) * nCols + c;
+                SecondDifferences.push_back(j - 1);
+                SecondDifferences.push_back(j);
+                SecondDifferences.push_back(j + 1);
+            }
+        }
+        for(int r = 1; r + 1 < nRows; ++r)
+        {
+            for(int c = 0; c < nCols; ++c)
+            {
+                vtkIdType j = vtkIdType(r) * nCols + c;
+                SecondDifferences.push_back(j - nCols);
+                SecondDifferences.push_back(j);
+                SecondDifferences.push_back(j + nCols);
+            }
+        }
+    }
+    for(vtkIdType i = 0; nFold >= 3 && i < nFold; ++i)
+    {
+        SecondDifferences.push_back(nSheet + (i + nFold - 1) % nFold);
+        SecondDifferences.push_back(nSheet + i);
+        SecondDifferences.push_back(nSheet + (i + 1) % nFold);
+    }
+    // every fold hub keeps its offset from the edge hub of the skeletal grid it hinges on
+    FoldAttachments.clear();
+    FoldOffsets.resize(0, 3);
+    if(vtkIdType(nRows) * nCols == nSheet && nRows >= 2 && nCols >= 2 && nFold == 2 * (nRows + nCols) - 4)
+    {
+        FoldOffsets.resize(nFold, 3);
+        for(vtkIdType i = 0; i < nFold; ++i)
+        {
+            vtkIdType edge = vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols);
+            FoldAttachments.push_back(nSheet + i);
+            FoldAttachments.push_back(edge);
+            FoldOffsets.row(i) = state.Hubs.row(nSheet + i) - state.Hubs.row(edge);
+        }
+    }
+
+    // 3. Levenberg-Marquardt on the normal equations (J^T J + lambda diag(J^T J)) step = -J^T r
+    vtkIdType nParameters = 3 * nHubs + 3 * nSpokes;
+    Eigen::VectorXd residuals, trialResiduals;
+    std::vector<Eigen::Triplet<double> > triplets, trialTriplets;
+    Eigen::MatrixXd tangents, trialTangents;
+    double cost = Evaluate(state, boundary, residuals, triplets, tangents);
+    InitialCost = cost;
+    Eigen::SparseMatrix<double> jacobian(residuals.size(), nParameters);
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > solver;
+    bool analyzed = false;
+    double lambda = 1e-3;
+    State trial;
+    for(int iteration = 0; iteration < MaximumNumberOfIterations; ++iteration)
+    {
+        jacobian.setFromTriplets(triplets.begin(), triplets.end());
+        Eigen::SparseMatrix<double> normal = jacobian.transpose() * jacobian;
+        Eigen::VectorXd gradient = jacobian.transpose() * residuals;
+        Eigen::VectorXd diagonal = normal.diagonal().cwiseMax(1e-12);
+        bool accepted = false;
+        double previousCost = cost;
+        for(int attempt = 0; attempt < MAX_DAMPING_ATTEMPTS && !accepted; ++attempt)
+        {
+            Eigen::SparseMatrix<double> damped = normal;
+            for(vtkIdType k = 0; k < nParameters; ++k)
+            {
+                damped.coeffRef(k, k) += lambda * diagonal(k);
+            }
+            if(!analyzed)
+            {
+                solver.analyzePattern(damped);
+                analyzed = true;
+            }
+            solver.factorize(damped);
+            if(solver.info() != Eigen::Success)
+            {
+                lambda *= 4;
+                continue;
+            }
+            Eigen::VectorXd step = solver.solve(-gradient);
+            Step(state, tangents, step, trial);
+            double trialCost = Evaluate(trial, boundary, trialResiduals, trialTriplets, trialTangents);
+            if(trialCost < cost)
+            {
+                std::swap(state, trial);
+                residuals.swap(trialResiduals);
+                triplets.swap(trialTriplets);
+                tangents.swap(trialTangents);
+                cost = trialCost;
+                lambda = std::max(lambda / 3, 1e-9);
+                accepted = true;
+            }
+            else
+            {
+                lambda *= 4;
+            }
+        }
+        if(!accepted)
+        {
+            break;
+        }
+        ++NumberOfIterations;
+        if(previousCost - cost < Tolerance * previousCost)
+        {
+            break;
+        }
+    }
+    FinalCost = cost;
+
+    // 4. write the hubs and spokes back, up and down spokes may share their points
+    s = 0;
+    for(int b = 0; b < 3; ++b)
+    {
+        vtkPolyData* spokes = blocks[b];
+        vtkDataArray* directions = spokes->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengths = spokes->GetPointData()->GetArray("spokeLength");
+        vtkIdType hubOffset = b == 2 ? nSheet : 0;
+        for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i, ++s)
+        {
+            spokes->GetPoints()->SetPoint(i, state.Hubs.row(hubOffset + i).data());
+            directions->SetTuple(i, state.Directions.row(s).data());
+            lengths->SetTuple1(i, state.Lengths(s));
+        }
+        spokes->GetPoints()->Modified();
+        directions->Modified();
+        lengths->Modified();
+        spokes->Modified();
+    }
+    return true;
+}
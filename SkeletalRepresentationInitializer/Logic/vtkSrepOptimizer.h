@@ -0,0 +1,94 @@
+// This class provides the fit of an s-rep to the boundary it represents
+// Hubs, spoke directions and spoke lengths are optimized together by Levenberg-Marquardt against
+//     E = 1/2 sum_spokes d(tip)^2 + 1/2 wn^2 L^2 sum_spokes |u - n(tip)|^2 + 1/2 wr^2 sum |h_i - 2 h_j + h_k|^2
+//         + 1/2 wf^2 sum_fold |f_i - h_e(i) - o_i|^2
+// where d is the signed distance to the boundary, n its normalized gradient, L the mean spoke length,
+// (h_i, h_j, h_k) consecutive hubs along the rows and columns of the skeletal grid and along the fold
+// curve, and o_i the initial offset of fold hub f_i from its edge hub h_e(i) of the skeletal grid, so that
+// the fold curve stays attached to the sheet. Spoke directions move in the tangent plane of the sphere.
+// The residuals and the sparse Jacobian blocks of the spokes are computed in parallel over the spokes, the
+// change of the normal along the tip by central differences; every distance query is served by the
+// prebuilt signed distance field of the boundary.
+#ifndef __vtkSrepOptimizer_h
+#define __vtkSrepOptimizer_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+// STD includes
+#include <vector>
+
+class vtkMultiBlockDataSet;
+class vtkSignedDistanceField;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkSrepOptimizer {
+public:
+    vtkSrepOptimizer();
+
+    // weight wn of the normal alignment, wr of the medial regularity and wf of the fold attachment,
+    // relative to the boundary distance
+    void SetNormalWeight(double weight) {NormalWeight = weight;}
+    double GetNormalWeight() const {return NormalWeight;}
+    void SetRegularityWeight(double weight) {RegularityWeight = weight;}
+    double GetRegularityWeight() const {return RegularityWeight;}
+    void SetFoldWeight(double weight) {FoldWeight = weight;}
+    double GetFoldWeight() const {return FoldWeight;}
+    // iterations stop after this number or once an accepted step lowers E by less than the relative tolerance
+    void SetMaximumNumberOfIterations(int n) {MaximumNumberOfIterations = n;}
+    int GetMaximumNumberOfIterations() const {return MaximumNumberOfIterations;}
+    void SetTolerance(double tolerance) {Tolerance = tolerance;}
+    double GetTolerance() const {return Tolerance;}
+
+    // move the hubs and spokes of the s-rep in place to minimize E
+    // up and down spokes must share their hubs, the crest spokes hinge on the fold curve, which keeps its
+    // offsets from the edge of the skeletal grid when it follows vtkSrepModel::GetCrestSkeletalPoint
+    // return false if the s-rep is not valid or the field is empty
+    bool Optimize(vtkMultiBlockDataSet* srep, const vtkSignedDistanceField& boundary);
+
+    // E before and after the last call of Optimize, and the number of accepted steps
+    double GetInitialCost() const {return InitialCost;}
+    double GetFinalCost() const {return FinalCost;}
+    int GetNumberOfIterations() const {return NumberOfIterations;}
+
+private:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> RowMatrixType;
+    struct State
+    {
+        // skeletal hubs followed by fold hubs
+        RowMatrixType Hubs;
+        // unit direction and length of the up, down and crest spokes, in that order
+        RowMatrixType Directions;
+        Eigen::VectorXd Lengths;
+    };
+
+    // residuals and Jacobian triplets at the state, return E
+    double Evaluate(const State& state, const vtkSignedDistanceField& boundary, Eigen::VectorXd& residuals,
+                    std::vector<Eigen::Triplet<double> >& triplets, Eigen::MatrixXd& tangents) const;
+    // state moved by the step, directions along the tangents of their spoke
+    void Step(const State& state, const Eigen::MatrixXd& tangents, const Eigen::VectorXd& step, State& moved) const;
+
+    double NormalWeight;
+    double RegularityWeight;
+    double FoldWeight;
+    int MaximumNumberOfIterations;
+    double Tolerance;
+    double InitialCost;
+    double FinalCost;
+    int NumberOfIterations;
+
+    // hub of every spoke, and the (i, j, k) hubs of every second difference of the regularity term
+    std::vector<vtkIdType> SpokeHubs;
+    std::vector<vtkIdType> SecondDifferences;
+    // (fold hub, edge hub) of every fold attachment, and the initial offset of the fold hub
+    std::vector<vtkIdType> FoldAttachments;
+    RowMatrixType FoldOffsets;
+    double MeanLength;
+
+    class SpokeFunctor;
+};
+#endif
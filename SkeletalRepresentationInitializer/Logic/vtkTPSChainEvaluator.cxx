@@ -0,0 +1,166 @@
+// This class provides batched evaluation of a chain of thin plate splines
+#include "vtkTPSChainEvaluator.h"
+#include "itkThinPlateSplineExtended.h"
+#include "vtkTPSFile.h"
+
+// VTK includes
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+// points carried together through the chain by one thread
+const vtkIdType TILE_SIZE = 64;
+// landmarks of one TPS visited by all the points of a tile before the next ones:
+// 256 landmarks and their coefficients take 12 KB and stay in the L1 cache
+const vtkIdType LANDMARK_BLOCK_SIZE = 256;
+}
+
+// carry the points of a range of tiles through the whole chain
+class vtkTPSChainEvaluator::TransformFunctor
+{
+public:
+    TransformFunctor(const std::vector<TPSCoefficients>& chain, vtkEigenArrayBridge::PointMatrixMap& points)
+        : Chain(chain), Points(points) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        typedef Eigen::Matrix<double, TILE_SIZE, 3> TileType;
+        TileType p, deformation;
+        Eigen::Array<double, LANDMARK_BLOCK_SIZE, 1> r;
+        for(vtkIdType tile = begin; tile < end; tile += TILE_SIZE)
+        {
+            vtkIdType m = std::min(TILE_SIZE, end - tile);
+            p.topRows(m) = this->Points.middleRows(tile, m);
+            for(size_t t = 0; t < this->Chain.size(); ++t)
+            {
+                const TPSCoefficients& tps = this->Chain[t];
+                vtkIdType n = tps.NumberOfLandmarks;
+                const double* values = tps.GetValues();
+                deformation.topRows(m).setZero();
+                for(vtkIdType block = 0; block < n; block += LANDMARK_BLOCK_SIZE)
+                {
+                    vtkIdType len = std::min(LANDMARK_BLOCK_SIZE, n - block);
+                    Eigen::Map<const Eigen::ArrayXd> x(values + block, len);
+                    Eigen::Map<const Eigen::ArrayXd> y(values + n + block, len);
+                    Eigen::Map<const Eigen::ArrayXd> z(values + 2 * n + block, len);
+                    Eigen::Map<const Eigen::ArrayXd> dx(values + 3 * n + block, len);
+                    Eigen::Map<const Eigen::ArrayXd> dy(values + 4 * n + block, len);
+                    Eigen::Map<const Eigen::ArrayXd> dz(values + 5 * n + block, len);
+                    for(vtkIdType i = 0; i < m; ++i)
+                    {
+                        // r kernel of point i to every landmark of the block, then one dot product per coordinate
+                        r.head(len) = ((x - p(i, 0)).square() + (y - p(i, 1)).square() + (z - p(i, 2)).square()).sqrt();
+                        deformation(i, 0) += (r.head(len) * dx).sum();
+                        deformation(i, 1) += (r.head(len) * dy).sum();
+                        deformation(i, 2) += (r.head(len) * dz).sum();
+                    }
+                }
+                p.topRows(m) = (p.topRows(m) * tps.Affine.transpose() + deformation.topRows(m)).rowwise()
+                        + tps.B.transpose();
+            }
+            this->Points.middleRows(tile, m) = p.topRows(m);
+        }
+    }
+
+private:
+    const std::vector<TPSCoefficients>& Chain;
+    vtkEigenArrayBridge::PointMatrixMap& Points;
+};
+
+vtkTPSChainEvaluator::vtkTPSChainEvaluator()
+{
+}
+
+void vtkTPSChainEvaluator::AppendTPS(itkThinPlateSplineExtended* tps)
+{
+    itkThinPlateSplineExtended::PointSetType::PointsContainer::Pointer landmarks = tps->GetSourceLandmarks()->GetPoints();
+    itkThinPlateSplineExtended::DMatrixType D = tps->getDMatrix();
+    itkThinPlateSplineExtended::AMatrixType A = tps->getAMatrix();
+    itkThinPlateSplineExtended::BMatrixType B = tps->getBVector();
+
+    vtkIdType n = static_cast<vtkIdType>(landmarks->Size());
+    TPSCoefficients coefficients;
+    coefficients.NumberOfLandmarks = n;
+    coefficients.MappedValues = NULL;
+    coefficients.Values.resize(6 * n);
+    for(vtkIdType l = 0; l < n; ++l)
+    {
+        itkThinPlateSplineExtended::InputPointType x = landmarks->GetElement(l);
+        for(int k = 0; k < 3; ++k)
+        {
+            coefficients.Values[k * n + l] = x[k];
+            coefficients.Values[(k + 3) * n + l] = D(k, l);
+        }
+    }
+    for(int i = 0; i < 3; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            coefficients.Affine(i, j) = A(i, j) + (i == j ? 1.0 : 0.0);
+        }
+        coefficients.B(i) = B[i];
+    }
+    Chain.push_back(coefficients);
+}
+
+void vtkTPSChainEvaluator::AppendTPS(const vtkTPSFile& file)
+{
+    if(!file.IsOpen())
+    {
+        return;
+    }
+    TPSCoefficients coefficients;
+    coefficients.NumberOfLandmarks = file.GetNumberOfLandmarks();
+    // source landmarks and D are contiguous in the file
+    coefficients.MappedValues = file.GetSourceLandmarks();
+    coefficients.Affine = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> >(file.GetAMatrix())
+            + Eigen::Matrix3d::Identity();
+    coefficients.B = Eigen::Map<const Eigen::Vector3d>(file.GetBVector());
+    Chain.push_back(coefficients);
+}
+
+void vtkTPSChainEvaluator::Clear()
+{
+    Chain.clear();
+}
+
+void vtkTPSChainEvaluator::TransformPoints(vtkEigenArrayBridge::PointMatrixMap points) const
+{
+    if(Chain.empty() || points.rows() == 0)
+    {
+        return;
+    }
+    TransformFunctor functor(Chain, points);
+    vtkSMPTools::For(0, points.rows(), TILE_SIZE, functor);
+}
+
+void vtkTPSChainEvaluator::TransformPoints(double* points, vtkIdType nPoints) const
+{
+    this->TransformPoints(vtkEigenArrayBridge::PointMatrixMap(points, nPoints, 3));
+}
+
+void vtkTPSChainEvaluator::TransformPoints(vtkPoints* points) const
+{
+    if(points == NULL || points->GetNumberOfPoints() == 0)
+    {
+        return;
+    }
+    vtkEigenArrayBridge::PointMatrixMap view = vtkEigenArrayBridge::MapPoints(points);
+    if(view.rows() == points->GetNumberOfPoints())
+    {
+        this->TransformPoints(view);
+        return;
+    }
+    // points of another data type keep it: transform a double copy and write it back
+    vtkEigenArrayBridge::PointMatrixType buffer;
+    vtkEigenArrayBridge::ReadPoints(points, buffer);
+    this->TransformPoints(vtkEigenArrayBridge::PointMatrixMap(buffer.data(), buffer.rows(), 3));
+    for(vtkIdType i = 0; i < buffer.rows(); ++i)
+    {
+        points->SetPoint(i, buffer.row(i).data());
+    }
+}
@@ -0,0 +1,60 @@
+// This class provides batched evaluation of a chain of thin plate splines
+// The landmarks and coefficients of every TPS are copied once into flat
+// coordinate-wise arrays, or used in place from a mapped TPS file; points are then carried through the whole chain tile
+// by tile, in parallel over the tiles. The r kernel is evaluated with Eigen
+// packet math over blocks of landmarks that stay in cache for a whole tile,
+// instead of one virtual TransformPoint call per point and per TPS.
+#ifndef __vtkTPSChainEvaluator_h
+#define __vtkTPSChainEvaluator_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+#include "vtkEigenArrayBridge.h"
+
+// Eigen includes
+#include <Eigen/Dense>
+
+// STD includes
+#include <vector>
+
+class vtkPoints;
+class itkThinPlateSplineExtended;
+class vtkTPSFile;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkTPSChainEvaluator {
+public:
+    vtkTPSChainEvaluator();
+
+    // append a TPS whose W matrix is computed; it is applied after the TPS already in the chain
+    void AppendTPS(itkThinPlateSplineExtended* tps);
+    // same for a mapped TPS file, the landmarks and coefficients are used in place without copy:
+    // the file must stay open as long as the evaluator uses it
+    void AppendTPS(const vtkTPSFile& file);
+    void Clear();
+    size_t GetNumberOfTPS() const {return Chain.size();}
+
+    // carry every row (x, y, z) through the chain in place
+    // gives the same result as calling TransformPoint of every TPS in order, up to rounding
+    void TransformPoints(vtkEigenArrayBridge::PointMatrixMap points) const;
+    // same for n points stored as x0 y0 z0 x1 y1 z1 ...
+    void TransformPoints(double* points, vtkIdType nPoints) const;
+    // same for vtkPoints, e.g. spoke hubs or spoke tips
+    void TransformPoints(vtkPoints* points) const;
+
+private:
+    // y = p + sum_l |p - x_l| d_l + A p + b
+    struct TPSCoefficients
+    {
+        vtkIdType NumberOfLandmarks;
+        // landmarks and kernel coefficients, one contiguous array per coordinate:
+        // x[n] y[n] z[n] dx[n] dy[n] dz[n], either owned or in a mapped TPS file
+        std::vector<double> Values;
+        const double* MappedValues;
+        const double* GetValues() const {return MappedValues != NULL ? MappedValues : Values.data();}
+        // I + A, so that y = (I + A) p + b + deformation
+        Eigen::Matrix3d Affine;
+        Eigen::Vector3d B;
+    };
+    std::vector<TPSCoefficients> Chain;
+
+    class TransformFunctor;
+};
+#endif
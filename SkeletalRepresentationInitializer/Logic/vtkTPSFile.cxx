@@ -0,0 +1,186 @@
+// This class provides binary storage of thin plate splines
+#include "vtkTPSFile.h"
+
+// STD includes
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+const char TPS_MAGIC[8] = {'S', 'R', 'E', 'P', 'T', 'P', 'S', '\0'};
+const unsigned int TPS_VERSION = 1;
+// read back in another byte order, the mark is swapped and the file rejected
+const unsigned int BYTE_ORDER_MARK = 0x01020304;
+
+struct TPSFileHeader
+{
+    char Magic[8];
+    unsigned int Version;
+    unsigned int ByteOrderMark;
+    unsigned long long NumberOfLandmarks;
+    double Stiffness;
+    // keeps the values 64 bytes aligned in the mapping
+    char Reserved[32];
+};
+static_assert(sizeof(TPSFileHeader) == 64, "the TPS file header takes 64 bytes");
+
+// number of doubles after the header for n landmarks
+size_t NumberOfValues(unsigned long long n)
+{
+    return static_cast<size_t>(9 * n + 12);
+}
+}
+
+vtkTPSFile::vtkTPSFile()
+    : numberOfLandmarks(0)
+{
+}
+
+bool vtkTPSFile::Write(itkThinPlateSplineExtended* tps, const std::string& fileName)
+{
+    typedef itkThinPlateSplineExtended::PointSetType::PointsContainer::Pointer ContainerPointer;
+    ContainerPointer source = tps->GetSourceLandmarks()->GetPoints();
+    ContainerPointer target = tps->GetTargetLandmarks()->GetPoints();
+    itkThinPlateSplineExtended::DMatrixType D = tps->getDMatrix();
+    itkThinPlateSplineExtended::AMatrixType A = tps->getAMatrix();
+    itkThinPlateSplineExtended::BMatrixType B = tps->getBVector();
+    size_t n = source->Size();
+    if(n == 0 || target->Size() != n || D.rows() != 3 || D.cols() != n)
+    {
+        std::cerr << "Cannot write a TPS without landmarks or coefficients to " << fileName << std::endl;
+        return false;
+    }
+
+    TPSFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, TPS_MAGIC, sizeof(TPS_MAGIC));
+    header.Version = TPS_VERSION;
+    header.ByteOrderMark = BYTE_ORDER_MARK;
+    header.NumberOfLandmarks = n;
+    header.Stiffness = tps->GetStiffness();
+
+    std::vector<double> values(NumberOfValues(n));
+    double* sourceValues = &values[0];
+    double* dValues = sourceValues + 3 * n;
+    double* targetValues = dValues + 3 * n;
+    for(size_t l = 0; l < n; ++l)
+    {
+        itkThinPlateSplineExtended::InputPointType s = source->GetElement(l);
+        itkThinPlateSplineExtended::InputPointType t = target->GetElement(l);
+        for(int k = 0; k < 3; ++k)
+        {
+            sourceValues[k * n + l] = s[k];
+            dValues[k * n + l] = D(k, l);
+            targetValues[k * n + l] = t[k];
+        }
+    }
+    double* affineValues = targetValues + 3 * n;
+    for(int i = 0; i < 3; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            affineValues[3 * i + j] = A(i, j);
+        }
+        affineValues[9 + i] = B[i];
+    }
+
+    std::ofstream fout(fileName.c_str(), std::ios::binary);
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fout.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(double));
+    if(!fout)
+    {
+        std::cerr << "Cannot write the TPS file " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool vtkTPSFile::Open(const std::string& fileName)
+{
+    Close();
+    if(!file.Open(fileName))
+    {
+        std::cerr << "Cannot map the TPS file " << fileName << std::endl;
+        return false;
+    }
+    const TPSFileHeader* header = reinterpret_cast<const TPSFileHeader*>(file.GetData());
+    if(file.GetSize() < sizeof(TPSFileHeader) || std::memcmp(header->Magic, TPS_MAGIC, sizeof(TPS_MAGIC)) != 0
+            || header->Version != TPS_VERSION || header->ByteOrderMark != BYTE_ORDER_MARK
+            || header->NumberOfLandmarks == 0
+            || file.GetSize() != sizeof(TPSFileHeader) + NumberOfValues(header->NumberOfLandmarks) * sizeof(double))
+    {
+        std::cerr << "Not a TPS file of this version and byte order: " << fileName << std::endl;
+        file.Close();
+        return false;
+    }
+    numberOfLandmarks = static_cast<vtkIdType>(header->NumberOfLandmarks);
+    return true;
+}
+
+void vtkTPSFile::Close()
+{
+    file.Close();
+    numberOfLandmarks = 0;
+}
+
+double vtkTPSFile::GetStiffness() const
+{
+    return IsOpen() ? reinterpret_cast<const TPSFileHeader*>(file.GetData())->Stiffness : 0.0;
+}
+
+const double* vtkTPSFile::GetValues() const
+{
+    return IsOpen() ? reinterpret_cast<const double*>(file.GetData() + sizeof(TPSFileHeader)) : NULL;
+}
+
+itkThinPlateSplineExtended::Pointer vtkTPSFile::NewTPS() const
+{
+    if(!IsOpen())
+    {
+        return NULL;
+    }
+    typedef itkThinPlateSplineExtended::PointSetType PointSetType;
+    vtkIdType n = numberOfLandmarks;
+    PointSetType::Pointer sourceLandmarks = PointSetType::New();
+    PointSetType::Pointer targetLandmarks = PointSetType::New();
+    itkThinPlateSplineExtended::DMatrixType D;
+    D.set_size(3, n);
+    const double* source = GetSourceLandmarks();
+    const double* target = GetTargetLandmarks();
+    const double* d = GetDMatrix();
+    for(vtkIdType l = 0; l < n; ++l)
+    {
+        itkThinPlateSplineExtended::InputPointType s, t;
+        for(int k = 0; k < 3; ++k)
+        {
+            s[k] = source[k * n + l];
+            t[k] = target[k * n + l];
+            D(k, l) = d[k * n + l];
+        }
+        sourceLandmarks->GetPoints()->InsertElement(l, s);
+        targetLandmarks->GetPoints()->InsertElement(l, t);
+    }
+    itkThinPlateSplineExtended::AMatrixType A;
+    itkThinPlateSplineExtended::BMatrixType B;
+    const double* a = GetAMatrix();
+    const double* b = GetBVector();
+    for(int i = 0; i < 3; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            A(i, j) = a[3 * i + j];
+        }
+        B[i] = b[i];
+    }
+
+    itkThinPlateSplineExtended::Pointer tps = itkThinPlateSplineExtended::New();
+    tps->SetStiffness(GetStiffness());
+    tps->SetSourceLandmarks(sourceLandmarks);
+    tps->SetTargetLandmarks(targetLandmarks);
+    tps->setDMatrix(D);
+    tps->setAMatrix(A);
+    tps->setBVector(B);
+    return tps;
+}
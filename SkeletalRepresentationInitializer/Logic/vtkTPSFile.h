@@ -0,0 +1,57 @@
+// This class provides binary storage of thin plate splines
+// A TPS file keeps everything needed to evaluate the transform at full precision:
+//   header (64 bytes): magic "SREPTPS", version, byte order mark, number of landmarks n, stiffness
+//   source landmarks: x[n], y[n], z[n]
+//   kernel coefficients D, one row per coordinate: dx[n], dy[n], dz[n]
+//   target landmarks: x[n], y[n], z[n]
+//   affine matrix A (3 x 3, row major) and translation B (3)
+// All values are doubles in the byte order of the writer. Source landmarks and D form
+// one contiguous 6n block laid out as vtkTPSChainEvaluator uses it, so a mapped file
+// is evaluated in place: loading a long chain costs one mapping per TPS and no copy.
+#ifndef __vtkTPSFile_h
+#define __vtkTPSFile_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+#include "vtkMemoryMappedFile.h"
+#include "itkThinPlateSplineExtended.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <string>
+
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkTPSFile {
+public:
+    vtkTPSFile();
+
+    // write a TPS whose W matrix is computed
+    static bool Write(itkThinPlateSplineExtended* tps, const std::string& fileName);
+
+    // map a TPS file, return false if it cannot be mapped or is not a valid TPS file
+    bool Open(const std::string& fileName);
+    void Close();
+    bool IsOpen() const {return numberOfLandmarks > 0;}
+
+    // views of the mapped file, valid until Close(); see the layout above
+    vtkIdType GetNumberOfLandmarks() const {return numberOfLandmarks;}
+    double GetStiffness() const;
+    const double* GetSourceLandmarks() const {return GetValues();}
+    const double* GetDMatrix() const {return GetValues() + 3 * numberOfLandmarks;}
+    const double* GetTargetLandmarks() const {return GetValues() + 6 * numberOfLandmarks;}
+    const double* GetAMatrix() const {return GetValues() + 9 * numberOfLandmarks;}
+    const double* GetBVector() const {return GetAMatrix() + 9;}
+
+    // a TPS with the stored landmarks and coefficients, the W matrix is not solved again
+    itkThinPlateSplineExtended::Pointer NewTPS() const;
+
+private:
+    vtkTPSFile(const vtkTPSFile&); // Not implemented
+    void operator=(const vtkTPSFile&); // Not implemented
+
+    const double* GetValues() const;
+
+    vtkMemoryMappedFile file;
+    vtkIdType numberOfLandmarks;
+};
+#endif
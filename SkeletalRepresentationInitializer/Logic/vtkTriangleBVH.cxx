@@ -0,0 +1,513 @@
+// This class provides a bounding volume hierarchy over the triangles of a mesh
+#include "vtkTriangleBVH.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// triangles of a leaf
+const vtkIdType LEAF_SIZE = 4;
+// deeper than any tree built from vtkIdType triangles split at the median
+const int MAX_DEPTH = 64;
+
+// compare triangles by the coordinate of their centroid along one axis
+class CentroidLess
+{
+public:
+    CentroidLess(const Eigen::MatrixXd& centroids, int axis) : Centroids(centroids), Axis(axis) {}
+    bool operator()(vtkIdType a, vtkIdType b) const {return Centroids(a, Axis) < Centroids(b, Axis);}
+
+private:
+    const Eigen::MatrixXd& Centroids;
+    int Axis;
+};
+
+// parameters where the ray enters and leaves a box, intersected with [tMin, tMax]
+bool IntersectBox(const double lower[3], const double upper[3], const Eigen::Vector3d& origin,
+                  const Eigen::Vector3d& inverseDirection, double tMin, double tMax, double& tEnter)
+{
+    for(int k = 0; k < 3; ++k)
+    {
+        double t0 = (lower[k] - origin(k)) * inverseDirection(k);
+        double t1 = (upper[k] - origin(k)) * inverseDirection(k);
+        if(t0 > t1)
+        {
+            std::swap(t0, t1);
+        }
+        // NaN (0 * inf on a box face) compares false and leaves the range unchanged
+        if(t0 > tMin) tMin = t0;
+        if(t1 < tMax) tMax = t1;
+        if(tMin > tMax)
+        {
+            return false;
+        }
+    }
+    tEnter = tMin;
+    return true;
+}
+
+// squared distance from x to a box, 0 inside
+double SquaredDistanceToBox(const double lower[3], const double upper[3], const Eigen::Vector3d& x)
+{
+    double d2 = 0;
+    for(int k = 0; k < 3; ++k)
+    {
+        double d = std::max(std::max(lower[k] - x(k), x(k) - upper[k]), 0.0);
+        d2 += d * d;
+    }
+    return d2;
+}
+}
+
+vtkTriangleBVH::vtkTriangleBVH() : Orientation(1)
+{
+}
+
+bool vtkTriangleBVH::Build(vtkPolyData* mesh)
+{
+    Vertices.resize(0, 3);
+    Triangles.clear();
+    Corners.resize(0, 9);
+    Cells.clear();
+    Nodes.clear();
+    if(mesh == NULL || mesh->GetPolys() == NULL)
+    {
+        return false;
+    }
+
+    vtkIdType nPoints = mesh->GetNumberOfPoints();
+    Vertices.resize(nPoints, 3);
+    for(vtkIdType i = 0; i < nPoints; ++i)
+    {
+        mesh->GetPoint(i, Vertices.row(i).data());
+    }
+    std::vector<vtkIdType> triangles, cells;
+    vtkSmartPointer<vtkIdList> cell = vtkSmartPointer<vtkIdList>::New();
+    vtkCellArray* polys = mesh->GetPolys();
+    // polygons come after the vertices and lines in the cell ids of a polydata
+    vtkIdType cellId = mesh->GetNumberOfVerts() + mesh->GetNumberOfLines();
+    polys->InitTraversal();
+    for(; polys->GetNextCell(cell); ++cellId)
+    {
+        for(vtkIdType k = 2; k < cell->GetNumberOfIds(); ++k)
+        {
+            triangles.push_back(cell->GetId(0));
+            triangles.push_back(cell->GetId(k - 1));
+            triangles.push_back(cell->GetId(k));
+            cells.push_back(cellId);
+        }
+    }
+    vtkIdType nTriangles = static_cast<vtkIdType>(triangles.size() / 3);
+    if(nTriangles == 0)
+    {
+        return false;
+    }
+    // the signed volume enclosed by the triangles is positive when they turn counterclockwise seen from outside
+    double volume = 0;
+    for(vtkIdType f = 0; f < nTriangles; ++f)
+    {
+        volume += Vertices.row(triangles[3 * f]).dot(Vertices.row(triangles[3 * f + 1]).cross(Vertices.row(triangles[3 * f + 2])));
+    }
+    Orientation = volume < 0 ? -1 : 1;
+
+    Eigen::MatrixXd centroids(nTriangles, 3);
+    std::vector<vtkIdType> order(nTriangles);
+    for(vtkIdType f = 0; f < nTriangles; ++f)
+    {
+        centroids.row(f) = (Vertices.row(triangles[3 * f]) + Vertices.row(triangles[3 * f + 1])
+                + Vertices.row(triangles[3 * f + 2])) / 3.0;
+        order[f] = f;
+    }
+    Triangles.swap(triangles);
+    Nodes.reserve(2 * nTriangles / LEAF_SIZE + 1);
+    BuildNode(order, centroids, 0, nTriangles);
+
+    // store the triangles in leaf order, so that a leaf reads contiguous memory
+    std::vector<vtkIdType> sorted(3 * nTriangles);
+    Cells.resize(nTriangles);
+    for(vtkIdType f = 0; f < nTriangles; ++f)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            sorted[3 * f + k] = Triangles[3 * order[f] + k];
+        }
+        Cells[f] = cells[order[f]];
+    }
+    Triangles.swap(sorted);
+    Corners.resize(nTriangles, 9);
+    for(vtkIdType f = 0; f < nTriangles; ++f)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            Corners.block<1, 3>(f, 3 * k) = Vertices.row(Triangles[3 * f + k]);
+        }
+    }
+    ComputePseudoNormals();
+    return true;
+}
+
+Eigen::Vector3d vtkTriangleBVH::FaceNormal(vtkIdType triangle) const
+{
+    Eigen::Vector3d a = Vertices.row(Triangles[3 * triangle]).transpose();
+    Eigen::Vector3d n = (Vertices.row(Triangles[3 * triangle + 1]).transpose() - a).cross(
+                Vertices.row(Triangles[3 * triangle + 2]).transpose() - a);
+    double area = n.norm();
+    return area > 0 ? Eigen::Vector3d(n * (Orientation / area)) : Eigen::Vector3d::Zero();
+}
+
+void vtkTriangleBVH::ComputePseudoNormals()
+{
+    // Baerentzen and Aanaes: the sign of (x - c) . n with n the angle weighted normal of the
+    // feature holding the closest point c is the side of a closed mesh x lies on
+    vtkIdType nTriangles = GetNumberOfTriangles();
+    VertexNormals.setZero(Vertices.rows(), 3);
+    EdgeNormals.setZero(3 * nTriangles, 3);
+    // edges (min id, max id) of every triangle, sorted so that the two sides of an edge are neighbours
+    const int EDGE_CORNERS[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    std::vector<std::pair<std::pair<vtkIdType, vtkIdType>, vtkIdType> > edges(3 * nTriangles);
+    for(vtkIdType f = 0; f < nTriangles; ++f)
+    {
+        Eigen::Vector3d n = FaceNormal(f);
+        for(int k = 0; k < 3; ++k)
+        {
+            Eigen::Vector3d v = Vertices.row(Triangles[3 * f + k]).transpose();
+            Eigen::Vector3d e1 = Vertices.row(Triangles[3 * f + (k + 1) % 3]).transpose() - v;
+            Eigen::Vector3d e2 = Vertices.row(Triangles[3 * f + (k + 2) % 3]).transpose() - v;
+            double angle = std::atan2(e1.cross(e2).norm(), e1.dot(e2));
+            VertexNormals.row(Triangles[3 * f + k]) += angle * n.transpose();
+
+            vtkIdType i = Triangles[3 * f + EDGE_CORNERS[k][0]];
+            vtkIdType j = Triangles[3 * f + EDGE_CORNERS[k][1]];
+            edges[3 * f + k] = std::make_pair(std::make_pair(std::min(i, j), std::max(i, j)), 3 * f + k);
+        }
+    }
+    for(vtkIdType i = 0; i < VertexNormals.rows(); ++i)
+    {
+        double norm = VertexNormals.row(i).norm();
+        if(norm > 0)
+        {
+            VertexNormals.row(i) /= norm;
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for(size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+    {
+        Eigen::RowVector3d n = Eigen::RowVector3d::Zero();
+        for(end = begin; end < edges.size() && edges[end].first == edges[begin].first; ++end)
+        {
+            n += FaceNormal(edges[end].second / 3).transpose();
+        }
+        double norm = n.norm();
+        for(size_t e = begin; e < end; ++e)
+        {
+            EdgeNormals.row(edges[e].second) = norm > 0 ? Eigen::RowVector3d(n / norm) : n;
+        }
+    }
+}
+
+void vtkTriangleBVH::GetBounds(double bounds[6]) const
+{
+    for(int k = 0; k < 3; ++k)
+    {
+        bounds[2 * k] = Nodes.empty() ? 0 : Nodes[0].Lower[k];
+        bounds[2 * k + 1] = Nodes.empty() ? 0 : Nodes[0].Upper[k];
+    }
+}
+
+vtkIdType vtkTriangleBVH::BuildNode(std::vector<vtkIdType>& order, const Eigen::MatrixXd& centroids,
+                                     vtkIdType start, vtkIdType count)
+{
+    // Triangles is still in input order here, order[start, start + count) are the triangles of the node
+    Eigen::RowVector3d lower = Eigen::RowVector3d::Constant(std::numeric_limits<double>::max());
+    Eigen::RowVector3d upper = -lower;
+    Eigen::RowVector3d centroidLower = lower;
+    Eigen::RowVector3d centroidUpper = upper;
+    for(vtkIdType f = start; f < start + count; ++f)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            lower = lower.cwiseMin(Vertices.row(Triangles[3 * order[f] + k]));
+            upper = upper.cwiseMax(Vertices.row(Triangles[3 * order[f] + k]));
+        }
+        centroidLower = centroidLower.cwiseMin(centroids.row(order[f]));
+        centroidUpper = centroidUpper.cwiseMax(centroids.row(order[f]));
+    }
+
+    vtkIdType index = static_cast<vtkIdType>(Nodes.size());
+    Node node;
+    for(int k = 0; k < 3; ++k)
+    {
+        node.Lower[k] = lower(k);
+        node.Upper[k] = upper(k);
+    }
+    node.Start = start;
+    node.Count = count;
+    node.Right = -1;
+    Nodes.push_back(node);
+    if(count <= LEAF_SIZE)
+    {
+        return index;
+    }
+
+    int axis;
+    (centroidUpper - centroidLower).maxCoeff(&axis);
+    vtkIdType half = count / 2;
+    std::nth_element(order.begin() + start, order.begin() + start + half, order.begin() + start + count,
+                     CentroidLess(centroids, axis));
+    BuildNode(order, centroids, start, half);
+    vtkIdType right = BuildNode(order, centroids, start + half, count - half);
+    Nodes[index].Count = 0;
+    Nodes[index].Right = right;
+    return index;
+}
+
+bool vtkTriangleBVH::IntersectTriangle(vtkIdType triangle, const Eigen::Vector3d& origin, const Eigen::Vector3d& direction,
+                                       double tMin, double tMax, double& t) const
+{
+    // Moller-Trumbore
+    Eigen::Vector3d v0 = Vertices.row(Triangles[3 * triangle]).transpose();
+    Eigen::Vector3d e1 = Vertices.row(Triangles[3 * triangle + 1]).transpose() - v0;
+    Eigen::Vector3d e2 = Vertices.row(Triangles[3 * triangle + 2]).transpose() - v0;
+    Eigen::Vector3d p = direction.cross(e2);
+    double det = e1.dot(p);
+    if(det == 0)
+    {
+        return false;
+    }
+    double inverseDet = 1.0 / det;
+    Eigen::Vector3d s = origin - v0;
+    double u = s.dot(p) * inverseDet;
+    if(u < 0 || u > 1)
+    {
+        return false;
+    }
+    Eigen::Vector3d q = s.cross(e1);
+    double v = direction.dot(q) * inverseDet;
+    if(v < 0 || u + v > 1)
+    {
+        return false;
+    }
+    double hit = e2.dot(q) * inverseDet;
+    if(hit < tMin || hit > tMax)
+    {
+        return false;
+    }
+    t = hit;
+    return true;
+}
+
+bool vtkTriangleBVH::IntersectRay(const double origin[3], const double direction[3], double tMin, double tMax,
+                                  double& t, vtkIdType& cellId) const
+{
+    if(Nodes.empty())
+    {
+        return false;
+    }
+    Eigen::Vector3d o(origin[0], origin[1], origin[2]);
+    Eigen::Vector3d d(direction[0], direction[1], direction[2]);
+    Eigen::Vector3d inverseDirection = d.cwiseInverse();
+    cellId = -1;
+    double tEnter;
+    vtkIdType stack[MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while(top > 0)
+    {
+        vtkIdType index = stack[--top];
+        const Node& node = Nodes[index];
+        if(!IntersectBox(node.Lower, node.Upper, o, inverseDirection, tMin, tMax, tEnter))
+        {
+            continue;
+        }
+        if(node.Count > 0)
+        {
+            for(vtkIdType f = node.Start; f < node.Start + node.Count; ++f)
+            {
+                double hit;
+                if(IntersectTriangle(f, o, d, tMin, tMax, hit))
+                {
+                    // closer hits only from now on
+                    tMax = hit;
+                    cellId = Cells[f];
+                }
+            }
+            continue;
+        }
+        // visit the closer child first: it is pushed last
+        vtkIdType left = index + 1;
+        vtkIdType right = node.Right;
+        double tLeft, tRight;
+        bool hitLeft = IntersectBox(Nodes[left].Lower, Nodes[left].Upper, o, inverseDirection, tMin, tMax, tLeft);
+        bool hitRight = IntersectBox(Nodes[right].Lower, Nodes[right].Upper, o, inverseDirection, tMin, tMax, tRight);
+        if(hitLeft && hitRight)
+        {
+            stack[top++] = tLeft < tRight ? right : left;
+            stack[top++] = tLeft < tRight ? left : right;
+        }
+        else if(hitLeft)
+        {
+            stack[top++] = left;
+        }
+        else if(hitRight)
+        {
+            stack[top++] = right;
+        }
+    }
+    if(cellId < 0)
+    {
+        return false;
+    }
+    t = tMax;
+    return true;
+}
+
+Eigen::Vector3d vtkTriangleBVH::ClosestPointOnTriangle(vtkIdType triangle, const Eigen::Vector3d& x, int& feature) const
+{
+    // region tests of Ericson, Real-Time Collision Detection 5.1.5
+    Eigen::Map<const Eigen::Vector3d> a(Corners.row(triangle).data());
+    Eigen::Map<const Eigen::Vector3d> b(Corners.row(triangle).data() + 3);
+    Eigen::Map<const Eigen::Vector3d> c(Corners.row(triangle).data() + 6);
+    Eigen::Vector3d ab = b - a, ac = c - a, ap = x - a;
+    double d1 = ab.dot(ap), d2 = ac.dot(ap);
+    if(d1 <= 0 && d2 <= 0)
+    {
+        feature = 0;
+        return a;
+    }
+    Eigen::Vector3d bp = x - b;
+    double d3 = ab.dot(bp), d4 = ac.dot(bp);
+    if(d3 >= 0 && d4 <= d3)
+    {
+        feature = 1;
+        return b;
+    }
+    double vc = d1 * d4 - d3 * d2;
+    if(vc <= 0 && d1 >= 0 && d3 <= 0)
+    {
+        feature = 3;
+        return a + d1 / (d1 - d3) * ab;
+    }
+    Eigen::Vector3d cp = x - c;
+    double d5 = ab.dot(cp), d6 = ac.dot(cp);
+    if(d6 >= 0 && d5 <= d6)
+    {
+        feature = 2;
+        return c;
+    }
+    double vb = d5 * d2 - d1 * d6;
+    if(vb <= 0 && d2 >= 0 && d6 <= 0)
+    {
+        feature = 4;
+        return a + d2 / (d2 - d6) * ac;
+    }
+    double va = d3 * d6 - d5 * d4;
+    if(va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+    {
+        feature = 5;
+        return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+    }
+    double sum = va + vb + vc;
+    if(sum <= 0)
+    {
+        // degenerate triangle: every region test failed, fall back to the first vertex
+        feature = 0;
+        return a;
+    }
+    feature = 6;
+    return a + (vb / sum) * ab + (vc / sum) * ac;
+}
+
+double vtkTriangleBVH::FindClosestPoint(const double x[3], double closest[3], double normal[3], vtkIdType& cellId,
+                                        double maxDistance) const
+{
+    if(Nodes.empty())
+    {
+        return -1;
+    }
+    Eigen::Vector3d p(x[0], x[1], x[2]);
+    double best = maxDistance < std::sqrt(std::numeric_limits<double>::max()) ? maxDistance * maxDistance
+                                                                             : std::numeric_limits<double>::max();
+    vtkIdType bestTriangle = -1;
+    int bestFeature = 6;
+    Eigen::Vector3d bestPoint = p;
+    // nodes to visit with the squared distance of their box, tested again once a closer triangle is known
+    vtkIdType stack[MAX_DEPTH];
+    double stackDistances[MAX_DEPTH];
+    int top = 0;
+    stack[top] = 0;
+    stackDistances[top++] = SquaredDistanceToBox(Nodes[0].Lower, Nodes[0].Upper, p);
+    while(top > 0)
+    {
+        --top;
+        vtkIdType index = stack[top];
+        if(stackDistances[top] >= best)
+        {
+            continue;
+        }
+        const Node& node = Nodes[index];
+        if(node.Count > 0)
+        {
+            for(vtkIdType f = node.Start; f < node.Start + node.Count; ++f)
+            {
+                int feature;
+                Eigen::Vector3d q = ClosestPointOnTriangle(f, p, feature);
+                double d2 = (q - p).squaredNorm();
+                if(d2 < best)
+                {
+                    best = d2;
+                    bestTriangle = f;
+                    bestFeature = feature;
+                    bestPoint = q;
+                }
+            }
+            continue;
+        }
+        // visit the closer child first: it is pushed last
+        vtkIdType children[2] = {index + 1, node.Right};
+        double distances[2] = {SquaredDistanceToBox(Nodes[children[0]].Lower, Nodes[children[0]].Upper, p),
+                               SquaredDistanceToBox(Nodes[children[1]].Lower, Nodes[children[1]].Upper, p)};
+        int closer = distances[1] < distances[0] ? 1 : 0;
+        for(int c = 1 - closer, n = 0; n < 2; c = 1 - c, ++n)
+        {
+            if(distances[c] < best)
+            {
+                stack[top] = children[c];
+                stackDistances[top++] = distances[c];
+            }
+        }
+    }
+    if(bestTriangle < 0)
+    {
+        return -1;
+    }
+
+    Eigen::Vector3d n;
+    if(bestFeature < 3)
+    {
+        n = VertexNormals.row(Triangles[3 * bestTriangle + bestFeature]).transpose();
+    }
+    else if(bestFeature < 6)
+    {
+        n = EdgeNormals.row(3 * bestTriangle + bestFeature - 3).transpose();
+    }
+    else
+    {
+        n = FaceNormal(bestTriangle);
+    }
+    for(int k = 0; k < 3; ++k)
+    {
+        closest[k] = bestPoint(k);
+        normal[k] = n(k);
+    }
+    cellId = Cells[bestTriangle];
+    return std::sqrt(best);
+}
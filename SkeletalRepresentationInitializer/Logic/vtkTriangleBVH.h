@@ -0,0 +1,81 @@
+// This class provides a bounding volume hierarchy over the triangles of a mesh
+// The hierarchy is a binary tree of axis aligned boxes split at the median triangle
+// centroid along the longest axis, stored depth first in one array. Queries only read
+// the tree, so they can run concurrently from several threads.
+#ifndef __vtkTriangleBVH_h
+#define __vtkTriangleBVH_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+
+// STD includes
+#include <limits>
+#include <vector>
+
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkTriangleBVH {
+public:
+    vtkTriangleBVH();
+
+    // build the hierarchy over the polygons of the mesh, polygons with more than 3 points are split in fans
+    // return false if the mesh has no polygon
+    bool Build(vtkPolyData* mesh);
+    vtkIdType GetNumberOfTriangles() const {return static_cast<vtkIdType>(Triangles.size() / 3);}
+
+    // nearest intersection of the ray origin + t direction with t in [tMin, tMax], both faces of a triangle count
+    // output[t]: ray parameter of the intersection, output[cellId]: mesh cell of the triangle hit
+    // return false if the ray misses every triangle in the range
+    bool IntersectRay(const double origin[3], const double direction[3], double tMin, double tMax,
+                      double& t, vtkIdType& cellId) const;
+
+    // closest point of the mesh to the point x
+    // output[closest]: closest point, output[normal]: angle weighted pseudo-normal of the face, edge or vertex
+    // the closest point lies on, pointing out of a closed mesh, so that (x - closest) . normal > 0 outside
+    // output[cellId]: mesh cell of the triangle; return the distance from x, -1 if the hierarchy is empty
+    // or no triangle is closer than maxDistance, a known bound that prunes the search
+    double FindClosestPoint(const double x[3], double closest[3], double normal[3], vtkIdType& cellId,
+                            double maxDistance = std::numeric_limits<double>::max()) const;
+
+    // bounds of the triangles (xmin, xmax, ymin, ymax, zmin, zmax)
+    void GetBounds(double bounds[6]) const;
+    // +1 if the triangles of the mesh turn counterclockwise seen from outside, -1 otherwise
+    double GetOrientation() const {return Orientation;}
+
+private:
+    struct Node
+    {
+        double Lower[3];
+        double Upper[3];
+        // leaf: triangles Order[Start, Start + Count); inner node: left child follows the node, right child at Right
+        vtkIdType Start;
+        vtkIdType Count;
+        vtkIdType Right;
+    };
+
+    vtkIdType BuildNode(std::vector<vtkIdType>& order, const Eigen::MatrixXd& centroids, vtkIdType start, vtkIdType count);
+    bool IntersectTriangle(vtkIdType triangle, const Eigen::Vector3d& origin, const Eigen::Vector3d& direction,
+                           double tMin, double tMax, double& t) const;
+    // feature: 0, 1, 2 for a vertex, 3, 4, 5 for the edge (0, 1), (0, 2), (1, 2), 6 inside the triangle
+    Eigen::Vector3d ClosestPointOnTriangle(vtkIdType triangle, const Eigen::Vector3d& x, int& feature) const;
+    Eigen::Vector3d FaceNormal(vtkIdType triangle) const;
+    void ComputePseudoNormals();
+
+    Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> Vertices;
+    // 3 vertex ids per triangle and the mesh cell it comes from, in leaf order
+    std::vector<vtkIdType> Triangles;
+    // coordinates of the 3 corners of every triangle in leaf order, so that a leaf reads contiguous memory
+    Eigen::Matrix<double, Eigen::Dynamic, 9, Eigen::RowMajor> Corners;
+    std::vector<vtkIdType> Cells;
+    std::vector<Node> Nodes;
+    // angle weighted normals of the vertices, and normals of the 3 edges of every triangle in leaf order
+    Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> VertexNormals;
+    Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> EdgeNormals;
+    // +1 if the triangles of the mesh turn counterclockwise seen from outside, -1 otherwise
+    double Orientation;
+};
+#endif
@@ -0,0 +1,458 @@
+// This class provides the geometric validity checks of flowed meshes and s-reps
+#include "vtkValidityChecker.h"
+#include "vtkSrepModel.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkIdList.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+// lower corner then upper corner of every box, or both ends of every segment
+typedef Eigen::Matrix<double, Eigen::Dynamic, 6, Eigen::RowMajor> BoxMatrixType;
+// largest number of cells of the grid along one axis, so that a cell key fits in 64 bits
+const double MAX_CELLS = 1 << 20;
+
+// uniform grid of cells about the size of the mean box, every box is listed in the cells it overlaps
+class SpatialHash
+{
+public:
+    typedef std::vector<std::pair<vtkTypeInt64, vtkIdType> >::const_iterator EntryIterator;
+
+    explicit SpatialHash(const BoxMatrixType& boxes) : Boxes(boxes)
+    {
+        this->Lower = boxes.leftCols<3>().colwise().minCoeff();
+        Eigen::RowVector3d extent = boxes.rightCols<3>().colwise().maxCoeff() - this->Lower;
+        this->CellSize = std::max((boxes.rightCols<3>() - boxes.leftCols<3>()).rowwise().maxCoeff().mean(),
+                                  extent.maxCoeff() / MAX_CELLS);
+        if(!(this->CellSize > 0))
+        {
+            this->CellSize = 1;
+        }
+        for(int k = 0; k < 3; ++k)
+        {
+            this->Dimensions[k] = static_cast<vtkTypeInt64>(extent(k) / this->CellSize) + 1;
+        }
+        for(vtkIdType i = 0; i < boxes.rows(); ++i)
+        {
+            vtkTypeInt64 lower[3], upper[3];
+            this->GetCell(boxes.row(i).data(), lower);
+            this->GetCell(boxes.row(i).data() + 3, upper);
+            for(vtkTypeInt64 x = lower[0]; x <= upper[0]; ++x)
+                for(vtkTypeInt64 y = lower[1]; y <= upper[1]; ++y)
+                    for(vtkTypeInt64 z = lower[2]; z <= upper[2]; ++z)
+                    {
+                        vtkTypeInt64 cell[3] = {x, y, z};
+                        this->Entries.push_back(std::make_pair(this->GetKey(cell), i));
+                    }
+        }
+        std::sort(this->Entries.begin(), this->Entries.end());
+    }
+
+    void GetCell(const double x[3], vtkTypeInt64 cell[3]) const
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            vtkTypeInt64 c = static_cast<vtkTypeInt64>(std::floor((x[k] - this->Lower(k)) / this->CellSize));
+            cell[k] = std::min(std::max<vtkTypeInt64>(c, 0), this->Dimensions[k] - 1);
+        }
+    }
+
+    vtkTypeInt64 GetKey(const vtkTypeInt64 cell[3]) const
+    {
+        return (cell[0] * this->Dimensions[1] + cell[1]) * this->Dimensions[2] + cell[2];
+    }
+
+    // boxes listed in the cell
+    void Find(vtkTypeInt64 key, EntryIterator& begin, EntryIterator& end) const
+    {
+        begin = std::lower_bound(this->Entries.begin(), this->Entries.end(), std::make_pair(key, static_cast<vtkIdType>(-1)));
+        for(end = begin; end != this->Entries.end() && end->first == key; ++end)
+        {
+        }
+    }
+
+    const BoxMatrixType& Boxes;
+
+private:
+    Eigen::RowVector3d Lower;
+    double CellSize;
+    vtkTypeInt64 Dimensions[3];
+    // (cell key, box) sorted by cell
+    std::vector<std::pair<vtkTypeInt64, vtkIdType> > Entries;
+};
+
+// test the pairs (i, j > i) of overlapping boxes for the boxes i in [begin, end), write the j that pass at hits[i]
+template<class Test>
+class PairFunctor
+{
+public:
+    PairFunctor(const SpatialHash& hash, const Test& test, std::vector<std::vector<vtkIdType> >& hits)
+        : Hash(hash), PairTest(test), Hits(hits) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        const BoxMatrixType& boxes = this->Hash.Boxes;
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            this->Hits[i].clear();
+            vtkTypeInt64 lower[3], upper[3];
+            this->Hash.GetCell(boxes.row(i).data(), lower);
+            this->Hash.GetCell(boxes.row(i).data() + 3, upper);
+            for(vtkTypeInt64 x = lower[0]; x <= upper[0]; ++x)
+                for(vtkTypeInt64 y = lower[1]; y <= upper[1]; ++y)
+                    for(vtkTypeInt64 z = lower[2]; z <= upper[2]; ++z)
+                    {
+                        vtkTypeInt64 cell[3] = {x, y, z};
+                        vtkTypeInt64 key = this->Hash.GetKey(cell);
+                        SpatialHash::EntryIterator first, last;
+                        this->Hash.Find(key, first, last);
+                        for(; first != last; ++first)
+                        {
+                            vtkIdType j = first->second;
+                            if(j <= i || (boxes.row(i).head<3>().array() > boxes.row(j).tail<3>().array()).any()
+                                || (boxes.row(j).head<3>().array() > boxes.row(i).tail<3>().array()).any())
+                            {
+                                continue;
+                            }
+                            // the pair is tested in the cell of the lower corner of the overlap only
+                            Eigen::RowVector3d corner = boxes.row(i).head<3>().cwiseMax(boxes.row(j).head<3>());
+                            vtkTypeInt64 owner[3];
+                            this->Hash.GetCell(corner.data(), owner);
+                            if(this->Hash.GetKey(owner) == key && this->PairTest(i, j))
+                            {
+                                this->Hits[i].push_back(j);
+                            }
+                        }
+                    }
+        }
+    }
+
+private:
+    const SpatialHash& Hash;
+    const Test& PairTest;
+    std::vector<std::vector<vtkIdType> >& Hits;
+};
+
+// pairs (i, j) passing the test among the boxes, i < j
+template<class Test>
+void FindPairs(const BoxMatrixType& boxes, const Test& test, vtkValidityChecker::PairList& pairs)
+{
+    SpatialHash hash(boxes);
+    std::vector<std::vector<vtkIdType> > hits(boxes.rows());
+    PairFunctor<Test> functor(hash, test, hits);
+    vtkSMPTools::For(0, boxes.rows(), functor);
+    pairs.clear();
+    for(vtkIdType i = 0; i < boxes.rows(); ++i)
+    {
+        for(size_t k = 0; k < hits[i].size(); ++k)
+        {
+            pairs.push_back(std::make_pair(i, hits[i][k]));
+        }
+    }
+}
+
+// true if the segment p q crosses the triangle, Moller-Trumbore; a segment parallel to the triangle does not
+bool SegmentCrossesTriangle(const Eigen::Vector3d& p, const Eigen::Vector3d& q,
+                            const Eigen::Vector3d& v0, const Eigen::Vector3d& v1, const Eigen::Vector3d& v2)
+{
+    Eigen::Vector3d direction = q - p;
+    Eigen::Vector3d e1 = v1 - v0;
+    Eigen::Vector3d e2 = v2 - v0;
+    Eigen::Vector3d h = direction.cross(e2);
+    double det = e1.dot(h);
+    if(det == 0)
+    {
+        return false;
+    }
+    double inverseDet = 1.0 / det;
+    Eigen::Vector3d s = p - v0;
+    double u = s.dot(h) * inverseDet;
+    if(u < 0 || u > 1)
+    {
+        return false;
+    }
+    Eigen::Vector3d r = s.cross(e1);
+    double v = direction.dot(r) * inverseDet;
+    if(v < 0 || u + v > 1)
+    {
+        return false;
+    }
+    double t = e2.dot(r) * inverseDet;
+    return t >= 0 && t <= 1;
+}
+
+// triangles that intersect other than along a shared edge or at a shared vertex
+class TriangleTest
+{
+public:
+    TriangleTest(const Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>& vertices, const std::vector<vtkIdType>& triangles)
+        : Vertices(vertices), Triangles(triangles) {}
+
+    bool operator()(vtkIdType a, vtkIdType b) const
+    {
+        const vtkIdType* ta = &this->Triangles[3 * a];
+        const vtkIdType* tb = &this->Triangles[3 * b];
+        int nShared = 0, sharedA = -1, sharedB = -1;
+        for(int k = 0; k < 3; ++k)
+        {
+            for(int l = 0; l < 3; ++l)
+            {
+                if(ta[k] == tb[l])
+                {
+                    ++nShared;
+                    sharedA = k;
+                    sharedB = l;
+                }
+            }
+        }
+        if(nShared >= 2)
+        {
+            return false;
+        }
+        // two triangles that cross, not in the same plane, meet along a segment whose ends lie on their edges;
+        // with a shared vertex the segment starts there and ends on the edge of one triangle opposite to it
+        for(int k = 0; k < 3; ++k)
+        {
+            if(k != sharedA && (k + 1) % 3 != sharedA && this->EdgeCrosses(ta[k], ta[(k + 1) % 3], tb))
+            {
+                return true;
+            }
+            if(k != sharedB && (k + 1) % 3 != sharedB && this->EdgeCrosses(tb[k], tb[(k + 1) % 3], ta))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    bool EdgeCrosses(vtkIdType p, vtkIdType q, const vtkIdType* triangle) const
+    {
+        return SegmentCrossesTriangle(this->Vertices.row(p).transpose(), this->Vertices.row(q).transpose(),
+                                      this->Vertices.row(triangle[0]).transpose(), this->Vertices.row(triangle[1]).transpose(),
+                                      this->Vertices.row(triangle[2]).transpose());
+    }
+
+    const Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>& Vertices;
+    const std::vector<vtkIdType>& Triangles;
+};
+
+// squared distance between the segments p0 p1 and q0 q1, closest points of segments after Ericson
+double SquaredSegmentDistance(const Eigen::Vector3d& p0, const Eigen::Vector3d& p1,
+                              const Eigen::Vector3d& q0, const Eigen::Vector3d& q1)
+{
+    Eigen::Vector3d d1 = p1 - p0, d2 = q1 - q0, r = p0 - q0;
+    double a = d1.squaredNorm(), e = d2.squaredNorm(), f = d2.dot(r);
+    double s = 0, t = 0;
+    if(a == 0 && e == 0)
+    {
+        return r.squaredNorm();
+    }
+    if(a == 0)
+    {
+        t = std::min(std::max(f / e, 0.0), 1.0);
+    }
+    else
+    {
+        double c = d1.dot(r);
+        if(e == 0)
+        {
+            s = std::min(std::max(-c / a, 0.0), 1.0);
+        }
+        else
+        {
+            double b = d1.dot(d2);
+            double denominator = a * e - b * b;
+            // parallel segments: any s, take the end of the first one
+            s = denominator > 0 ? std::min(std::max((b * f - c * e) / denominator, 0.0), 1.0) : 0.0;
+            t = (b * s + f) / e;
+            if(t < 0)
+            {
+                t = 0;
+                s = std::min(std::max(-c / a, 0.0), 1.0);
+            }
+            else if(t > 1)
+            {
+                t = 1;
+                s = std::min(std::max((b - c) / a, 0.0), 1.0);
+            }
+        }
+    }
+    return (p0 + s * d1 - q0 - t * d2).squaredNorm();
+}
+
+// spokes closer than the tolerance, other than spokes on the same skeletal point or hub
+class SpokeTest
+{
+public:
+    SpokeTest(const BoxMatrixType& segments, const std::vector<vtkIdType>& skeletalPoints, double tolerance)
+        : Segments(segments), SkeletalPoints(skeletalPoints), Tolerance(tolerance) {}
+
+    bool operator()(vtkIdType a, vtkIdType b) const
+    {
+        // spokes on one skeletal point, or on one hub, meet there by construction
+        if(this->SkeletalPoints[a] == this->SkeletalPoints[b]
+            || (this->Segments.row(a).head<3>() - this->Segments.row(b).head<3>()).squaredNorm() < this->Tolerance * this->Tolerance)
+        {
+            return false;
+        }
+        return SquaredSegmentDistance(this->Segments.row(a).head<3>().transpose(), this->Segments.row(a).tail<3>().transpose(),
+                                      this->Segments.row(b).head<3>().transpose(), this->Segments.row(b).tail<3>().transpose())
+            < this->Tolerance * this->Tolerance;
+    }
+
+private:
+    const BoxMatrixType& Segments;
+    const std::vector<vtkIdType>& SkeletalPoints;
+    double Tolerance;
+};
+}
+
+vtkIdType vtkValidityChecker::FindSelfIntersections(vtkPolyData* mesh, PairList* pairs)
+{
+    if(mesh == NULL || mesh->GetPolys() == NULL || mesh->GetPolys()->GetNumberOfCells() == 0)
+    {
+        std::cerr << "The self intersection check needs a mesh with polygons" << std::endl;
+        return -1;
+    }
+    vtkIdType nPoints = mesh->GetNumberOfPoints();
+    Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> vertices(nPoints, 3);
+    for(vtkIdType i = 0; i < nPoints; ++i)
+    {
+        mesh->GetPoint(i, vertices.row(i).data());
+    }
+    std::vector<vtkIdType> triangles, cells;
+    vtkSmartPointer<vtkIdList> cell = vtkSmartPointer<vtkIdList>::New();
+    vtkCellArray* polys = mesh->GetPolys();
+    // polygons come after the vertices and lines in the cell ids of a polydata
+    vtkIdType cellId = mesh->GetNumberOfVerts() + mesh->GetNumberOfLines();
+    polys->InitTraversal();
+    for(; polys->GetNextCell(cell); ++cellId)
+    {
+        for(vtkIdType k = 2; k < cell->GetNumberOfIds(); ++k)
+        {
+            triangles.push_back(cell->GetId(0));
+            triangles.push_back(cell->GetId(k - 1));
+            triangles.push_back(cell->GetId(k));
+            cells.push_back(cellId);
+        }
+    }
+    vtkIdType nTriangles = static_cast<vtkIdType>(cells.size());
+    BoxMatrixType boxes(nTriangles, 6);
+    for(vtkIdType f = 0; f < nTriangles; ++f)
+    {
+        Eigen::Matrix3d corners;
+        for(int k = 0; k < 3; ++k)
+        {
+            corners.row(k) = vertices.row(triangles[3 * f + k]);
+        }
+        boxes.block<1, 3>(f, 0) = corners.colwise().minCoeff();
+        boxes.block<1, 3>(f, 3) = corners.colwise().maxCoeff();
+    }
+
+    PairList trianglePairs;
+    FindPairs(boxes, TriangleTest(vertices, triangles), trianglePairs);
+    // triangles of the same polygons cross more than once
+    PairList cellPairs;
+    for(size_t k = 0; k < trianglePairs.size(); ++k)
+    {
+        vtkIdType a = cells[trianglePairs[k].first], b = cells[trianglePairs[k].second];
+        if(a != b)
+        {
+            cellPairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+        }
+    }
+    std::sort(cellPairs.begin(), cellPairs.end());
+    cellPairs.erase(std::unique(cellPairs.begin(), cellPairs.end()), cellPairs.end());
+    if(pairs != NULL)
+    {
+        pairs->swap(cellPairs);
+        return static_cast<vtkIdType>(pairs->size());
+    }
+    return static_cast<vtkIdType>(cellPairs.size());
+}
+
+vtkIdType vtkValidityChecker::FindSpokeCrossings(vtkMultiBlockDataSet* srep, double tolerance, PairList* pairs)
+{
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "The spoke crossing check needs a valid s-rep" << std::endl;
+        return -1;
+    }
+    int nRows = vtkSrepModel::GetNumberOfRows(srep);
+    int nCols = vtkSrepModel::GetNumberOfColumns(srep);
+    vtkPolyData* blocks[3] = {vtkSrepModel::GetUpSpokes(srep), vtkSrepModel::GetDownSpokes(srep), vtkSrepModel::GetCrestSpokes(srep)};
+    vtkIdType nGrid = blocks[0]->GetNumberOfPoints();
+    vtkIdType nCrest = blocks[2]->GetNumberOfPoints();
+    // the crest spoke i hinges next to grid point GetCrestSkeletalPoint(i) when the fold follows the grid
+    bool crestOnGrid = nGrid == nRows * nCols && blocks[1]->GetNumberOfPoints() == nGrid
+        && nRows >= 2 && nCols >= 2 && nCrest == 2 * nRows + 2 * (nCols - 2);
+
+    vtkIdType nSpokes = nGrid + blocks[1]->GetNumberOfPoints() + nCrest;
+    BoxMatrixType segments(nSpokes, 6);
+    std::vector<vtkIdType> skeletalPoints(nSpokes);
+    double meanLength = 0;
+    vtkIdType s = 0;
+    for(int b = 0; b < 3; ++b)
+    {
+        vtkDataArray* directions = blocks[b]->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengths = blocks[b]->GetPointData()->GetArray("spokeLength");
+        for(vtkIdType i = 0; i < blocks[b]->GetNumberOfPoints(); ++i, ++s)
+        {
+            double hub[3], direction[3];
+            blocks[b]->GetPoint(i, hub);
+            directions->GetTuple(i, direction);
+            double length = lengths->GetTuple1(i);
+            for(int k = 0; k < 3; ++k)
+            {
+                segments(s, k) = hub[k];
+                segments(s, 3 + k) = hub[k] + length * direction[k];
+            }
+            meanLength += length;
+            if(b != vtkSrepModel::CrestBlock)
+            {
+                skeletalPoints[s] = i;
+            }
+            else
+            {
+                skeletalPoints[s] = crestOnGrid ? vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols) : nGrid + i;
+            }
+        }
+    }
+    if(nSpokes > 0)
+    {
+        meanLength /= nSpokes;
+    }
+    double distance = tolerance * meanLength;
+
+    // boxes of the segments, grown by half the tolerance so that close segments overlap
+    BoxMatrixType boxes(nSpokes, 6);
+    for(vtkIdType i = 0; i < nSpokes; ++i)
+    {
+        boxes.block<1, 3>(i, 0) = segments.block<1, 3>(i, 0).cwiseMin(segments.block<1, 3>(i, 3)).array() - distance / 2;
+        boxes.block<1, 3>(i, 3) = segments.block<1, 3>(i, 0).cwiseMax(segments.block<1, 3>(i, 3)).array() + distance / 2;
+    }
+    PairList crossings;
+    FindPairs(boxes, SpokeTest(segments, skeletalPoints, distance), crossings);
+    if(pairs != NULL)
+    {
+        pairs->swap(crossings);
+        return static_cast<vtkIdType>(pairs->size());
+    }
+    return static_cast<vtkIdType>(crossings.size());
+}
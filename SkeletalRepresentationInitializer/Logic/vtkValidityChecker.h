@@ -0,0 +1,36 @@
+// This class provides the geometric validity checks of flowed meshes and s-reps
+// Triangles or spokes are listed in a uniform grid of cells about the size of one of them, sorted by
+// cell, so that only the pairs sharing a cell are tested; every pair is tested once, in the cell of the
+// lower corner of the overlap of their boxes, in parallel over the first of the pair. The cost grows
+// with the number of triangles or spokes times a logarithm, cheap enough to run during a flow.
+#ifndef __vtkValidityChecker_h
+#define __vtkValidityChecker_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <utility>
+#include <vector>
+
+class vtkMultiBlockDataSet;
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkValidityChecker {
+public:
+    typedef std::vector<std::pair<vtkIdType, vtkIdType> > PairList;
+
+    // pairs of polygons of the mesh that intersect other than along a shared edge or at a shared vertex,
+    // as mesh cell ids (first < second); polygons with more than 3 points are split in fans, and
+    // triangles lying in the same plane are not tested against each other
+    // return the number of pairs, -1 if the mesh has no polygon
+    static vtkIdType FindSelfIntersections(vtkPolyData* mesh, PairList* pairs = NULL);
+
+    // pairs of spokes of the s-rep closer than tolerance times the mean spoke length, other than spokes
+    // on the same skeletal point (up and down spokes of a grid point and the crest spoke of the fold point
+    // next to it) or with the same hub; spokes are numbered up, then down, then crest
+    // return the number of pairs, -1 if the s-rep is not valid
+    static vtkIdType FindSpokeCrossings(vtkMultiBlockDataSet* srep, double tolerance, PairList* pairs = NULL);
+};
+#endif
@@ -0,0 +1,211 @@
+// This class provides mapping of points between meshes with the same connectivity
+#include "vtkVertexCorrespondenceMapper.h"
+#include "vtkTriangleBVH.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+// frame of the triangle (v0, v1, v2) of a mesh: columns v1 - v0, v2 - v0 and the normal,
+// scaled with the triangle or of unit length pointing out of a mesh of the given orientation
+Eigen::Matrix3d TriangleFrame(vtkPolyData* mesh, const vtkIdType* ids, bool unitNormal, double orientation,
+                              Eigen::Vector3d& origin)
+{
+    Eigen::Vector3d v[3];
+    for(int k = 0; k < 3; ++k)
+    {
+        mesh->GetPoint(ids[k], v[k].data());
+    }
+    origin = v[0];
+    Eigen::Matrix3d frame;
+    frame.col(0) = v[1] - v[0];
+    frame.col(1) = v[2] - v[0];
+    Eigen::Vector3d normal = frame.col(0).cross(frame.col(1));
+    double area = normal.norm();
+    if(area > 0)
+    {
+        frame.col(2) = unitNormal ? Eigen::Vector3d(normal * (orientation / area)) : Eigen::Vector3d(normal / std::sqrt(area));
+    }
+    else
+    {
+        frame.col(2).setZero();
+    }
+    return frame;
+}
+
+// anchor the points to their closest triangle of the mesh
+// a point that cannot be anchored gets the vertex ids -1
+class AnchorFunctor
+{
+public:
+    AnchorFunctor(vtkPolyData* mesh, const vtkTriangleBVH& boundary, const std::vector<vtkIdType>& cellTriangles,
+                  const vtkEigenArrayBridge::PointMatrixMap& points, std::vector<vtkIdType>& triangles,
+                  Eigen::MatrixXd& coordinates, std::vector<char>& unitNormal)
+        : Mesh(mesh), Boundary(boundary), CellTriangles(cellTriangles), Points(points), Triangles(triangles),
+          Coordinates(coordinates), UnitNormal(unitNormal) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            Eigen::Vector3d p = this->Points.row(i).transpose();
+            Eigen::Vector3d closest, normal;
+            vtkIdType cellId = -1;
+            vtkIdType* ids = &this->Triangles[3 * i];
+            if(this->Boundary.FindClosestPoint(p.data(), closest.data(), normal.data(), cellId) < 0
+                    || this->CellTriangles[3 * cellId] < 0)
+            {
+                ids[0] = ids[1] = ids[2] = -1;
+                continue;
+            }
+            // polygons are anchored to their first three vertices
+            for(int k = 0; k < 3; ++k)
+            {
+                ids[k] = this->CellTriangles[3 * cellId + k];
+            }
+            Eigen::Vector3d origin;
+            Eigen::Matrix3d frame = TriangleFrame(this->Mesh, ids, false, 1, origin);
+            Eigen::FullPivLU<Eigen::Matrix3d> lu = frame.fullPivLu();
+            if(lu.rank() == 3)
+            {
+                this->Coordinates.col(i) = lu.solve(p - origin);
+                this->UnitNormal[i] = 0;
+                continue;
+            }
+            // degenerate triangle: closest point in the edges of the triangle, offset along the outward normal
+            Eigen::Matrix<double, 3, 2> edges = frame.leftCols<2>();
+            this->Coordinates.col(i).head<2>() = edges.jacobiSvd(Eigen::ComputeFullU | Eigen::ComputeFullV).solve(closest - origin);
+            // the closest point may have no normal on a mesh of degenerate triangles, then only the distance is kept
+            this->Coordinates(2, i) = normal.squaredNorm() > 0 ? (p - closest).dot(normal) : (p - closest).norm();
+            this->UnitNormal[i] = 1;
+        }
+    }
+
+private:
+    vtkPolyData* Mesh;
+    const vtkTriangleBVH& Boundary;
+    const std::vector<vtkIdType>& CellTriangles;
+    const vtkEigenArrayBridge::PointMatrixMap& Points;
+    std::vector<vtkIdType>& Triangles;
+    Eigen::MatrixXd& Coordinates;
+    std::vector<char>& UnitNormal;
+};
+
+// rebuild the anchored points from the triangles of the target mesh
+class RebuildFunctor
+{
+public:
+    RebuildFunctor(vtkPolyData* mesh, const std::vector<vtkIdType>& triangles, const Eigen::MatrixXd& coordinates,
+                   const std::vector<char>& unitNormal, double orientation, vtkEigenArrayBridge::PointMatrixMap& points)
+        : Mesh(mesh), Triangles(triangles), Coordinates(coordinates), UnitNormal(unitNormal), Orientation(orientation),
+          Points(points) {}
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            Eigen::Vector3d origin;
+            Eigen::Matrix3d frame = TriangleFrame(this->Mesh, &this->Triangles[3 * i], this->UnitNormal[i] != 0,
+                                                  this->Orientation, origin);
+            this->Points.row(i) = (origin + frame * this->Coordinates.col(i)).transpose();
+        }
+    }
+
+private:
+    vtkPolyData* Mesh;
+    const std::vector<vtkIdType>& Triangles;
+    const Eigen::MatrixXd& Coordinates;
+    const std::vector<char>& UnitNormal;
+    double Orientation;
+    vtkEigenArrayBridge::PointMatrixMap& Points;
+};
+}
+
+vtkVertexCorrespondenceMapper::vtkVertexCorrespondenceMapper() : NumberOfMeshPoints(0), Orientation(1)
+{
+}
+
+bool vtkVertexCorrespondenceMapper::Anchor(vtkPolyData* mesh, const vtkEigenArrayBridge::PointMatrixMap& points)
+{
+    NumberOfMeshPoints = 0;
+    Triangles.clear();
+    UnitNormal.clear();
+    Coordinates.resize(3, 0);
+    vtkTriangleBVH boundary;
+    if(mesh == NULL || !boundary.Build(mesh))
+    {
+        std::cerr << "Cannot anchor points to a mesh without triangles" << std::endl;
+        return false;
+    }
+
+    // first three vertices of every cell, read once so that the anchoring tasks share no cell list
+    vtkIdType nCells = mesh->GetNumberOfCells();
+    std::vector<vtkIdType> cellTriangles(3 * nCells, -1);
+    vtkSmartPointer<vtkIdList> cellPoints = vtkSmartPointer<vtkIdList>::New();
+    for(vtkIdType c = 0; c < nCells; ++c)
+    {
+        mesh->GetCellPoints(c, cellPoints);
+        if(cellPoints->GetNumberOfIds() >= 3)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                cellTriangles[3 * c + k] = cellPoints->GetId(k);
+            }
+        }
+    }
+
+    vtkIdType nPoints = points.rows();
+    std::vector<vtkIdType> triangles(3 * nPoints);
+    Eigen::MatrixXd coordinates(3, nPoints);
+    std::vector<char> unitNormal(nPoints);
+    AnchorFunctor functor(mesh, boundary, cellTriangles, points, triangles, coordinates, unitNormal);
+    vtkSMPTools::For(0, nPoints, functor);
+    for(vtkIdType i = 0; i < nPoints; ++i)
+    {
+        if(triangles[3 * i] < 0)
+        {
+            std::cerr << "Cannot anchor point " << i << " to a triangle" << std::endl;
+            return false;
+        }
+    }
+
+    NumberOfMeshPoints = mesh->GetNumberOfPoints();
+    Triangles.swap(triangles);
+    Coordinates.swap(coordinates);
+    UnitNormal.swap(unitNormal);
+    Orientation = boundary.GetOrientation();
+    return true;
+}
+
+bool vtkVertexCorrespondenceMapper::Rebuild(vtkPolyData* mesh, vtkEigenArrayBridge::PointMatrixMap points) const
+{
+    vtkIdType nPoints = static_cast<vtkIdType>(UnitNormal.size());
+    if(NumberOfMeshPoints == 0 || mesh == NULL || mesh->GetNumberOfPoints() != NumberOfMeshPoints || points.rows() != nPoints)
+    {
+        std::cerr << "Anchored points can only be rebuilt on a mesh with the vertices of the anchor mesh" << std::endl;
+        return false;
+    }
+    RebuildFunctor functor(mesh, Triangles, Coordinates, UnitNormal, Orientation, points);
+    vtkSMPTools::For(0, nPoints, functor);
+    return true;
+}
+
+bool vtkVertexCorrespondenceMapper::MapPoints(vtkPolyData* from, vtkPolyData* to, vtkEigenArrayBridge::PointMatrixMap points)
+{
+    if(from == NULL || to == NULL || from->GetNumberOfPoints() != to->GetNumberOfPoints())
+    {
+        std::cerr << "Vertex correspondence needs two meshes with the same vertices and triangles" << std::endl;
+        return false;
+    }
+    vtkVertexCorrespondenceMapper mapper;
+    return mapper.Anchor(from, points) && mapper.Rebuild(to, points);
+}
@@ -0,0 +1,48 @@
+// This class provides mapping of points between meshes with the same connectivity
+// The forward flow moves the vertices of the input mesh without changing its topology,
+// so vertex i of every snapshot is vertex i of the input mesh. A point is anchored once to its
+// closest triangle T = (v0, v1, v2) of one snapshot by its coordinates (a, b, c) in the frame
+//     p = v0 + a (v1 - v0) + b (v2 - v0) + c n,  n = (v1 - v0) x (v2 - v0) / sqrt(|(v1 - v0) x (v2 - v0)|)
+// (a, b are the barycentric coordinates of the projection of p, c its signed offset, scaled with
+// the triangle) and rebuilt from the same triangle of any other snapshot. No TPS is solved.
+// On a degenerate triangle the frame has no normal: the point is anchored to its closest point
+// on the triangle and its signed distance along the outward unit normal instead.
+#ifndef __vtkVertexCorrespondenceMapper_h
+#define __vtkVertexCorrespondenceMapper_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleLogicExport.h"
+#include "vtkEigenArrayBridge.h"
+
+// STD includes
+#include <vector>
+
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_LOGIC_EXPORT vtkVertexCorrespondenceMapper {
+public:
+    vtkVertexCorrespondenceMapper();
+
+    // anchor every row (x, y, z) of points to its closest triangle of the mesh
+    // return false if the mesh has no triangle
+    bool Anchor(vtkPolyData* mesh, const vtkEigenArrayBridge::PointMatrixMap& points);
+
+    // write the anchored points rebuilt from the same triangles of the mesh into points
+    // return false if nothing is anchored, the mesh does not have the vertices of the anchor mesh
+    // or points does not have one row per anchored point
+    bool Rebuild(vtkPolyData* mesh, vtkEigenArrayBridge::PointMatrixMap points) const;
+
+    // carry every row (x, y, z) from the triangle mesh "from" to the mesh "to" in place
+    // return false if the meshes do not have the same number of points or "from" has no triangle
+    static bool MapPoints(vtkPolyData* from, vtkPolyData* to, vtkEigenArrayBridge::PointMatrixMap points);
+
+private:
+    vtkIdType NumberOfMeshPoints;
+    // 3 vertex ids per anchored point
+    std::vector<vtkIdType> Triangles;
+    // (a, b, c) of every anchored point, one column per point
+    Eigen::MatrixXd Coordinates;
+    // 1 if c is a distance along the outward unit normal (degenerate anchor triangle)
+    std::vector<char> UnitNormal;
+    // +1 if the triangles of the anchor mesh turn counterclockwise seen from outside, -1 otherwise
+    double Orientation;
+};
+#endif
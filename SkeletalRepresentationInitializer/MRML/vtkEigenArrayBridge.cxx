@@ -0,0 +1,86 @@
+// This class provides zero-copy views between Eigen matrices and VTK arrays
+#include "vtkEigenArrayBridge.h"
+
+#include <vtkDoubleArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+vtkEigenArrayBridge::TupleMatrixMap vtkEigenArrayBridge::MapArray(vtkAOSDataArrayTemplate<double>* array)
+{
+    if(array == NULL || array->GetNumberOfTuples() == 0)
+    {
+        return TupleMatrixMap(NULL, 0, array == NULL ? 1 : array->GetNumberOfComponents());
+    }
+    return TupleMatrixMap(array->GetPointer(0), array->GetNumberOfTuples(), array->GetNumberOfComponents());
+}
+
+vtkEigenArrayBridge::PointMatrixMap vtkEigenArrayBridge::MapPoints(vtkPoints* points)
+{
+    if(points == NULL || points->GetNumberOfPoints() == 0 || points->GetDataType() != VTK_DOUBLE)
+    {
+        return PointMatrixMap(NULL, 0, 3);
+    }
+    vtkAOSDataArrayTemplate<double>* coords = vtkAOSDataArrayTemplate<double>::FastDownCast(points->GetData());
+    if(coords == NULL)
+    {
+        // double points not stored as array of structures
+        return PointMatrixMap(NULL, 0, 3);
+    }
+    return PointMatrixMap(coords->GetPointer(0), points->GetNumberOfPoints(), 3);
+}
+
+vtkEigenArrayBridge::ConstPointMatrixMap vtkEigenArrayBridge::ReadPoints(vtkPoints* points, PointMatrixType& buffer)
+{
+    if(points == NULL || points->GetNumberOfPoints() == 0)
+    {
+        return ConstPointMatrixMap(NULL, 0, 3);
+    }
+    PointMatrixMap view = MapPoints(points);
+    if(view.rows() == points->GetNumberOfPoints())
+    {
+        return ConstPointMatrixMap(view.data(), view.rows(), 3);
+    }
+    buffer.resize(points->GetNumberOfPoints(), 3);
+    for(vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+        points->GetPoint(i, buffer.row(i).data());
+    }
+    return ConstPointMatrixMap(buffer.data(), buffer.rows(), 3);
+}
+
+vtkEigenArrayBridge::PointMatrixMap vtkEigenArrayBridge::AllocatePoints(vtkPolyData* poly, vtkIdType nPoints)
+{
+    vtkSmartPointer<vtkDoubleArray> coords = vtkSmartPointer<vtkDoubleArray>::New();
+    coords->SetNumberOfComponents(3);
+    coords->SetNumberOfTuples(nPoints);
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(coords);
+    poly->SetPoints(points);
+    return PointMatrixMap(coords->GetPointer(0), nPoints, 3);
+}
+
+vtkSmartPointer<vtkDoubleArray> vtkEigenArrayBridge::WrapMatrix(TupleMatrixType& matrix)
+{
+    vtkSmartPointer<vtkDoubleArray> array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetNumberOfComponents(matrix.cols());
+    // save = 1: VTK does not free memory owned by Eigen
+    array->SetArray(matrix.data(), matrix.size(), 1);
+    return array;
+}
+
+vtkSmartPointer<vtkDoubleArray> vtkEigenArrayBridge::WrapMatrix(PointMatrixType& matrix)
+{
+    vtkSmartPointer<vtkDoubleArray> array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetNumberOfComponents(3);
+    array->SetArray(matrix.data(), matrix.size(), 1);
+    return array;
+}
+
+void vtkEigenArrayBridge::TransformInPlace(PointMatrixMap points, const Eigen::Matrix3d& rotation, const Eigen::Vector3d& translation)
+{
+    for(Eigen::Index i = 0; i < points.rows(); ++i)
+    {
+        Eigen::Vector3d p = points.row(i).transpose();
+        points.row(i) = (rotation * p + translation).transpose();
+    }
+}
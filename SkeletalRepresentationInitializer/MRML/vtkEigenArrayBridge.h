@@ -0,0 +1,51 @@
+// This class provides zero-copy views between Eigen matrices and VTK arrays
+// Point coordinates are viewed as n x 3 row-major matrices sharing the
+// memory of the vtkAOSDataArrayTemplate<double> that stores them, so results
+// computed with Eigen land directly in vtkPoints and vice versa.
+// Points of another data type are never converted: they are read through a copy.
+#ifndef __vtkEigenArrayBridge_h
+#define __vtkEigenArrayBridge_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+// VTK includes
+#include <vtkAOSDataArrayTemplate.h>
+#include <vtkSmartPointer.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+
+class vtkDoubleArray;
+class vtkPoints;
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkEigenArrayBridge {
+public:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> PointMatrixType;
+    typedef Eigen::Map<PointMatrixType> PointMatrixMap;
+    typedef Eigen::Map<const PointMatrixType> ConstPointMatrixMap;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> TupleMatrixType;
+    typedef Eigen::Map<TupleMatrixType> TupleMatrixMap;
+
+    // view the tuples of a double array as a (number of tuples) x (number of components) matrix
+    static TupleMatrixMap MapArray(vtkAOSDataArrayTemplate<double>* array);
+
+    // view the coordinates of double precision points as an n x 3 matrix
+    // points of another data type are left as they are and give an empty view
+    static PointMatrixMap MapPoints(vtkPoints* points);
+
+    // read-only view of the coordinates of points of any data type: double precision points are
+    // viewed in place, the others are copied into buffer, which must outlive the view
+    static ConstPointMatrixMap ReadPoints(vtkPoints* points, PointMatrixType& buffer);
+
+    // allocate nPoints double precision points for the polydata and return their view
+    static PointMatrixMap AllocatePoints(vtkPolyData* poly, vtkIdType nPoints);
+
+    // expose an Eigen matrix as a VTK array without copy
+    // the matrix owns the memory: it must outlive the returned array and must not be resized
+    static vtkSmartPointer<vtkDoubleArray> WrapMatrix(TupleMatrixType& matrix);
+    static vtkSmartPointer<vtkDoubleArray> WrapMatrix(PointMatrixType& matrix);
+
+    // p <- rotation * p + translation for every row, without temporaries
+    static void TransformInPlace(PointMatrixMap points, const Eigen::Matrix3d& rotation, const Eigen::Vector3d& translation);
+};
+#endif
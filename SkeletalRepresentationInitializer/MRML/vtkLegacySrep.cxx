@@ -0,0 +1,422 @@
+// This class provides legacy s-reps (.m3d files) in flat arrays
+#include "vtkLegacySrep.h"
+#include "vtkMemoryMappedFile.h"
+#include "vtkSrepModel.h"
+#include "vtkEigenArrayBridge.h"
+
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkPointData.h>
+#include <vtkDoubleArray.h>
+#include <vtkCellArray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool KeyIs(const char* begin, const char* end, const char* literal)
+{
+    size_t n = strlen(literal);
+    return size_t(end - begin) == n && strncmp(begin, literal, n) == 0;
+}
+
+static inline bool KeyStartsWith(const char* begin, const char* end, const char* literal)
+{
+    size_t n = strlen(literal);
+    return size_t(end - begin) >= n && strncmp(begin, literal, n) == 0;
+}
+
+// the buffer is not null terminated, copy the token before converting it
+static double ParseNumber(const char* begin, const char* end)
+{
+    char token[64];
+    size_t n = std::min(size_t(end - begin), sizeof(token) - 1);
+    memcpy(token, begin, n);
+    token[n] = '\0';
+    return strtod(token, NULL);
+}
+
+vtkLegacySrep::vtkLegacySrep()
+    : numRows(0), numCols(0)
+{
+}
+
+void vtkLegacySrep::SetGridSize(int nRows, int nCols)
+{
+    numRows = nRows;
+    numCols = nCols;
+    int nAtoms = nRows * nCols;
+    hubs.assign(3 * nAtoms, 0.0);
+    directions.assign(9 * nAtoms, 0.0);
+    radii.assign(3 * nAtoms, 0.0);
+    crest.assign(nAtoms, 0);
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
+        {
+            crest[r * nCols + c] = (r == 0 || r == nRows - 1 || c == 0 || c == nCols - 1) ? 1 : 0;
+        }
+    }
+}
+
+bool vtkLegacySrep::ReadM3D(const std::string& fileName)
+{
+    vtkMemoryMappedFile file;
+    if(!file.Open(fileName))
+    {
+        std::cerr << "Cannot open legacy s-rep: " << fileName << std::endl;
+        return false;
+    }
+    if(!ParseM3D(file.GetData(), file.GetSize()))
+    {
+        std::cerr << "Cannot parse legacy s-rep: " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool vtkLegacySrep::ParseM3D(const char* buffer, size_t size)
+{
+    // kinds of the blocks on the way from the top level to the current block
+    enum {OtherBlock, ModelBlock, FigureBlock, PrimitiveBlock};
+    std::vector<int> blocks;
+    int declaredRows = 0, declaredCols = 0;
+    int atom = -1;
+    bool hasFigure = false;
+    numRows = numCols = 0;
+    hubs.clear(); directions.clear(); radii.clear(); crest.clear();
+
+    const char* p = buffer;
+    const char* end = buffer + size;
+    while(true)
+    {
+        while(p < end && IsSpace(*p)) ++p;
+        if(p >= end)
+        {
+            break;
+        }
+        if(*p == '}')
+        {
+            if(blocks.empty())
+            {
+                return false;
+            }
+            blocks.pop_back();
+            ++p;
+            continue;
+        }
+        if(*p == ';')
+        {
+            ++p;
+            continue;
+        }
+
+        const char* keyBegin = p;
+        while(p < end && !IsSpace(*p) && *p != '=' && *p != '{' && *p != '}' && *p != ';') ++p;
+        const char* keyEnd = p;
+        while(p < end && IsSpace(*p)) ++p;
+        if(p >= end)
+        {
+            return false;
+        }
+        int parent = blocks.empty() ? -1 : blocks.back();
+
+        if(*p == '{')
+        {
+            ++p;
+            int kind = OtherBlock;
+            if(parent == -1 && KeyIs(keyBegin, keyEnd, "model"))
+            {
+                kind = ModelBlock;
+            }
+            else if(parent == ModelBlock && KeyIs(keyBegin, keyEnd, "figure[0]"))
+            {
+                kind = FigureBlock;
+                hasFigure = true;
+            }
+            else if(parent == FigureBlock && KeyStartsWith(keyBegin, keyEnd, "primitive["))
+            {
+                if(numRows == 0)
+                {
+                    // the grid size comes before the primitives
+                    if(declaredRows <= 0 || declaredCols <= 0)
+                    {
+                        return false;
+                    }
+                    SetGridSize(declaredRows, declaredCols);
+                }
+                const char* index = keyBegin + strlen("primitive[");
+                char* next = NULL;
+                long r = strtol(index, &next, 10);
+                if(next >= keyEnd || next[0] != ']' || next + 1 >= keyEnd || next[1] != '[')
+                {
+                    return false;
+                }
+                long c = strtol(next + 2, NULL, 10);
+                if(r < 0 || r >= numRows || c < 0 || c >= numCols)
+                {
+                    return false;
+                }
+                atom = int(r * numCols + c);
+                kind = PrimitiveBlock;
+            }
+            blocks.push_back(kind);
+            continue;
+        }
+        if(*p != '=')
+        {
+            return false;
+        }
+        ++p;
+        while(p < end && IsSpace(*p)) ++p;
+        const char* valueBegin = p;
+        while(p < end && *p != ';') ++p;
+        const char* valueEnd = p;
+        while(valueEnd > valueBegin && IsSpace(valueEnd[-1])) --valueEnd;
+        if(p < end)
+        {
+            ++p;
+        }
+
+        if(parent == FigureBlock)
+        {
+            if(KeyIs(keyBegin, keyEnd, "numRows"))
+            {
+                declaredRows = int(ParseNumber(valueBegin, valueEnd));
+            }
+            else if(KeyIs(keyBegin, keyEnd, "numColumns"))
+            {
+                declaredCols = int(ParseNumber(valueBegin, valueEnd));
+            }
+        }
+        else if(parent == PrimitiveBlock)
+        {
+            size_t keyLength = keyEnd - keyBegin;
+            if(keyLength == 1 && keyBegin[0] >= 'x' && keyBegin[0] <= 'z')
+            {
+                hubs[3 * atom + (keyBegin[0] - 'x')] = ParseNumber(valueBegin, valueEnd);
+            }
+            else if(keyLength == 4 && keyBegin[0] == 'r' && keyBegin[1] == '[' && keyBegin[2] >= '0' && keyBegin[2] <= '2')
+            {
+                radii[3 * atom + (keyBegin[2] - '0')] = ParseNumber(valueBegin, valueEnd);
+            }
+            else if(keyLength == 5 && keyBegin[0] == 'u' && keyBegin[1] >= 'x' && keyBegin[1] <= 'z'
+                    && keyBegin[2] == '[' && keyBegin[3] >= '0' && keyBegin[3] <= '2')
+            {
+                directions[9 * atom + 3 * (keyBegin[3] - '0') + (keyBegin[1] - 'x')] = ParseNumber(valueBegin, valueEnd);
+            }
+            else if(KeyIs(keyBegin, keyEnd, "type"))
+            {
+                crest[atom] = KeyIs(valueBegin, valueEnd, "EndPrimitive") ? 1 : 0;
+            }
+        }
+    }
+    return blocks.empty() && hasFigure && numRows > 0;
+}
+
+bool vtkLegacySrep::WriteM3D(const std::string& fileName) const
+{
+    FILE* fout = fopen(fileName.c_str(), "wb");
+    if(fout == NULL)
+    {
+        std::cerr << "Write out failed, cannot open the file: " << fileName << std::endl;
+        return false;
+    }
+
+    // format the whole file in memory and write it at once
+    std::string out;
+    out.reserve(1024 + size_t(GetNumberOfAtoms()) * 640);
+    char line[256];
+    out += "pabloVersion = 9974 2009/07/24 19:36:23;\n"
+           "coordSystem {\n"
+           "    yDirection = 1;\n"
+           "}\n"
+           "model {\n"
+           "    figureCount = 1;\n"
+           "    name = default;\n"
+           "    figureTrees {\n"
+           "        count = 1;\n"
+           "        tree[0] {\n"
+           "            attachmentMode = 0;\n"
+           "            blendAmount = 0;\n"
+           "            blendExtent = 0;\n"
+           "            childCount = 0;\n"
+           "            figureId = 0;\n"
+           "            linkCount = 0;\n"
+           "        }\n"
+           "    }\n"
+           "    figure[0] {\n"
+           "        name = default;\n";
+    snprintf(line, sizeof(line), "        numColumns = %d;\n        numLandmarks = 0;\n        numRows = %d;\n", numCols, numRows);
+    out += line;
+    out += "        positivePolarity = 1;\n"
+           "        positiveSpace = 1;\n"
+           "        smoothness = 50;\n"
+           "        type = QuadFigure;\n"
+           "        color {\n"
+           "            blue = 0;\n"
+           "            green = 1;\n"
+           "            red = 0;\n"
+           "        }\n";
+
+    const char* axes = "xyz";
+    for(int r = 0; r < numRows; ++r)
+    {
+        for(int c = 0; c < numCols; ++c)
+        {
+            int atom = r * numCols + c;
+            int nSpokes = IsCrest(atom) ? 3 : 2;
+            snprintf(line, sizeof(line), "        primitive[%d][%d] {\n", r, c);
+            out += line;
+            for(int k = 0; k < nSpokes; ++k)
+            {
+                snprintf(line, sizeof(line), "            r[%d] = %.17g;\n", k, radii[3 * atom + k]);
+                out += line;
+            }
+            out += "            selected = 1;\n";
+            out += IsCrest(atom) ? "            type = EndPrimitive;\n" : "            type = StandardPrimitive;\n";
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                for(int k = 0; k < 3; ++k)
+                {
+                    // standard atoms have no crest spoke, the legacy tools expect (1, 0, 0)
+                    double value = k < nSpokes ? directions[9 * atom + 3 * k + axis] : (axis == 0 ? 1.0 : 0.0);
+                    snprintf(line, sizeof(line), "            u%c[%d] = %.17g;\n", axes[axis], k, value);
+                    out += line;
+                }
+            }
+            snprintf(line, sizeof(line), "            x = %.17g;\n            y = %.17g;\n            z = %.17g;\n",
+                     hubs[3 * atom], hubs[3 * atom + 1], hubs[3 * atom + 2]);
+            out += line;
+            out += "        }\n";
+        }
+    }
+    out += "    }\n}\n";
+
+    bool success = fwrite(out.data(), 1, out.size(), fout) == out.size();
+    success = (fclose(fout) == 0) && success;
+    if(!success)
+    {
+        std::cerr << "Write out failed: " << fileName << std::endl;
+    }
+    return success;
+}
+
+int vtkLegacySrep::GetCrestAtom(int i) const
+{
+    int r, c;
+    if(i < numCols - 1)                         { r = 0; c = i; }                                   // top row
+    else if(i < numCols + numRows - 2)          { r = i - (numCols - 1); c = numCols - 1; }         // right column
+    else if(i < 2 * numCols + numRows - 3)      { r = numRows - 1; c = 2 * numCols + numRows - 3 - i; } // bottom row
+    else                                        { r = GetNumberOfCrestAtoms() - i; c = 0; }         // left column
+    return r * numCols + c;
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkLegacySrep::ToSrepModel(double crestShift) const
+{
+    int nAtoms = GetNumberOfAtoms();
+    int nCrest = GetNumberOfCrestAtoms();
+
+    vtkSmartPointer<vtkPolyData> medial = vtkSmartPointer<vtkPolyData>::New();
+    vtkEigenArrayBridge::PointMatrixMap medialPts = vtkEigenArrayBridge::AllocatePoints(medial, nAtoms);
+    memcpy(medialPts.data(), GetHubs(), sizeof(double) * 3 * nAtoms);
+    vtkSmartPointer<vtkCellArray> quads = vtkSrepModel::NewQuadMesh(numRows, numCols);
+
+    vtkSmartPointer<vtkPolyData> spokes[3];
+    vtkSmartPointer<vtkDoubleArray> dirArrays[3];
+    vtkSmartPointer<vtkDoubleArray> lengthArrays[3];
+    vtkIdType nPoints[3] = {nAtoms, nAtoms, nCrest};
+    for(int k = 0; k < 3; ++k)
+    {
+        spokes[k] = vtkSmartPointer<vtkPolyData>::New();
+        dirArrays[k] = vtkSmartPointer<vtkDoubleArray>::New();
+        dirArrays[k]->SetName("spokeDirection");
+        dirArrays[k]->SetNumberOfComponents(3);
+        dirArrays[k]->SetNumberOfTuples(nPoints[k]);
+        lengthArrays[k] = vtkSmartPointer<vtkDoubleArray>::New();
+        lengthArrays[k]->SetName("spokeLength");
+        lengthArrays[k]->SetNumberOfComponents(1);
+        lengthArrays[k]->SetNumberOfTuples(nPoints[k]);
+    }
+
+    // up and down spokes share the skeletal points and the quad mesh
+    for(int k = 0; k < 2; ++k)
+    {
+        double* dir = dirArrays[k]->GetPointer(0);
+        double* length = lengthArrays[k]->GetPointer(0);
+        for(int atom = 0; atom < nAtoms; ++atom)
+        {
+            memcpy(dir + 3 * atom, &directions[9 * atom + 3 * k], sizeof(double) * 3);
+            length[atom] = radii[3 * atom + k];
+        }
+        spokes[k]->SetPoints(medial->GetPoints());
+        spokes[k]->SetPolys(quads);
+    }
+
+    // crest points go clockwise and are moved off the interior along the crest spoke
+    vtkEigenArrayBridge::PointMatrixMap crestPts = vtkEigenArrayBridge::AllocatePoints(spokes[CrestSpoke], nCrest);
+    double* dir = dirArrays[CrestSpoke]->GetPointer(0);
+    double* length = lengthArrays[CrestSpoke]->GetPointer(0);
+    for(int i = 0; i < nCrest; ++i)
+    {
+        int atom = GetCrestAtom(i);
+        const double* u = &directions[9 * atom + 3 * CrestSpoke];
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            crestPts(i, axis) = hubs[3 * atom + axis] + crestShift * u[axis];
+            dir[3 * i + axis] = u[axis];
+        }
+        length[i] = radii[3 * atom + CrestSpoke];
+    }
+    spokes[CrestSpoke]->SetLines(vtkSrepModel::NewClosedPolyLine(nCrest));
+
+    for(int k = 0; k < 3; ++k)
+    {
+        spokes[k]->GetPointData()->AddArray(dirArrays[k]);
+        spokes[k]->GetPointData()->SetActiveVectors("spokeDirection");
+        spokes[k]->GetPointData()->AddArray(lengthArrays[k]);
+        spokes[k]->GetPointData()->SetActiveScalars("spokeLength");
+    }
+    return vtkSrepModel::New(spokes[UpSpoke], spokes[DownSpoke], spokes[CrestSpoke], numRows, numCols);
+}
+
+bool vtkLegacySrep::FromSrepModel(vtkMultiBlockDataSet* srep)
+{
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        return false;
+    }
+    SetGridSize(vtkSrepModel::GetNumberOfRows(srep), vtkSrepModel::GetNumberOfColumns(srep));
+    vtkPolyData* blocks[3] = {vtkSrepModel::GetUpSpokes(srep), vtkSrepModel::GetDownSpokes(srep), vtkSrepModel::GetCrestSpokes(srep)};
+    if(blocks[UpSpoke]->GetNumberOfPoints() != GetNumberOfAtoms()
+            || blocks[DownSpoke]->GetNumberOfPoints() != GetNumberOfAtoms()
+            || blocks[CrestSpoke]->GetNumberOfPoints() != GetNumberOfCrestAtoms())
+    {
+        return false;
+    }
+
+    for(int k = 0; k < 3; ++k)
+    {
+        vtkDataArray* dir = blocks[k]->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* length = blocks[k]->GetPointData()->GetArray("spokeLength");
+        vtkIdType n = blocks[k]->GetNumberOfPoints();
+        for(vtkIdType i = 0; i < n; ++i)
+        {
+            int atom = (k == CrestSpoke) ? GetCrestAtom(int(i)) : int(i);
+            dir->GetTuple(i, &directions[9 * atom + 3 * k]);
+            radii[3 * atom + k] = length->GetTuple1(i);
+            if(k == UpSpoke)
+            {
+                blocks[k]->GetPoint(i, &hubs[3 * atom]);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+// This class provides legacy s-reps (.m3d files) in flat arrays
+// Only the first figure (a quad figure) of the model is kept, as in the python reader.
+// Atom (r, c) has index r * nCols + c; every atom has a hub and three spokes:
+// 0 up (top) spoke, 1 down (bottom) spoke, 2 crest spoke (meaningful on crest atoms only).
+#ifndef __vtkLegacySrep_h
+#define __vtkLegacySrep_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+
+class vtkMultiBlockDataSet;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkLegacySrep {
+public:
+    enum {UpSpoke = 0, DownSpoke = 1, CrestSpoke = 2};
+
+    vtkLegacySrep();
+    ~vtkLegacySrep(){}
+
+    // allocate (and reset) a grid of nRows x nCols atoms
+    void SetGridSize(int nRows, int nCols);
+    int GetNumberOfRows() const {return numRows;}
+    int GetNumberOfColumns() const {return numCols;}
+    int GetNumberOfAtoms() const {return numRows * numCols;}
+
+    // 3 values per atom
+    double* GetHubs() {return hubs.empty() ? NULL : &hubs[0];}
+    const double* GetHubs() const {return hubs.empty() ? NULL : &hubs[0];}
+    // 9 values per atom: direction (unit vector) of spoke 0, 1 and 2
+    double* GetSpokeDirections() {return directions.empty() ? NULL : &directions[0];}
+    const double* GetSpokeDirections() const {return directions.empty() ? NULL : &directions[0];}
+    // 3 values per atom: length of spoke 0, 1 and 2
+    double* GetSpokeRadii() {return radii.empty() ? NULL : &radii[0];}
+    const double* GetSpokeRadii() const {return radii.empty() ? NULL : &radii[0];}
+    // crest atoms are the EndPrimitive atoms, on the border of the grid
+    bool IsCrest(int atom) const {return crest[atom] != 0;}
+
+    // parse a legacy m3d file in a single pass over the memory mapped file
+    bool ReadM3D(const std::string& fileName);
+    // parse m3d content from a buffer (not necessarily null terminated)
+    bool ParseM3D(const char* buffer, size_t size);
+    // write a legacy m3d file
+    bool WriteM3D(const std::string& fileName) const;
+
+    // convert to the new s-rep format (see vtkSrepModel)
+    // crest points are moved off their atom along the crest spoke by crestShift
+    vtkSmartPointer<vtkMultiBlockDataSet> ToSrepModel(double crestShift) const;
+    // inverse of ToSrepModel, hubs of crest atoms are taken from the skeletal points
+    bool FromSrepModel(vtkMultiBlockDataSet* srep);
+
+    // atom index of the i-th crest point, clockwise from the top left corner
+    int GetCrestAtom(int i) const;
+    int GetNumberOfCrestAtoms() const {return 2 * numRows + 2 * numCols - 4;}
+
+private:
+    int numRows;
+    int numCols;
+    std::vector<double> hubs;
+    std::vector<double> directions;
+    std::vector<double> radii;
+    std::vector<char> crest;
+};
+#endif
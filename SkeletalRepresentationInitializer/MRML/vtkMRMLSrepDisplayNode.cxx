@@ -0,0 +1,83 @@
+// This class provides display properties of an s-rep
+#include "vtkMRMLSrepDisplayNode.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <sstream>
+
+//----------------------------------------------------------------------------
+vtkMRMLNodeNewMacro(vtkMRMLSrepDisplayNode);
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepDisplayNode::vtkMRMLSrepDisplayNode()
+{
+    // same colors as the s-reps shown by the initializer and the visualizer
+    this->UpSpokeColor[0] = 0; this->UpSpokeColor[1] = 1; this->UpSpokeColor[2] = 1;
+    this->DownSpokeColor[0] = 1; this->DownSpokeColor[1] = 0; this->DownSpokeColor[2] = 1;
+    this->CrestSpokeColor[0] = 1; this->CrestSpokeColor[1] = 0; this->CrestSpokeColor[2] = 0;
+    this->SkeletalSheetColor[0] = 0; this->SkeletalSheetColor[1] = 0; this->SkeletalSheetColor[2] = 0;
+    this->FoldCurveColor[0] = 1; this->FoldCurveColor[1] = 1; this->FoldCurveColor[2] = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepDisplayNode::~vtkMRMLSrepDisplayNode()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayNode::WriteXML(ostream& of, int nIndent)
+{
+    Superclass::WriteXML(of, nIndent);
+    vtkMRMLWriteXMLBeginMacro(of);
+    vtkMRMLWriteXMLVectorMacro(upSpokeColor, UpSpokeColor, double, 3);
+    vtkMRMLWriteXMLVectorMacro(downSpokeColor, DownSpokeColor, double, 3);
+    vtkMRMLWriteXMLVectorMacro(crestSpokeColor, CrestSpokeColor, double, 3);
+    vtkMRMLWriteXMLVectorMacro(skeletalSheetColor, SkeletalSheetColor, double, 3);
+    vtkMRMLWriteXMLVectorMacro(foldCurveColor, FoldCurveColor, double, 3);
+    vtkMRMLWriteXMLEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayNode::ReadXMLAttributes(const char** atts)
+{
+    int wasModifying = this->StartModify();
+    Superclass::ReadXMLAttributes(atts);
+    vtkMRMLReadXMLBeginMacro(atts);
+    vtkMRMLReadXMLVectorMacro(upSpokeColor, UpSpokeColor, double, 3);
+    vtkMRMLReadXMLVectorMacro(downSpokeColor, DownSpokeColor, double, 3);
+    vtkMRMLReadXMLVectorMacro(crestSpokeColor, CrestSpokeColor, double, 3);
+    vtkMRMLReadXMLVectorMacro(skeletalSheetColor, SkeletalSheetColor, double, 3);
+    vtkMRMLReadXMLVectorMacro(foldCurveColor, FoldCurveColor, double, 3);
+    vtkMRMLReadXMLEndMacro();
+    this->EndModify(wasModifying);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayNode::Copy(vtkMRMLNode* anode)
+{
+    int wasModifying = this->StartModify();
+    Superclass::Copy(anode);
+    vtkMRMLCopyBeginMacro(anode);
+    vtkMRMLCopyVectorMacro(UpSpokeColor, double, 3);
+    vtkMRMLCopyVectorMacro(DownSpokeColor, double, 3);
+    vtkMRMLCopyVectorMacro(CrestSpokeColor, double, 3);
+    vtkMRMLCopyVectorMacro(SkeletalSheetColor, double, 3);
+    vtkMRMLCopyVectorMacro(FoldCurveColor, double, 3);
+    vtkMRMLCopyEndMacro();
+    this->EndModify(wasModifying);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+    Superclass::PrintSelf(os, indent);
+    vtkMRMLPrintBeginMacro(os, indent);
+    vtkMRMLPrintVectorMacro(UpSpokeColor, double, 3);
+    vtkMRMLPrintVectorMacro(DownSpokeColor, double, 3);
+    vtkMRMLPrintVectorMacro(CrestSpokeColor, double, 3);
+    vtkMRMLPrintVectorMacro(SkeletalSheetColor, double, 3);
+    vtkMRMLPrintVectorMacro(FoldCurveColor, double, 3);
+    vtkMRMLPrintEndMacro();
+}
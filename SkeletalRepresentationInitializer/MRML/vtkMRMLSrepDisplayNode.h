@@ -0,0 +1,50 @@
+// This class provides display properties of an s-rep
+// Every part of the s-rep has its own color; visibility, opacity and line
+// width of the display node apply to the whole s-rep.
+#ifndef __vtkMRMLSrepDisplayNode_h
+#define __vtkMRMLSrepDisplayNode_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+// MRML includes
+#include <vtkMRMLDisplayNode.h>
+
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkMRMLSrepDisplayNode : public vtkMRMLDisplayNode
+{
+public:
+    static vtkMRMLSrepDisplayNode* New();
+    vtkTypeMacro(vtkMRMLSrepDisplayNode, vtkMRMLDisplayNode);
+    void PrintSelf(ostream& os, vtkIndent indent);
+
+    virtual vtkMRMLNode* CreateNodeInstance();
+    virtual const char* GetNodeTagName() {return "SrepDisplay";}
+    virtual void ReadXMLAttributes(const char** atts);
+    virtual void WriteXML(ostream& of, int indent);
+    virtual void Copy(vtkMRMLNode* node);
+
+    vtkSetVector3Macro(UpSpokeColor, double);
+    vtkGetVector3Macro(UpSpokeColor, double);
+    vtkSetVector3Macro(DownSpokeColor, double);
+    vtkGetVector3Macro(DownSpokeColor, double);
+    vtkSetVector3Macro(CrestSpokeColor, double);
+    vtkGetVector3Macro(CrestSpokeColor, double);
+    vtkSetVector3Macro(SkeletalSheetColor, double);
+    vtkGetVector3Macro(SkeletalSheetColor, double);
+    vtkSetVector3Macro(FoldCurveColor, double);
+    vtkGetVector3Macro(FoldCurveColor, double);
+
+protected:
+    vtkMRMLSrepDisplayNode();
+    virtual ~vtkMRMLSrepDisplayNode();
+
+    double UpSpokeColor[3];
+    double DownSpokeColor[3];
+    double CrestSpokeColor[3];
+    double SkeletalSheetColor[3];
+    double FoldCurveColor[3];
+
+private:
+    vtkMRMLSrepDisplayNode(const vtkMRMLSrepDisplayNode&); // Not implemented
+    void operator=(const vtkMRMLSrepDisplayNode&); // Not implemented
+};
+#endif
@@ -0,0 +1,152 @@
+// This class provides the MRML node of an s-rep
+#include "vtkMRMLSrepNode.h"
+#include "vtkMRMLSrepDisplayNode.h"
+#include "vtkMRMLSrepStorageNode.h"
+#include "vtkSrepModel.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMultiBlockDataSet.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <vtkMath.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkMRMLNodeNewMacro(vtkMRMLSrepNode);
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepNode::vtkMRMLSrepNode()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepNode::~vtkMRMLSrepNode()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Rows: " << vtkSrepModel::GetNumberOfRows(this->Srep) << "\n";
+    os << indent << "Columns: " << vtkSrepModel::GetNumberOfColumns(this->Srep) << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepNode::Copy(vtkMRMLNode* anode)
+{
+    int wasModifying = this->StartModify();
+    Superclass::Copy(anode);
+    vtkMRMLSrepNode* node = vtkMRMLSrepNode::SafeDownCast(anode);
+    if(node != NULL && node->GetSrep() != NULL)
+    {
+        vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSmartPointer<vtkMultiBlockDataSet>::New();
+        srep->DeepCopy(node->GetSrep());
+        this->SetSrep(srep);
+    }
+    else
+    {
+        this->SetSrep(NULL);
+    }
+    this->EndModify(wasModifying);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepNode::SetSrep(vtkMultiBlockDataSet* srep)
+{
+    if(this->Srep == srep)
+    {
+        return;
+    }
+    this->Srep = srep;
+    this->StorableModifiedTime.Modified();
+    this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMultiBlockDataSet* vtkMRMLSrepNode::GetSrep()
+{
+    return this->Srep;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepDisplayNode* vtkMRMLSrepNode::GetSrepDisplayNode()
+{
+    return vtkMRMLSrepDisplayNode::SafeDownCast(this->GetDisplayNode());
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLStorageNode* vtkMRMLSrepNode::CreateDefaultStorageNode()
+{
+    return vtkMRMLSrepStorageNode::New();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepNode::CreateDefaultDisplayNodes()
+{
+    if(this->GetSrepDisplayNode() != NULL)
+    {
+        return;
+    }
+    if(this->GetScene() == NULL)
+    {
+        vtkErrorMacro("vtkMRMLSrepNode::CreateDefaultDisplayNodes failed: scene is invalid");
+        return;
+    }
+    vtkMRMLSrepDisplayNode* displayNode = vtkMRMLSrepDisplayNode::SafeDownCast(
+                this->GetScene()->AddNewNodeByClass("vtkMRMLSrepDisplayNode"));
+    if(displayNode == NULL)
+    {
+        vtkErrorMacro("vtkMRMLSrepNode::CreateDefaultDisplayNodes failed: cannot add an s-rep display node, is vtkMRMLSrepDisplayNode registered?");
+        return;
+    }
+    this->SetAndObserveDisplayNodeID(displayNode->GetID());
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepNode::GetRASBounds(double bounds[6])
+{
+    vtkMath::UninitializeBounds(bounds);
+    if(!vtkSrepModel::IsValid(this->Srep))
+    {
+        return;
+    }
+    bool first = true;
+    vtkPolyData* blocks[3] = {vtkSrepModel::GetUpSpokes(this->Srep), vtkSrepModel::GetDownSpokes(this->Srep),
+                              vtkSrepModel::GetCrestSpokes(this->Srep)};
+    for(int k = 0; k < 3; ++k)
+    {
+        vtkDataArray* directions = blocks[k]->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengths = blocks[k]->GetPointData()->GetArray("spokeLength");
+        for(vtkIdType i = 0; i < blocks[k]->GetNumberOfPoints(); ++i)
+        {
+            double hub[3], dir[3];
+            blocks[k]->GetPoint(i, hub);
+            directions->GetTuple(i, dir);
+            double length = lengths->GetTuple1(i);
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                double tip = hub[axis] + length * dir[axis];
+                double low = std::min(hub[axis], tip);
+                double high = std::max(hub[axis], tip);
+                bounds[2 * axis] = first ? low : std::min(bounds[2 * axis], low);
+                bounds[2 * axis + 1] = first ? high : std::max(bounds[2 * axis + 1], high);
+            }
+            first = false;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepNode::GetBounds(double bounds[6])
+{
+    // s-reps are not transformable, local and world coordinates are the same
+    this->GetRASBounds(bounds);
+}
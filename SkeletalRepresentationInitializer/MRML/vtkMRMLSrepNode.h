@@ -0,0 +1,53 @@
+// This class provides the MRML node of an s-rep
+// The s-rep is kept in memory as an s-rep model (see vtkSrepModel), so modules
+// hand s-reps to each other through the scene. It is written to disk by
+// vtkMRMLSrepStorageNode only when the scene is saved.
+#ifndef __vtkMRMLSrepNode_h
+#define __vtkMRMLSrepNode_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+// MRML includes
+#include <vtkMRMLDisplayableNode.h>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+class vtkMultiBlockDataSet;
+class vtkMRMLSrepDisplayNode;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkMRMLSrepNode : public vtkMRMLDisplayableNode
+{
+public:
+    static vtkMRMLSrepNode* New();
+    vtkTypeMacro(vtkMRMLSrepNode, vtkMRMLDisplayableNode);
+    void PrintSelf(ostream& os, vtkIndent indent);
+
+    virtual vtkMRMLNode* CreateNodeInstance();
+    virtual const char* GetNodeTagName() {return "Srep";}
+    // copy the node attributes and a deep copy of the s-rep
+    virtual void Copy(vtkMRMLNode* node);
+
+    // the node keeps a reference to the s-rep, it is not copied
+    void SetSrep(vtkMultiBlockDataSet* srep);
+    vtkMultiBlockDataSet* GetSrep();
+
+    vtkMRMLSrepDisplayNode* GetSrepDisplayNode();
+
+    virtual vtkMRMLStorageNode* CreateDefaultStorageNode();
+    virtual void CreateDefaultDisplayNodes();
+
+    // bounds of all the skeletal points and spoke tips
+    virtual void GetRASBounds(double bounds[6]);
+    virtual void GetBounds(double bounds[6]);
+
+protected:
+    vtkMRMLSrepNode();
+    virtual ~vtkMRMLSrepNode();
+
+private:
+    vtkMRMLSrepNode(const vtkMRMLSrepNode&); // Not implemented
+    void operator=(const vtkMRMLSrepNode&); // Not implemented
+
+    vtkSmartPointer<vtkMultiBlockDataSet> Srep;
+};
+#endif
@@ -0,0 +1,103 @@
+// This class provides storage of s-rep nodes
+#include "vtkMRMLSrepStorageNode.h"
+#include "vtkMRMLSrepNode.h"
+#include "vtkSrepIO.h"
+#include "vtkLegacySrep.h"
+
+// VTK includes
+#include <vtkMultiBlockDataSet.h>
+#include <vtkObjectFactory.h>
+#include <vtkStringArray.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+//----------------------------------------------------------------------------
+vtkMRMLNodeNewMacro(vtkMRMLSrepStorageNode);
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepStorageNode::vtkMRMLSrepStorageNode()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepStorageNode::~vtkMRMLSrepStorageNode()
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSrepStorageNode::CanReadInReferenceNode(vtkMRMLNode* refNode)
+{
+    return refNode != NULL && refNode->IsA("vtkMRMLSrepNode");
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepStorageNode::InitializeSupportedReadFileTypes()
+{
+    this->SupportedReadFileTypes->InsertNextValue("S-rep (.srep.xml)");
+    this->SupportedReadFileTypes->InsertNextValue("S-rep (.xml)");
+    this->SupportedReadFileTypes->InsertNextValue("Legacy s-rep (.m3d)");
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepStorageNode::InitializeSupportedWriteFileTypes()
+{
+    this->SupportedWriteFileTypes->InsertNextValue("S-rep (.srep.xml)");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSrepStorageNode::ReadDataInternal(vtkMRMLNode* refNode)
+{
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(refNode);
+    std::string fullName = this->GetFullNameFromFileName();
+    if(srepNode == NULL || fullName.empty())
+    {
+        vtkErrorMacro("ReadDataInternal: no s-rep node or file name to read");
+        return 0;
+    }
+
+    vtkSmartPointer<vtkMultiBlockDataSet> srep;
+    std::string extension = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(fullName));
+    if(extension == ".m3d")
+    {
+        vtkLegacySrep legacySrep;
+        if(legacySrep.ReadM3D(fullName))
+        {
+            srep = legacySrep.ToSrepModel(0.0);
+        }
+    }
+    else
+    {
+        srep = vtkSrepIO::ReadSrep(fullName);
+    }
+    if(srep == NULL)
+    {
+        vtkErrorMacro("ReadDataInternal: cannot read the s-rep " << fullName);
+        return 0;
+    }
+    srepNode->SetSrep(srep);
+    return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSrepStorageNode::WriteDataInternal(vtkMRMLNode* refNode)
+{
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(refNode);
+    std::string fullName = this->GetFullNameFromFileName();
+    if(srepNode == NULL || fullName.empty())
+    {
+        vtkErrorMacro("WriteDataInternal: no s-rep node or file name to write");
+        return 0;
+    }
+    if(!vtkSrepIO::WriteSrep(srepNode->GetSrep(), fullName))
+    {
+        vtkErrorMacro("WriteDataInternal: cannot write the s-rep " << fullName);
+        return 0;
+    }
+    // the spoke files are part of the stored s-rep (e.g. when the scene is packed in a bundle)
+    this->ResetFileNameList();
+    this->AddFileName(vtkSrepIO::GetSpokeFileName(fullName, "up").c_str());
+    this->AddFileName(vtkSrepIO::GetSpokeFileName(fullName, "down").c_str());
+    this->AddFileName(vtkSrepIO::GetSpokeFileName(fullName, "crest").c_str());
+    return 1;
+}
@@ -0,0 +1,37 @@
+// This class provides storage of s-rep nodes
+// S-reps are written in the new s-rep format (header plus up, down and crest vtp files);
+// both the new format and legacy m3d files can be read.
+#ifndef __vtkMRMLSrepStorageNode_h
+#define __vtkMRMLSrepStorageNode_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+// MRML includes
+#include <vtkMRMLStorageNode.h>
+
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkMRMLSrepStorageNode : public vtkMRMLStorageNode
+{
+public:
+    static vtkMRMLSrepStorageNode* New();
+    vtkTypeMacro(vtkMRMLSrepStorageNode, vtkMRMLStorageNode);
+
+    virtual vtkMRMLNode* CreateNodeInstance();
+    virtual const char* GetNodeTagName() {return "SrepStorage";}
+
+    virtual bool CanReadInReferenceNode(vtkMRMLNode* refNode);
+    virtual const char* GetDefaultWriteFileExtension() {return "srep.xml";}
+
+protected:
+    vtkMRMLSrepStorageNode();
+    virtual ~vtkMRMLSrepStorageNode();
+
+    virtual void InitializeSupportedReadFileTypes();
+    virtual void InitializeSupportedWriteFileTypes();
+    virtual int ReadDataInternal(vtkMRMLNode* refNode);
+    virtual int WriteDataInternal(vtkMRMLNode* refNode);
+
+private:
+    vtkMRMLSrepStorageNode(const vtkMRMLSrepStorageNode&); // Not implemented
+    void operator=(const vtkMRMLSrepStorageNode&); // Not implemented
+};
+#endif
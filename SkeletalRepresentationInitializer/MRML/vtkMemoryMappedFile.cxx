@@ -0,0 +1,123 @@
+// This class provides read-only memory mapping of a whole file
+#include "vtkMemoryMappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+vtkMemoryMappedFile::vtkMemoryMappedFile()
+    : data(NULL), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL)
+{
+}
+#else
+vtkMemoryMappedFile::vtkMemoryMappedFile()
+    : data(NULL), size(0), fileDescriptor(-1)
+{
+}
+#endif
+
+vtkMemoryMappedFile::~vtkMemoryMappedFile()
+{
+    Close();
+}
+
+bool vtkMemoryMappedFile::Open(const std::string& fileName)
+{
+    Close();
+#ifdef _WIN32
+    fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        Close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    if(size == 0)
+    {
+        // nothing to map, but an empty file is still a valid file
+        return true;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle == NULL)
+    {
+        Close();
+        return false;
+    }
+    data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(data == NULL)
+    {
+        Close();
+        return false;
+    }
+#else
+    fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if(fileDescriptor < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0)
+    {
+        Close();
+        return false;
+    }
+    size = static_cast<size_t>(fileStat.st_size);
+    if(size == 0)
+    {
+        return true;
+    }
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if(mapped == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+#endif
+    return true;
+}
+
+void vtkMemoryMappedFile::Close()
+{
+#ifdef _WIN32
+    if(data != NULL)
+    {
+        UnmapViewOfFile(data);
+    }
+    if(mappingHandle != NULL)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if(fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(fileHandle);
+    }
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if(data != NULL)
+    {
+        munmap(const_cast<char*>(data), size);
+    }
+    if(fileDescriptor >= 0)
+    {
+        close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+#endif
+    data = NULL;
+    size = 0;
+}
@@ -0,0 +1,36 @@
+// This class provides read-only memory mapping of a whole file
+// The mapping is released when the object is destroyed.
+#ifndef __vtkMemoryMappedFile_h
+#define __vtkMemoryMappedFile_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+#include <cstddef>
+#include <string>
+
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkMemoryMappedFile {
+public:
+    vtkMemoryMappedFile();
+    ~vtkMemoryMappedFile();
+
+    // map the file, return false if it cannot be opened or mapped
+    bool Open(const std::string& fileName);
+    void Close();
+
+    const char* GetData() const {return data;}
+    size_t GetSize() const {return size;}
+
+private:
+    vtkMemoryMappedFile(const vtkMemoryMappedFile&); // Not implemented
+    void operator=(const vtkMemoryMappedFile&); // Not implemented
+
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
+#endif
@@ -0,0 +1,172 @@
+// This class provides file input/output of s-rep models in the new s-rep format
+#include "vtkSrepIO.h"
+#include "vtkSrepModel.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPolyData.h>
+#include <vtkXMLPolyDataWriter.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtkZLibDataCompressor.h>
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+bool vtkSrepIO::WriteSrep(vtkMultiBlockDataSet* srep, const std::string& headerFileName, vtkPolyData* statistics)
+{
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "Cannot write an incomplete s-rep to " << headerFileName << std::endl;
+        return false;
+    }
+    if(statistics != NULL && !WriteSpokes(statistics, GetSpokeFileName(headerFileName, "stat")))
+    {
+        return false;
+    }
+    return WriteHeader(headerFileName, vtkSrepModel::GetNumberOfRows(srep), vtkSrepModel::GetNumberOfColumns(srep), statistics != NULL)
+            && WriteSpokes(vtkSrepModel::GetUpSpokes(srep), GetSpokeFileName(headerFileName, "up"))
+            && WriteSpokes(vtkSrepModel::GetDownSpokes(srep), GetSpokeFileName(headerFileName, "down"))
+            && WriteSpokes(vtkSrepModel::GetCrestSpokes(srep), GetSpokeFileName(headerFileName, "crest"));
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkSrepIO::ReadSrep(const std::string& headerFileName)
+{
+    vtkSmartPointer<vtkXMLDataElement> root = vtkSmartPointer<vtkXMLDataElement>::Take(
+                vtkXMLUtilities::ReadElementFromFile(headerFileName.c_str()));
+    if(root == NULL)
+    {
+        std::cerr << "Cannot read the s-rep header: " << headerFileName << std::endl;
+        return NULL;
+    }
+    const char* tags[] = {"nRows", "nCols", "upSpoke", "downSpoke", "crestSpoke"};
+    std::string values[5];
+    for(int i = 0; i < 5; ++i)
+    {
+        vtkXMLDataElement* element = root->FindNestedElementWithName(tags[i]);
+        if(element == NULL || element->GetCharacterData() == NULL)
+        {
+            std::cerr << "The s-rep header " << headerFileName << " has no " << tags[i] << std::endl;
+            return NULL;
+        }
+        values[i] = element->GetCharacterData();
+    }
+
+    std::string directory = vtksys::SystemTools::GetFilenamePath(headerFileName);
+    if(directory.empty())
+    {
+        directory = ".";
+    }
+    vtkSmartPointer<vtkPolyData> up = ReadSpokes(directory, values[2]);
+    vtkSmartPointer<vtkPolyData> down = ReadSpokes(directory, values[3]);
+    vtkSmartPointer<vtkPolyData> crest = ReadSpokes(directory, values[4]);
+    if(up == NULL || down == NULL || crest == NULL)
+    {
+        return NULL;
+    }
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSrepModel::New(up, down, crest, atoi(values[0].c_str()), atoi(values[1].c_str()));
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        std::cerr << "Incomplete s-rep: " << headerFileName << std::endl;
+        return NULL;
+    }
+    return srep;
+}
+
+std::string vtkSrepIO::GetSpokeFileName(const std::string& headerFileName, const std::string& part)
+{
+    std::string directory = vtksys::SystemTools::GetFilenamePath(headerFileName);
+    if(directory.empty())
+    {
+        directory = ".";
+    }
+    std::string name = vtksys::SystemTools::GetFilenameWithoutExtension(headerFileName);
+    std::string prefix = (name == "header") ? "" : name + "_";
+    return directory + "/" + prefix + part + ".vtp";
+}
+
+bool vtkSrepIO::WriteHeader(const std::string& headerFileName, int nRows, int nCols, bool isMean)
+{
+    std::ofstream fout(headerFileName.c_str());
+    if(!fout)
+    {
+        std::cerr << "Write out failed, cannot open the file: " << headerFileName << std::endl;
+        return false;
+    }
+    // same layout as the header written by the legacy transformer; data files are relative to the header
+    std::string up = vtksys::SystemTools::GetFilenameName(GetSpokeFileName(headerFileName, "up"));
+    std::string down = vtksys::SystemTools::GetFilenameName(GetSpokeFileName(headerFileName, "down"));
+    std::string crest = vtksys::SystemTools::GetFilenameName(GetSpokeFileName(headerFileName, "crest"));
+    std::string meanStatPath = isMean ? "<meanStatPath>" + vtksys::SystemTools::GetFilenameName(GetSpokeFileName(headerFileName, "stat"))
+                                        + "</meanStatPath>" : "<meanStatPath/>";
+    fout << "<?xml version=\"1.0\" ?>\n"
+         << "<s-rep>\n"
+         << "  <nRows>" << nRows << "</nRows>\n"
+         << "  <nCols>" << nCols << "</nCols>\n"
+         << "  <meshType>Quad</meshType>\n"
+         << "  <color>\n"
+         << "    <red>0</red>\n"
+         << "    <green>0.5</green>\n"
+         << "    <blue>0</blue>\n"
+         << "  </color>\n"
+         << "  <isMean>" << (isMean ? "True" : "False") << "</isMean>\n"
+         << "  " << meanStatPath << "\n"
+         << "  <upSpoke>" << up << "</upSpoke>\n"
+         << "  <downSpoke>" << down << "</downSpoke>\n"
+         << "  <crestSpoke>" << crest << "</crestSpoke>\n"
+         << "</s-rep>\n";
+    fout.close();
+    return !fout.fail();
+}
+
+bool vtkSrepIO::WriteSpokes(vtkPolyData* spokes, const std::string& fileName)
+{
+    vtkSmartPointer<vtkZLibDataCompressor> compressor = vtkSmartPointer<vtkZLibDataCompressor>::New();
+    vtkSmartPointer<vtkXMLPolyDataWriter> writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+    writer->SetInputData(spokes);
+    writer->SetFileName(fileName.c_str());
+    // raw (not base64 encoded) appended binary data, compressed block by block
+    writer->SetDataModeToAppended();
+    writer->EncodeAppendedDataOff();
+    writer->SetCompressor(compressor);
+    if(writer->Write() == 0)
+    {
+        std::cerr << "Write out failed, cannot write the file: " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+vtkSmartPointer<vtkPolyData> vtkSrepIO::ReadSpokes(const std::string& directory, const std::string& fileName)
+{
+    std::string path = fileName;
+    if(!vtksys::SystemTools::FileIsFullPath(fileName.c_str()))
+    {
+        // headers of the legacy transformer hold paths relative to the working directory of the conversion
+        path = directory + "/" + fileName;
+        if(!vtksys::SystemTools::FileExists(path.c_str(), true))
+        {
+            path = directory + "/" + vtksys::SystemTools::GetFilenameName(fileName);
+        }
+    }
+    if(!vtksys::SystemTools::FileExists(path.c_str(), true))
+    {
+        std::cerr << "Cannot find the spoke file: " << fileName << std::endl;
+        return NULL;
+    }
+    vtkSmartPointer<vtkXMLPolyDataReader> reader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->SetFileName(path.c_str());
+    reader->Update();
+    vtkSmartPointer<vtkPolyData> spokes = reader->GetOutput();
+    if(spokes == NULL || spokes->GetNumberOfPoints() == 0)
+    {
+        std::cerr << "Cannot read the spoke file: " << path << std::endl;
+        return NULL;
+    }
+    return spokes;
+}
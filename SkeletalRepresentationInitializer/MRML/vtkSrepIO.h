@@ -0,0 +1,38 @@
+// This class provides file input/output of s-rep models in the new s-rep format
+// The format is a header.xml that references up.vtp, down.vtp and crest.vtp.
+// The vtp files are written with raw binary appended, zlib compressed arrays.
+// A header named other than header.xml, e.g. hippo.srep.xml, gets its own
+// spoke files (hippo_up.vtp, ...) so that several s-reps can share a folder.
+// A mean s-rep also gets the statistics of its cohort (stat.vtp, see vtkSrepStatistics),
+// referenced by meanStatPath in the header.
+#ifndef __vtkSrepIO_h
+#define __vtkSrepIO_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+class vtkMultiBlockDataSet;
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkSrepIO {
+public:
+    // write the header and the three vtp files next to it
+    // with statistics, the s-rep is written as a mean s-rep and the statistics as its "stat" file
+    // return false if the s-rep is not valid or a file cannot be written
+    static bool WriteSrep(vtkMultiBlockDataSet* srep, const std::string& headerFileName, vtkPolyData* statistics = NULL);
+
+    // read an s-rep in the new format, return NULL if it cannot be read
+    // spoke files are looked up relative to the header first, then as given
+    static vtkSmartPointer<vtkMultiBlockDataSet> ReadSrep(const std::string& headerFileName);
+
+    // full path of the spoke file ("up", "down", "crest" or "stat") written next to the header
+    static std::string GetSpokeFileName(const std::string& headerFileName, const std::string& part);
+
+private:
+    static bool WriteHeader(const std::string& headerFileName, int nRows, int nCols, bool isMean);
+    static bool WriteSpokes(vtkPolyData* spokes, const std::string& fileName);
+    static vtkSmartPointer<vtkPolyData> ReadSpokes(const std::string& directory, const std::string& fileName);
+};
+#endif
@@ -0,0 +1,261 @@
+// This class provides helpers for s-reps held in memory
+#include "vtkSrepModel.h"
+#include "vtkEigenArrayBridge.h"
+
+#include <vtkMultiBlockDataSet.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkInformation.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkPointData.h>
+#include <vtkFieldData.h>
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkCellArray.h>
+#include <vtkPointLocator.h>
+
+// double precision view of an array, copied only when stored in another type
+static vtkSmartPointer<vtkDoubleArray> AsDoubleArray(vtkDataArray* array)
+{
+    vtkSmartPointer<vtkDoubleArray> doubles = vtkDoubleArray::FastDownCast(array);
+    if(doubles == NULL)
+    {
+        doubles = vtkSmartPointer<vtkDoubleArray>::New();
+        doubles->DeepCopy(array);
+    }
+    return doubles;
+}
+
+// n line segments (2i, 2i+1) in the legacy connectivity layout
+static vtkSmartPointer<vtkCellArray> NewSegments(vtkIdType n)
+{
+    vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+    if(n == 0)
+    {
+        return cells;
+    }
+    typedef Eigen::Matrix<vtkIdType, Eigen::Dynamic, 3, Eigen::RowMajor> SegmentMatrixType;
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(3 * n);
+    Eigen::Map<SegmentMatrixType> segments(connectivity->GetPointer(0), n, 3);
+    segments.col(0).setConstant(2);
+    segments.col(1) = 2 * Eigen::Matrix<vtkIdType, Eigen::Dynamic, 1>::LinSpaced(n, 0, n - 1);
+    segments.col(2) = segments.col(1).array() + 1;
+    cells->SetCells(n, connectivity);
+    return cells;
+}
+
+static void SetGridSize(vtkMultiBlockDataSet* srep, const char* name, int value)
+{
+    vtkSmartPointer<vtkIntArray> size = vtkSmartPointer<vtkIntArray>::New();
+    size->SetName(name);
+    size->InsertNextValue(value);
+    srep->GetFieldData()->AddArray(size);
+}
+
+static int GetGridSize(vtkMultiBlockDataSet* srep, const char* name)
+{
+    if(srep == NULL || srep->GetFieldData()->GetArray(name) == NULL)
+    {
+        return 0;
+    }
+    return static_cast<int>(srep->GetFieldData()->GetArray(name)->GetTuple1(0));
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkSrepModel::New(vtkPolyData* up, vtkPolyData* down, vtkPolyData* crest, int nRows, int nCols)
+{
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSmartPointer<vtkMultiBlockDataSet>::New();
+    srep->SetNumberOfBlocks(3);
+    srep->SetBlock(UpBlock, up);
+    srep->GetMetaData(static_cast<unsigned int>(UpBlock))->Set(vtkCompositeDataSet::NAME(), "up");
+    srep->SetBlock(DownBlock, down);
+    srep->GetMetaData(static_cast<unsigned int>(DownBlock))->Set(vtkCompositeDataSet::NAME(), "down");
+    srep->SetBlock(CrestBlock, crest);
+    srep->GetMetaData(static_cast<unsigned int>(CrestBlock))->Set(vtkCompositeDataSet::NAME(), "crest");
+    SetGridSize(srep, "nRows", nRows);
+    SetGridSize(srep, "nCols", nCols);
+    return srep;
+}
+
+vtkSmartPointer<vtkPolyData> vtkSrepModel::NewSpokes(vtkPoints* hubs, vtkPoints* tailHeadPairs)
+{
+    vtkIdType nSpokes = hubs->GetNumberOfPoints();
+    vtkSmartPointer<vtkDoubleArray> directions = vtkSmartPointer<vtkDoubleArray>::New();
+    directions->SetName("spokeDirection");
+    directions->SetNumberOfComponents(3);
+    directions->SetNumberOfTuples(nSpokes);
+    vtkSmartPointer<vtkDoubleArray> lengths = vtkSmartPointer<vtkDoubleArray>::New();
+    lengths->SetName("spokeLength");
+    lengths->SetNumberOfComponents(1);
+    lengths->SetNumberOfTuples(nSpokes);
+
+    vtkEigenArrayBridge::PointMatrixType hubBuffer, pairBuffer;
+    vtkEigenArrayBridge::ConstPointMatrixMap hub = vtkEigenArrayBridge::ReadPoints(hubs, hubBuffer);
+    vtkEigenArrayBridge::ConstPointMatrixMap pairs = vtkEigenArrayBridge::ReadPoints(tailHeadPairs, pairBuffer);
+    vtkEigenArrayBridge::TupleMatrixMap dir = vtkEigenArrayBridge::MapArray(directions);
+    double* length = lengths->GetPointer(0);
+    for(vtkIdType i = 0; i < nSpokes; ++i)
+    {
+        Eigen::RowVector3d spoke = pairs.row(2 * i + 1) - hub.row(i);
+        length[i] = spoke.norm();
+        if(length[i] > 0)
+        {
+            spoke /= length[i];
+        }
+        dir.row(i) = spoke;
+    }
+
+    vtkSmartPointer<vtkPolyData> spokes = vtkSmartPointer<vtkPolyData>::New();
+    spokes->SetPoints(hubs);
+    spokes->GetPointData()->AddArray(directions);
+    spokes->GetPointData()->SetActiveVectors("spokeDirection");
+    spokes->GetPointData()->AddArray(lengths);
+    spokes->GetPointData()->SetActiveScalars("spokeLength");
+    return spokes;
+}
+
+vtkSmartPointer<vtkPolyData> vtkSrepModel::NewSpokeLines(vtkPolyData* spokes)
+{
+    vtkIdType nSpokes = spokes->GetNumberOfPoints();
+    vtkSmartPointer<vtkPolyData> lines = vtkSmartPointer<vtkPolyData>::New();
+    vtkEigenArrayBridge::PointMatrixMap pts = vtkEigenArrayBridge::AllocatePoints(lines, 2 * nSpokes);
+    lines->SetLines(NewSegments(nSpokes));
+    if(nSpokes == 0)
+    {
+        return lines;
+    }
+
+    vtkSmartPointer<vtkDoubleArray> hubs = AsDoubleArray(spokes->GetPoints()->GetData());
+    vtkSmartPointer<vtkDoubleArray> directions = AsDoubleArray(spokes->GetPointData()->GetArray("spokeDirection"));
+    vtkSmartPointer<vtkDoubleArray> lengths = AsDoubleArray(spokes->GetPointData()->GetArray("spokeLength"));
+
+    // points 2i and 2i+1 are the hub and the tip of spoke i: both are strided views of the same rows
+    typedef Eigen::Map<vtkEigenArrayBridge::PointMatrixType, Eigen::Unaligned, Eigen::OuterStride<> > StridedPointMap;
+    StridedPointMap hubRows(pts.data(), nSpokes, 3, Eigen::OuterStride<>(6));
+    StridedPointMap tipRows(pts.data() + 3, nSpokes, 3, Eigen::OuterStride<>(6));
+    hubRows = vtkEigenArrayBridge::MapArray(hubs);
+    tipRows = hubRows.array() + vtkEigenArrayBridge::MapArray(directions).array().colwise()
+            * vtkEigenArrayBridge::MapArray(lengths).col(0).array();
+    return lines;
+}
+
+vtkSmartPointer<vtkPolyData> vtkSrepModel::NewFoldConnections(vtkMultiBlockDataSet* srep)
+{
+    vtkPolyData* sheet = GetUpSpokes(srep);
+    vtkPolyData* fold = GetCrestSpokes(srep);
+    vtkIdType nFoldPoints = sheet->GetNumberOfPoints() > 0 ? fold->GetNumberOfPoints() : 0;
+
+    // points 2i and 2i+1 are the fold point i and its closest skeletal point
+    vtkSmartPointer<vtkPolyData> connections = vtkSmartPointer<vtkPolyData>::New();
+    vtkEigenArrayBridge::PointMatrixMap pts = vtkEigenArrayBridge::AllocatePoints(connections, 2 * nFoldPoints);
+    connections->SetLines(NewSegments(nFoldPoints));
+    if(nFoldPoints == 0)
+    {
+        return connections;
+    }
+
+    vtkSmartPointer<vtkPointLocator> locator = vtkSmartPointer<vtkPointLocator>::New();
+    locator->SetDataSet(sheet);
+    locator->BuildLocator();
+    for(vtkIdType i = 0; i < nFoldPoints; ++i)
+    {
+        double foldPoint[3], skeletalPoint[3];
+        fold->GetPoint(i, foldPoint);
+        sheet->GetPoint(locator->FindClosestPoint(foldPoint), skeletalPoint);
+        pts.row(2 * i) = Eigen::Map<Eigen::RowVector3d>(foldPoint);
+        pts.row(2 * i + 1) = Eigen::Map<Eigen::RowVector3d>(skeletalPoint);
+    }
+    return connections;
+}
+
+vtkSmartPointer<vtkCellArray> vtkSrepModel::NewQuadMesh(int nRows, int nCols)
+{
+    // connectivity in the legacy layout (n, id0, id1, ...) is accepted by every vtk version
+    vtkIdType nQuads = vtkIdType(nRows - 1) * (nCols - 1);
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(5 * nQuads);
+    vtkIdType* quad = connectivity->GetPointer(0);
+    for(int r = 0; r < nRows - 1; ++r)
+    {
+        for(int c = 0; c < nCols - 1; ++c, quad += 5)
+        {
+            vtkIdType id = vtkIdType(r) * nCols + c;
+            quad[0] = 4; quad[1] = id; quad[2] = id + nCols; quad[3] = id + nCols + 1; quad[4] = id + 1;
+        }
+    }
+    vtkSmartPointer<vtkCellArray> quads = vtkSmartPointer<vtkCellArray>::New();
+    quads->SetCells(nQuads, connectivity);
+    return quads;
+}
+
+vtkSmartPointer<vtkCellArray> vtkSrepModel::NewClosedPolyLine(vtkIdType n)
+{
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(n + 2);
+    vtkIdType* loop = connectivity->GetPointer(0);
+    loop[0] = n + 1;
+    for(vtkIdType i = 0; i <= n; ++i)
+    {
+        loop[i + 1] = i % n;
+    }
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(1, connectivity);
+    return lines;
+}
+
+bool vtkSrepModel::IsValid(vtkMultiBlockDataSet* srep)
+{
+    if(srep == NULL || srep->GetNumberOfBlocks() < 3
+            || GetNumberOfRows(srep) <= 0 || GetNumberOfColumns(srep) <= 0)
+    {
+        return false;
+    }
+    for(unsigned int i = 0; i < 3; ++i)
+    {
+        vtkPolyData* spokes = vtkPolyData::SafeDownCast(srep->GetBlock(i));
+        if(spokes == NULL || spokes->GetPoints() == NULL
+                || spokes->GetPointData()->GetArray("spokeDirection") == NULL
+                || spokes->GetPointData()->GetArray("spokeLength") == NULL)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+vtkPolyData* vtkSrepModel::GetUpSpokes(vtkMultiBlockDataSet* srep)
+{
+    return srep == NULL ? NULL : vtkPolyData::SafeDownCast(srep->GetBlock(UpBlock));
+}
+
+vtkPolyData* vtkSrepModel::GetDownSpokes(vtkMultiBlockDataSet* srep)
+{
+    return srep == NULL ? NULL : vtkPolyData::SafeDownCast(srep->GetBlock(DownBlock));
+}
+
+vtkPolyData* vtkSrepModel::GetCrestSpokes(vtkMultiBlockDataSet* srep)
+{
+    return srep == NULL ? NULL : vtkPolyData::SafeDownCast(srep->GetBlock(CrestBlock));
+}
+
+int vtkSrepModel::GetNumberOfRows(vtkMultiBlockDataSet* srep)
+{
+    return GetGridSize(srep, "nRows");
+}
+
+int vtkSrepModel::GetNumberOfColumns(vtkMultiBlockDataSet* srep)
+{
+    return GetGridSize(srep, "nCols");
+}
+
+vtkIdType vtkSrepModel::GetCrestSkeletalPoint(vtkIdType i, int nRows, int nCols)
+{
+    vtkIdType nCrestPoints = 2 * vtkIdType(nRows) + 2 * (nCols - 2);
+    vtkIdType r, c;
+    if(i < nCols - 1)                    { r = 0; c = i; }                                      // top row
+    else if(i < nCols + nRows - 2)       { r = i - (nCols - 1); c = nCols - 1; }                // right column
+    else if(i < 2 * nCols + nRows - 3)   { r = nRows - 1; c = 2 * nCols + nRows - 3 - i; }      // bottom row
+    else                                 { r = nCrestPoints - i; c = 0; }                       // left column
+    return r * nCols + c;
+}
@@ -0,0 +1,53 @@
+// This class provides helpers for s-reps held in memory
+// An s-rep model is a vtkMultiBlockDataSet with the three parts of the new s-rep format:
+//   block "up" and "down": skeletal points (quad mesh) carrying the up and down spokes
+//   block "crest": fold curve points (closed poly line) carrying the crest spokes
+// Spokes are point data of each block: "spokeDirection" (unit vector) and "spokeLength".
+// The size of the skeletal grid is stored in the field data as "nRows" and "nCols".
+#ifndef __vtkSrepModel_h
+#define __vtkSrepModel_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+class vtkMultiBlockDataSet;
+class vtkPolyData;
+class vtkPoints;
+class vtkCellArray;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkSrepModel {
+public:
+    enum {UpBlock = 0, DownBlock = 1, CrestBlock = 2};
+
+    // assemble an s-rep model from the three spoke polydata
+    static vtkSmartPointer<vtkMultiBlockDataSet> New(vtkPolyData* up, vtkPolyData* down, vtkPolyData* crest, int nRows, int nCols);
+
+    // spoke polydata on the hub points; spoke i goes from hub i to point 2i+1 of tailHeadPairs
+    // (the (tail, head) layout of the displayed spoke lines). Cells are left to the caller.
+    static vtkSmartPointer<vtkPolyData> NewSpokes(vtkPoints* hubs, vtkPoints* tailHeadPairs);
+
+    // line segments from every hub to the tip of its spoke, for display
+    static vtkSmartPointer<vtkPolyData> NewSpokeLines(vtkPolyData* spokes);
+    // line segments from every fold curve point to the closest point of the skeletal sheet, for display
+    static vtkSmartPointer<vtkPolyData> NewFoldConnections(vtkMultiBlockDataSet* srep);
+
+    // quads of a nRows x nCols grid of skeletal points, point (r, c) has index r * nCols + c
+    static vtkSmartPointer<vtkCellArray> NewQuadMesh(int nRows, int nCols);
+    // one poly line through points 0 .. n-1 and back to 0
+    static vtkSmartPointer<vtkCellArray> NewClosedPolyLine(vtkIdType n);
+
+    // return false if the model misses a block, a spoke array or the grid size
+    static bool IsValid(vtkMultiBlockDataSet* srep);
+
+    static vtkPolyData* GetUpSpokes(vtkMultiBlockDataSet* srep);
+    static vtkPolyData* GetDownSpokes(vtkMultiBlockDataSet* srep);
+    static vtkPolyData* GetCrestSpokes(vtkMultiBlockDataSet* srep);
+    static int GetNumberOfRows(vtkMultiBlockDataSet* srep);
+    static int GetNumberOfColumns(vtkMultiBlockDataSet* srep);
+
+    // index r * nCols + c of the skeletal point of crest spoke i: the fold curve follows the boundary
+    // of the skeletal grid clockwise from (0, 0), along the top row, right column, bottom row and left column
+    static vtkIdType GetCrestSkeletalPoint(vtkIdType i, int nRows, int nCols);
+};
+#endif
@@ -0,0 +1,463 @@
+// This class provides the mean s-rep and the spoke variances of a cohort of s-reps
+#include "vtkSrepStatistics.h"
+#include "vtkSrepModel.h"
+#include "vtkSrepIO.h"
+#include "vtkLegacySrep.h"
+
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkPointData.h>
+#include <vtkFieldData.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkSMPTools.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+// largest number of blocks of files accumulated separately, and so of s-reps held in memory at once
+const vtkIdType MAXIMUM_NUMBER_OF_BLOCKS = 64;
+// largest step of the direction means under which the refinement passes stop
+const double DIRECTION_TOLERANCE = 1e-12;
+
+// tangent vector at the unit vector mean pointing to the unit vector x along the great circle,
+// its norm is the geodesic distance; taken as x - mean for antipodal and equal vectors
+Eigen::RowVector3d LogMap(const Eigen::RowVector3d& mean, const Eigen::RowVector3d& x)
+{
+    double c = mean.dot(x);
+    Eigen::RowVector3d tangent = x - c * mean;
+    double s = tangent.norm();
+    if(s < 1e-15)
+    {
+        return tangent;
+    }
+    return (std::atan2(s, c) / s) * tangent;
+}
+
+// unit vector reached from the unit vector mean along the great circle of the tangent vector
+Eigen::RowVector3d ExpMap(const Eigen::RowVector3d& mean, const Eigen::RowVector3d& tangent)
+{
+    double t = tangent.norm();
+    if(t < 1e-15)
+    {
+        return mean;
+    }
+    return (std::cos(t) * mean + (std::sin(t) / t) * tangent).normalized();
+}
+
+vtkSmartPointer<vtkDoubleArray> NewPointArray(const char* name, const Eigen::VectorXd& values)
+{
+    vtkSmartPointer<vtkDoubleArray> array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(name);
+    array->SetNumberOfComponents(1);
+    array->SetNumberOfTuples(values.size());
+    Eigen::VectorXd::Map(array->GetPointer(0), values.size()) = values;
+    return array;
+}
+
+} // end of anonymous namespace
+
+// sums of the spokes of a block of s-reps: counts, means and sums of squared differences to the means
+// (Welford) of hubs and log lengths, and either the sum of the directions (first pass) or the sums of
+// their log maps and of the squares of their norms at the current direction means (refinement passes)
+class vtkSrepStatistics::Accumulator
+{
+public:
+    void Reset(vtkIdType nSpokes)
+    {
+        Count = 0;
+        HubMean = PointMatrixType::Zero(nSpokes, 3);
+        HubSquares = Eigen::VectorXd::Zero(nSpokes);
+        LogLengthMean = Eigen::VectorXd::Zero(nSpokes);
+        LogLengthSquares = Eigen::VectorXd::Zero(nSpokes);
+        DirectionSum = PointMatrixType::Zero(nSpokes, 3);
+        DirectionSquares = Eigen::VectorXd::Zero(nSpokes);
+    }
+
+    void Add(const PointMatrixType& hubs, const PointMatrixType& directions, const Eigen::VectorXd& logLengths)
+    {
+        ++Count;
+        PointMatrixType hubDelta = hubs - HubMean;
+        HubMean += hubDelta / static_cast<double>(Count);
+        HubSquares += hubDelta.cwiseProduct(hubs - HubMean).rowwise().sum();
+        Eigen::VectorXd logDelta = logLengths - LogLengthMean;
+        LogLengthMean += logDelta / static_cast<double>(Count);
+        LogLengthSquares += logDelta.cwiseProduct(logLengths - LogLengthMean);
+        DirectionSum += directions;
+    }
+
+    void AddTangents(const PointMatrixType& directions, const PointMatrixType& mean)
+    {
+        ++Count;
+        for(vtkIdType i = 0; i < directions.rows(); ++i)
+        {
+            Eigen::RowVector3d tangent = LogMap(mean.row(i), directions.row(i));
+            DirectionSum.row(i) += tangent;
+            DirectionSquares[i] += tangent.squaredNorm();
+        }
+    }
+
+    // pairwise update of the means and sums of squares, other follows this block
+    void Merge(const Accumulator& other)
+    {
+        if(other.Count == 0)
+        {
+            return;
+        }
+        if(Count == 0)
+        {
+            *this = other;
+            return;
+        }
+        double n = static_cast<double>(Count + other.Count);
+        double weight = static_cast<double>(Count) * static_cast<double>(other.Count) / n;
+        PointMatrixType hubDelta = other.HubMean - HubMean;
+        HubMean += hubDelta * (static_cast<double>(other.Count) / n);
+        HubSquares += other.HubSquares + weight * hubDelta.rowwise().squaredNorm();
+        Eigen::VectorXd logDelta = other.LogLengthMean - LogLengthMean;
+        LogLengthMean += logDelta * (static_cast<double>(other.Count) / n);
+        LogLengthSquares += other.LogLengthSquares + weight * logDelta.cwiseAbs2();
+        DirectionSum += other.DirectionSum;
+        DirectionSquares += other.DirectionSquares;
+        Count += other.Count;
+    }
+
+    vtkIdType Count;
+    PointMatrixType HubMean;
+    Eigen::VectorXd HubSquares;
+    Eigen::VectorXd LogLengthMean;
+    Eigen::VectorXd LogLengthSquares;
+    PointMatrixType DirectionSum;
+    Eigen::VectorXd DirectionSquares;
+};
+
+// accumulates a range of blocks of files, block b holds the files [b n / nBlocks, (b + 1) n / nBlocks)
+class vtkSrepStatistics::AccumulateFunctor
+{
+public:
+    AccumulateFunctor(const vtkSrepStatistics* self, const std::vector<std::string>& fileNames, bool firstPass,
+                      std::vector<Accumulator>& blocks, std::vector<char>& accepted, std::vector<std::string>& messages)
+        : Self(self), FileNames(fileNames), FirstPass(firstPass), Blocks(blocks), Accepted(accepted), Messages(messages)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+        vtkIdType nFiles = static_cast<vtkIdType>(FileNames.size());
+        vtkIdType nBlocks = static_cast<vtkIdType>(Blocks.size());
+        PointMatrixType hubs, directions;
+        Eigen::VectorXd logLengths;
+        for(vtkIdType b = begin; b < end; ++b)
+        {
+            Accumulator& block = Blocks[b];
+            block.Reset(Self->GetNumberOfSpokes());
+            for(vtkIdType i = b * nFiles / nBlocks; i < (b + 1) * nFiles / nBlocks; ++i)
+            {
+                if(!FirstPass && !Accepted[i])
+                {
+                    continue;
+                }
+                std::string message;
+                if(!Self->ReadSpokes(FileNames[i], hubs, directions, logLengths, message))
+                {
+                    // a file that changed since the first pass is no longer accepted, which fails Compute
+                    Accepted[i] = 0;
+                    Messages[i] = FirstPass ? message : "changed since the first pass: " + message;
+                    continue;
+                }
+                if(FirstPass)
+                {
+                    Accepted[i] = 1;
+                    block.Add(hubs, directions, logLengths);
+                }
+                else
+                {
+                    block.AddTangents(directions, Self->DirectionMean);
+                }
+            }
+        }
+    }
+
+private:
+    const vtkSrepStatistics* Self;
+    const std::vector<std::string>& FileNames;
+    bool FirstPass;
+    std::vector<Accumulator>& Blocks;
+    std::vector<char>& Accepted;
+    std::vector<std::string>& Messages;
+};
+
+vtkSrepStatistics::vtkSrepStatistics()
+    : NumberOfRefinementPasses(3), FoldCurveDistance(0.0), NumberOfRows(0), NumberOfColumns(0), NumberOfSamples(0),
+      NumberOfPasses(0)
+{
+    NumberOfSpokes[0] = NumberOfSpokes[1] = NumberOfSpokes[2] = 0;
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkSrepStatistics::ReadSample(const std::string& fileName, double foldCurveDistance)
+{
+    if(vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(fileName)) == ".m3d")
+    {
+        vtkLegacySrep legacySrep;
+        if(!legacySrep.ReadM3D(fileName))
+        {
+            return NULL;
+        }
+        return legacySrep.ToSrepModel(foldCurveDistance);
+    }
+    return vtkSrepIO::ReadSrep(fileName);
+}
+
+bool vtkSrepStatistics::Compute(const std::vector<std::string>& fileNames)
+{
+    NumberOfSamples = 0;
+    NumberOfPasses = 0;
+    Rejected.clear();
+    Template = NULL;
+    for(size_t i = 0; i < fileNames.size() && Template == NULL; ++i)
+    {
+        vtkSmartPointer<vtkMultiBlockDataSet> srep = ReadSample(fileNames[i], FoldCurveDistance);
+        if(vtkSrepModel::IsValid(srep))
+        {
+            Template = srep;
+        }
+    }
+    if(Template == NULL)
+    {
+        std::cerr << "None of the " << fileNames.size() << " files is an s-rep" << std::endl;
+        return false;
+    }
+    NumberOfRows = vtkSrepModel::GetNumberOfRows(Template);
+    NumberOfColumns = vtkSrepModel::GetNumberOfColumns(Template);
+    NumberOfSpokes[vtkSrepModel::UpBlock] = vtkSrepModel::GetUpSpokes(Template)->GetNumberOfPoints();
+    NumberOfSpokes[vtkSrepModel::DownBlock] = vtkSrepModel::GetDownSpokes(Template)->GetNumberOfPoints();
+    NumberOfSpokes[vtkSrepModel::CrestBlock] = vtkSrepModel::GetCrestSpokes(Template)->GetNumberOfPoints();
+
+    vtkIdType nFiles = static_cast<vtkIdType>(fileNames.size());
+    vtkIdType nBlocks = std::min(nFiles, MAXIMUM_NUMBER_OF_BLOCKS);
+    std::vector<Accumulator> blocks(nBlocks);
+    std::vector<char> accepted(nFiles, 0);
+    std::vector<std::string> messages(nFiles);
+    Accumulator total;
+
+    // first pass: hubs, log lengths and the extrinsic mean of the directions
+    AccumulateFunctor firstPass(this, fileNames, true, blocks, accepted, messages);
+    vtkSMPTools::For(0, nBlocks, 1, firstPass);
+    NumberOfPasses = 1;
+    total.Reset(GetNumberOfSpokes());
+    for(vtkIdType b = 0; b < nBlocks; ++b)
+    {
+        total.Merge(blocks[b]);
+    }
+    for(vtkIdType i = 0; i < nFiles; ++i)
+    {
+        if(!accepted[i])
+        {
+            Rejected.push_back(std::make_pair(fileNames[i], messages[i]));
+        }
+    }
+    if(total.Count == 0)
+    {
+        std::cerr << "None of the " << fileNames.size() << " files can be used, see the rejected files" << std::endl;
+        return false;
+    }
+    NumberOfSamples = total.Count;
+    HubMean = total.HubMean;
+    HubVariance = total.HubSquares / static_cast<double>(NumberOfSamples);
+    LogLengthMean = total.LogLengthMean;
+    LogLengthVariance = total.LogLengthSquares / static_cast<double>(NumberOfSamples);
+    DirectionMean = total.DirectionSum;
+    for(vtkIdType i = 0; i < DirectionMean.rows(); ++i)
+    {
+        // directions spread evenly over the sphere have no extrinsic mean, start from any of them
+        double norm = DirectionMean.row(i).norm();
+        DirectionMean.row(i) = norm > 0 ? Eigen::RowVector3d(DirectionMean.row(i) / norm) : Eigen::RowVector3d::UnitX();
+    }
+
+    // refinement passes: Karcher steps mean <- Exp_mean(mean of Log_mean(x)); the variance of the
+    // geodesic distance to the new mean is mean(|Log_mean(x)|^2) - |mean of Log_mean(x)|^2 to second order
+    // the direction statistics must cover the s-reps of the first pass, so a file that can no longer be read
+    // is rejected and no statistics are given
+    DirectionVariance = Eigen::VectorXd::Zero(GetNumberOfSpokes());
+    const std::vector<char> firstAccepted(accepted);
+    for(int pass = 0; pass < NumberOfRefinementPasses; ++pass)
+    {
+        AccumulateFunctor refinementPass(this, fileNames, false, blocks, accepted, messages);
+        vtkSMPTools::For(0, nBlocks, 1, refinementPass);
+        ++NumberOfPasses;
+        total.Reset(GetNumberOfSpokes());
+        for(vtkIdType b = 0; b < nBlocks; ++b)
+        {
+            total.Merge(blocks[b]);
+        }
+        if(total.Count != NumberOfSamples)
+        {
+            for(vtkIdType i = 0; i < nFiles; ++i)
+            {
+                if(firstAccepted[i] && !accepted[i])
+                {
+                    Rejected.push_back(std::make_pair(fileNames[i], messages[i]));
+                }
+            }
+            std::cerr << NumberOfSamples - total.Count << " files changed during the statistics, see the rejected files" << std::endl;
+            NumberOfSamples = 0;
+            return false;
+        }
+        PointMatrixType step = total.DirectionSum / static_cast<double>(total.Count);
+        DirectionVariance = (total.DirectionSquares / static_cast<double>(total.Count)
+                             - step.rowwise().squaredNorm()).cwiseMax(0.0);
+        for(vtkIdType i = 0; i < DirectionMean.rows(); ++i)
+        {
+            DirectionMean.row(i) = ExpMap(DirectionMean.row(i), step.row(i));
+        }
+        if(step.rowwise().norm().maxCoeff() < DIRECTION_TOLERANCE)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+bool vtkSrepStatistics::ReadSpokes(const std::string& fileName, PointMatrixType& hubs, PointMatrixType& directions,
+                                   Eigen::VectorXd& logLengths, std::string& message) const
+{
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = ReadSample(fileName, FoldCurveDistance);
+    if(!vtkSrepModel::IsValid(srep))
+    {
+        message = "cannot read the s-rep";
+        return false;
+    }
+    if(vtkSrepModel::GetNumberOfRows(srep) != NumberOfRows || vtkSrepModel::GetNumberOfColumns(srep) != NumberOfColumns)
+    {
+        std::ostringstream out;
+        out << "grid of " << vtkSrepModel::GetNumberOfRows(srep) << " x " << vtkSrepModel::GetNumberOfColumns(srep)
+            << " instead of " << NumberOfRows << " x " << NumberOfColumns;
+        message = out.str();
+        return false;
+    }
+    hubs.resize(GetNumberOfSpokes(), 3);
+    directions.resize(GetNumberOfSpokes(), 3);
+    logLengths.resize(GetNumberOfSpokes());
+    vtkIdType offset = 0;
+    for(int k = 0; k < 3; ++k)
+    {
+        vtkPolyData* spokes = vtkPolyData::SafeDownCast(srep->GetBlock(k));
+        if(spokes->GetNumberOfPoints() != NumberOfSpokes[k])
+        {
+            std::ostringstream out;
+            out << spokes->GetNumberOfPoints() << " spokes in block " << k << " instead of " << NumberOfSpokes[k];
+            message = out.str();
+            return false;
+        }
+        vtkDataArray* directionArray = spokes->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengthArray = spokes->GetPointData()->GetArray("spokeLength");
+        for(vtkIdType i = 0; i < NumberOfSpokes[k]; ++i, ++offset)
+        {
+            double hub[3], direction[3];
+            spokes->GetPoint(i, hub);
+            directionArray->GetTuple(i, direction);
+            double length = lengthArray->GetTuple1(i);
+            Eigen::RowVector3d unit(direction[0], direction[1], direction[2]);
+            double norm = unit.norm();
+            // log lengths and directions on the sphere need positive lengths and non zero directions
+            if(!(length > 0) || !(norm > 0) || !std::isfinite(length) || !std::isfinite(norm))
+            {
+                std::ostringstream out;
+                out << "spoke " << i << " of block " << k << " has length " << length << " and direction norm " << norm;
+                message = out.str();
+                return false;
+            }
+            hubs.row(offset) << hub[0], hub[1], hub[2];
+            directions.row(offset) = unit / norm;
+            logLengths[offset] = std::log(length);
+        }
+    }
+    return true;
+}
+
+vtkSmartPointer<vtkMultiBlockDataSet> vtkSrepStatistics::NewMeanSrep() const
+{
+    if(NumberOfSamples == 0)
+    {
+        return NULL;
+    }
+    vtkSmartPointer<vtkPolyData> blocks[3];
+    vtkIdType offset = 0;
+    for(int k = 0; k < 3; ++k)
+    {
+        vtkPolyData* templateSpokes = vtkPolyData::SafeDownCast(Template->GetBlock(k));
+        vtkIdType n = NumberOfSpokes[k];
+        blocks[k] = vtkSmartPointer<vtkPolyData>::New();
+        vtkEigenArrayBridge::AllocatePoints(blocks[k], n) = HubMean.middleRows(offset, n);
+        // quad mesh of the skeletal sheet or poly line of the fold curve
+        blocks[k]->SetPolys(templateSpokes->GetPolys());
+        blocks[k]->SetLines(templateSpokes->GetLines());
+
+        vtkSmartPointer<vtkDoubleArray> directions = vtkSmartPointer<vtkDoubleArray>::New();
+        directions->SetName("spokeDirection");
+        directions->SetNumberOfComponents(3);
+        directions->SetNumberOfTuples(n);
+        vtkEigenArrayBridge::MapArray(directions) = DirectionMean.middleRows(offset, n);
+        vtkSmartPointer<vtkDoubleArray> lengths = NewPointArray("spokeLength", LogLengthMean.segment(offset, n).array().exp().matrix());
+        blocks[k]->GetPointData()->AddArray(directions);
+        blocks[k]->GetPointData()->SetActiveVectors("spokeDirection");
+        blocks[k]->GetPointData()->AddArray(lengths);
+        blocks[k]->GetPointData()->SetActiveScalars("spokeLength");
+        offset += n;
+    }
+    return vtkSrepModel::New(blocks[vtkSrepModel::UpBlock], blocks[vtkSrepModel::DownBlock],
+                             blocks[vtkSrepModel::CrestBlock], NumberOfRows, NumberOfColumns);
+}
+
+vtkSmartPointer<vtkPolyData> vtkSrepStatistics::NewStatistics() const
+{
+    if(NumberOfSamples == 0)
+    {
+        return NULL;
+    }
+    vtkSmartPointer<vtkPolyData> statistics = vtkSmartPointer<vtkPolyData>::New();
+    vtkEigenArrayBridge::AllocatePoints(statistics, GetNumberOfSpokes()) = HubMean;
+
+    vtkSmartPointer<vtkIntArray> part = vtkSmartPointer<vtkIntArray>::New();
+    part->SetName("part");
+    part->SetNumberOfValues(GetNumberOfSpokes());
+    vtkIdType offset = 0;
+    for(int k = 0; k < 3; ++k)
+    {
+        std::fill(part->GetPointer(offset), part->GetPointer(offset) + NumberOfSpokes[k], k);
+        offset += NumberOfSpokes[k];
+    }
+    statistics->GetPointData()->AddArray(part);
+    statistics->GetPointData()->AddArray(NewPointArray("hubVariance", HubVariance));
+    statistics->GetPointData()->AddArray(NewPointArray("directionVariance", DirectionVariance));
+    statistics->GetPointData()->AddArray(NewPointArray("logLengthMean", LogLengthMean));
+    statistics->GetPointData()->AddArray(NewPointArray("logLengthVariance", LogLengthVariance));
+
+    vtkSmartPointer<vtkIdTypeArray> nSamples = vtkSmartPointer<vtkIdTypeArray>::New();
+    nSamples->SetName("numberOfSamples");
+    nSamples->InsertNextValue(NumberOfSamples);
+    statistics->GetFieldData()->AddArray(nSamples);
+    return statistics;
+}
+
+bool vtkSrepStatistics::Write(const std::string& headerFileName) const
+{
+    vtkSmartPointer<vtkMultiBlockDataSet> mean = NewMeanSrep();
+    if(mean == NULL)
+    {
+        std::cerr << "No statistics to write to " << headerFileName << std::endl;
+        return false;
+    }
+    return vtkSrepIO::WriteSrep(mean, headerFileName, NewStatistics());
+}
@@ -0,0 +1,99 @@
+// This class provides the mean s-rep and the spoke variances of a cohort of s-reps
+// S-reps are streamed from their files (new format headers or legacy .m3d files), so that only one
+// s-rep per block of files is held in memory whatever the size of the cohort. Every spoke gets
+//   the mean of its hub and the variance of the hub around it (sum over x, y and z),
+//   the Frechet mean of its direction on the unit sphere and the variance of the geodesic distance to it,
+//   the mean and the variance of the logarithm of its length; the mean length is exp(mean log length).
+// Hubs and log lengths are accumulated with Welford updates. The direction mean starts from the normalized
+// sum of the directions and is refined by Karcher steps, every refinement pass streaming the files again.
+// Files are split into contiguous blocks accumulated in parallel, the blocks are merged in order with the
+// pairwise update of Chan et al., so results do not depend on the number of threads.
+// All s-reps must have the grid size and the numbers of spokes of the first s-rep that can be read.
+#ifndef __vtkSrepStatistics_h
+#define __vtkSrepStatistics_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLExport.h"
+#include "vtkEigenArrayBridge.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+// Eigen includes
+#include <Eigen/Dense>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class vtkMultiBlockDataSet;
+class vtkPolyData;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRML_EXPORT vtkSrepStatistics {
+public:
+    typedef vtkEigenArrayBridge::PointMatrixType PointMatrixType;
+
+    vtkSrepStatistics();
+
+    // passes over the files refining the direction means, at least 1: the last one gives the direction variances
+    void SetNumberOfRefinementPasses(int n) {NumberOfRefinementPasses = n < 1 ? 1 : n;}
+    int GetNumberOfRefinementPasses() const {return NumberOfRefinementPasses;}
+    // crest shift of the legacy s-reps, see vtkLegacySrep::ToSrepModel
+    void SetFoldCurveDistance(double distance) {FoldCurveDistance = distance;}
+    double GetFoldCurveDistance() const {return FoldCurveDistance;}
+
+    // read an s-rep of the cohort: a legacy s-rep if the extension is .m3d, a new format header otherwise
+    // return NULL if it cannot be read
+    static vtkSmartPointer<vtkMultiBlockDataSet> ReadSample(const std::string& fileName, double foldCurveDistance);
+
+    // compute the statistics of the s-reps of the files, in parallel over blocks of files
+    // return false if no s-rep can be used, or if a file used by the first pass cannot be read again by a
+    // refinement pass: the file is then listed with the rejected files and there are no statistics
+    bool Compute(const std::vector<std::string>& fileNames);
+
+    // number of s-reps in the statistics
+    vtkIdType GetNumberOfSamples() const {return NumberOfSamples;}
+    // passes over the files run by the last Compute, the first pass included; refinement stops early
+    // once the direction means no longer move
+    int GetNumberOfPasses() const {return NumberOfPasses;}
+    // files left out of the statistics, with the reason
+    const std::vector<std::pair<std::string, std::string> >& GetRejectedFiles() const {return Rejected;}
+
+    // the mean s-rep, with the cells of the first s-rep
+    vtkSmartPointer<vtkMultiBlockDataSet> NewMeanSrep() const;
+    // the mean hubs of the up, down and crest spokes one after the other, with point data
+    // "part" (vtkSrepModel::UpBlock, DownBlock or CrestBlock), "hubVariance", "directionVariance",
+    // "logLengthMean" and "logLengthVariance", and field data "numberOfSamples"
+    vtkSmartPointer<vtkPolyData> NewStatistics() const;
+
+    // write the mean s-rep, its header referencing the statistics written next to it (see vtkSrepIO)
+    bool Write(const std::string& headerFileName) const;
+
+private:
+    // read the spokes of a file in the layout of the first s-rep, message tells why it cannot be used
+    bool ReadSpokes(const std::string& fileName, PointMatrixType& hubs, PointMatrixType& directions,
+                    Eigen::VectorXd& logLengths, std::string& message) const;
+    vtkIdType GetNumberOfSpokes() const {return NumberOfSpokes[0] + NumberOfSpokes[1] + NumberOfSpokes[2];}
+
+    int NumberOfRefinementPasses;
+    double FoldCurveDistance;
+    // first s-rep of the cohort, giving the layout and the cells of the mean s-rep
+    vtkSmartPointer<vtkMultiBlockDataSet> Template;
+    int NumberOfRows;
+    int NumberOfColumns;
+    vtkIdType NumberOfSpokes[3];
+
+    vtkIdType NumberOfSamples;
+    int NumberOfPasses;
+    // one row per spoke, up, down and crest spokes one after the other
+    PointMatrixType HubMean;
+    PointMatrixType DirectionMean;
+    Eigen::VectorXd LogLengthMean;
+    Eigen::VectorXd HubVariance;
+    Eigen::VectorXd DirectionVariance;
+    Eigen::VectorXd LogLengthVariance;
+    std::vector<std::pair<std::string, std::string> > Rejected;
+
+    class Accumulator;
+    class AccumulateFunctor;
+};
+#endif
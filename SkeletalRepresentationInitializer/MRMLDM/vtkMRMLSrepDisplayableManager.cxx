@@ -0,0 +1,233 @@
+// This class provides rendering of s-rep nodes in 3D views
+#include "vtkMRMLSrepDisplayableManager.h"
+#include "vtkMRMLSrepNode.h"
+#include "vtkMRMLSrepDisplayNode.h"
+#include "vtkSrepModel.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLViewNode.h>
+
+// VTK includes
+#include <vtkActor.h>
+#include <vtkCallbackCommand.h>
+#include <vtkIntArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <map>
+#include <vector>
+
+//----------------------------------------------------------------------------
+class vtkMRMLSrepDisplayableManager::vtkInternal
+{
+public:
+    typedef std::vector<vtkSmartPointer<vtkActor> > ActorList;
+    // actors of every observed s-rep node
+    std::map<vtkMRMLSrepNode*, ActorList> Actors;
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLSrepDisplayableManager);
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepDisplayableManager::vtkMRMLSrepDisplayableManager()
+{
+    this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSrepDisplayableManager::~vtkMRMLSrepDisplayableManager()
+{
+    delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::PrintSelf(ostream& os, vtkIndent indent)
+{
+    this->Superclass::PrintSelf(os, indent);
+    os << indent << "Number of s-reps: " << this->Internal->Actors.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::SetMRMLSceneInternal(vtkMRMLScene* newScene)
+{
+    vtkNew<vtkIntArray> sceneEvents;
+    sceneEvents->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+    sceneEvents->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+    sceneEvents->InsertNextValue(vtkMRMLScene::EndBatchProcessEvent);
+    this->SetAndObserveMRMLSceneEventsInternal(newScene, sceneEvents.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::UnobserveMRMLScene()
+{
+    this->RemoveAllSrepNodes();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(node);
+    if(srepNode == NULL)
+    {
+        return;
+    }
+    if(this->GetMRMLScene()->IsBatchProcessing())
+    {
+        // all the s-reps are added at the end of the batch process
+        this->SetUpdateFromMRMLRequested(1);
+        return;
+    }
+    this->AddSrepNode(srepNode);
+    this->RequestRender();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(node);
+    if(srepNode == NULL)
+    {
+        return;
+    }
+    this->RemoveSrepNode(srepNode);
+    this->RequestRender();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::OnMRMLSceneEndBatchProcess()
+{
+    this->UpdateFromMRML();
+    this->RequestRender();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+    vtkMRMLSrepNode* srepNode = vtkMRMLSrepNode::SafeDownCast(caller);
+    if(srepNode != NULL && this->Internal->Actors.count(srepNode) > 0)
+    {
+        this->UpdateActors(srepNode);
+        this->RequestRender();
+        return;
+    }
+    this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::UpdateFromMRML()
+{
+    this->SetUpdateFromMRMLRequested(0);
+    this->RemoveAllSrepNodes();
+    vtkMRMLScene* scene = this->GetMRMLScene();
+    if(scene == NULL)
+    {
+        return;
+    }
+    std::vector<vtkMRMLNode*> nodes;
+    scene->GetNodesByClass("vtkMRMLSrepNode", nodes);
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        this->AddSrepNode(vtkMRMLSrepNode::SafeDownCast(nodes[i]));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::AddSrepNode(vtkMRMLSrepNode* node)
+{
+    if(node == NULL || this->Internal->Actors.count(node) > 0)
+    {
+        return;
+    }
+    vtkNew<vtkIntArray> nodeEvents;
+    nodeEvents->InsertNextValue(vtkCommand::ModifiedEvent);
+    nodeEvents->InsertNextValue(vtkMRMLDisplayableNode::DisplayModifiedEvent);
+    this->GetMRMLNodesObserverManager()->AddObjectEvents(node, nodeEvents.GetPointer());
+    this->Internal->Actors[node] = vtkInternal::ActorList();
+    this->UpdateActors(node);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::RemoveSrepNode(vtkMRMLSrepNode* node)
+{
+    std::map<vtkMRMLSrepNode*, vtkInternal::ActorList>::iterator it = this->Internal->Actors.find(node);
+    if(it == this->Internal->Actors.end())
+    {
+        return;
+    }
+    for(size_t i = 0; i < it->second.size(); ++i)
+    {
+        this->GetRenderer()->RemoveViewProp(it->second[i]);
+    }
+    this->GetMRMLNodesObserverManager()->RemoveObjectEvents(node);
+    this->Internal->Actors.erase(it);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::RemoveAllSrepNodes()
+{
+    while(!this->Internal->Actors.empty())
+    {
+        this->RemoveSrepNode(this->Internal->Actors.begin()->first);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSrepDisplayableManager::UpdateActors(vtkMRMLSrepNode* node)
+{
+    vtkInternal::ActorList& actors = this->Internal->Actors[node];
+    for(size_t i = 0; i < actors.size(); ++i)
+    {
+        this->GetRenderer()->RemoveViewProp(actors[i]);
+    }
+    actors.clear();
+
+    vtkMultiBlockDataSet* srep = node->GetSrep();
+    vtkMRMLSrepDisplayNode* displayNode = node->GetSrepDisplayNode();
+    vtkMRMLViewNode* viewNode = this->GetMRMLViewNode();
+    if(!vtkSrepModel::IsValid(srep) || displayNode == NULL
+            || !displayNode->GetVisibility(viewNode != NULL ? viewNode->GetID() : NULL))
+    {
+        return;
+    }
+
+    // the skeletal sheet is the quad mesh of the up spokes, the fold curve the poly line of the crest spokes
+    vtkSmartPointer<vtkPolyData> sheet = vtkSmartPointer<vtkPolyData>::New();
+    sheet->SetPoints(vtkSrepModel::GetUpSpokes(srep)->GetPoints());
+    sheet->SetPolys(vtkSrepModel::GetUpSpokes(srep)->GetPolys());
+    vtkSmartPointer<vtkPolyData> fold = vtkSmartPointer<vtkPolyData>::New();
+    fold->SetPoints(vtkSrepModel::GetCrestSpokes(srep)->GetPoints());
+    fold->SetLines(vtkSrepModel::GetCrestSpokes(srep)->GetLines());
+
+    vtkSmartPointer<vtkPolyData> parts[5] = {vtkSrepModel::NewSpokeLines(vtkSrepModel::GetUpSpokes(srep)),
+                                             vtkSrepModel::NewSpokeLines(vtkSrepModel::GetDownSpokes(srep)),
+                                             vtkSrepModel::NewSpokeLines(vtkSrepModel::GetCrestSpokes(srep)),
+                                             sheet, fold};
+    double* colors[5] = {displayNode->GetUpSpokeColor(), displayNode->GetDownSpokeColor(), displayNode->GetCrestSpokeColor(),
+                         displayNode->GetSkeletalSheetColor(), displayNode->GetFoldCurveColor()};
+
+    for(int i = 0; i < 5; ++i)
+    {
+        vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+        mapper->SetInputData(parts[i]);
+        vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+        actor->SetMapper(mapper);
+        actor->GetProperty()->SetColor(colors[i]);
+        actor->GetProperty()->SetOpacity(displayNode->GetOpacity());
+        actor->GetProperty()->SetLineWidth(displayNode->GetLineWidth());
+        if(i == 3)
+        {
+            actor->GetProperty()->SetRepresentationToWireframe();
+        }
+        this->GetRenderer()->AddViewProp(actor);
+        actors.push_back(actor);
+    }
+}
@@ -0,0 +1,47 @@
+// This class provides rendering of s-rep nodes in 3D views
+// Every s-rep node is shown as up, down and crest spokes, the skeletal sheet
+// and the fold curve, built directly from the s-rep model held by the node.
+#ifndef __vtkMRMLSrepDisplayableManager_h
+#define __vtkMRMLSrepDisplayableManager_h
+
+#include "vtkSlicerSkeletalRepresentationInitializerModuleMRMLDisplayableManagerExport.h"
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLAbstractThreeDViewDisplayableManager.h>
+
+class vtkMRMLSrepNode;
+class VTK_SLICER_SKELETALREPRESENTATIONINITIALIZER_MODULE_MRMLDISPLAYABLEMANAGER_EXPORT vtkMRMLSrepDisplayableManager
+    : public vtkMRMLAbstractThreeDViewDisplayableManager
+{
+public:
+    static vtkMRMLSrepDisplayableManager* New();
+    vtkTypeMacro(vtkMRMLSrepDisplayableManager, vtkMRMLAbstractThreeDViewDisplayableManager);
+    void PrintSelf(ostream& os, vtkIndent indent);
+
+protected:
+    vtkMRMLSrepDisplayableManager();
+    virtual ~vtkMRMLSrepDisplayableManager();
+
+    virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene);
+    virtual void UnobserveMRMLScene();
+    virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
+    virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+    virtual void OnMRMLSceneEndBatchProcess();
+    virtual void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData);
+    // rebuild the actors of every s-rep node of the scene
+    virtual void UpdateFromMRML();
+
+private:
+    vtkMRMLSrepDisplayableManager(const vtkMRMLSrepDisplayableManager&); // Not implemented
+    void operator=(const vtkMRMLSrepDisplayableManager&); // Not implemented
+
+    void AddSrepNode(vtkMRMLSrepNode* node);
+    void RemoveSrepNode(vtkMRMLSrepNode* node);
+    void RemoveAllSrepNodes();
+    // rebuild the actors of one s-rep from its s-rep model and display node
+    void UpdateActors(vtkMRMLSrepNode* node);
+
+    class vtkInternal;
+    vtkInternal* Internal;
+};
+#endif
@@ -0,0 +1,108 @@
+// Test the solvers of the TPS: the iterative solve matches the dense solve on the same landmarks,
+// and an iterative solve that fails falls back to the dense solve
+#include "itkThinPlateSplineExtended.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+typedef itkThinPlateSplineExtended TPSType;
+
+// n landmarks spread over an ellipsoid (a golden angle spiral), moved by a smooth deformation
+void SetLandmarks(TPSType* tps, unsigned long n)
+{
+    TPSType::PointSetType::Pointer source = TPSType::PointSetType::New();
+    TPSType::PointSetType::Pointer target = TPSType::PointSetType::New();
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        double z = 1.0 - 2.0 * (i + 0.5) / n;
+        double r = std::sqrt(1.0 - z * z);
+        double phi = 2.39996322972865332 * i;
+        TPSType::InputPointType p, q;
+        p[0] = 30.0 * r * std::cos(phi);
+        p[1] = 20.0 * r * std::sin(phi);
+        p[2] = 10.0 * z;
+        q[0] = 1.1 * p[0] + 2.0 * std::sin(p[1] / 7.0);
+        q[1] = p[1] + 1.5 * std::cos(p[2] / 5.0);
+        q[2] = 0.9 * p[2] + 0.01 * p[0] * p[1];
+        source->GetPoints()->InsertElement(i, p);
+        target->GetPoints()->InsertElement(i, q);
+    }
+    tps->SetSourceLandmarks(source);
+    tps->SetTargetLandmarks(target);
+}
+
+} // end of anonymous namespace
+
+int itkThinPlateSplineExtendedTest1(int, char*[])
+{
+    const unsigned long n = 200;
+    TPSType::Pointer dense = TPSType::New();
+    SetLandmarks(dense, n);
+    dense->setSolver(TPSType::DenseSolver);
+    dense->ComputeWMatrix();
+    if(dense->getNumberOfIterations() != 0)
+    {
+        std::cerr << "The dense solve reports " << dense->getNumberOfIterations() << " iterations" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TPSType::Pointer iterative = TPSType::New();
+    SetLandmarks(iterative, n);
+    iterative->setSolver(TPSType::IterativeSolver);
+    iterative->setTolerance(1e-10);
+    iterative->ComputeWMatrix();
+    if(iterative->getNumberOfIterations() == 0)
+    {
+        std::cerr << "The iterative solve did not run" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // same warp at the landmarks and inside the ellipsoid
+    double maxDifference = 0.0, maxDisplacement = 0.0;
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        TPSType::InputPointType landmark = dense->GetSourceLandmarks()->GetPoints()->GetElement(i);
+        TPSType::InputPointType target = dense->GetTargetLandmarks()->GetPoints()->GetElement(i);
+        for(int scale = 0; scale < 2; ++scale)
+        {
+            TPSType::InputPointType p;
+            for(int k = 0; k < 3; ++k)
+            {
+                p[k] = scale == 0 ? landmark[k] : 0.5 * landmark[k];
+                maxDisplacement = std::max(maxDisplacement, std::fabs(target[k] - landmark[k]));
+            }
+            TPSType::OutputPointType denseWarp = dense->TransformPoint(p);
+            TPSType::OutputPointType iterativeWarp = iterative->TransformPoint(p);
+            for(int k = 0; k < 3; ++k)
+            {
+                maxDifference = std::max(maxDifference, std::fabs(denseWarp[k] - iterativeWarp[k]));
+            }
+        }
+    }
+    if(!(maxDifference <= 1e-6 * maxDisplacement))
+    {
+        std::cerr << "The iterative and dense warps differ by " << maxDifference
+                  << " for displacements up to " << maxDisplacement << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // this stiffness makes the system indefinite after a few iterations: the iterative solver
+    // gives way to the dense one, whose solve takes no iteration
+    TPSType::Pointer fallback = TPSType::New();
+    SetLandmarks(fallback, n);
+    fallback->SetStiffness(10.0);
+    fallback->setSolver(TPSType::IterativeSolver);
+    fallback->ComputeWMatrix();
+    if(fallback->getNumberOfIterations() != 0)
+    {
+        std::cerr << "The dense solve after a failed iterative solve reports "
+                  << fallback->getNumberOfIterations() << " iterations" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
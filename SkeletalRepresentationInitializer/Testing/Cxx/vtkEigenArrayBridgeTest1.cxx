@@ -0,0 +1,70 @@
+// Test the Eigen views of VTK points: double points are viewed in place, single precision points
+// are read through a copy and keep their data type
+#include "vtkEigenArrayBridge.h"
+
+#include <vtkNew.h>
+#include <vtkPoints.h>
+
+#include <cstdlib>
+#include <iostream>
+
+int vtkEigenArrayBridgeTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    const double coords[4][3] = {{1.5, -2.0, 3.25}, {0.0, 4.0, -1.0}, {10.0, 0.5, 0.125}, {-7.0, 8.0, 9.0}};
+    vtkNew<vtkPoints> floatPoints;
+    floatPoints->SetDataTypeToFloat();
+    vtkNew<vtkPoints> doublePoints;
+    doublePoints->SetDataTypeToDouble();
+    for(int i = 0; i < 4; ++i)
+    {
+        floatPoints->InsertNextPoint(coords[i]);
+        doublePoints->InsertNextPoint(coords[i]);
+    }
+
+    // float points are not viewed, and not converted either
+    if(vtkEigenArrayBridge::MapPoints(floatPoints.GetPointer()).rows() != 0 || floatPoints->GetDataType() != VTK_FLOAT)
+    {
+        std::cerr << "Float points are viewed or converted to type " << floatPoints->GetDataType() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    vtkEigenArrayBridge::PointMatrixType floatBuffer, doubleBuffer;
+    vtkEigenArrayBridge::ConstPointMatrixMap floatView = vtkEigenArrayBridge::ReadPoints(floatPoints.GetPointer(), floatBuffer);
+    vtkEigenArrayBridge::ConstPointMatrixMap doubleView = vtkEigenArrayBridge::ReadPoints(doublePoints.GetPointer(), doubleBuffer);
+    if(floatView.rows() != 4 || floatPoints->GetNumberOfPoints() != 4 || floatPoints->GetDataType() != VTK_FLOAT
+            || floatView.data() != floatBuffer.data())
+    {
+        std::cerr << "Float points read as " << floatView.rows() << " rows, " << floatPoints->GetNumberOfPoints()
+                  << " points of type " << floatPoints->GetDataType() << " instead of a copy of 4 float points" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(doubleView.rows() != 4 || doubleBuffer.size() != 0)
+    {
+        std::cerr << "Double points are copied instead of viewed in place" << std::endl;
+        return EXIT_FAILURE;
+    }
+    for(int i = 0; i < 4; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            if(floatView(i, j) != coords[i][j] || doubleView(i, j) != coords[i][j])
+            {
+                std::cerr << "Coordinate " << j << " of point " << i << " is read as " << floatView(i, j) << " and "
+                          << doubleView(i, j) << " instead of " << coords[i][j] << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // the view of double points shares their memory
+    vtkEigenArrayBridge::PointMatrixMap view = vtkEigenArrayBridge::MapPoints(doublePoints.GetPointer());
+    view(2, 1) = 42.0;
+    double p[3];
+    doublePoints->GetPoint(2, p);
+    if(view.rows() != 4 || p[1] != 42.0 || doubleView(2, 1) != 42.0)
+    {
+        std::cerr << "The view does not write through to the points" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+// Test the fit of an ellipsoid with known axes whose surface is sampled much more densely near one pole
+#include "vtkEllipsoidFitLogic.h"
+
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+int vtkEllipsoidFitLogicTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    // ellipsoid with radii 3, 5, 8 along the axes of a rotated frame, centered at (1, -2, 4)
+    const double pi = 3.141592653589793;
+    const double radii[3] = {3.0, 5.0, 8.0};
+    const double center[3] = {1.0, -2.0, 4.0};
+    const double c = std::cos(pi / 6), s = std::sin(pi / 6);
+    // columns are the axes of the ellipsoid
+    const double axes[3][3] = {{c, -s, 0}, {s, c, 0}, {0, 0, 1}};
+
+    // latitudes crowd towards the north pole: phi = pi (i / n)^2
+    const int nTheta = 96;
+    const int nPhi = 96;
+    vtkNew<vtkPoints> points;
+    for(int i = 0; i <= nPhi; ++i)
+    {
+        double t = static_cast<double>(i) / nPhi;
+        double phi = pi * t * t;
+        int count = (i == 0 || i == nPhi) ? 1 : nTheta;
+        for(int j = 0; j < count; ++j)
+        {
+            double theta = 2 * pi * j / nTheta;
+            double local[3] = {radii[0] * std::sin(phi) * std::cos(theta), radii[1] * std::sin(phi) * std::sin(theta),
+                               radii[2] * std::cos(phi)};
+            double x[3];
+            for(int k = 0; k < 3; ++k)
+            {
+                x[k] = center[k] + axes[k][0] * local[0] + axes[k][1] * local[1] + axes[k][2] * local[2];
+            }
+            points->InsertNextPoint(x);
+        }
+    }
+    vtkIdType south = points->GetNumberOfPoints() - 1;
+    vtkNew<vtkCellArray> triangles;
+    for(int j = 0; j < nTheta; ++j)
+    {
+        vtkIdType next = (j + 1) % nTheta;
+        vtkIdType north[3] = {0, 1 + j, 1 + next};
+        triangles->InsertNextCell(3, north);
+        for(int i = 1; i < nPhi - 1; ++i)
+        {
+            vtkIdType a = 1 + (i - 1) * nTheta;
+            vtkIdType b = 1 + i * nTheta;
+            vtkIdType lower[3] = {a + j, b + j, b + next};
+            vtkIdType upper[3] = {a + j, b + next, a + next};
+            triangles->InsertNextCell(3, lower);
+            triangles->InsertNextCell(3, upper);
+        }
+        vtkIdType last = 1 + (nPhi - 2) * nTheta;
+        vtkIdType southCap[3] = {last + j, south, last + next};
+        triangles->InsertNextCell(3, southCap);
+    }
+    vtkNew<vtkPolyData> ellipsoid;
+    ellipsoid->SetPoints(points.GetPointer());
+    ellipsoid->SetPolys(triangles.GetPointer());
+
+    vtkEllipsoidFitLogic fit;
+    if(!fit.Fit(ellipsoid.GetPointer()))
+    {
+        std::cerr << "Cannot fit the ellipsoid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the facets cut slightly into the ellipsoid, hence the tolerances
+    for(int k = 0; k < 3; ++k)
+    {
+        if(std::fabs(fit.GetCenter()(k) - center[k]) > 0.01)
+        {
+            std::cerr << "Center " << fit.GetCenter().transpose() << " instead of (1, -2, 4)" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if(std::fabs(fit.GetRadii()(k) - radii[k]) > 0.01 * radii[k])
+        {
+            std::cerr << "Radii " << fit.GetRadii().transpose() << " instead of (3, 5, 8)" << std::endl;
+            return EXIT_FAILURE;
+        }
+        // axis k of the fit is axis k of the ellipsoid up to its sign
+        double alignment = 0;
+        for(int l = 0; l < 3; ++l)
+        {
+            alignment += fit.GetRotation()(l, k) * axes[l][k];
+        }
+        if(std::fabs(alignment) < 1 - 1e-4)
+        {
+            std::cerr << "Axis " << k << " of the fit is " << fit.GetRotation().col(k).transpose() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    double volume = 4 / 3.0 * pi * radii[0] * radii[1] * radii[2];
+    if(std::fabs(fit.GetVolume() - volume) > 0.01 * volume)
+    {
+        std::cerr << "Volume " << fit.GetVolume() << " instead of " << volume << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // a mesh without polygons cannot be fit
+    vtkNew<vtkPolyData> empty;
+    if(fit.Fit(empty.GetPointer()))
+    {
+        std::cerr << "An empty mesh should not be fit" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
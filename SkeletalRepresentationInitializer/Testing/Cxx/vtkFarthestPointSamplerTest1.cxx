@@ -0,0 +1,70 @@
+// Test the farthest point order: single and double precision points give the same order of distinct ids
+#include "vtkFarthestPointSampler.h"
+
+#include <vtkNew.h>
+#include <vtkPoints.h>
+
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <vector>
+
+int vtkFarthestPointSamplerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    // golden spiral on an ellipsoid, the coordinates are exact in single precision
+    const int nPoints = 500;
+    vtkNew<vtkPoints> doublePoints;
+    vtkNew<vtkPoints> floatPoints;
+    floatPoints->SetDataTypeToFloat();
+    for(int i = 0; i < nPoints; ++i)
+    {
+        double z = 1.0 - (2.0 * i + 1.0) / nPoints;
+        double r = std::sqrt(1.0 - z * z);
+        double phi = 2.399963229728653 * i;
+        float p[3] = {static_cast<float>(30.0 * r * std::cos(phi)), static_cast<float>(20.0 * r * std::sin(phi)),
+                      static_cast<float>(10.0 * z)};
+        double q[3] = {p[0], p[1], p[2]};
+        floatPoints->InsertNextPoint(q);
+        doublePoints->InsertNextPoint(q);
+    }
+
+    std::vector<vtkIdType> doubleOrder = vtkFarthestPointSampler::Order(doublePoints.GetPointer());
+    std::vector<vtkIdType> floatOrder = vtkFarthestPointSampler::Order(floatPoints.GetPointer());
+    if(static_cast<int>(doubleOrder.size()) != nPoints || static_cast<int>(floatOrder.size()) != nPoints)
+    {
+        std::cerr << "Ordered " << doubleOrder.size() << " double and " << floatOrder.size()
+                  << " float points instead of " << nPoints << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(doubleOrder[0] != 0)
+    {
+        std::cerr << "The order starts at point " << doubleOrder[0] << " instead of 0" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::set<vtkIdType> ids(doubleOrder.begin(), doubleOrder.end());
+    if(static_cast<int>(ids.size()) != nPoints || *ids.begin() != 0 || *ids.rbegin() != nPoints - 1)
+    {
+        std::cerr << "The order is not a permutation of the points" << std::endl;
+        return EXIT_FAILURE;
+    }
+    for(int i = 0; i < nPoints; ++i)
+    {
+        if(floatOrder[i] != doubleOrder[i])
+        {
+            std::cerr << "Sample " << i << " is point " << floatOrder[i] << " for float points and "
+                      << doubleOrder[i] << " for double points" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // a prefix of the order
+    std::vector<vtkIdType> prefix = vtkFarthestPointSampler::Order(doublePoints.GetPointer(), 20);
+    if(prefix.size() != 20 || !std::equal(prefix.begin(), prefix.end(), doubleOrder.begin()))
+    {
+        std::cerr << "The first 20 samples differ from the full order" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+// Test the implied boundary of the s-rep of an ellipsoid: the quad mesh is closed, every edge is shared by
+// two quads that run it in opposite directions, and the quads face outward, enclosing the volume of the
+// ellipsoid, also for the mirrored s-rep whose grid turns the other way
+#include "vtkImpliedBoundary.h"
+#include "vtkSrepModel.h"
+
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const double RADII[3] = {6.0, 4.0, 2.0};
+
+// spokes from the hubs to the tips
+vtkSmartPointer<vtkPolyData> NewSpokes(const std::vector<double>& hubs, const std::vector<double>& tips)
+{
+    vtkNew<vtkPoints> hubPoints;
+    vtkNew<vtkPoints> tailHeadPairs;
+    hubPoints->SetDataTypeToDouble();
+    tailHeadPairs->SetDataTypeToDouble();
+    for(size_t i = 0; i < hubs.size(); i += 3)
+    {
+        hubPoints->InsertNextPoint(&hubs[i]);
+        tailHeadPairs->InsertNextPoint(&hubs[i]);
+        tailHeadPairs->InsertNextPoint(&tips[i]);
+    }
+    return vtkSrepModel::NewSpokes(hubPoints.GetPointer(), tailHeadPairs.GetPointer());
+}
+
+// medial s-rep of the ellipsoid on a nRows x nCols grid filling its medial ellipse, the hub (x, y, 0) has
+// the spokes to (x a^2 / (a^2 - c^2), y b^2 / (b^2 - c^2), +-z) on the ellipsoid; mirror flips the x axis
+vtkSmartPointer<vtkMultiBlockDataSet> NewEllipsoidSrep(int nRows, int nCols, bool mirror)
+{
+    const double medialRadii[2] = {RADII[0] - RADII[2] * RADII[2] / RADII[0], RADII[1] - RADII[2] * RADII[2] / RADII[1]};
+    std::vector<double> hubs, upTips, downTips;
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
+        {
+            // the square grid is pulled onto the ellipse ring by ring, its edge lies on the medial ellipse
+            double u = 2.0 * c / (nCols - 1) - 1;
+            double v = 2.0 * r / (nRows - 1) - 1;
+            double ring = std::max(std::fabs(u), std::fabs(v));
+            double norm = std::sqrt(u * u + v * v);
+            double x = norm > 0 ? medialRadii[0] * u * ring / norm : 0;
+            double y = norm > 0 ? medialRadii[1] * v * ring / norm : 0;
+            x = mirror ? -x : x;
+            double tip[3] = {x * RADII[0] * RADII[0] / (RADII[0] * RADII[0] - RADII[2] * RADII[2]),
+                             y * RADII[1] * RADII[1] / (RADII[1] * RADII[1] - RADII[2] * RADII[2]), 0};
+            tip[2] = RADII[2] * std::sqrt(std::max(0.0, 1 - tip[0] * tip[0] / (RADII[0] * RADII[0])
+                                                   - tip[1] * tip[1] / (RADII[1] * RADII[1])));
+            double hub[3] = {x, y, 0};
+            hubs.insert(hubs.end(), hub, hub + 3);
+            upTips.insert(upTips.end(), tip, tip + 3);
+            tip[2] = -tip[2];
+            downTips.insert(downTips.end(), tip, tip + 3);
+        }
+    }
+    std::vector<double> foldHubs, crestTips;
+    for(int i = 0; i < 2 * (nRows + nCols) - 4; ++i)
+    {
+        vtkIdType hub = vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols);
+        foldHubs.insert(foldHubs.end(), &hubs[3 * hub], &hubs[3 * hub] + 3);
+        double tip[3] = {upTips[3 * hub], upTips[3 * hub + 1], 0};
+        crestTips.insert(crestTips.end(), tip, tip + 3);
+    }
+    return vtkSrepModel::New(NewSpokes(hubs, upTips), NewSpokes(hubs, downTips), NewSpokes(foldHubs, crestTips), nRows, nCols);
+}
+
+// check that the mesh is closed and consistently oriented and that it encloses the volume of the ellipsoid
+bool CheckClosedAndOutward(vtkPolyData* mesh)
+{
+    std::map<std::pair<vtkIdType, vtkIdType>, int> edges;
+    std::vector<int> used(mesh->GetNumberOfPoints(), 0);
+    double volume = 0;
+    vtkNew<vtkIdList> cell;
+    vtkCellArray* polys = mesh->GetPolys();
+    polys->InitTraversal();
+    while(polys->GetNextCell(cell.GetPointer()))
+    {
+        vtkIdType n = cell->GetNumberOfIds();
+        for(vtkIdType k = 0; k < n; ++k)
+        {
+            ++edges[std::make_pair(cell->GetId(k), cell->GetId((k + 1) % n))];
+            used[cell->GetId(k)] = 1;
+        }
+        double p0[3], p1[3], p2[3];
+        mesh->GetPoint(cell->GetId(0), p0);
+        for(vtkIdType k = 1; k + 1 < n; ++k)
+        {
+            mesh->GetPoint(cell->GetId(k), p1);
+            mesh->GetPoint(cell->GetId(k + 1), p2);
+            volume += (p0[0] * (p1[1] * p2[2] - p1[2] * p2[1]) + p0[1] * (p1[2] * p2[0] - p1[0] * p2[2])
+                    + p0[2] * (p1[0] * p2[1] - p1[1] * p2[0])) / 6;
+        }
+    }
+    for(std::map<std::pair<vtkIdType, vtkIdType>, int>::const_iterator e = edges.begin(); e != edges.end(); ++e)
+    {
+        if(e->second != 1 || edges.count(std::make_pair(e->first.second, e->first.first)) != 1)
+        {
+            std::cerr << "Edge (" << e->first.first << ", " << e->first.second << ") is run " << e->second
+                      << " times and not once in each direction" << std::endl;
+            return false;
+        }
+    }
+    for(vtkIdType i = 0; i < mesh->GetNumberOfPoints(); ++i)
+    {
+        if(!used[i])
+        {
+            std::cerr << "Point " << i << " is in no quad" << std::endl;
+            return false;
+        }
+    }
+    double exact = 4.0 / 3.0 * 3.141592653589793 * RADII[0] * RADII[1] * RADII[2];
+    if(std::fabs(volume - exact) > 0.1 * exact)
+    {
+        std::cerr << "The mesh encloses " << volume << " instead of " << exact << std::endl;
+        return false;
+    }
+    return true;
+}
+}
+
+int vtkImpliedBoundaryTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    const int nRows = 5;
+    const int nCols = 9;
+    const int resolution = 3;
+    for(int mirror = 0; mirror < 2; ++mirror)
+    {
+        vtkSmartPointer<vtkMultiBlockDataSet> srep = NewEllipsoidSrep(nRows, nCols, mirror != 0);
+        vtkImpliedBoundary impliedBoundary;
+        impliedBoundary.SetResolution(resolution);
+        if(!impliedBoundary.Update(srep))
+        {
+            std::cerr << "Failed to compute the implied boundary" << std::endl;
+            return EXIT_FAILURE;
+        }
+        vtkPolyData* boundary = impliedBoundary.GetOutput();
+        vtkIdType N = (nRows - 1) * resolution + 1;
+        vtkIdType M = (nCols - 1) * resolution + 1;
+        vtkIdType nRing = 2 * (N + M) - 4;
+        if(boundary->GetNumberOfPoints() != 2 * N * M + nRing * (2 * resolution - 1))
+        {
+            std::cerr << "The implied boundary has " << boundary->GetNumberOfPoints() << " points" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if(!CheckClosedAndOutward(boundary))
+        {
+            std::cerr << "Wrong implied boundary of the " << (mirror ? "mirrored " : "") << "s-rep" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
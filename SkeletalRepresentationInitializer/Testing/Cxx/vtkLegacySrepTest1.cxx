@@ -0,0 +1,135 @@
+// Test legacy s-reps: a 3 x 5 s-rep written as .m3d reads back unchanged, and converting it to the new s-rep format
+// and back keeps every hub and spoke
+#include "vtkLegacySrep.h"
+
+#include <vtkMultiBlockDataSet.h>
+#include <vtkSmartPointer.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+// largest difference of the hubs and of the up, down and (on crest atoms) crest spokes of two legacy s-reps
+double LegacyDifference(const vtkLegacySrep& srep, const vtkLegacySrep& other)
+{
+    if(srep.GetNumberOfRows() != other.GetNumberOfRows() || srep.GetNumberOfColumns() != other.GetNumberOfColumns())
+    {
+        return 1;
+    }
+    double difference = 0;
+    for(int atom = 0; atom < srep.GetNumberOfAtoms(); ++atom)
+    {
+        if(srep.IsCrest(atom) != other.IsCrest(atom))
+        {
+            return 1;
+        }
+        for(int k = 0; k < 3; ++k)
+        {
+            difference = std::max(difference, std::fabs(srep.GetHubs()[3 * atom + k] - other.GetHubs()[3 * atom + k]));
+        }
+        int nSpokes = srep.IsCrest(atom) ? 3 : 2;
+        for(int s = 0; s < nSpokes; ++s)
+        {
+            difference = std::max(difference, std::fabs(srep.GetSpokeRadii()[3 * atom + s] - other.GetSpokeRadii()[3 * atom + s]));
+            for(int k = 0; k < 3; ++k)
+            {
+                difference = std::max(difference, std::fabs(srep.GetSpokeDirections()[9 * atom + 3 * s + k]
+                                                            - other.GetSpokeDirections()[9 * atom + 3 * s + k]));
+            }
+        }
+    }
+    return difference;
+}
+}
+
+int vtkLegacySrepTest1(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: vtkLegacySrepTest1 temporaryDirectory" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string directory = std::string(argv[1]) + "/vtkLegacySrepTest1";
+    vtksys::SystemTools::MakeDirectory(directory);
+
+    // one primitive as written by the legacy tools: ux, uy, uz hold the x, y, z coordinates of the three spokes
+    const char primitive[] =
+            "model {\n figureCount = 1;\n figure[0] {\n  numRows = 3;\n  numColumns = 3;\n  type = QuadFigure;\n"
+            "  primitive[1][2] {\n   type = EndPrimitive;\n   x = 1.5;\n   y = -2;\n   z = 0.25;\n"
+            "   ux[0] = 0;\n   ux[1] = 0;\n   ux[2] = 1;\n   uy[0] = 0.6;\n   uy[1] = -0.6;\n   uy[2] = 0;\n"
+            "   uz[0] = 0.8;\n   uz[1] = -0.8;\n   uz[2] = 0;\n   r[0] = 2;\n   r[1] = 3;\n   r[2] = 4;\n  }\n }\n}\n";
+    vtkLegacySrep parsed;
+    const double expected[9] = {0, 0.6, 0.8, 0, -0.6, -0.8, 1, 0, 0};
+    if(!parsed.ParseM3D(primitive, sizeof(primitive) - 1) || parsed.GetNumberOfRows() != 3 || parsed.GetNumberOfColumns() != 3
+            || parsed.GetHubs()[15] != 1.5 || parsed.GetHubs()[16] != -2 || parsed.GetHubs()[17] != 0.25
+            || parsed.GetSpokeRadii()[15] != 2 || parsed.GetSpokeRadii()[16] != 3 || parsed.GetSpokeRadii()[17] != 4)
+    {
+        std::cerr << "Cannot parse the hub and spoke lengths of primitive [1][2]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    for(int k = 0; k < 9; ++k)
+    {
+        if(parsed.GetSpokeDirections()[45 + k] != expected[k])
+        {
+            std::cerr << "Spoke direction value " << k << " of primitive [1][2] is " << parsed.GetSpokeDirections()[45 + k]
+                      << " instead of " << expected[k] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // 3 x 5 s-rep with distinct values everywhere
+    vtkLegacySrep srep;
+    srep.SetGridSize(3, 5);
+    for(int atom = 0; atom < srep.GetNumberOfAtoms(); ++atom)
+    {
+        srep.GetHubs()[3 * atom] = 0.5 * (atom % 5);
+        srep.GetHubs()[3 * atom + 1] = 0.5 * (atom / 5);
+        srep.GetHubs()[3 * atom + 2] = 0.1 * std::sin(1.0 * atom);
+        for(int s = 0; s < 3; ++s)
+        {
+            double angle = 0.3 * atom + 2.0 * s;
+            double tilt = s == vtkLegacySrep::UpSpoke ? 0.8 : (s == vtkLegacySrep::DownSpoke ? -0.8 : 0.0);
+            double planar = std::sqrt(1 - tilt * tilt);
+            srep.GetSpokeDirections()[9 * atom + 3 * s] = planar * std::cos(angle);
+            srep.GetSpokeDirections()[9 * atom + 3 * s + 1] = planar * std::sin(angle);
+            srep.GetSpokeDirections()[9 * atom + 3 * s + 2] = tilt;
+            srep.GetSpokeRadii()[3 * atom + s] = 1.0 + 0.01 * atom + 0.1 * s;
+        }
+    }
+
+    std::string fileName = directory + "/srep.m3d";
+    vtkLegacySrep read;
+    if(!srep.WriteM3D(fileName) || !read.ReadM3D(fileName))
+    {
+        std::cerr << "Cannot write and read back " << fileName << std::endl;
+        return EXIT_FAILURE;
+    }
+    double difference = LegacyDifference(srep, read);
+    if(difference != 0)
+    {
+        std::cerr << "The s-rep read back from " << fileName << " differs by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the new s-rep format keeps every hub and spoke, the crest points back on their atoms without shift
+    vtkSmartPointer<vtkMultiBlockDataSet> model = srep.ToSrepModel(0.0);
+    vtkLegacySrep converted;
+    if(!converted.FromSrepModel(model))
+    {
+        std::cerr << "Cannot convert the s-rep model back to a legacy s-rep" << std::endl;
+        return EXIT_FAILURE;
+    }
+    difference = LegacyDifference(srep, converted);
+    if(difference > 1e-12)
+    {
+        std::cerr << "The s-rep converted to the new format and back differs by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+// Test the storage of s-rep nodes: a node written by its default storage node reads back into another node with
+// the same s-rep, and a legacy m3d file reads into a node
+#include "vtkLegacySrep.h"
+#include "vtkMRMLSrepNode.h"
+#include "vtkMRMLSrepStorageNode.h"
+#include "vtkSrepModel.h"
+
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+// spokes of n hubs on a wavy sheet, of unit directions and lengths between 1 and 2
+vtkSmartPointer<vtkPolyData> NewSpokes(int n, double side)
+{
+    vtkNew<vtkPoints> hubs;
+    vtkNew<vtkPoints> tailHeadPairs;
+    for(int i = 0; i < n; ++i)
+    {
+        double hub[3] = {static_cast<double>(i % 5), static_cast<double>(i / 5), 0.1 * std::sin(1.0 * i)};
+        double direction[3] = {0.3 * std::cos(0.7 * i), 0.3 * std::sin(0.7 * i), side};
+        double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        double length = 1.0 + 0.1 * i;
+        double tip[3];
+        for(int k = 0; k < 3; ++k)
+        {
+            tip[k] = hub[k] + length * direction[k] / norm;
+        }
+        hubs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(tip);
+    }
+    return vtkSrepModel::NewSpokes(hubs.GetPointer(), tailHeadPairs.GetPointer());
+}
+
+// largest difference of the hubs, directions and lengths of two spoke polydata
+double SpokeDifference(vtkPolyData* spokes, vtkPolyData* other)
+{
+    if(other == NULL || spokes->GetNumberOfPoints() != other->GetNumberOfPoints())
+    {
+        return 1;
+    }
+    double difference = 0;
+    for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i)
+    {
+        double p[3], q[3], u[3], v[3];
+        spokes->GetPoint(i, p);
+        other->GetPoint(i, q);
+        spokes->GetPointData()->GetArray("spokeDirection")->GetTuple(i, u);
+        other->GetPointData()->GetArray("spokeDirection")->GetTuple(i, v);
+        for(int k = 0; k < 3; ++k)
+        {
+            difference = std::max(difference, std::max(std::fabs(p[k] - q[k]), std::fabs(u[k] - v[k])));
+        }
+        difference = std::max(difference, std::fabs(spokes->GetPointData()->GetArray("spokeLength")->GetTuple1(i)
+                                                    - other->GetPointData()->GetArray("spokeLength")->GetTuple1(i)));
+    }
+    return difference;
+}
+}
+
+int vtkMRMLSrepStorageNodeTest1(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: vtkMRMLSrepStorageNodeTest1 temporaryDirectory" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string directory = std::string(argv[1]) + "/vtkMRMLSrepStorageNodeTest1";
+    vtksys::SystemTools::MakeDirectory(directory);
+
+    // 3 x 5 grid, 12 crest spokes around it
+    vtkSmartPointer<vtkPolyData> up = NewSpokes(15, 1.0);
+    up->SetPolys(vtkSrepModel::NewQuadMesh(3, 5));
+    vtkSmartPointer<vtkPolyData> down = NewSpokes(15, -1.0);
+    down->SetPolys(vtkSrepModel::NewQuadMesh(3, 5));
+    vtkSmartPointer<vtkPolyData> crest = NewSpokes(12, 0.0);
+    crest->SetLines(vtkSrepModel::NewClosedPolyLine(12));
+    vtkNew<vtkMRMLSrepNode> srepNode;
+    srepNode->SetSrep(vtkSrepModel::New(up, down, crest, 3, 5));
+
+    vtkSmartPointer<vtkMRMLSrepStorageNode> storageNode = vtkSmartPointer<vtkMRMLSrepStorageNode>::Take(
+                vtkMRMLSrepStorageNode::SafeDownCast(srepNode->CreateDefaultStorageNode()));
+    std::string fileName = directory + "/srep." + storageNode->GetDefaultWriteFileExtension();
+    storageNode->SetFileName(fileName.c_str());
+    if(storageNode->WriteData(srepNode.GetPointer()) == 0)
+    {
+        std::cerr << "Cannot write the s-rep node to " << fileName << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    vtkNew<vtkMRMLSrepNode> readNode;
+    if(storageNode->ReadData(readNode.GetPointer()) == 0 || !vtkSrepModel::IsValid(readNode->GetSrep())
+            || vtkSrepModel::GetNumberOfRows(readNode->GetSrep()) != 3 || vtkSrepModel::GetNumberOfColumns(readNode->GetSrep()) != 5)
+    {
+        std::cerr << "Cannot read the 3 x 5 s-rep back from " << fileName << std::endl;
+        return EXIT_FAILURE;
+    }
+    double difference = std::max(SpokeDifference(up, vtkSrepModel::GetUpSpokes(readNode->GetSrep())),
+                                 std::max(SpokeDifference(down, vtkSrepModel::GetDownSpokes(readNode->GetSrep())),
+                                          SpokeDifference(crest, vtkSrepModel::GetCrestSpokes(readNode->GetSrep()))));
+    if(difference != 0)
+    {
+        std::cerr << "The s-rep read back from " << fileName << " differs by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // a legacy s-rep has its hubs on the skeletal grid, the up and down spokes are kept as they are
+    vtkLegacySrep legacySrep;
+    std::string legacyFileName = directory + "/srep.m3d";
+    if(!legacySrep.FromSrepModel(srepNode->GetSrep()) || !legacySrep.WriteM3D(legacyFileName))
+    {
+        std::cerr << "Cannot write the legacy s-rep " << legacyFileName << std::endl;
+        return EXIT_FAILURE;
+    }
+    vtkNew<vtkMRMLSrepNode> legacyNode;
+    storageNode->SetFileName(legacyFileName.c_str());
+    if(storageNode->ReadData(legacyNode.GetPointer()) == 0 || !vtkSrepModel::IsValid(legacyNode->GetSrep()))
+    {
+        std::cerr << "Cannot read the legacy s-rep " << legacyFileName << " into a node" << std::endl;
+        return EXIT_FAILURE;
+    }
+    difference = std::max(SpokeDifference(up, vtkSrepModel::GetUpSpokes(legacyNode->GetSrep())),
+                          SpokeDifference(down, vtkSrepModel::GetDownSpokes(legacyNode->GetSrep())));
+    if(difference > 1e-12)
+    {
+        std::cerr << "The legacy s-rep read into a node differs by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+// Test the narrow band signed distance field of a sphere: negative inside, the distance to the sphere in the band
+#include "vtkSignedDistanceField.h"
+#include "vtkTriangleBVH.h"
+
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+int vtkSignedDistanceFieldTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    // latitude-longitude sphere of radius 10, its facets stay within 0.02 of the sphere
+    const double radius = 10.0;
+    const int nTheta = 64;
+    const int nPhi = 64;
+    const double pi = 3.141592653589793;
+    vtkNew<vtkPoints> points;
+    points->InsertNextPoint(0, 0, radius);
+    for(int i = 1; i < nPhi; ++i)
+    {
+        double phi = pi * i / nPhi;
+        for(int j = 0; j < nTheta; ++j)
+        {
+            double theta = 2 * pi * j / nTheta;
+            points->InsertNextPoint(radius * std::sin(phi) * std::cos(theta), radius * std::sin(phi) * std::sin(theta),
+                                    radius * std::cos(phi));
+        }
+    }
+    points->InsertNextPoint(0, 0, -radius);
+    vtkIdType south = points->GetNumberOfPoints() - 1;
+    vtkNew<vtkCellArray> triangles;
+    for(int j = 0; j < nTheta; ++j)
+    {
+        vtkIdType next = (j + 1) % nTheta;
+        vtkIdType north[3] = {0, 1 + j, 1 + next};
+        triangles->InsertNextCell(3, north);
+        for(int i = 1; i < nPhi - 1; ++i)
+        {
+            vtkIdType a = 1 + (i - 1) * nTheta;
+            vtkIdType b = 1 + i * nTheta;
+            vtkIdType lower[3] = {a + j, b + j, b + next};
+            vtkIdType upper[3] = {a + j, b + next, a + next};
+            triangles->InsertNextCell(3, lower);
+            triangles->InsertNextCell(3, upper);
+        }
+        vtkIdType last = 1 + (nPhi - 2) * nTheta;
+        vtkIdType southCap[3] = {last + j, south, last + next};
+        triangles->InsertNextCell(3, southCap);
+    }
+    vtkNew<vtkPolyData> sphere;
+    sphere->SetPoints(points.GetPointer());
+    sphere->SetPolys(triangles.GetPointer());
+
+    vtkTriangleBVH boundary;
+    vtkSignedDistanceField field;
+    if(!boundary.Build(sphere.GetPointer()) || !field.Build(boundary, 0.25, 2.0) || field.IsEmpty())
+    {
+        std::cerr << "Cannot build the distance field of the sphere" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // points in the band at radii from 8.5 to 11.5 along a few directions
+    const double directions[4][3] = {{1, 0, 0}, {0, -1, 0}, {0.6, 0, 0.8}, {-0.48, 0.6, -0.64}};
+    for(int d = 0; d < 4; ++d)
+    {
+        for(double r = 8.5; r <= 11.5; r += 0.5)
+        {
+            double x[3] = {r * directions[d][0], r * directions[d][1], r * directions[d][2]};
+            double gradient[3];
+            double distance = field.Evaluate(x, gradient);
+            if(std::fabs(distance - (r - radius)) > 0.05)
+            {
+                std::cerr << "Signed distance " << distance << " at radius " << r << " instead of " << r - radius << std::endl;
+                return EXIT_FAILURE;
+            }
+            double alignment = 0;
+            for(int k = 0; k < 3; ++k)
+            {
+                alignment += gradient[k] * directions[d][k];
+            }
+            if(alignment < 0.99)
+            {
+                std::cerr << "Gradient at radius " << r << " is not radial: " << gradient[0] << " " << gradient[1]
+                          << " " << gradient[2] << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // beyond the band only the sign is exact
+    const double center[3] = {0, 0, 0};
+    const double far[3] = {20, 5, -3};
+    if(field.Evaluate(center, NULL) >= 0 || field.Evaluate(far, NULL) <= 0)
+    {
+        std::cerr << "Wrong sign beyond the band: " << field.Evaluate(center, NULL) << " at the center, "
+                  << field.Evaluate(far, NULL) << " outside" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
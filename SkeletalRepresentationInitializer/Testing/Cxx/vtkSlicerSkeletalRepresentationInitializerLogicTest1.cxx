@@ -0,0 +1,155 @@
+// Test the s-rep generated for an ellipsoid on a 21 x 41 grid: the hubs lie in the plane of its two longest axes
+// and the tips of the up and down spokes on the ellipsoid
+#include "vtkSlicerSkeletalRepresentationInitializerLogic.h"
+#include "vtkSrepIO.h"
+#include "vtkSrepModel.h"
+
+#include <vtkMRMLScene.h>
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+// largest |(x/rx)^2 + (y/ry)^2 + (z/rz)^2 - 1| of the spoke tips
+double TipDeviation(vtkPolyData* spokes, const double radii[3])
+{
+    double deviation = 0;
+    for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i)
+    {
+        double hub[3], direction[3];
+        spokes->GetPoint(i, hub);
+        spokes->GetPointData()->GetArray("spokeDirection")->GetTuple(i, direction);
+        double length = spokes->GetPointData()->GetArray("spokeLength")->GetTuple1(i);
+        double level = 0;
+        for(int k = 0; k < 3; ++k)
+        {
+            double tip = (hub[k] + length * direction[k]) / radii[k];
+            level += tip * tip;
+        }
+        deviation = std::max(deviation, std::fabs(level - 1));
+    }
+    return deviation;
+}
+}
+
+int vtkSlicerSkeletalRepresentationInitializerLogicTest1(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: vtkSlicerSkeletalRepresentationInitializerLogicTest1 temporaryDirectory" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string directory = std::string(argv[1]) + "/vtkSlicerSkeletalRepresentationInitializerLogicTest1";
+    vtksys::SystemTools::MakeDirectory(directory);
+
+    // latitude-longitude ellipsoid with radii 10, 6, 3 along x, y, z
+    const double radii[3] = {10.0, 6.0, 3.0};
+    const int nTheta = 128;
+    const int nPhi = 128;
+    const double pi = 3.141592653589793;
+    vtkNew<vtkPoints> points;
+    points->InsertNextPoint(0, 0, radii[2]);
+    for(int i = 1; i < nPhi; ++i)
+    {
+        double phi = pi * i / nPhi;
+        for(int j = 0; j < nTheta; ++j)
+        {
+            double theta = 2 * pi * j / nTheta;
+            points->InsertNextPoint(radii[0] * std::sin(phi) * std::cos(theta), radii[1] * std::sin(phi) * std::sin(theta),
+                                    radii[2] * std::cos(phi));
+        }
+    }
+    points->InsertNextPoint(0, 0, -radii[2]);
+    vtkIdType south = points->GetNumberOfPoints() - 1;
+    vtkNew<vtkCellArray> triangles;
+    for(int j = 0; j < nTheta; ++j)
+    {
+        vtkIdType next = (j + 1) % nTheta;
+        vtkIdType north[3] = {0, 1 + j, 1 + next};
+        triangles->InsertNextCell(3, north);
+        for(int i = 1; i < nPhi - 1; ++i)
+        {
+            vtkIdType a = 1 + (i - 1) * nTheta;
+            vtkIdType b = 1 + i * nTheta;
+            vtkIdType lower[3] = {a + j, b + j, b + next};
+            vtkIdType upper[3] = {a + j, b + next, a + next};
+            triangles->InsertNextCell(3, lower);
+            triangles->InsertNextCell(3, upper);
+        }
+        vtkIdType last = 1 + (nPhi - 2) * nTheta;
+        vtkIdType southCap[3] = {last + j, south, last + next};
+        triangles->InsertNextCell(3, southCap);
+    }
+    vtkNew<vtkPolyData> ellipsoid;
+    ellipsoid->SetPoints(points.GetPointer());
+    ellipsoid->SetPolys(triangles.GetPointer());
+
+    vtkNew<vtkMRMLScene> scene;
+    vtkNew<vtkSlicerSkeletalRepresentationInitializerLogic> logic;
+    logic->SetMRMLScene(scene.GetPointer());
+
+    const int nRows = 21;
+    const int nCols = 41;
+    std::string header = directory + "/header.xml";
+    if(logic->GenerateSrepForEllipsoid(ellipsoid.GetPointer(), nRows, nCols) != 0 || logic->WriteSrep(header) != 0)
+    {
+        std::cerr << "Cannot generate the s-rep of the ellipsoid" << std::endl;
+        return EXIT_FAILURE;
+    }
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSrepIO::ReadSrep(header);
+    if(srep == NULL || vtkSrepModel::GetNumberOfRows(srep) != nRows || vtkSrepModel::GetNumberOfColumns(srep) != nCols)
+    {
+        std::cerr << "The s-rep does not have a " << nRows << " x " << nCols << " grid" << std::endl;
+        return EXIT_FAILURE;
+    }
+    vtkPolyData* up = vtkSrepModel::GetUpSpokes(srep);
+    vtkPolyData* down = vtkSrepModel::GetDownSpokes(srep);
+    vtkPolyData* crest = vtkSrepModel::GetCrestSpokes(srep);
+    if(up->GetNumberOfPoints() != nRows * nCols || down->GetNumberOfPoints() != nRows * nCols
+            || crest->GetNumberOfPoints() != 2 * nRows + 2 * (nCols - 2))
+    {
+        std::cerr << up->GetNumberOfPoints() << " up, " << down->GetNumberOfPoints() << " down and "
+                  << crest->GetNumberOfPoints() << " crest spokes" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the hubs are shared by the up and down spokes, which mirror each other across the plane z = 0
+    for(vtkIdType i = 0; i < up->GetNumberOfPoints(); ++i)
+    {
+        double p[3], q[3], u[3], v[3];
+        up->GetPoint(i, p);
+        down->GetPoint(i, q);
+        up->GetPointData()->GetArray("spokeDirection")->GetTuple(i, u);
+        down->GetPointData()->GetArray("spokeDirection")->GetTuple(i, v);
+        if(std::fabs(p[2]) > 0.01 || std::fabs(p[0] - q[0]) + std::fabs(p[1] - q[1]) + std::fabs(p[2] - q[2]) > 1e-9
+                || std::fabs(u[0] - v[0]) + std::fabs(u[1] - v[1]) + std::fabs(u[2] + v[2]) > 1e-9)
+        {
+            std::cerr << "Up and down spoke " << i << " are not mirrored across the skeletal plane" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    // the fitted radii differ from the ones of the facets by the faceting error
+    double deviation = std::max(TipDeviation(up, radii), TipDeviation(down, radii));
+    if(deviation > 0.01)
+    {
+        std::cerr << "The spoke tips are off the ellipsoid by " << deviation << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+// Test the spoke interpolation of a wavy s-rep: at the nodes of the skeletal grid and of the fold curve the
+// interpolated spokes are the given spokes, also at crest positions wrapped around the fold curve and after a
+// spoke changed and its coefficients were updated
+#include "vtkSpokeInterpolator.h"
+#include "vtkSrepModel.h"
+
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+// spokes from the hubs along unit directions of varying lengths, all of them wavy in the spoke index
+vtkSmartPointer<vtkPolyData> NewSpokes(vtkPoints* hubs, double phase)
+{
+    vtkNew<vtkPoints> tailHeadPairs;
+    tailHeadPairs->SetDataTypeToDouble();
+    for(vtkIdType i = 0; i < hubs->GetNumberOfPoints(); ++i)
+    {
+        double hub[3];
+        hubs->GetPoint(i, hub);
+        double direction[3] = {std::sin(0.7 * i + phase), std::cos(1.3 * i + phase), 0.5 + std::sin(0.4 * i)};
+        double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        double length = 2 + std::cos(0.9 * i + phase);
+        double tip[3];
+        for(int k = 0; k < 3; ++k)
+        {
+            tip[k] = hub[k] + length * direction[k] / norm;
+        }
+        tailHeadPairs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(tip);
+    }
+    return vtkSrepModel::NewSpokes(hubs, tailHeadPairs.GetPointer());
+}
+
+// check that the interpolated spokes at the positions are the spokes ids of the block
+bool CheckNodes(const vtkSpokeInterpolator& interpolator, vtkMultiBlockDataSet* srep, int block,
+                const std::vector<double>& positions, const std::vector<vtkIdType>& ids)
+{
+    vtkIdType nQueries = static_cast<vtkIdType>(ids.size());
+    std::vector<double> hubs(3 * nQueries), directions(3 * nQueries), lengths(nQueries);
+    interpolator.Evaluate(block, &positions[0], nQueries, &hubs[0], &directions[0], &lengths[0]);
+    vtkPolyData* spokes = vtkPolyData::SafeDownCast(srep->GetBlock(block));
+    vtkDataArray* spokeDirections = spokes->GetPointData()->GetArray("spokeDirection");
+    vtkDataArray* spokeLengths = spokes->GetPointData()->GetArray("spokeLength");
+    for(vtkIdType q = 0; q < nQueries; ++q)
+    {
+        double hub[3], direction[3];
+        spokes->GetPoint(ids[q], hub);
+        spokeDirections->GetTuple(ids[q], direction);
+        double error = std::fabs(lengths[q] - spokeLengths->GetTuple1(ids[q]));
+        for(int k = 0; k < 3; ++k)
+        {
+            error = std::max(error, std::fabs(hubs[3 * q + k] - hub[k]));
+            error = std::max(error, std::fabs(directions[3 * q + k] - direction[k]));
+        }
+        if(error > 1e-12)
+        {
+            std::cerr << "Spoke " << ids[q] << " of block " << block << " is interpolated " << error
+                      << " away from the given spoke" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+int vtkSpokeInterpolatorTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    // 4 x 6 wavy skeletal grid and a fold curve around it
+    const int nRows = 4;
+    const int nCols = 6;
+    const int nCrest = 2 * (nRows + nCols) - 4;
+    vtkNew<vtkPoints> skeletalPoints;
+    skeletalPoints->SetDataTypeToDouble();
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
+        {
+            skeletalPoints->InsertNextPoint(c + 0.2 * std::sin(1.0 * r), r + 0.3 * std::cos(0.8 * c), 0.5 * std::sin(0.6 * r * c));
+        }
+    }
+    vtkNew<vtkPoints> foldPoints;
+    foldPoints->SetDataTypeToDouble();
+    for(int i = 0; i < nCrest; ++i)
+    {
+        double hub[3];
+        skeletalPoints->GetPoint(vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols), hub);
+        foldPoints->InsertNextPoint(hub[0] + 0.1 * std::cos(1.0 * i), hub[1] + 0.1 * std::sin(1.0 * i), hub[2]);
+    }
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSrepModel::New(NewSpokes(skeletalPoints.GetPointer(), 0.0),
+                                                                   NewSpokes(skeletalPoints.GetPointer(), 2.0),
+                                                                   NewSpokes(foldPoints.GetPointer(), 1.0),
+                                                                   nRows, nCols);
+
+    vtkSpokeInterpolator interpolator;
+    if(!interpolator.Update(srep))
+    {
+        std::cerr << "Cannot interpolate the s-rep" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // spoke (r, c) of the grid at (r, c)
+    std::vector<double> gridPositions;
+    std::vector<vtkIdType> gridIds;
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
+        {
+            gridPositions.push_back(r);
+            gridPositions.push_back(c);
+            gridIds.push_back(r * nCols + c);
+        }
+    }
+    // crest spoke i at i, at i - nCrest and at i + nCrest
+    std::vector<double> crestPositions;
+    std::vector<vtkIdType> crestIds;
+    for(int turn = -1; turn <= 1; ++turn)
+    {
+        for(int i = 0; i < nCrest; ++i)
+        {
+            crestPositions.push_back(i + turn * nCrest);
+            crestIds.push_back(i);
+        }
+    }
+    if(!CheckNodes(interpolator, srep, vtkSrepModel::UpBlock, gridPositions, gridIds)
+            || !CheckNodes(interpolator, srep, vtkSrepModel::DownBlock, gridPositions, gridIds)
+            || !CheckNodes(interpolator, srep, vtkSrepModel::CrestBlock, crestPositions, crestIds))
+    {
+        return EXIT_FAILURE;
+    }
+
+    // change an inner up spoke and a crest spoke and update only their coefficients
+    const vtkIdType upId = 1 * nCols + 2;
+    const vtkIdType crestId = nCrest - 1;
+    vtkPolyData* up = vtkSrepModel::GetUpSpokes(srep);
+    up->GetPoints()->SetPoint(upId, 1.5, 0.5, -1.0);
+    up->GetPointData()->GetArray("spokeLength")->SetTuple1(upId, 4.0);
+    vtkPolyData* crest = vtkSrepModel::GetCrestSpokes(srep);
+    double direction[3] = {0, 0, -1};
+    crest->GetPointData()->GetArray("spokeDirection")->SetTuple(crestId, direction);
+    if(!interpolator.UpdateSpoke(vtkSrepModel::UpBlock, upId) || !interpolator.UpdateSpoke(vtkSrepModel::CrestBlock, crestId))
+    {
+        std::cerr << "Cannot update the coefficients of a changed spoke" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(!CheckNodes(interpolator, srep, vtkSrepModel::UpBlock, gridPositions, gridIds)
+            || !CheckNodes(interpolator, srep, vtkSrepModel::CrestBlock, crestPositions, crestIds))
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+// Test the spoke refinement against a sphere: the tip of every spoke cast from a hub inside lands on the sphere
+// at the closed form distance along its direction, spoke directions are stored as unit vectors, and spokes
+// without direction or with a hub outside the sphere keep their length
+#include "vtkSpokeRefiner.h"
+#include "vtkTriangleBVH.h"
+#include "vtkSrepModel.h"
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+const double RADIUS = 10.0;
+
+// latitude-longitude sphere of radius 10, its facets stay within 0.02 of the sphere
+vtkSmartPointer<vtkPolyData> NewSphere()
+{
+    const int nTheta = 64;
+    const int nPhi = 64;
+    const double pi = 3.141592653589793;
+    vtkNew<vtkPoints> points;
+    points->InsertNextPoint(0, 0, RADIUS);
+    for(int i = 1; i < nPhi; ++i)
+    {
+        double phi = pi * i / nPhi;
+        for(int j = 0; j < nTheta; ++j)
+        {
+            double theta = 2 * pi * j / nTheta;
+            points->InsertNextPoint(RADIUS * std::sin(phi) * std::cos(theta), RADIUS * std::sin(phi) * std::sin(theta),
+                                    RADIUS * std::cos(phi));
+        }
+    }
+    points->InsertNextPoint(0, 0, -RADIUS);
+    vtkIdType south = points->GetNumberOfPoints() - 1;
+    vtkNew<vtkCellArray> triangles;
+    for(int j = 0; j < nTheta; ++j)
+    {
+        vtkIdType next = (j + 1) % nTheta;
+        vtkIdType north[3] = {0, 1 + j, 1 + next};
+        triangles->InsertNextCell(3, north);
+        for(int i = 1; i < nPhi - 1; ++i)
+        {
+            vtkIdType a = 1 + (i - 1) * nTheta;
+            vtkIdType b = 1 + i * nTheta;
+            vtkIdType lower[3] = {a + j, b + j, b + next};
+            vtkIdType upper[3] = {a + j, b + next, a + next};
+            triangles->InsertNextCell(3, lower);
+            triangles->InsertNextCell(3, upper);
+        }
+        vtkIdType last = 1 + (nPhi - 2) * nTheta;
+        vtkIdType southCap[3] = {last + j, south, last + next};
+        triangles->InsertNextCell(3, southCap);
+    }
+    vtkSmartPointer<vtkPolyData> sphere = vtkSmartPointer<vtkPolyData>::New();
+    sphere->SetPoints(points.GetPointer());
+    sphere->SetPolys(triangles.GetPointer());
+    return sphere;
+}
+
+// spokes of length 1 from the hubs along the directions, stored with twice their unit direction
+vtkSmartPointer<vtkPolyData> NewSpokes(const double (*hubs)[3], const double (*directions)[3], int n)
+{
+    vtkNew<vtkPoints> hubPoints;
+    vtkNew<vtkPoints> tailHeadPairs;
+    hubPoints->SetDataTypeToDouble();
+    tailHeadPairs->SetDataTypeToDouble();
+    for(int i = 0; i < n; ++i)
+    {
+        double norm = std::sqrt(directions[i][0] * directions[i][0] + directions[i][1] * directions[i][1]
+                + directions[i][2] * directions[i][2]);
+        double tip[3];
+        for(int k = 0; k < 3; ++k)
+        {
+            tip[k] = hubs[i][k] + directions[i][k] / norm;
+        }
+        hubPoints->InsertNextPoint(hubs[i]);
+        tailHeadPairs->InsertNextPoint(hubs[i]);
+        tailHeadPairs->InsertNextPoint(tip);
+    }
+    vtkSmartPointer<vtkPolyData> spokes = vtkSrepModel::NewSpokes(hubPoints.GetPointer(), tailHeadPairs.GetPointer());
+    vtkDataArray* spokeDirections = spokes->GetPointData()->GetArray("spokeDirection");
+    for(int i = 0; i < n; ++i)
+    {
+        double direction[3];
+        spokeDirections->GetTuple(i, direction);
+        for(int k = 0; k < 3; ++k)
+        {
+            direction[k] *= 2;
+        }
+        spokeDirections->SetTuple(i, direction);
+    }
+    return spokes;
+}
+
+// distance from a hub inside the sphere to the sphere along a unit direction
+double DistanceToSphere(const double hub[3], const double direction[3])
+{
+    double hd = hub[0] * direction[0] + hub[1] * direction[1] + hub[2] * direction[2];
+    double hh = hub[0] * hub[0] + hub[1] * hub[1] + hub[2] * hub[2];
+    return -hd + std::sqrt(hd * hd - hh + RADIUS * RADIUS);
+}
+}
+
+int vtkSpokeRefinerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    vtkTriangleBVH boundary;
+    if(!boundary.Build(NewSphere()))
+    {
+        std::cerr << "Cannot build the hierarchy of the sphere" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // 3 x 5 skeletal grid in the plane z = 0, up and down spokes tilted away from the z axis
+    const int nRows = 3;
+    const int nCols = 5;
+    double skeletalPoints[nRows * nCols][3];
+    double upDirections[nRows * nCols][3];
+    double downDirections[nRows * nCols][3];
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
+        {
+            int i = r * nCols + c;
+            skeletalPoints[i][0] = 2.0 * (c - 2);
+            skeletalPoints[i][1] = 2.0 * (r - 1);
+            skeletalPoints[i][2] = 0;
+            upDirections[i][0] = 0.1 * (c - 2);
+            upDirections[i][1] = 0.2 * (r - 1);
+            upDirections[i][2] = 1;
+            downDirections[i][0] = upDirections[i][0];
+            downDirections[i][1] = upDirections[i][1];
+            downDirections[i][2] = -1;
+        }
+    }
+    // crest spokes point away from the center of the grid, the first one starts outside the sphere
+    // and points through it
+    const int nCrest = 2 * (nRows + nCols) - 4;
+    double crestHubs[nCrest][3];
+    double crestDirections[nCrest][3];
+    for(int i = 0; i < nCrest; ++i)
+    {
+        const double* hub = skeletalPoints[vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols)];
+        for(int k = 0; k < 3; ++k)
+        {
+            crestHubs[i][k] = 1.2 * hub[k];
+            crestDirections[i][k] = hub[k];
+        }
+        crestDirections[i][2] = 0.5;
+    }
+    crestHubs[0][0] = 2 * RADIUS;
+    crestDirections[0][0] = -1;
+    crestDirections[0][1] = 0;
+    crestDirections[0][2] = 0;
+
+    vtkSmartPointer<vtkPolyData> up = NewSpokes(skeletalPoints, upDirections, nRows * nCols);
+    vtkSmartPointer<vtkPolyData> down = NewSpokes(skeletalPoints, downDirections, nRows * nCols);
+    vtkSmartPointer<vtkPolyData> crest = NewSpokes(crestHubs, crestDirections, nCrest);
+    // one spoke without direction
+    double zero[3] = {0, 0, 0};
+    down->GetPointData()->GetArray("spokeDirection")->SetTuple(7, zero);
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSrepModel::New(up, down, crest, nRows, nCols);
+
+    vtkIdType nRefined = vtkSpokeRefiner::RefineSpokeLengths(srep, boundary);
+    if(nRefined != 2 * nRows * nCols + nCrest - 2)
+    {
+        std::cerr << "Refined " << nRefined << " spokes instead of " << 2 * nRows * nCols + nCrest - 2 << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // every cast spoke ends on the sphere, along its original direction stored as a unit vector
+    const double (*directions[3])[3] = {upDirections, downDirections, crestDirections};
+    vtkPolyData* blocks[3] = {up, down, crest};
+    for(int b = 0; b < 3; ++b)
+    {
+        vtkDataArray* spokeDirections = blocks[b]->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengths = blocks[b]->GetPointData()->GetArray("spokeLength");
+        vtkDataArray* residuals = blocks[b]->GetPointData()->GetArray("spokeResidual");
+        if(residuals == NULL)
+        {
+            std::cerr << "Block " << b << " has no spoke residuals" << std::endl;
+            return EXIT_FAILURE;
+        }
+        for(vtkIdType i = 0; i < blocks[b]->GetNumberOfPoints(); ++i)
+        {
+            bool skipped = (b == 1 && i == 7) || (b == 2 && i == 0);
+            double length = lengths->GetTuple1(i);
+            double residual = residuals->GetTuple1(i);
+            if(skipped)
+            {
+                if(!std::isnan(residual) || std::fabs(length - 1.0) > 1e-12)
+                {
+                    std::cerr << "Spoke " << i << " of block " << b << " should keep its length, residual "
+                              << residual << " length " << length << std::endl;
+                    return EXIT_FAILURE;
+                }
+                continue;
+            }
+            double hub[3], direction[3];
+            blocks[b]->GetPoint(i, hub);
+            spokeDirections->GetTuple(i, direction);
+            const double* given = directions[b][i];
+            double givenNorm = std::sqrt(given[0] * given[0] + given[1] * given[1] + given[2] * given[2]);
+            for(int k = 0; k < 3; ++k)
+            {
+                if(std::fabs(direction[k] - given[k] / givenNorm) > 1e-12)
+                {
+                    std::cerr << "Spoke " << i << " of block " << b << " has no unit direction" << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+            double expected = DistanceToSphere(hub, direction);
+            if(std::fabs(length - expected) > 0.02 || std::fabs(residual - (length - 1.0)) > 1e-12)
+            {
+                std::cerr << "Spoke " << i << " of block " << b << " has length " << length << " instead of "
+                          << expected << ", residual " << residual << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    double maxResidual = 0, meanResidual = 0;
+    vtkSpokeRefiner::GetResidualStatistics(srep, maxResidual, meanResidual);
+    if(maxResidual < meanResidual || meanResidual <= 0 || maxResidual > RADIUS)
+    {
+        std::cerr << "Wrong residual statistics: max " << maxResidual << " mean " << meanResidual << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+// Test the new s-rep format: an s-rep written as header.xml and vtp files reads back with the same grid, hubs,
+// spokes and cells, under the default and under a named header
+#include "vtkSrepIO.h"
+#include "vtkSrepModel.h"
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkIdList.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+// spokes of n hubs on a wavy sheet, of unit directions and lengths between 1 and 2
+vtkSmartPointer<vtkPolyData> NewSpokes(int n, double side)
+{
+    vtkNew<vtkPoints> hubs;
+    vtkNew<vtkPoints> tailHeadPairs;
+    for(int i = 0; i < n; ++i)
+    {
+        double hub[3] = {static_cast<double>(i % 5), static_cast<double>(i / 5), 0.1 * std::sin(1.0 * i)};
+        double direction[3] = {0.3 * std::cos(0.7 * i), 0.3 * std::sin(0.7 * i), side};
+        double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        double length = 1.0 + 0.1 * i;
+        double tip[3];
+        for(int k = 0; k < 3; ++k)
+        {
+            tip[k] = hub[k] + length * direction[k] / norm;
+        }
+        hubs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(tip);
+    }
+    return vtkSrepModel::NewSpokes(hubs.GetPointer(), tailHeadPairs.GetPointer());
+}
+
+// true if the cells of two cell arrays list the same point ids
+bool SameCells(vtkCellArray* cells, vtkCellArray* other)
+{
+    if(cells->GetNumberOfCells() != other->GetNumberOfCells())
+    {
+        return false;
+    }
+    vtkNew<vtkIdList> ids;
+    vtkNew<vtkIdList> otherIds;
+    cells->InitTraversal();
+    other->InitTraversal();
+    while(cells->GetNextCell(ids.GetPointer()) && other->GetNextCell(otherIds.GetPointer()))
+    {
+        if(ids->GetNumberOfIds() != otherIds->GetNumberOfIds())
+        {
+            return false;
+        }
+        for(vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i)
+        {
+            if(ids->GetId(i) != otherIds->GetId(i))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// true if two spoke polydata have the same hubs, directions, lengths and cells
+bool SameSpokes(vtkPolyData* spokes, vtkPolyData* other)
+{
+    if(other == NULL || spokes->GetNumberOfPoints() != other->GetNumberOfPoints()
+            || !SameCells(spokes->GetPolys(), other->GetPolys()) || !SameCells(spokes->GetLines(), other->GetLines()))
+    {
+        return false;
+    }
+    for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i)
+    {
+        double p[3], q[3], u[3], v[3];
+        spokes->GetPoint(i, p);
+        other->GetPoint(i, q);
+        spokes->GetPointData()->GetArray("spokeDirection")->GetTuple(i, u);
+        other->GetPointData()->GetArray("spokeDirection")->GetTuple(i, v);
+        for(int k = 0; k < 3; ++k)
+        {
+            if(p[k] != q[k] || u[k] != v[k])
+            {
+                return false;
+            }
+        }
+        if(spokes->GetPointData()->GetArray("spokeLength")->GetTuple1(i)
+                != other->GetPointData()->GetArray("spokeLength")->GetTuple1(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+int vtkSrepIOTest1(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: vtkSrepIOTest1 temporaryDirectory" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string directory = std::string(argv[1]) + "/vtkSrepIOTest1";
+    vtksys::SystemTools::MakeDirectory(directory);
+
+    // 3 x 5 grid, 12 crest spokes around it
+    vtkSmartPointer<vtkPolyData> up = NewSpokes(15, 1.0);
+    up->SetPolys(vtkSrepModel::NewQuadMesh(3, 5));
+    vtkSmartPointer<vtkPolyData> down = NewSpokes(15, -1.0);
+    down->SetPolys(vtkSrepModel::NewQuadMesh(3, 5));
+    vtkSmartPointer<vtkPolyData> crest = NewSpokes(12, 0.0);
+    crest->SetLines(vtkSrepModel::NewClosedPolyLine(12));
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSrepModel::New(up, down, crest, 3, 5);
+
+    // header.xml gets up.vtp, ..., any other header its own prefixed spoke files in the same folder
+    const std::string headers[2] = {directory + "/header.xml", directory + "/hippo.srep.xml"};
+    const std::string upFiles[2] = {directory + "/up.vtp", directory + "/hippo_up.vtp"};
+    for(int h = 0; h < 2; ++h)
+    {
+        if(vtkSrepIO::GetSpokeFileName(headers[h], "up") != upFiles[h])
+        {
+            std::cerr << "The up spokes of " << headers[h] << " go to " << vtkSrepIO::GetSpokeFileName(headers[h], "up")
+                      << " instead of " << upFiles[h] << std::endl;
+            return EXIT_FAILURE;
+        }
+        if(!vtkSrepIO::WriteSrep(srep, headers[h]) || !vtksys::SystemTools::FileExists(upFiles[h], true))
+        {
+            std::cerr << "Cannot write " << headers[h] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    for(int h = 0; h < 2; ++h)
+    {
+        vtkSmartPointer<vtkMultiBlockDataSet> read = vtkSrepIO::ReadSrep(headers[h]);
+        if(read == NULL || vtkSrepModel::GetNumberOfRows(read) != 3 || vtkSrepModel::GetNumberOfColumns(read) != 5)
+        {
+            std::cerr << "Cannot read the 3 x 5 s-rep back from " << headers[h] << std::endl;
+            return EXIT_FAILURE;
+        }
+        if(!SameSpokes(up, vtkSrepModel::GetUpSpokes(read)) || !SameSpokes(down, vtkSrepModel::GetDownSpokes(read))
+                || !SameSpokes(crest, vtkSrepModel::GetCrestSpokes(read)))
+        {
+            std::cerr << "The spokes read from " << headers[h] << " differ from the ones written" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // an s-rep without spokes is not written
+    vtkNew<vtkMultiBlockDataSet> incomplete;
+    if(vtkSrepIO::WriteSrep(incomplete.GetPointer(), directory + "/incomplete.srep.xml")
+            || vtksys::SystemTools::FileExists(directory + "/incomplete.srep.xml", true))
+    {
+        std::cerr << "Wrote an incomplete s-rep" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,260 @@
+// Test the s-rep optimization on an ellipsoid: from spokes 10% too short and tilted, the cost decreases,
+// the spoke tips end on the ellipsoid and the fold curve keeps its offsets from the edge of the skeletal grid
+#include "vtkSignedDistanceField.h"
+#include "vtkSrepOptimizer.h"
+#include "vtkSrepModel.h"
+#include "vtkTriangleBVH.h"
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+const double RADII[3] = {6.0, 4.0, 2.0};
+
+// latitude-longitude ellipsoid of radii 6, 4 and 2
+vtkSmartPointer<vtkPolyData> NewEllipsoid()
+{
+    const int nTheta = 96;
+    const int nPhi = 64;
+    const double pi = 3.141592653589793;
+    vtkNew<vtkPoints> points;
+    points->SetDataTypeToDouble();
+    points->InsertNextPoint(0, 0, RADII[2]);
+    for(int i = 1; i < nPhi; ++i)
+    {
+        double phi = pi * i / nPhi;
+        for(int j = 0; j < nTheta; ++j)
+        {
+            double theta = 2 * pi * j / nTheta;
+            points->InsertNextPoint(RADII[0] * std::sin(phi) * std::cos(theta), RADII[1] * std::sin(phi) * std::sin(theta),
+                                    RADII[2] * std::cos(phi));
+        }
+    }
+    points->InsertNextPoint(0, 0, -RADII[2]);
+    vtkIdType south = points->GetNumberOfPoints() - 1;
+    vtkNew<vtkCellArray> triangles;
+    for(int j = 0; j < nTheta; ++j)
+    {
+        vtkIdType next = (j + 1) % nTheta;
+        vtkIdType north[3] = {0, 1 + j, 1 + next};
+        triangles->InsertNextCell(3, north);
+        for(int i = 1; i < nPhi - 1; ++i)
+        {
+            vtkIdType a = 1 + (i - 1) * nTheta;
+            vtkIdType b = 1 + i * nTheta;
+            vtkIdType lower[3] = {a + j, b + j, b + next};
+            vtkIdType upper[3] = {a + j, b + next, a + next};
+            triangles->InsertNextCell(3, lower);
+            triangles->InsertNextCell(3, upper);
+        }
+        vtkIdType last = 1 + (nPhi - 2) * nTheta;
+        vtkIdType southCap[3] = {last + j, south, last + next};
+        triangles->InsertNextCell(3, southCap);
+    }
+    vtkSmartPointer<vtkPolyData> ellipsoid = vtkSmartPointer<vtkPolyData>::New();
+    ellipsoid->SetPoints(points.GetPointer());
+    ellipsoid->SetPolys(triangles.GetPointer());
+    return ellipsoid;
+}
+
+// value of the ellipsoid function at x, sqrt(sum (x_k / r_k)^2) - 1, about the distance over the radius
+double EllipsoidFunction(const double x[3])
+{
+    double sum = 0;
+    for(int k = 0; k < 3; ++k)
+    {
+        sum += x[k] * x[k] / (RADII[k] * RADII[k]);
+    }
+    return std::sqrt(sum) - 1;
+}
+
+// distance from a point inside the ellipsoid to the ellipsoid along a unit direction
+double DistanceToEllipsoid(const double hub[3], const double direction[3])
+{
+    double a = 0, b = 0, c = -1;
+    for(int k = 0; k < 3; ++k)
+    {
+        double r2 = RADII[k] * RADII[k];
+        a += direction[k] * direction[k] / r2;
+        b += 2 * hub[k] * direction[k] / r2;
+        c += hub[k] * hub[k] / r2;
+    }
+    return (-b + std::sqrt(b * b - 4 * a * c)) / (2 * a);
+}
+
+// spokes from the hubs along the normalized directions, of 90% of the distance to the ellipsoid
+vtkSmartPointer<vtkPolyData> NewSpokes(vtkPoints* hubs, double (*directions)[3])
+{
+    vtkNew<vtkPoints> tailHeadPairs;
+    tailHeadPairs->SetDataTypeToDouble();
+    for(vtkIdType i = 0; i < hubs->GetNumberOfPoints(); ++i)
+    {
+        double hub[3], tip[3];
+        hubs->GetPoint(i, hub);
+        double* direction = directions[i];
+        double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        for(int k = 0; k < 3; ++k)
+        {
+            direction[k] /= norm;
+        }
+        double length = 0.9 * DistanceToEllipsoid(hub, direction);
+        for(int k = 0; k < 3; ++k)
+        {
+            tip[k] = hub[k] + length * direction[k];
+        }
+        tailHeadPairs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(tip);
+    }
+    return vtkSrepModel::NewSpokes(hubs, tailHeadPairs.GetPointer());
+}
+
+// largest distance of a spoke tip from the ellipsoid, as a fraction of the smallest radius
+double LargestTipError(vtkMultiBlockDataSet* srep)
+{
+    double largest = 0;
+    for(unsigned int b = 0; b < srep->GetNumberOfBlocks(); ++b)
+    {
+        vtkPolyData* spokes = vtkPolyData::SafeDownCast(srep->GetBlock(b));
+        vtkDataArray* directions = spokes->GetPointData()->GetArray("spokeDirection");
+        vtkDataArray* lengths = spokes->GetPointData()->GetArray("spokeLength");
+        for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i)
+        {
+            double tip[3], direction[3];
+            spokes->GetPoint(i, tip);
+            directions->GetTuple(i, direction);
+            double length = lengths->GetTuple1(i);
+            for(int k = 0; k < 3; ++k)
+            {
+                tip[k] += length * direction[k];
+            }
+            largest = std::max(largest, std::fabs(EllipsoidFunction(tip)));
+        }
+    }
+    return largest;
+}
+}
+
+int vtkSrepOptimizerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    vtkTriangleBVH boundary;
+    vtkSignedDistanceField field;
+    if(!boundary.Build(NewEllipsoid()) || !field.Build(boundary, 0.1, 0.8))
+    {
+        std::cerr << "Cannot build the distance field of the ellipsoid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // 5 x 9 skeletal grid inside the medial ellipse of the ellipsoid, slightly out of the plane z = 0
+    const int nRows = 5;
+    const int nCols = 9;
+    const int nSheet = nRows * nCols;
+    const int nFold = 2 * (nRows + nCols) - 4;
+    const double medialRadii[2] = {RADII[0] - RADII[2] * RADII[2] / RADII[0], RADII[1] - RADII[2] * RADII[2] / RADII[1]};
+    vtkNew<vtkPoints> skeletalPoints;
+    skeletalPoints->SetDataTypeToDouble();
+    double upDirections[nSheet][3];
+    double downDirections[nSheet][3];
+    for(int r = 0; r < nRows; ++r)
+    {
+        for(int c = 0; c < nCols; ++c)
+        {
+            int i = r * nCols + c;
+            double x = 0.8 * medialRadii[0] * (2.0 * c / (nCols - 1) - 1);
+            double y = 0.8 * medialRadii[1] * std::sqrt(1 - x * x / (medialRadii[0] * medialRadii[0])) * (2.0 * r / (nRows - 1) - 1);
+            skeletalPoints->InsertNextPoint(x, y, 0.05 * std::sin(1.0 * i));
+            upDirections[i][0] = 0.2 * std::sin(0.7 * i);
+            upDirections[i][1] = 0.2 * std::cos(0.7 * i);
+            upDirections[i][2] = 1;
+            downDirections[i][0] = 0.2 * std::cos(0.5 * i);
+            downDirections[i][1] = -0.2 * std::sin(0.5 * i);
+            downDirections[i][2] = -1;
+        }
+    }
+    // fold curve just outside the edge of the grid, crest spokes pointing out in the plane z = 0
+    vtkNew<vtkPoints> foldPoints;
+    foldPoints->SetDataTypeToDouble();
+    double crestDirections[nFold][3];
+    for(int i = 0; i < nFold; ++i)
+    {
+        double edge[3];
+        skeletalPoints->GetPoint(vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols), edge);
+        double outward[3] = {edge[0] / (medialRadii[0] * medialRadii[0]), edge[1] / (medialRadii[1] * medialRadii[1]), 0};
+        double norm = std::sqrt(outward[0] * outward[0] + outward[1] * outward[1]);
+        foldPoints->InsertNextPoint(edge[0] + 0.3 * outward[0] / norm, edge[1] + 0.3 * outward[1] / norm, edge[2]);
+        crestDirections[i][0] = outward[0] / norm;
+        crestDirections[i][1] = outward[1] / norm;
+        crestDirections[i][2] = 0.1 * std::sin(1.0 * i);
+    }
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = vtkSrepModel::New(NewSpokes(skeletalPoints.GetPointer(), upDirections),
+                                                                   NewSpokes(skeletalPoints.GetPointer(), downDirections),
+                                                                   NewSpokes(foldPoints.GetPointer(), crestDirections),
+                                                                   nRows, nCols);
+    // initial offsets of the fold hubs from their edge hubs
+    double offsets[nFold][3];
+    for(int i = 0; i < nFold; ++i)
+    {
+        double fold[3], edge[3];
+        foldPoints->GetPoint(i, fold);
+        skeletalPoints->GetPoint(vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols), edge);
+        for(int k = 0; k < 3; ++k)
+        {
+            offsets[i][k] = fold[k] - edge[k];
+        }
+    }
+    double initialError = LargestTipError(srep);
+
+    vtkSrepOptimizer optimizer;
+    if(!optimizer.Optimize(srep, field))
+    {
+        std::cerr << "The optimization failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(optimizer.GetNumberOfIterations() < 1 || !(optimizer.GetFinalCost() < 0.1 * optimizer.GetInitialCost()))
+    {
+        std::cerr << "The cost went from " << optimizer.GetInitialCost() << " to " << optimizer.GetFinalCost()
+                  << " in " << optimizer.GetNumberOfIterations() << " iterations" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the tips end on the ellipsoid
+    double finalError = LargestTipError(srep);
+    if(finalError > 0.01 || finalError > 0.5 * initialError)
+    {
+        std::cerr << "The spoke tips are " << finalError << " off the ellipsoid, from " << initialError << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the fold hubs keep their offsets from the edge hubs
+    vtkPolyData* sheet = vtkSrepModel::GetUpSpokes(srep);
+    vtkPolyData* fold = vtkSrepModel::GetCrestSpokes(srep);
+    for(int i = 0; i < nFold; ++i)
+    {
+        double foldHub[3], edgeHub[3];
+        fold->GetPoint(i, foldHub);
+        sheet->GetPoint(vtkSrepModel::GetCrestSkeletalPoint(i, nRows, nCols), edgeHub);
+        double drift = 0;
+        for(int k = 0; k < 3; ++k)
+        {
+            double d = foldHub[k] - edgeHub[k] - offsets[i][k];
+            drift += d * d;
+        }
+        if(std::sqrt(drift) > 0.05)
+        {
+            std::cerr << "Fold hub " << i << " moved " << std::sqrt(drift) << " away from its edge hub" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
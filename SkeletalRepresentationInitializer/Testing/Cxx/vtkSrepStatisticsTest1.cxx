@@ -0,0 +1,283 @@
+// Test the statistics of a cohort of identical s-reps: the mean is the s-rep and every variance is 0
+// Then of a cohort of s-reps shifted, rotated and scaled symmetrically about a base s-rep: the mean is the
+// base s-rep, the variances have closed forms, and they do not depend on how the files are split into blocks,
+// from a single file to more files than blocks
+#include "vtkSrepIO.h"
+#include "vtkSrepModel.h"
+#include "vtkSrepStatistics.h"
+
+#include <vtkDataArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// vtk system tools
+#include <vtksys/SystemTools.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// spokes of n hubs on a wavy sheet, of unit directions and lengths between 1 and 2; the hubs can be shifted
+// along x, the directions rotated by an angle along the great circle through z and the lengths scaled by
+// the exponential of logScale
+vtkSmartPointer<vtkPolyData> NewSpokes(int n, double side, double shift = 0, double angle = 0, double logScale = 0)
+{
+    vtkNew<vtkPoints> hubs;
+    vtkNew<vtkPoints> tailHeadPairs;
+    hubs->SetDataTypeToDouble();
+    tailHeadPairs->SetDataTypeToDouble();
+    for(int i = 0; i < n; ++i)
+    {
+        double hub[3] = {i % 3 + shift, static_cast<double>(i / 3), 0.1 * std::sin(1.0 * i)};
+        double direction[3] = {0.3 * std::cos(0.7 * i), 0.3 * std::sin(0.7 * i), side};
+        double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        // unit vector orthogonal to the direction in the plane of the direction and z
+        double orthogonal[3] = {-direction[0] * direction[2], -direction[1] * direction[2],
+                                direction[0] * direction[0] + direction[1] * direction[1]};
+        double orthogonalNorm = std::sqrt(orthogonal[0] * orthogonal[0] + orthogonal[1] * orthogonal[1]
+                + orthogonal[2] * orthogonal[2]);
+        double length = (1.0 + 0.1 * i) * std::exp(logScale);
+        double tip[3];
+        for(int k = 0; k < 3; ++k)
+        {
+            tip[k] = hub[k] + length * (std::cos(angle) * direction[k] / norm + std::sin(angle) * orthogonal[k] / orthogonalNorm);
+        }
+        hubs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(hub);
+        tailHeadPairs->InsertNextPoint(tip);
+    }
+    return vtkSrepModel::NewSpokes(hubs.GetPointer(), tailHeadPairs.GetPointer());
+}
+
+// s-rep on a 3 x 3 grid with 8 crest spokes around it, see NewSpokes
+vtkSmartPointer<vtkMultiBlockDataSet> NewSrep(double shift = 0, double angle = 0, double logScale = 0)
+{
+    vtkSmartPointer<vtkPolyData> up = NewSpokes(9, 1.0, shift, angle, logScale);
+    up->SetPolys(vtkSrepModel::NewQuadMesh(3, 3));
+    vtkSmartPointer<vtkPolyData> down = NewSpokes(9, -1.0, shift, angle, logScale);
+    down->SetPolys(vtkSrepModel::NewQuadMesh(3, 3));
+    vtkSmartPointer<vtkPolyData> crest = NewSpokes(8, 0.0, shift, angle, logScale);
+    crest->SetLines(vtkSrepModel::NewClosedPolyLine(8));
+    return vtkSrepModel::New(up, down, crest, 3, 3);
+}
+
+// largest difference of the hubs, directions and lengths of two spoke polydata
+double SpokeDifference(vtkPolyData* spokes, vtkPolyData* other)
+{
+    if(spokes->GetNumberOfPoints() != other->GetNumberOfPoints())
+    {
+        return 1;
+    }
+    double difference = 0;
+    for(vtkIdType i = 0; i < spokes->GetNumberOfPoints(); ++i)
+    {
+        double p[3], q[3], u[3], v[3];
+        spokes->GetPoint(i, p);
+        other->GetPoint(i, q);
+        spokes->GetPointData()->GetArray("spokeDirection")->GetTuple(i, u);
+        other->GetPointData()->GetArray("spokeDirection")->GetTuple(i, v);
+        for(int k = 0; k < 3; ++k)
+        {
+            difference = std::max(difference, std::max(std::fabs(p[k] - q[k]), std::fabs(u[k] - v[k])));
+        }
+        difference = std::max(difference, std::fabs(spokes->GetPointData()->GetArray("spokeLength")->GetTuple1(i)
+                                                    - other->GetPointData()->GetArray("spokeLength")->GetTuple1(i)));
+    }
+    return difference;
+}
+
+// largest difference of the mean s-reps and of the variances of two statistics
+double StatisticsDifference(const vtkSrepStatistics& statistics, const vtkSrepStatistics& other)
+{
+    vtkSmartPointer<vtkMultiBlockDataSet> mean = statistics.NewMeanSrep();
+    vtkSmartPointer<vtkMultiBlockDataSet> otherMean = other.NewMeanSrep();
+    double difference = 0;
+    for(int b = 0; b < 3; ++b)
+    {
+        difference = std::max(difference, SpokeDifference(vtkPolyData::SafeDownCast(mean->GetBlock(b)),
+                                                          vtkPolyData::SafeDownCast(otherMean->GetBlock(b))));
+    }
+    vtkSmartPointer<vtkPolyData> variances = statistics.NewStatistics();
+    vtkSmartPointer<vtkPolyData> otherVariances = other.NewStatistics();
+    const char* names[3] = {"hubVariance", "directionVariance", "logLengthVariance"};
+    for(int a = 0; a < 3; ++a)
+    {
+        vtkDataArray* variance = variances->GetPointData()->GetArray(names[a]);
+        vtkDataArray* otherVariance = otherVariances->GetPointData()->GetArray(names[a]);
+        for(vtkIdType i = 0; i < variance->GetNumberOfTuples(); ++i)
+        {
+            difference = std::max(difference, std::fabs(variance->GetTuple1(i) - otherVariance->GetTuple1(i)));
+        }
+    }
+    return difference;
+}
+}
+
+int vtkSrepStatisticsTest1(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: vtkSrepStatisticsTest1 temporaryDirectory" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string directory = std::string(argv[1]) + "/vtkSrepStatisticsTest1";
+    vtksys::SystemTools::MakeDirectory(directory);
+
+    vtkSmartPointer<vtkMultiBlockDataSet> srep = NewSrep();
+    vtkPolyData* up = vtkSrepModel::GetUpSpokes(srep);
+    vtkPolyData* down = vtkSrepModel::GetDownSpokes(srep);
+    vtkPolyData* crest = vtkSrepModel::GetCrestSpokes(srep);
+    std::vector<std::string> fileNames;
+    for(int s = 0; s < 4; ++s)
+    {
+        fileNames.push_back(directory + "/sample" + std::string(1, static_cast<char>('0' + s)) + ".srep.xml");
+        if(!vtkSrepIO::WriteSrep(srep, fileNames.back()))
+        {
+            std::cerr << "Cannot write " << fileNames.back() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    vtkSrepStatistics statistics;
+    statistics.SetNumberOfRefinementPasses(5);
+    if(!statistics.Compute(fileNames) || statistics.GetNumberOfSamples() != 4 || !statistics.GetRejectedFiles().empty())
+    {
+        std::cerr << "Statistics of " << statistics.GetNumberOfSamples() << " s-reps, " << statistics.GetRejectedFiles().size()
+                  << " rejected, instead of 4 s-reps" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // the direction means do not move in the first refinement pass
+    if(statistics.GetNumberOfPasses() != 2)
+    {
+        std::cerr << "Ran " << statistics.GetNumberOfPasses() << " passes instead of 2" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    vtkSmartPointer<vtkMultiBlockDataSet> mean = statistics.NewMeanSrep();
+    double difference = std::max(SpokeDifference(vtkSrepModel::GetUpSpokes(mean), up),
+                                 std::max(SpokeDifference(vtkSrepModel::GetDownSpokes(mean), down),
+                                          SpokeDifference(vtkSrepModel::GetCrestSpokes(mean), crest)));
+    if(difference > 1e-9)
+    {
+        std::cerr << "The mean s-rep differs from the s-reps by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+    vtkSmartPointer<vtkPolyData> variances = statistics.NewStatistics();
+    const char* names[3] = {"hubVariance", "directionVariance", "logLengthVariance"};
+    for(int a = 0; a < 3; ++a)
+    {
+        vtkDataArray* variance = variances->GetPointData()->GetArray(names[a]);
+        for(vtkIdType i = 0; variance != NULL && i < variance->GetNumberOfTuples(); ++i)
+        {
+            if(std::fabs(variance->GetTuple1(i)) > 1e-12)
+            {
+                std::cerr << names[a] << " of spoke " << i << " is " << variance->GetTuple1(i) << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        if(variance == NULL || variance->GetNumberOfTuples() != 26)
+        {
+            std::cerr << "No " << names[a] << " for every spoke" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // 70 s-reps, more than the blocks of files: sample s is shifted by 0.05 c, rotated by 0.02 c and scaled by
+    // exp(0.01 c) with c = s - 34.5, so the means are those of the base s-rep and the variances are the
+    // squares of the steps times the mean of c^2, (70^2 - 1) / 12
+    const int nSamples = 70;
+    std::vector<std::string> cohort;
+    for(int s = 0; s < nSamples; ++s)
+    {
+        double c = s - 0.5 * (nSamples - 1);
+        std::ostringstream fileName;
+        fileName << directory << "/cohort" << s << ".srep.xml";
+        cohort.push_back(fileName.str());
+        if(!vtkSrepIO::WriteSrep(NewSrep(0.05 * c, 0.02 * c, 0.01 * c), cohort.back()))
+        {
+            std::cerr << "Cannot write " << cohort.back() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    vtkSrepStatistics cohortStatistics;
+    if(!cohortStatistics.Compute(cohort) || cohortStatistics.GetNumberOfSamples() != nSamples)
+    {
+        std::cerr << "Statistics of " << cohortStatistics.GetNumberOfSamples() << " s-reps instead of " << nSamples << std::endl;
+        return EXIT_FAILURE;
+    }
+    vtkSmartPointer<vtkMultiBlockDataSet> base = NewSrep();
+    vtkSmartPointer<vtkMultiBlockDataSet> cohortMean = cohortStatistics.NewMeanSrep();
+    for(int b = 0; b < 3; ++b)
+    {
+        difference = SpokeDifference(vtkPolyData::SafeDownCast(cohortMean->GetBlock(b)), vtkPolyData::SafeDownCast(base->GetBlock(b)));
+        if(difference > 1e-9)
+        {
+            std::cerr << "Block " << b << " of the mean s-rep differs from the base s-rep by " << difference << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    double meanSquare = (nSamples * nSamples - 1) / 12.0;
+    double expected[3] = {0.05 * 0.05 * meanSquare, 0.02 * 0.02 * meanSquare, 0.01 * 0.01 * meanSquare};
+    variances = cohortStatistics.NewStatistics();
+    for(int a = 0; a < 3; ++a)
+    {
+        vtkDataArray* variance = variances->GetPointData()->GetArray(names[a]);
+        for(vtkIdType i = 0; i < variance->GetNumberOfTuples(); ++i)
+        {
+            if(std::fabs(variance->GetTuple1(i) - expected[a]) > 1e-9 * expected[a])
+            {
+                std::cerr << names[a] << " of spoke " << i << " is " << variance->GetTuple1(i) << " instead of "
+                          << expected[a] << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // every file listed twice gives the same statistics from blocks of other files
+    std::vector<std::string> twice(cohort);
+    twice.insert(twice.end(), cohort.begin(), cohort.end());
+    vtkSrepStatistics twiceStatistics;
+    if(!twiceStatistics.Compute(twice) || twiceStatistics.GetNumberOfSamples() != 2 * nSamples)
+    {
+        std::cerr << "Statistics of " << twiceStatistics.GetNumberOfSamples() << " s-reps instead of " << 2 * nSamples << std::endl;
+        return EXIT_FAILURE;
+    }
+    difference = StatisticsDifference(cohortStatistics, twiceStatistics);
+    if(difference > 1e-12)
+    {
+        std::cerr << "Listing every file twice changes the statistics by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+    // and so does a cohort of a single file and of that file 70 times
+    vtkSrepStatistics single;
+    vtkSrepStatistics repeated;
+    if(!single.Compute(std::vector<std::string>(1, cohort[0])) || !repeated.Compute(std::vector<std::string>(nSamples, cohort[0])))
+    {
+        std::cerr << "Cannot compute the statistics of a single s-rep" << std::endl;
+        return EXIT_FAILURE;
+    }
+    difference = StatisticsDifference(single, repeated);
+    if(difference > 1e-12)
+    {
+        std::cerr << "Repeating a single file changes the statistics by " << difference << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // no s-rep to compute the statistics of
+    vtkSrepStatistics empty;
+    if(empty.Compute(std::vector<std::string>()))
+    {
+        std::cerr << "Computed the statistics of an empty cohort" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+// Test the validity checks: two crossing triangles of a mesh and two crossing spokes of an s-rep are found
+#include "vtkSrepModel.h"
+#include "vtkValidityChecker.h"
+
+#include <vtkCellArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+// spokes from every hub to its tip
+vtkSmartPointer<vtkPolyData> NewSpokes(const double hubs[][3], const double tips[][3], int n)
+{
+    vtkNew<vtkPoints> hubPoints;
+    vtkNew<vtkPoints> tailHeadPairs;
+    for(int i = 0; i < n; ++i)
+    {
+        hubPoints->InsertNextPoint(hubs[i]);
+        tailHeadPairs->InsertNextPoint(hubs[i]);
+        tailHeadPairs->InsertNextPoint(tips[i]);
+    }
+    return vtkSrepModel::NewSpokes(hubPoints.GetPointer(), tailHeadPairs.GetPointer());
+}
+
+// a triangle in the plane z = 0, a triangle sharing its long edge and a vertical triangle through
+// the first one at height offset
+vtkSmartPointer<vtkPolyData> NewTriangles(double offset)
+{
+    const double coords[7][3] = {{0, 0, 0}, {2, 0, 0}, {0, 2, 0},
+                                 {0.5, 0.5, offset - 1}, {0.5, 0.5, offset + 1}, {1, 0.5, offset},
+                                 {2, 2, 0}};
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    for(int i = 0; i < 7; ++i)
+    {
+        points->InsertNextPoint(coords[i]);
+    }
+    vtkSmartPointer<vtkCellArray> triangles = vtkSmartPointer<vtkCellArray>::New();
+    const vtkIdType cells[3][3] = {{0, 1, 2}, {3, 4, 5}, {1, 6, 2}};
+    for(int i = 0; i < 3; ++i)
+    {
+        triangles->InsertNextCell(3, cells[i]);
+    }
+    vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+    mesh->SetPoints(points);
+    mesh->SetPolys(triangles);
+    return mesh;
+}
+
+// s-rep of a 1 x 2 grid whose up spokes cross when crossing is true, and lean outwards otherwise
+vtkSmartPointer<vtkMultiBlockDataSet> NewSrep(bool crossing)
+{
+    const double gridHubs[2][3] = {{0, 0, 0}, {2, 0, 0}};
+    const double upTips[2][3] = {{crossing ? 2.0 : -1.0, 0, 2}, {crossing ? 0.0 : 3.0, 0, 2}};
+    const double downTips[2][3] = {{0, 0, -2}, {2, 0, -2}};
+    const double crestHubs[2][3] = {{-1, 0, 0}, {3, 0, 0}};
+    const double crestTips[2][3] = {{-3, 0, 0}, {5, 0, 0}};
+    return vtkSrepModel::New(NewSpokes(gridHubs, upTips, 2), NewSpokes(gridHubs, downTips, 2),
+                             NewSpokes(crestHubs, crestTips, 2), 1, 2);
+}
+}
+
+int vtkValidityCheckerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+    vtkValidityChecker::PairList pairs;
+    vtkIdType nPairs = vtkValidityChecker::FindSelfIntersections(NewTriangles(0), &pairs);
+    if(nPairs != 1 || pairs[0].first != 0 || pairs[0].second != 1)
+    {
+        std::cerr << "Found " << nPairs << " intersecting pairs of triangles instead of cells 0 and 1" << std::endl;
+        return EXIT_FAILURE;
+    }
+    nPairs = vtkValidityChecker::FindSelfIntersections(NewTriangles(2), &pairs);
+    if(nPairs != 0)
+    {
+        std::cerr << "Found " << nPairs << " intersecting pairs of separate triangles" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // spokes are numbered up, then down, then crest
+    nPairs = vtkValidityChecker::FindSpokeCrossings(NewSrep(true), 1e-3, &pairs);
+    if(nPairs != 1 || pairs[0].first != 0 || pairs[0].second != 1)
+    {
+        std::cerr << "Found " << nPairs << " pairs of crossing spokes instead of up spokes 0 and 1" << std::endl;
+        return EXIT_FAILURE;
+    }
+    nPairs = vtkValidityChecker::FindSpokeCrossings(NewSrep(false), 1e-3, &pairs);
+    if(nPairs != 0)
+    {
+        std::cerr << "Found " << nPairs << " pairs of crossing spokes in an s-rep without crossing" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -18,6 +18,13 @@
 // SkeletalRepresentationInitializer Logic includes
 #include <vtkSlicerSkeletalRepresentationInitializerLogic.h>
 
+// DisplayableManager initialization
+#include <vtkAutoInit.h>
+VTK_MODULE_INIT(vtkSlicerSkeletalRepresentationInitializerModuleMRMLDisplayableManager)
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLThreeDViewDisplayableManagerFactory.h>
+
 // SkeletalRepresentationInitializer includes
 #include "qSlicerSkeletalRepresentationInitializerModule.h"
 #include "qSlicerSkeletalRepresentationInitializerModuleWidget.h"
@@ -101,6 +108,8 @@ QStringList qSlicerSkeletalRepresentationInitializerModule::dependencies() const
 void qSlicerSkeletalRepresentationInitializerModule::setup()
 {
   this->Superclass::setup();
+  // s-rep nodes are rendered in 3D views by their own displayable manager
+  vtkMRMLThreeDViewDisplayableManagerFactory::GetInstance()->RegisterDisplayableManager("vtkMRMLSrepDisplayableManager");
 }
 
 //-----------------------------------------------------------------------------
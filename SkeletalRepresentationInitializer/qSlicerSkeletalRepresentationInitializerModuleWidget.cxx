@@ -25,6 +25,9 @@
 // module logic file
 #include "vtkSlicerSkeletalRepresentationInitializerLogic.h"
 
+// MRML includes
+#include <vtkMRMLScene.h>
+
 #include <QFileDialog>
 #include <QMessageBox>
 
@@ -141,11 +144,22 @@ void qSlicerSkeletalRepresentationInitializerModuleWidget::inklingFlow()
 void qSlicerSkeletalRepresentationInitializerModuleWidget::backwardFlow()
 {
     Q_D(qSlicerSkeletalRepresentationInitializerModuleWidget);
-    std::string filePath;
-    d->logic()->DummyBackwardFlow(filePath);
-
-    std::string msg("The result can be visualized with visualizer module. The result has been save to: ");
-    msg += filePath;
+    d->logic()->SetSequentialBackwardFlow(d->cb_sequential_backward_flow->isChecked());
+    d->logic()->SetKeyframeTolerance(d->sl_keyframe_tolerance->value());
+    d->logic()->SetLandmarkErrorTarget(d->sl_landmark_error_target->value());
+    d->logic()->SetCorrespondenceBackwardFlow(d->cb_correspondence_backward_flow->isChecked());
+    d->logic()->SetRefineSpokeLengths(d->cb_refine_spoke_lengths->isChecked());
+    d->logic()->SetOptimizeSrep(d->cb_optimize_srep->isChecked());
+    std::string nodeID;
+    if(d->logic()->BackwardFlow(nodeID) != 0)
+    {
+        QMessageBox::warning(this, "Skeletal Representation Initializer", "The backward flow failed, see the application log for details.");
+        return;
+    }
+
+    std::string msg("The s-rep has been added to the scene: ");
+    vtkMRMLNode* srepNode = this->mrmlScene()->GetNodeByID(nodeID);
+    msg += (srepNode != NULL && srepNode->GetName() != NULL) ? srepNode->GetName() : nodeID;
     QMessageBox msgBox;
     msgBox.setText(msg.c_str());
     msgBox.exec();
@@ -154,11 +168,16 @@ void qSlicerSkeletalRepresentationInitializerModuleWidget::backwardFlow()
 void qSlicerSkeletalRepresentationInitializerModuleWidget::generateSrep()
 {
     Q_D(qSlicerSkeletalRepresentationInitializerModuleWidget);
-    std::string filePath;
-    d->logic()->GenerateSrep(filePath);
-
-    std::string msg("The result can be visualized with visualizer module. The result has been save to: ");
-    msg += filePath;
+    std::string nodeID;
+    if(d->logic()->GenerateSrep(nodeID) != 0)
+    {
+        QMessageBox::warning(this, "Skeletal Representation Initializer", "The s-rep could not be generated, see the application log for details.");
+        return;
+    }
+
+    std::string msg("The s-rep has been added to the scene: ");
+    vtkMRMLNode* srepNode = this->mrmlScene()->GetNodeByID(nodeID);
+    msg += (srepNode != NULL && srepNode->GetName() != NULL) ? srepNode->GetName() : nodeID;
     QMessageBox msgBox;
     msgBox.setText(msg.c_str());
     msgBox.exec();
@@ -2,7 +2,6 @@ import vtk, qt, ctk, slicer
 import os
 import logging
 import math
-import xml.etree.ElementTree as ET
 from slicer.ScriptedLoadableModule import (ScriptedLoadableModule, ScriptedLoadableModuleWidget,
                                            ScriptedLoadableModuleLogic, ScriptedLoadableModuleTest)
 from LegacyTransformer.legacyTransformer import legacyTransformer as transformer
@@ -20,7 +19,7 @@ class SkeletalRepresentationVisualizer(ScriptedLoadableModule):
         ScriptedLoadableModule.__init__(self, parent)
         self.parent.title = "Skeletal Representation Visualizer"
         self.parent.categories = ["Skeleton, topology"]
-        self.parent.dependencies = []
+        self.parent.dependencies = ["SkeletalRepresentationInitializer"]
         self.parent.contributors = ["Zhiyuan Liu, Junpyo Hong, Pablo Hernandez-Cerdan"]
         self.parent.helpText = """
     Given an header.xml or a .m3d (legacy) file with a Skeletal Representation, visualize it.
@@ -52,6 +51,8 @@ class SkeletalRepresentationVisualizerWidget(ScriptedLoadableModuleWidget):
         self.inputFileLabelHeader.text = "Input File: "
         self.inputFileLabelFile = qt.QLabel()
         self.inputFileLabelFile.text = "Input header.xml or .m3d"
+        # file of the s-rep node last loaded, Apply shows that node again instead of reading the file again
+        self.loadedFilename = None
         self.inputFileButton = qt.QPushButton()
         self.inputFileButton.text = "Browse"
         self.inputFileLayout.addWidget(self.inputFileLabelHeader)
@@ -59,6 +60,20 @@ class SkeletalRepresentationVisualizerWidget(ScriptedLoadableModuleWidget):
         self.inputFileLayout.addWidget(self.inputFileButton)
         self.layout.addLayout(self.inputFileLayout)
 
+        # or an s-rep node of the scene, e.g. the s-rep generated by the initializer
+        self.inputNodeLayout = qt.QFormLayout()
+        self.inputSrepSelector = slicer.qMRMLNodeComboBox()
+        self.inputSrepSelector.nodeTypes = ["vtkMRMLSrepNode"]
+        self.inputSrepSelector.selectNodeUponCreation = True
+        self.inputSrepSelector.addEnabled = False
+        self.inputSrepSelector.removeEnabled = False
+        self.inputSrepSelector.noneEnabled = True
+        self.inputSrepSelector.showHidden = False
+        self.inputSrepSelector.setMRMLScene(slicer.mrmlScene)
+        self.inputSrepSelector.setToolTip("S-rep node to visualize, a file is loaded into a new s-rep node")
+        self.inputNodeLayout.addRow("Input s-rep node: ", self.inputSrepSelector)
+        self.layout.addLayout(self.inputNodeLayout)
+
         #
         # Parameters Area
         #
@@ -123,6 +138,7 @@ class SkeletalRepresentationVisualizerWidget(ScriptedLoadableModuleWidget):
 
         # Show the filename in the label.
         self.inputFileLabelFile.text = filename
+        self.loadedFilename = None
 
         if filename.endswith('.m3d'):
             self.parametersCollapsibleButton.collapsed = False
@@ -153,7 +169,14 @@ class SkeletalRepresentationVisualizerWidget(ScriptedLoadableModuleWidget):
         filename = self.inputFileLabelFile.text
         dist = self.distSlider.value
         outputFolder = self.outputFolderLabelFile.text
-        logic.run(filename, dist, outputFolder)
+        if filename != self.loadedFilename and os.path.exists(filename):
+            srepNode = logic.run(filename, dist, outputFolder)
+            if srepNode:
+                # the file is read once, applying again updates the nodes of the selected s-rep node
+                self.loadedFilename = filename
+                self.inputSrepSelector.setCurrentNode(srepNode)
+        else:
+            logic.visualizeSrepNode(self.inputSrepSelector.currentNode())
 
 
 #
@@ -178,297 +201,37 @@ class SkeletalRepresentationVisualizerLogic(ScriptedLoadableModuleLogic):
     def distance(self, p0, p1):
         return math.sqrt((p0[0] - p1[0]) ** 2 + (p0[1] - p1[1]) ** 2 + (p0[2] - p1[2]) ** 2)
 
+    def loadSrep(self, filename):
+        """ Read the s-rep described by the header.xml file into a new vtkMRMLSrepNode.
+        """
+        logic = slicer.modules.skeletalrepresentationinitializer.logic()
+        srepNode = logic.LoadSrep(filename)
+        if srepNode is None:
+            logging.error('Cannot read the s-rep: ' + filename)
+        return srepNode
+
+    def visualizeSrepNode(self, srepNode):
+        """ Visualize the s-rep held by the vtkMRMLSrepNode: its display node draws the spokes,
+        medial mesh and fold curve, the SkeletalRepresentationInitializer logic adds the medial
+        points and the implied boundary. Visualizing a node again updates these nodes.
+        """
+        if srepNode is None:
+            logging.error('Choose an s-rep node or an s-rep file to visualize')
+            return False
+        logic = slicer.modules.skeletalrepresentationinitializer.logic()
+        if logic.VisualizeSrepNode(srepNode) != 0:
+            logging.error('Cannot visualize the s-rep of node: ' + srepNode.GetName())
+            return False
+        return True
+
     def visualizeNewSrep(self, filename):
-        """ Parse header.xml file, create models from the data, and visualize it. """
-        # 1. parse header file
-        tree = ET.parse(filename)
-        upFileName = ''
-        crestFileName = ''
-        downFileName = ''
-        nCols = 0
-        nRows = 0
-        headerFolder = os.path.dirname(filename)
-        for child in tree.getroot():
-            if child.tag == 'upSpoke':
-                if os.path.isabs(child.text):
-                    upFileName = os.path.join(headerFolder, child.text)
-                upFileName = os.path.join(headerFolder, child.text)
-            elif child.tag == 'downSpoke':
-                downFileName = os.path.join(headerFolder, child.text)
-            elif child.tag == 'crestSpoke':
-                crestFileName = os.path.join(headerFolder, child.text)
-            elif child.tag == 'nRows':
-                nRows = (int)(child.text)
-            elif child.tag == 'nCols':
-                nCols = (int)(child.text)
-
-        logging.info("upSpoke file: " + upFileName)
-        logging.info("downSpoke file: " + downFileName)
-        logging.info("crestSpoke file: " + crestFileName)
-
-        reader = vtk.vtkXMLPolyDataReader()
-        reader.SetFileName(upFileName)
-        reader.Update()
-
-        upSpokes = reader.GetOutput()
-
-        upPointData = upSpokes.GetPointData()
-        numberOfArrays = upPointData.GetNumberOfArrays()
-        if numberOfArrays is 0:
-            logging.warning("File: " + upFileName + " does not contain data")
-
-        # medial_polyData = upSpokes #  this is poly data for skeleton
-
-        scene = slicer.mrmlScene
-
-        # base line of medial sheet
-        fidDisplayNode = slicer.vtkMRMLMarkupsDisplayNode()
-        scene.AddNode(fidDisplayNode)
-        fidNode = slicer.vtkMRMLMarkupsFiducialNode()
-        # If we would have more than 100 fiducial points (meant for editing points) better to use a regular MRMLModelNode
-        # In the future, we would like the user to be able to move the nodes, and the connected structures to update accordingly.
-        # Meanwhile, we lock the moving.
-        fidNode.SetLocked(True)
-        fidDisplayNode.SetGlyphScale(0.01)
-        fidDisplayNode.SetSelectedColor(1.0, 1.0, 0.0)
-        fidDisplayNode.SetTextScale(0.0)
-        scene.AddNode(fidNode)
-        fidNode.SetAndObserveDisplayNodeID(fidDisplayNode.GetID())
-        # \TODO come up with better name later
-
-        # prepare for arrows for upspokes
-        upSpoke_points = vtk.vtkPoints()
-        upSpoke_lines = vtk.vtkCellArray()
-
-        arr_length = upPointData.GetArray('spokeLength')
-        arr_dirs = upPointData.GetArray('spokeDirection')
-        for i in range(upSpokes.GetNumberOfPoints()):
-            pt = [0] * 3
-            upSpokes.GetPoint(i, pt)
-            # base point of up arrows
-            id0 = upSpoke_points.InsertNextPoint(pt)
-
-            # head of up arrows
-            spoke_length = arr_length.GetValue(i)
-            baseIdx = i * 3
-            dirX = arr_dirs.GetValue(baseIdx)
-            dirY = arr_dirs.GetValue(baseIdx + 1)
-            dirZ = arr_dirs.GetValue(baseIdx + 2)
-            pt1 = [0] * 3
-            pt1[0] = pt[0] + spoke_length * dirX
-            pt1[1] = pt[1] + spoke_length * dirY
-            pt1[2] = pt[2] + spoke_length * dirZ
-            id1 = upSpoke_points.InsertNextPoint(pt1)
-
-            up_arrow = vtk.vtkLine()
-            up_arrow.GetPointIds().SetId(0, id0)
-            up_arrow.GetPointIds().SetId(1, id1)
-            upSpoke_lines.InsertNextCell(up_arrow)
-
-            fidNode.AddFiducial(pt[0], pt[1], pt[2])
-
-        # boundary_point_ids = []
-
-        # model node for medial mesh
-        medial_model = slicer.vtkMRMLModelNode()
-        medial_model.SetScene(scene)
-        medial_model.SetName("Medial Mesh")
-        medial_model.SetAndObservePolyData(reader.GetOutput())
-        # model display node for the medial mesh
-        medial_model_display = slicer.vtkMRMLModelDisplayNode()
-        medial_model_display.SetColor(0, 0.5, 0)
-        medial_model_display.SetScene(scene)
-        medial_model_display.SetLineWidth(3.0)
-        medial_model_display.SetRepresentation(1)
-        medial_model_display.SetBackfaceCulling(0)
-        scene.AddNode(medial_model_display)
-        medial_model.SetAndObserveDisplayNodeID(medial_model_display.GetID())
-        scene.AddNode(medial_model)
-
-        # model node for up spoke (poly data for arrows)
-        upSpoke_polyData = vtk.vtkPolyData()
-        upSpoke_polyData.SetPoints(upSpoke_points)
-        upSpoke_polyData.SetLines(upSpoke_lines)
-
-        upSpoke_model = slicer.vtkMRMLModelNode()
-        upSpoke_model.SetScene(scene)
-        upSpoke_model.SetName("Top Spoke")
-        upSpoke_model.SetAndObservePolyData(upSpoke_polyData)
-        # model display node for the top spoke
-        # cyan for the top spoke
-        upSpoke_model_display = slicer.vtkMRMLModelDisplayNode()
-        upSpoke_model_display.SetColor(0, 1, 1)
-        upSpoke_model_display.SetScene(scene)
-        upSpoke_model_display.SetLineWidth(3.0)
-        upSpoke_model_display.SetBackfaceCulling(0)
-        scene.AddNode(upSpoke_model_display)
-        upSpoke_model.SetAndObserveDisplayNodeID(upSpoke_model_display.GetID())
-        scene.AddNode(upSpoke_model)
-
-        # prepare for down spokes
-        reader.SetFileName(downFileName)
-        reader.Update()
-        downSpokes = reader.GetOutput()
-
-        downSpoke_polyData = vtk.vtkPolyData()
-        downSpoke_lines = vtk.vtkCellArray()
-        downSpoke_points = vtk.vtkPoints()
-
-        downPointData = downSpokes.GetPointData()
-        arr_length = downPointData.GetArray('spokeLength')
-        arr_dirs = downPointData.GetArray('spokeDirection')
-        for i in range(downSpokes.GetNumberOfPoints()):
-            # tail of arrows
-            pt_tail = [0] * 3
-            downSpokes.GetPoint(i, pt_tail)
-            id0 = downSpoke_points.InsertNextPoint(pt_tail)
-
-            # head of arrows
-            pt_head = [0] * 3
-            spoke_length = arr_length.GetValue(i)
-            baseIdx = i * 3
-            dirX = arr_dirs.GetValue(baseIdx)
-            dirY = arr_dirs.GetValue(baseIdx+1)
-            dirZ = arr_dirs.GetValue(baseIdx+2)
-            pt_head[0] = pt_tail[0] + spoke_length * dirX
-            pt_head[1] = pt_tail[1] + spoke_length * dirY
-            pt_head[2] = pt_tail[2] + spoke_length * dirZ
-            id1 = downSpoke_points.InsertNextPoint(pt_head)
-
-            # connection between head and tail
-            con = vtk.vtkLine()
-            con.GetPointIds().SetId(0, id0)
-            con.GetPointIds().SetId(1, id1)
-            downSpoke_lines.InsertNextCell(con)
-
-        downSpoke_polyData.SetPoints(downSpoke_points)
-        downSpoke_polyData.SetLines(downSpoke_lines)
-
-        downSpoke_model = slicer.vtkMRMLModelNode()
-        downSpoke_model.SetScene(scene)
-        downSpoke_model.SetName("Bottom Spoke")
-        downSpoke_model.SetAndObservePolyData(downSpoke_polyData)
-        # model display node for the down spoke
-        downSpoke_model_display = slicer.vtkMRMLModelDisplayNode()
-        downSpoke_model_display.SetColor(1, 0, 1)
-        downSpoke_model_display.SetScene(scene)
-        downSpoke_model_display.SetLineWidth(3.0)
-        downSpoke_model_display.SetBackfaceCulling(0)
-        scene.AddNode(downSpoke_model_display)
-        downSpoke_model.SetAndObserveDisplayNodeID(downSpoke_model_display.GetID())
-        scene.AddNode(downSpoke_model)
-
-        # crest spoke
-        new_reader = vtk.vtkXMLPolyDataReader()
-        new_reader.SetFileName(crestFileName)
-        new_reader.Update()
-        foldCurve_polyData = new_reader.GetOutput()
-        foldPointData = foldCurve_polyData.GetPointData()
-        arr_length = foldPointData.GetArray('spokeLength')
-        arr_dirs = foldPointData.GetArray('spokeDirection')
-        crest_arrows_polydata = vtk.vtkPolyData()
-        crest_arrows_points = vtk.vtkPoints()
-        crest_arrows_lines = vtk.vtkCellArray()
-        for i in range(foldCurve_polyData.GetNumberOfPoints()):
-            # tail of crest arrows
-            pt_tail = [0] * 3
-            foldCurve_polyData.GetPoint(i, pt_tail)
-            id0 = crest_arrows_points.InsertNextPoint(pt_tail)
-
-            # head of crest arrows
-            pt_head = [0] * 3
-            spoke_length = arr_length.GetValue(i)
-            baseIdx = i * 3
-            dirX = arr_dirs.GetValue(baseIdx)
-            dirY = arr_dirs.GetValue(baseIdx + 1)
-            dirZ = arr_dirs.GetValue(baseIdx + 2)
-            pt_head[0] = pt_tail[0] + spoke_length * dirX
-            pt_head[1] = pt_tail[1] + spoke_length * dirY
-            pt_head[2] = pt_tail[2] + spoke_length * dirZ
-            id1 = crest_arrows_points.InsertNextPoint(pt_head)
-
-            crest_line = vtk.vtkLine()
-            crest_line.GetPointIds().SetId(0, id0)
-            crest_line.GetPointIds().SetId(1, id1)
-            crest_arrows_lines.InsertNextCell(crest_line)
-
-        crest_arrows_polydata.SetPoints(crest_arrows_points)
-        crest_arrows_polydata.SetLines(crest_arrows_lines)
-
-        # show crest arrows
-        crestSpoke_model = slicer.vtkMRMLModelNode()
-        crestSpoke_model.SetScene(scene)
-        crestSpoke_model.SetName("Crest Spoke")
-        crestSpoke_model.SetAndObservePolyData(crest_arrows_polydata)
-        # model display node
-        crestSpoke_model_display = slicer.vtkMRMLModelDisplayNode()
-        crestSpoke_model_display.SetColor(1, 1, 0)
-        crestSpoke_model_display.SetScene(scene)
-        crestSpoke_model_display.SetLineWidth(3.0)
-        crestSpoke_model_display.SetBackfaceCulling(0)
-        scene.AddNode(crestSpoke_model_display)
-        crestSpoke_model.SetAndObserveDisplayNodeID(crestSpoke_model_display.GetID())
-        scene.AddNode(crestSpoke_model)
-
-        # show fold curve
-        foldCurve_model = slicer.vtkMRMLModelNode()
-        foldCurve_model.SetScene(scene)
-        foldCurve_model.SetName("Fold Curve")
-        foldCurve_model.SetAndObservePolyData(foldCurve_polyData)
-        # model display node
-        foldCurve_model_display = slicer.vtkMRMLModelDisplayNode()
-        foldCurve_model_display.SetColor(1, 1, 0)
-        foldCurve_model_display.SetScene(scene)
-        foldCurve_model_display.SetLineWidth(3.0)
-        foldCurve_model_display.SetBackfaceCulling(0)
-        scene.AddNode(foldCurve_model_display)
-        foldCurve_model.SetAndObserveDisplayNodeID(foldCurve_model_display.GetID())
-        scene.AddNode(foldCurve_model)
-
-        # show connections to fold curve point from nearby interior points
-        # compute the nearest interior point
-        connection_polydata = vtk.vtkPolyData()
-        connection_points = vtk.vtkPoints()
-        connection_lines = vtk.vtkCellArray()
-        for i in range(foldCurve_polyData.GetNumberOfPoints()):
-            min_dist = 100000.0
-            nearest_index = 0
-            pt_fold = [0] * 3
-            foldCurve_polyData.GetPoint(i, pt_fold)
-            id0 = connection_points.InsertNextPoint(pt_fold)
-
-            for j in range(upSpokes.GetNumberOfPoints()):
-                pt_interior = [0] * 3
-                upSpokes.GetPoint(j, pt_interior)
-                dist = self.distance(pt_fold, pt_interior)
-                if dist < min_dist:
-                    min_dist = dist
-                    nearest_index = j
-
-            pt_nearest_interior = upSpokes.GetPoint(nearest_index)
-            id1 = connection_points.InsertNextPoint(pt_nearest_interior)
-            line = vtk.vtkLine()
-
-            line.GetPointIds().SetId(0, id0)
-            line.GetPointIds().SetId(1, id1)
-
-            connection_lines.InsertNextCell(line)
-
-        connection_polydata.SetPoints(connection_points)
-        connection_polydata.SetLines(connection_lines)
-        connection_model = slicer.vtkMRMLModelNode()
-        connection_model.SetScene(scene)
-        connection_model.SetName("Connection to Fold Curve")
-        connection_model.SetAndObservePolyData(connection_polydata)
-        # model display node
-        connection_model_display = slicer.vtkMRMLModelDisplayNode()
-        connection_model_display.SetColor(0, 0, 0)
-        connection_model_display.SetScene(scene)
-        connection_model_display.SetLineWidth(3.0)
-        connection_model_display.SetBackfaceCulling(0)
-        scene.AddNode(connection_model_display)
-        connection_model.SetAndObserveDisplayNodeID(connection_model_display.GetID())
-        scene.AddNode(connection_model)
+        """ Load the s-rep described by the header.xml file into a vtkMRMLSrepNode and visualize it.
+        Return the s-rep node, or None if it cannot be read.
+        """
+        srepNode = self.loadSrep(filename)
+        if srepNode is None or not self.visualizeSrepNode(srepNode):
+            return None
+        return srepNode
 
     def validateInputs(self, filename, dist, outputFolder):
         if os.path.exists(filename) is False:
@@ -496,22 +259,24 @@ class SkeletalRepresentationVisualizerLogic(ScriptedLoadableModuleLogic):
 
         """
         Run the actual algorithm
+        Return the s-rep node that is visualized, or None
         """
 
         validInputs = self.validateInputs(filename, dist, outputFolder)
         if validInputs is False:
             logging.error('Invalid input parameters')
-            return False
+            return None
 
         logging.info('Processing started')
+        srepNode = None
         if filename.endswith('.m3d'):
             newSrepFile = self.transformLegacySrep(filename, dist, outputFolder)
-            self.visualizeNewSrep(newSrepFile)
+            srepNode = self.visualizeNewSrep(newSrepFile)
 
         elif filename.endswith('.xml'):
-            self.visualizeNewSrep(filename)
+            srepNode = self.visualizeNewSrep(filename)
         logging.info('Processing completed')
-        return True
+        return srepNode
 
     def transformLegacySrep(self, filename, dist, outputFolder):
         logging.info('The input is legacy s-rep, now converting to new s-rep')
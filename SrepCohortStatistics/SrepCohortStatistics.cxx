@@ -0,0 +1,145 @@
+// Compute the mean s-rep and the spoke variances of a cohort of s-reps
+#include "SrepCohortStatisticsCLP.h"
+
+#include "vtkSrepStatistics.h"
+
+#include <vtkSMPTools.h>
+#include <vtkTimerLog.h>
+
+// vtk system tools
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+bool IsLegacySrepFile(const std::string& fileName)
+{
+    return vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(fileName)) == ".m3d";
+}
+
+// .m3d files of the directory and header.xml of its sub folders
+void ListDirectory(const std::string& directory, std::vector<std::string>& files)
+{
+    vtksys::Directory dir;
+    if(!dir.Load(directory))
+    {
+        std::cerr << "Cannot read the input directory: " << directory << std::endl;
+        return;
+    }
+    std::vector<std::string> found;
+    for(unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+    {
+        std::string name = dir.GetFile(i);
+        std::string fileName = directory + "/" + name;
+        if(vtksys::SystemTools::FileIsDirectory(fileName))
+        {
+            if(name != "." && name != ".." && vtksys::SystemTools::FileExists(fileName + "/header.xml", true))
+            {
+                found.push_back(fileName + "/header.xml");
+            }
+        }
+        else if(IsLegacySrepFile(fileName))
+        {
+            found.push_back(fileName);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+void ReadManifest(const std::string& manifest, std::vector<std::string>& files)
+{
+    std::ifstream fin(manifest.c_str());
+    if(!fin)
+    {
+        std::cerr << "Cannot read the manifest: " << manifest << std::endl;
+        return;
+    }
+    std::string base = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(manifest));
+    std::string line;
+    while(std::getline(fin, line))
+    {
+        // one file per line, empty lines and lines starting with # are ignored
+        std::string::size_type first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        std::string::size_type last = line.find_last_not_of(" \t\r");
+        files.push_back(vtksys::SystemTools::CollapseFullPath(line.substr(first, last - first + 1), base));
+    }
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    PARSE_ARGS;
+
+    std::vector<std::string> inputs;
+    if(!inputDirectory.empty())
+    {
+        ListDirectory(inputDirectory, inputs);
+    }
+    if(!manifest.empty())
+    {
+        ReadManifest(manifest, inputs);
+    }
+    if(inputs.empty())
+    {
+        std::cerr << "No s-rep to compute statistics of" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if(outputHeader.empty())
+    {
+        std::cerr << "No header given for the mean s-rep" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double startTime = vtkTimerLog::GetUniversalTime();
+    if(numberOfThreads > 0)
+    {
+        vtkSMPTools::Initialize(numberOfThreads);
+    }
+    vtkSrepStatistics statistics;
+    statistics.SetFoldCurveDistance(foldCurveDistance);
+    statistics.SetNumberOfRefinementPasses(numberOfRefinementPasses);
+    bool computed = statistics.Compute(inputs);
+    double elapsed = vtkTimerLog::GetUniversalTime() - startTime;
+
+    // files rejected by the first pass are left out of the statistics, a file that changed afterwards stops the cohort
+    const std::vector<std::pair<std::string, std::string> >& rejected = statistics.GetRejectedFiles();
+    for(size_t i = 0; i < rejected.size(); ++i)
+    {
+        std::cerr << "Warning: " << rejected[i].first << " rejected: " << rejected[i].second << std::endl;
+    }
+    if(!computed)
+    {
+        return EXIT_FAILURE;
+    }
+    std::string outputDirectory = vtksys::SystemTools::GetFilenamePath(outputHeader);
+    if((!outputDirectory.empty() && !vtksys::SystemTools::MakeDirectory(outputDirectory))
+            || !statistics.Write(outputHeader))
+    {
+        std::cerr << "Cannot write the mean s-rep: " << outputHeader << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Mean of " << statistics.GetNumberOfSamples() << " s-reps, rejected " << rejected.size()
+              << " in " << elapsed << " s" << std::endl;
+    if(elapsed > 0)
+    {
+        // the cohort is read once per pass, refinement may stop before numberOfRefinementPasses
+        std::cout << "Throughput: " << statistics.GetNumberOfSamples() * statistics.GetNumberOfPasses() / elapsed
+                  << " s-reps/s over " << statistics.GetNumberOfPasses() << " passes" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
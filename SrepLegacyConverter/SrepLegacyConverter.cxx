@@ -0,0 +1,228 @@
+// Convert legacy s-reps (.m3d) to the new s-rep format in bulk
+#include "SrepLegacyConverterCLP.h"
+
+#include "vtkLegacySrep.h"
+#include "vtkSrepIO.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkSMPTools.h>
+#include <vtkTimerLog.h>
+
+// vtk system tools
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+enum ConversionStatus {Pending, Converted, Skipped, Failed};
+
+struct ConversionJob
+{
+    std::string input;
+    std::string outputDirectory;
+    ConversionStatus status;
+    std::string message;
+};
+
+bool IsLegacySrepFile(const std::string& fileName)
+{
+    return vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(fileName)) == ".m3d";
+}
+
+void ListDirectory(const std::string& directory, std::vector<std::string>& files)
+{
+    vtksys::Directory dir;
+    if(!dir.Load(directory))
+    {
+        std::cerr << "Cannot read the input directory: " << directory << std::endl;
+        return;
+    }
+    std::vector<std::string> found;
+    for(unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+    {
+        std::string fileName = directory + "/" + dir.GetFile(i);
+        if(IsLegacySrepFile(fileName) && !vtksys::SystemTools::FileIsDirectory(fileName))
+        {
+            found.push_back(fileName);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+void ReadManifest(const std::string& manifest, std::vector<std::string>& files)
+{
+    std::ifstream fin(manifest.c_str());
+    if(!fin)
+    {
+        std::cerr << "Cannot read the manifest: " << manifest << std::endl;
+        return;
+    }
+    std::string base = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(manifest));
+    std::string line;
+    while(std::getline(fin, line))
+    {
+        // one file per line, empty lines and lines starting with # are ignored
+        std::string::size_type first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        std::string::size_type last = line.find_last_not_of(" \t\r");
+        files.push_back(vtksys::SystemTools::CollapseFullPath(line.substr(first, last - first + 1), base));
+    }
+}
+
+// the output is up to date if all its files exist and the last one written is not older than the input
+bool IsUpToDate(const std::string& input, const std::string& outputDirectory)
+{
+    const char* outputs[] = {"header.xml", "up.vtp", "down.vtp", "crest.vtp"};
+    for(int i = 0; i < 4; ++i)
+    {
+        if(!vtksys::SystemTools::FileExists(outputDirectory + "/" + outputs[i], true))
+        {
+            return false;
+        }
+    }
+    int result = 0;
+    return vtksys::SystemTools::FileTimeCompare(input, outputDirectory + "/crest.vtp", &result) && result <= 0;
+}
+
+// converts a range of jobs, every job is one s-rep
+class ConvertFunctor
+{
+public:
+    ConvertFunctor(std::vector<ConversionJob>& jobs, double foldCurveDistance, bool force)
+        : Jobs(jobs), FoldCurveDistance(foldCurveDistance), Force(force)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+        for(vtkIdType i = begin; i < end; ++i)
+        {
+            Convert(Jobs[i]);
+        }
+    }
+
+private:
+    void Convert(ConversionJob& job) const
+    {
+        if(!Force && IsUpToDate(job.input, job.outputDirectory))
+        {
+            job.status = Skipped;
+            return;
+        }
+        vtkLegacySrep legacySrep;
+        if(!legacySrep.ReadM3D(job.input))
+        {
+            job.status = Failed;
+            job.message = "cannot read the legacy s-rep";
+            return;
+        }
+        vtkSmartPointer<vtkMultiBlockDataSet> srep = legacySrep.ToSrepModel(FoldCurveDistance);
+        if(!vtksys::SystemTools::MakeDirectory(job.outputDirectory)
+                || !vtkSrepIO::WriteSrep(srep, job.outputDirectory + "/header.xml"))
+        {
+            job.status = Failed;
+            job.message = "cannot write " + job.outputDirectory;
+            return;
+        }
+        job.status = Converted;
+    }
+
+    std::vector<ConversionJob>& Jobs;
+    double FoldCurveDistance;
+    bool Force;
+};
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    PARSE_ARGS;
+
+    std::vector<std::string> inputs;
+    if(!inputDirectory.empty())
+    {
+        ListDirectory(inputDirectory, inputs);
+    }
+    if(!manifest.empty())
+    {
+        ReadManifest(manifest, inputs);
+    }
+    if(outputDirectory.empty() || !vtksys::SystemTools::MakeDirectory(outputDirectory))
+    {
+        std::cerr << "Cannot create the output directory: " << outputDirectory << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // every s-rep goes to a folder named after its m3d file
+    std::vector<ConversionJob> jobs;
+    std::set<std::string> outputNames;
+    int nFailed = 0;
+    for(size_t i = 0; i < inputs.size(); ++i)
+    {
+        std::string name = vtksys::SystemTools::GetFilenameWithoutLastExtension(inputs[i]);
+        if(!outputNames.insert(name).second)
+        {
+            std::cerr << inputs[i] << ": another s-rep is already written to " << name << ", skipped" << std::endl;
+            ++nFailed;
+            continue;
+        }
+        ConversionJob job;
+        job.input = inputs[i];
+        job.outputDirectory = outputDirectory + "/" + name;
+        job.status = Pending;
+        jobs.push_back(job);
+    }
+
+    double startTime = vtkTimerLog::GetUniversalTime();
+    if(numberOfThreads > 0)
+    {
+        vtkSMPTools::Initialize(numberOfThreads);
+    }
+    // grain of one s-rep: files differ in size, so let the scheduler balance them one by one
+    ConvertFunctor convert(jobs, foldCurveDistance, force);
+    vtkSMPTools::For(0, static_cast<vtkIdType>(jobs.size()), 1, convert);
+    double elapsed = vtkTimerLog::GetUniversalTime() - startTime;
+
+    int nConverted = 0, nSkipped = 0;
+    double convertedBytes = 0;
+    for(size_t i = 0; i < jobs.size(); ++i)
+    {
+        if(jobs[i].status == Converted)
+        {
+            ++nConverted;
+            convertedBytes += static_cast<double>(vtksys::SystemTools::FileLength(jobs[i].input));
+        }
+        else if(jobs[i].status == Skipped)
+        {
+            ++nSkipped;
+        }
+        else
+        {
+            ++nFailed;
+            std::cerr << jobs[i].input << ": " << jobs[i].message << std::endl;
+        }
+    }
+
+    std::cout << "Converted " << nConverted << " s-reps, skipped " << nSkipped
+              << " up to date, failed " << nFailed << " in " << elapsed << " s" << std::endl;
+    if(elapsed > 0 && nConverted > 0)
+    {
+        std::cout << "Throughput: " << nConverted / elapsed << " s-reps/s, "
+                  << convertedBytes / (1024.0 * 1024.0) / elapsed << " MB/s of m3d input" << std::endl;
+    }
+    return nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}